@@ -0,0 +1,254 @@
+#include <string.h>
+#include <algorithm>
+#include "XPCMessageBus.h"
+
+/*
+ * The queue is a bounded multi-producer queue in the style of Dmitry
+ * Vyukov's: every cell carries a sequence number which tells posting threads
+ * whether the cell is free for the position they claimed and tells the
+ * delivering thread whether the cell has been filled.  Posting threads claim
+ * positions with a compare-and-swap on mTail; only the sim thread moves mHead.
+ *
+ */
+
+XPCMessageBus::XPCMessageBus(
+				int				inCapacity,
+				int				inMaxPerCycle) :
+	mCells(NULL),
+	mMask(0),
+	mTail(0),
+	mHead(0),
+	mDropped(0),
+	mMaxPerCycle(inMaxPerCycle),
+	mDelivering(false),
+	mNeedsCompacting(false)
+{
+	unsigned int capacity = 2;
+	while (capacity < (unsigned int) inCapacity)
+		capacity *= 2;
+
+	mCells = new Cell[capacity];
+	mMask = capacity - 1;
+	for (unsigned int n = 0; n < capacity; ++n)
+		mCells[n].mSequence.store(n, std::memory_order_relaxed);
+
+	StartProcessCycles(1);
+}
+
+XPCMessageBus::~XPCMessageBus()
+{
+	mDelivering = false;
+	Compact();
+	while (!mSubscriptions.empty())
+		UnsubscribeAll(mSubscriptions.front().mListener);
+	delete [] mCells;
+}
+
+void		XPCMessageBus::Subscribe(
+				XPCBusListener *	inListener,
+				int					inMessage)
+{
+	for (SubscriptionVector::iterator iter = mSubscriptions.begin(); iter != mSubscriptions.end(); ++iter)
+	{
+		if (iter->mListener == inListener && iter->mMessage == inMessage)
+			return;
+	}
+
+	if (!IsSubscribed(inListener))
+		inListener->BusAdded(this);
+
+	Subscription subscription;
+	subscription.mMessage = inMessage;
+	subscription.mListener = inListener;
+	mSubscriptions.push_back(subscription);
+}
+
+void		XPCMessageBus::Unsubscribe(
+				XPCBusListener *	inListener,
+				int					inMessage)
+{
+	for (SubscriptionVector::iterator iter = mSubscriptions.begin(); iter != mSubscriptions.end(); ++iter)
+	{
+		if (iter->mListener == inListener && iter->mMessage == inMessage)
+		{
+			iter->mListener = NULL;
+			mNeedsCompacting = true;
+			break;
+		}
+	}
+
+	if (!IsSubscribed(inListener))
+		inListener->BusRemoved(this);
+
+	if (!mDelivering)
+		Compact();
+}
+
+void		XPCMessageBus::UnsubscribeAll(
+				XPCBusListener *	inListener)
+{
+	bool	wasSubscribed = false;
+	for (SubscriptionVector::iterator iter = mSubscriptions.begin(); iter != mSubscriptions.end(); ++iter)
+	{
+		if (iter->mListener == inListener)
+		{
+			iter->mListener = NULL;
+			mNeedsCompacting = true;
+			wasSubscribed = true;
+		}
+	}
+
+	if (wasSubscribed)
+		inListener->BusRemoved(this);
+
+	if (!mDelivering)
+		Compact();
+}
+
+bool		XPCMessageBus::Post(
+				int				inMessage,
+				const void *	inData,
+				int				inSize)
+{
+	if (inSize < 0 || inSize > XPC_BUS_MAX_DATA)
+	{
+		mDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	Cell *			cell;
+	unsigned int	position = mTail.load(std::memory_order_relaxed);
+	while (true)
+	{
+		cell = &mCells[position & mMask];
+		unsigned int	sequence = cell->mSequence.load(std::memory_order_acquire);
+		int				difference = (int) (sequence - position);
+		if (difference == 0)
+		{
+			if (mTail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			// The delivering thread has not freed this cell yet: the queue is full.
+			mDropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else
+			position = mTail.load(std::memory_order_relaxed);
+	}
+
+	cell->mMessage = inMessage;
+	cell->mSize = inSize;
+	if (inSize > 0)
+		memcpy(cell->mData, inData, inSize);
+	cell->mSequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+int			XPCMessageBus::DeliverMessages(
+				int				inMaxMessages)
+{
+	// Without a limit, deliver at most one queue's worth so that listeners
+	// which post as they listen can not keep us here forever.
+	int		limit = (inMaxMessages > 0) ? inMaxMessages : (int) (mMask + 1);
+	int		delivered = 0;
+	char	data[XPC_BUS_MAX_DATA];
+
+	bool	wasDelivering = mDelivering;
+	mDelivering = true;
+	while (delivered < limit)
+	{
+		Cell *			cell = &mCells[mHead & mMask];
+		unsigned int	sequence = cell->mSequence.load(std::memory_order_acquire);
+		if ((int) (sequence - (mHead + 1)) < 0)
+			break;
+
+		// Copy the message out and free the cell before calling anyone, so
+		// listeners can post without finding the queue full of themselves.
+		int		message = cell->mMessage;
+		int		size = cell->mSize;
+		memcpy(data, cell->mData, size);
+		cell->mSequence.store(mHead + mMask + 1, std::memory_order_release);
+		++mHead;
+		++delivered;
+
+		for (size_t n = 0; n < mSubscriptions.size(); ++n)
+		{
+			XPCBusListener *	listener = mSubscriptions[n].mListener;
+			if (listener != NULL && mSubscriptions[n].mMessage == message)
+				listener->ListenToBusMessage(message, data, size);
+		}
+	}
+	mDelivering = wasDelivering;
+
+	if (!mDelivering)
+		Compact();
+	return delivered;
+}
+
+long long	XPCMessageBus::GetDroppedCount(void) const
+{
+	return mDropped.load(std::memory_order_relaxed);
+}
+
+void		XPCMessageBus::DoProcessing(
+				float 				inElapsedSinceLastCall,
+				float				inElapsedTimeSinceLastFlightLoop,
+				int 				inCounter)
+{
+	DeliverMessages(mMaxPerCycle);
+}
+
+bool		XPCMessageBus::IsSubscribed(
+				XPCBusListener *	inListener)
+{
+	for (SubscriptionVector::iterator iter = mSubscriptions.begin(); iter != mSubscriptions.end(); ++iter)
+	{
+		if (iter->mListener == inListener)
+			return true;
+	}
+	return false;
+}
+
+void		XPCMessageBus::Compact(void)
+{
+	if (!mNeedsCompacting)
+		return;
+
+	SubscriptionVector::iterator iter = mSubscriptions.begin();
+	while (iter != mSubscriptions.end())
+	{
+		if (iter->mListener == NULL)
+			iter = mSubscriptions.erase(iter);
+		else
+			++iter;
+	}
+	mNeedsCompacting = false;
+}
+
+
+
+XPCBusListener::XPCBusListener()
+{
+}
+
+XPCBusListener::~XPCBusListener()
+{
+	while (!mBuses.empty())
+		mBuses.front()->UnsubscribeAll(this);
+}
+
+void		XPCBusListener::BusAdded(
+				XPCMessageBus *	inBus)
+{
+	mBuses.push_back(inBus);
+}
+
+void		XPCBusListener::BusRemoved(
+				XPCMessageBus *	inBus)
+{
+	BusVector::iterator iter = std::find(mBuses.begin(), mBuses.end(), inBus);
+	if (iter != mBuses.end())
+		mBuses.erase(iter);
+}
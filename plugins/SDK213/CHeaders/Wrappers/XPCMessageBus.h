@@ -0,0 +1,126 @@
+#ifndef _XPCMessageBus_h_
+#define _XPCMessageBus_h_
+
+#include <vector>
+#include <atomic>
+
+#include "XPCProcessing.h"
+
+/*
+ * XPCMessageBus
+ *
+ * A broadcaster that any thread may post to.  Unlike XPCBroadcaster, which
+ * calls its listeners right away on the thread that broadcasts, posted
+ * messages are copied into a bounded lock-free queue (many posting threads,
+ * one delivering thread) and delivered later on the sim thread, from the
+ * bus's flight loop callback, to the listeners subscribed to that message.
+ * Posting never locks or allocates: each message carries up to
+ * XPC_BUS_MAX_DATA bytes which are copied into the queue, and if the queue is
+ * full the message is dropped and counted.
+ *
+ * Subscribing, unsubscribing and delivering must happen on the sim thread.
+ * Listeners may subscribe, unsubscribe and post while a message is being
+ * delivered to them.
+ *
+ */
+
+#define	XPC_BUS_MAX_DATA	48
+
+class	XPCBusListener;
+
+class	XPCMessageBus : public XPCProcess {
+public:
+
+						XPCMessageBus(
+							int				inCapacity = 1024,
+							int				inMaxPerCycle = 0);
+	virtual				~XPCMessageBus();
+
+			void		Subscribe(
+							XPCBusListener *	inListener,
+							int					inMessage);
+			void		Unsubscribe(
+							XPCBusListener *	inListener,
+							int					inMessage);
+			void		UnsubscribeAll(
+							XPCBusListener *	inListener);
+
+			bool		Post(
+							int				inMessage,
+							const void *	inData = 0,
+							int				inSize = 0);
+
+			int			DeliverMessages(
+							int				inMaxMessages = 0);
+			long long	GetDroppedCount(void) const;
+
+	virtual	void		DoProcessing(
+							float 				inElapsedSinceLastCall,
+							float				inElapsedTimeSinceLastFlightLoop,
+							int 				inCounter);
+
+private:
+
+	struct	Cell {
+		std::atomic<unsigned int>	mSequence;
+		int							mMessage;
+		int							mSize;
+		char						mData[XPC_BUS_MAX_DATA];
+	};
+
+	struct	Subscription {
+		int					mMessage;
+		XPCBusListener *	mListener;		// NULL once unsubscribed during delivery
+	};
+
+	typedef	std::vector<Subscription>	SubscriptionVector;
+
+		Cell *						mCells;
+		unsigned int				mMask;
+		std::atomic<unsigned int>	mTail;
+		unsigned int				mHead;
+		std::atomic<long long>		mDropped;
+		int							mMaxPerCycle;
+
+		SubscriptionVector			mSubscriptions;
+		bool						mDelivering;
+		bool						mNeedsCompacting;
+
+			bool		IsSubscribed(
+							XPCBusListener *	inListener);
+			void		Compact(void);
+
+	XPCMessageBus(const XPCMessageBus&);
+	XPCMessageBus& operator=(const XPCMessageBus&);
+
+};
+
+
+
+class	XPCBusListener {
+public:
+
+						XPCBusListener();
+	virtual				~XPCBusListener();
+
+	virtual	void		ListenToBusMessage(
+							int				inMessage,
+							const void *	inData,
+							int				inSize)=0;
+
+private:
+
+	typedef	std::vector<XPCMessageBus *>	BusVector;
+
+	BusVector	mBuses;
+
+	friend	class	XPCMessageBus;
+
+			void		BusAdded(
+							XPCMessageBus *	inBus);
+			void		BusRemoved(
+							XPCMessageBus *	inBus);
+
+};
+
+#endif
@@ -1,15 +1,69 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
 #include "XPCProcessing.h"
 #include "XPLMUtilities.h"
 
+typedef	std::chrono::steady_clock	ProfileClock;
+
+struct	XPCProcess::Profiler {
+	struct	TraceEvent {
+		double		start;			// microseconds since sTraceOrigin
+		double		duration;		// microseconds
+		int			counter;
+	};
+
+	char			name[64];
+	char			jsonName[128];	// name escaped for the trace file
+	double			budget;
+	long long		totalCalls;
+	long long		overBudget;
+	double			window[XPC_PROFILE_WINDOW];
+	int				histogram[XPC_PROFILE_BUCKETS];
+	TraceEvent		events[XPC_PROFILE_TRACE_EVENTS];
+};
+
+static	std::vector<XPCProcess *>	sProfiled;
+static	ProfileClock::time_point	sTraceOrigin;
+
+static	int		ProfileBucket(double inSeconds)
+{
+	double	limit = 1e-6;
+	int		bucket = 0;
+	while (bucket < XPC_PROFILE_BUCKETS - 1 && inSeconds >= limit)
+	{
+		limit *= 2.0;
+		++bucket;
+	}
+	return bucket;
+}
+
+static	double	ProfilePercentile(const int * inHistogram, int inCalls, double inFraction)
+{
+	int		wanted = (int) (inCalls * inFraction);
+	int		seen = 0;
+	for (int bucket = 0; bucket < XPC_PROFILE_BUCKETS; ++bucket)
+	{
+		seen += inHistogram[bucket];
+		if (seen > wanted)
+			return 1e-6 * (double) (1 << bucket);
+	}
+	return 1e-6 * (double) (1 << (XPC_PROFILE_BUCKETS - 1));
+}
+
 XPCProcess::XPCProcess() :
 	mInCallback(false),
-	mCallbackTime(0)
+	mCallbackTime(0),
+	mProfiler(NULL)
 {
 	XPLMRegisterFlightLoopCallback(FlightLoopCB, 0, reinterpret_cast<void *>(this));
 }
 
 XPCProcess::~XPCProcess()
 {
+	DisableProfiling();
 	XPLMUnregisterFlightLoopCallback(FlightLoopCB, reinterpret_cast<void *>(this));
 }
 	
@@ -46,7 +100,135 @@ float	XPCProcess::FlightLoopCB(
 {
 	XPCProcess * me = reinterpret_cast<XPCProcess *>(inRefcon);
 	me->mInCallback = true;
-	me->DoProcessing(inElapsedSinceLastCall, inElapsedTimeSinceLastFlightLoop, inCounter);
+	if (me->mProfiler == NULL)
+		me->DoProcessing(inElapsedSinceLastCall, inElapsedTimeSinceLastFlightLoop, inCounter);
+	else
+	{
+		ProfileClock::time_point start = ProfileClock::now();
+		me->DoProcessing(inElapsedSinceLastCall, inElapsedTimeSinceLastFlightLoop, inCounter);
+		ProfileClock::time_point end = ProfileClock::now();
+
+		// DoProcessing may have turned profiling off.
+		Profiler * profiler = me->mProfiler;
+		if (profiler != NULL)
+		{
+			double	seconds = std::chrono::duration<double>(end - start).count();
+			int		slot = (int) (profiler->totalCalls % XPC_PROFILE_WINDOW);
+			if (profiler->totalCalls >= XPC_PROFILE_WINDOW)
+				profiler->histogram[ProfileBucket(profiler->window[slot])]--;
+			profiler->window[slot] = seconds;
+			profiler->histogram[ProfileBucket(seconds)]++;
+			if (seconds > profiler->budget)
+				profiler->overBudget++;
+
+			Profiler::TraceEvent * event = &profiler->events[profiler->totalCalls % XPC_PROFILE_TRACE_EVENTS];
+			event->start = std::chrono::duration<double, std::micro>(start - sTraceOrigin).count();
+			event->duration = seconds * 1e6;
+			event->counter = inCounter;
+			profiler->totalCalls++;
+		}
+	}
 	me->mInCallback = false;
 	return me->mCallbackTime;
+}
+
+void		XPCProcess::EnableProfiling(
+				const char *		inName,
+				float				inBudgetSeconds)
+{
+	if (mProfiler == NULL)
+	{
+		if (sProfiled.empty())
+			sTraceOrigin = ProfileClock::now();
+		mProfiler = new Profiler;
+		sProfiled.push_back(this);
+	}
+
+	memset(mProfiler, 0, sizeof(Profiler));
+	strncpy(mProfiler->name, inName, sizeof(mProfiler->name) - 1);
+
+	char * out = mProfiler->jsonName;
+	for (const char * in = mProfiler->name; *in != 0; ++in)
+	{
+		if (*in == '"' || *in == '\\')
+			*out++ = '\\';
+		*out++ = ((unsigned char) *in < ' ') ? ' ' : *in;
+	}
+	mProfiler->budget = inBudgetSeconds;
+}
+
+void		XPCProcess::DisableProfiling(void)
+{
+	if (mProfiler == NULL)
+		return;
+
+	delete mProfiler;
+	mProfiler = NULL;
+	sProfiled.erase(std::find(sProfiled.begin(), sProfiled.end(), this));
+}
+
+bool		XPCProcess::GetProfile(
+				XPCProcessProfile *	outProfile) const
+{
+	memset(outProfile, 0, sizeof(XPCProcessProfile));
+	if (mProfiler == NULL)
+		return false;
+
+	int		calls = (int) std::min<long long>(mProfiler->totalCalls, XPC_PROFILE_WINDOW);
+	double	total = 0;
+	for (int n = 0; n < calls; ++n)
+	{
+		total += mProfiler->window[n];
+		outProfile->maxSeconds = std::max(outProfile->maxSeconds, mProfiler->window[n]);
+	}
+
+	outProfile->calls = calls;
+	outProfile->totalCalls = mProfiler->totalCalls;
+	outProfile->overBudget = mProfiler->overBudget;
+	memcpy(outProfile->histogram, mProfiler->histogram, sizeof(outProfile->histogram));
+	if (calls > 0)
+	{
+		outProfile->lastSeconds = mProfiler->window[(mProfiler->totalCalls - 1) % XPC_PROFILE_WINDOW];
+		outProfile->meanSeconds = total / calls;
+		outProfile->p50Seconds = std::min(ProfilePercentile(mProfiler->histogram, calls, 0.50), outProfile->maxSeconds);
+		outProfile->p99Seconds = std::min(ProfilePercentile(mProfiler->histogram, calls, 0.99), outProfile->maxSeconds);
+	}
+	return true;
+}
+
+/*
+ * Writes the recent calls of every profiled process as complete ("X") events
+ * in the Chrome trace event format, one track per process.
+ *
+ */
+bool		XPCProcess::WriteChromeTrace(
+				const char *		inFileName)
+{
+	FILE * file = fopen(inFileName, "w");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool	first = true;
+	for (size_t track = 0; track < sProfiled.size(); ++track)
+	{
+		Profiler *	profiler = sProfiled[track]->mProfiler;
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				first ? "" : ",\n", (int) track + 1, profiler->jsonName);
+		first = false;
+
+		long long	count = std::min<long long>(profiler->totalCalls, XPC_PROFILE_TRACE_EVENTS);
+		for (long long n = profiler->totalCalls - count; n < profiler->totalCalls; ++n)
+		{
+			Profiler::TraceEvent * event = &profiler->events[n % XPC_PROFILE_TRACE_EVENTS];
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"XPCProcess\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+					"\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"counter\":%d,\"over_budget\":%s}}",
+					profiler->jsonName, (int) track + 1, event->start, event->duration, event->counter,
+					event->duration > profiler->budget * 1e6 ? "true" : "false");
+		}
+	}
+	fprintf(file, "\n]}\n");
+
+	fclose(file);
+	return true;
 }
\ No newline at end of file
@@ -3,6 +3,35 @@
 
 #include "XPLMProcessing.h"
 
+/*
+ * Profiling
+ *
+ * Any XPCProcess can time its DoProcessing calls: call EnableProfiling with a
+ * name and a budget.  Each call is timed on the monotonic clock.  The last
+ * XPC_PROFILE_WINDOW calls are kept in a rolling histogram (see GetProfile),
+ * calls over the budget are counted, and the last XPC_PROFILE_TRACE_EVENTS
+ * calls of every profiled process can be written out with WriteChromeTrace
+ * for chrome://tracing or Perfetto.  Processes which do not enable profiling
+ * pay only a pointer test per call.
+ *
+ */
+
+#define	XPC_PROFILE_BUCKETS			24		// bucket 0 holds calls under 1 us, bucket n calls under 2^n us
+#define	XPC_PROFILE_WINDOW			1024
+#define	XPC_PROFILE_TRACE_EVENTS	16384
+
+struct	XPCProcessProfile {
+	int			calls;								// calls in the window
+	long long	totalCalls;							// since profiling was enabled
+	long long	overBudget;							// since profiling was enabled
+	double		lastSeconds;
+	double		meanSeconds;						// over the window
+	double		p50Seconds;							// upper edge of the bucket holding the 50th percentile (at most maxSeconds)
+	double		p99Seconds;
+	double		maxSeconds;							// over the window
+	int			histogram[XPC_PROFILE_BUCKETS];		// calls in the window per bucket
+};
+
 class	XPCProcess {
 public:
 
@@ -13,6 +42,15 @@ public:
 			void		StartProcessCycles(int	inCycles);
 			void		StopProcess(void);
 
+			void		EnableProfiling(
+							const char *		inName,
+							float				inBudgetSeconds = 0.001f);
+			void		DisableProfiling(void);
+			bool		GetProfile(
+							XPCProcessProfile *	outProfile) const;
+	static	bool		WriteChromeTrace(
+							const char *		inFileName);
+
 	virtual	void		DoProcessing(
 							float 				inElapsedSinceLastCall, 
 							float				inElapsedTimeSinceLastFlightLoop,
@@ -28,6 +66,10 @@ private:
 						
 		bool		mInCallback;
 		float		mCallbackTime;
+
+	struct	Profiler;
+
+		Profiler *	mProfiler;
 		
 	XPCProcess(const XPCProcess&);
 	XPCProcess& operator=(const XPCProcess&);
@@ -0,0 +1,136 @@
+// DataRefBatchBenchmark.cpp : Compares writing multi-aircraft array datarefs one slot at a time against writing
+// them through UWDataRefBatch.  Runs against the XPLM stand-in, which counts the calls made into "X-Plane".
+//
+//	DataRefBatchBenchmark [numSlots] [numArrays] [numFrames] [callCostNanoseconds]
+//
+
+#include <iostream>            // For cout and cerr
+#include <cstdlib>             // For atoi()
+#include <cstdio>              // For sprintf()
+#include <chrono>
+
+#include "XPLMDataAccess.h"
+#include "XPLMStandIn.h"
+#include "UWDataRefBatch.h"
+
+using namespace std;
+
+#define MAX_ARRAYS 64
+
+//Function prototypes
+void SetupDataRefs(int numSlots, int numArrays);
+void RunPerSlotWrites(int numSlots, int numArrays, int numFrames);
+void RunBatchedWrites(int numSlots, int numArrays, int numFrames);
+void PrintResults(const char * name, int numFrames, double elapsedSeconds);
+
+XPLMDataRef		gArrays[MAX_ARRAYS];
+UWDataRefBatch	gBatch;
+
+
+
+int main(int argc, char *argv[]) {
+	int numSlots		= (argc > 1) ? atoi(argv[1]) : 20;		//multiplayer slots (the override arrays have 20)
+	int numArrays		= (argc > 2) ? atoi(argv[2]) : 6;		//array datarefs written per slot (x, y, z, theta, phi, psi)
+	int numFrames		= (argc > 3) ? atoi(argv[3]) : 100000;
+	long long callCost	= (argc > 4) ? atoll(argv[4]) : 0;		//simulated cost of a call into X-Plane
+
+	if(numArrays > MAX_ARRAYS) {
+		numArrays = MAX_ARRAYS;
+	}
+
+	cout << "DataRefBatchBenchmark: " << numSlots << " slots, " << numArrays << " array datarefs, "
+		 << numFrames << " frames, " << callCost << " ns per XPLM call" << endl << endl;
+
+	SetupDataRefs(numSlots, numArrays);
+	XPLMStandInSetCallCost(callCost);
+
+	RunPerSlotWrites(numSlots, numArrays, numFrames);
+	RunBatchedWrites(numSlots, numArrays, numFrames);
+
+	return 0;
+}
+
+
+
+/*
+Add the array datarefs to the stand-in
+*/
+void SetupDataRefs(int numSlots, int numArrays)
+{
+	XPLMStandInReset();
+
+	for(int a = 0; a < numArrays; a++) {
+		char name[64];
+		sprintf(name, "uw/benchmark/array_%d", a);
+		XPLMStandInAddDataRef(name, xplmType_FloatArray, numSlots);
+		gArrays[a] = XPLMFindDataRef(name);
+	}
+}
+
+
+
+/*
+What the plugins do today: one XPLMSetDatavf call per slot per dataref
+*/
+void RunPerSlotWrites(int numSlots, int numArrays, int numFrames)
+{
+	XPLMStandInResetStats();
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(int frame = 0; frame < numFrames; frame++) {
+		for(int slot = 0; slot < numSlots; slot++) {
+			for(int a = 0; a < numArrays; a++) {
+				float value = (float)(frame + slot + a);
+				XPLMSetDatavf(gArrays[a], &value, slot, 1);
+			}
+		}
+	}
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	PrintResults("per-slot writes", numFrames, elapsed.count());
+}
+
+
+
+/*
+Writes recorded in the batch and flushed once per frame
+*/
+void RunBatchedWrites(int numSlots, int numArrays, int numFrames)
+{
+	int handles[MAX_ARRAYS];
+	UWBatchInit(&gBatch);
+	for(int a = 0; a < numArrays; a++) {
+		handles[a] = UWBatchRegister(&gBatch, gArrays[a]);
+	}
+
+	XPLMStandInResetStats();
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(int frame = 0; frame < numFrames; frame++) {
+		for(int slot = 0; slot < numSlots; slot++) {
+			for(int a = 0; a < numArrays; a++) {
+				UWBatchSet(&gBatch, handles[a], slot, (double)(frame + slot + a));
+			}
+		}
+		UWBatchFlush(&gBatch);
+	}
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	PrintResults("batched writes", numFrames, elapsed.count());
+}
+
+
+
+/*
+Print the calls per frame and time per frame
+*/
+void PrintResults(const char * name, int numFrames, double elapsedSeconds)
+{
+	const XPLMStandInStats * stats = XPLMStandInGetStats();
+	long long numCalls = stats->setScalar + stats->setArray;
+
+	cout << name << endl;
+	cout << "  XPLMSetData* calls per frame: " << (double)numCalls / numFrames << endl;
+	cout << "  values written per frame:     " << (double)stats->valuesWritten / numFrames << endl;
+	cout << "  time per frame (us):          " << elapsedSeconds * 1e6 / numFrames << endl << endl;
+}
@@ -0,0 +1,437 @@
+// MessageBusBenchmark.cpp : Checks and times XPCMessageBus (SDK213/CHeaders/Wrappers) against the XPLM stand-in,
+// which runs the bus's flight loop callback as X-Plane would.
+//
+//	MessageBusBenchmark [numMessages] [numProducers] [capacity]
+//
+// Producer threads post numMessages each while the main thread runs frames which deliver them.  The queue is kept
+// small so it fills up and drops posts; every post must then be either delivered (in order per producer, with its
+// data intact) or counted as dropped.  The single threaded checks fill the queue on purpose and unsubscribe, delete
+// and post from listeners while a message is being delivered.  The last check covers the profiling of XPCProcess
+// (the histogram, the over budget count and the Chrome trace) with a process whose calls take known times.  Returns
+// 1 if any check fails.
+//
+
+#include <iostream>            // For cout and cerr
+#include <fstream>             // For reading the trace back
+#include <sstream>
+#include <cstdlib>             // For atoi()
+#include <cstdio>              // For remove()
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "XPLMStandIn.h"
+#include "XPCMessageBus.h"
+
+using namespace std;
+
+#define MAX_PRODUCERS	16
+#define TEST_MESSAGE	1
+#define OTHER_MESSAGE	2
+#define TRACE_FILE		"/tmp/MessageBusBenchmarkTrace.json"
+#define PROFILE_BUDGET	0.001			//seconds
+#define SLOW_SECONDS	0.002			//a call which is over the budget
+#define NUM_SLOW_CALLS	5
+#define NUM_FAST_CALLS	15
+
+struct TestMessage {
+	int		producer;
+	int		counter;
+	int		check;					//producer * counter, to catch torn copies
+};
+
+//Function prototypes
+bool RunPostDeliver(int numMessages, int numProducers, int capacity);
+bool RunFullQueue();
+bool RunDeliveryChanges();
+bool RunProfiling();
+int CountOccurrences(const string & text, const string & pattern);
+bool Check(bool condition, const char * what);
+
+int gFailures = 0;
+
+
+
+/*
+Checks every message it is given: each producer's counters must arrive in order (some may have been dropped)
+*/
+class CheckingListener : public XPCBusListener {
+public:
+	CheckingListener() : delivered(0), errors(0) {
+		for(int i = 0; i < MAX_PRODUCERS; i++) {
+			lastCounter[i] = -1;
+		}
+	}
+
+	virtual void ListenToBusMessage(int inMessage, const void * inData, int inSize) {
+		const TestMessage * message = (const TestMessage *)inData;
+		if(inMessage != TEST_MESSAGE || inSize != sizeof(TestMessage) || message->producer < 0 ||
+		   message->producer >= MAX_PRODUCERS || message->check != message->producer * message->counter ||
+		   message->counter <= lastCounter[message->producer]) {
+			errors++;
+			return;
+		}
+		lastCounter[message->producer] = message->counter;
+		delivered++;
+	}
+
+	long long	delivered;
+	long long	errors;
+	int			lastCounter[MAX_PRODUCERS];
+};
+
+
+
+/*
+Counts what it is given and, once it has been given a message, does whatever the check needs
+*/
+class ActingListener : public XPCBusListener {
+public:
+	ActingListener(XPCMessageBus * bus) : bus(bus), received(0), unsubscribeSelf(false), unsubscribeOther(NULL),
+		deleteOther(NULL), postMessage(0) {
+	}
+
+	virtual void ListenToBusMessage(int inMessage, const void * inData, int inSize) {
+		received++;
+		if(unsubscribeSelf) {
+			bus->Unsubscribe(this, inMessage);
+		}
+		if(unsubscribeOther != NULL) {
+			bus->UnsubscribeAll(unsubscribeOther);
+			unsubscribeOther = NULL;
+		}
+		if(deleteOther != NULL) {
+			delete deleteOther;
+			deleteOther = NULL;
+		}
+		if(postMessage != 0) {
+			bus->Post(postMessage);
+			postMessage = 0;
+		}
+	}
+
+	XPCMessageBus *		bus;
+	int					received;
+	bool				unsubscribeSelf;
+	XPCBusListener *	unsubscribeOther;
+	XPCBusListener *	deleteOther;
+	int					postMessage;
+};
+
+
+
+/*
+A process whose calls are either slow (busy for SLOW_SECONDS) or return straight away, to be profiled
+*/
+class BusyProcess : public XPCProcess {
+public:
+	BusyProcess() : slow(false) {
+		StartProcessCycles(1);
+	}
+
+	virtual void DoProcessing(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter) {
+		if(slow) {
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			while(chrono::duration<double>(chrono::steady_clock::now() - start).count() < SLOW_SECONDS) {
+			}
+		}
+	}
+
+	bool	slow;
+};
+
+
+
+int main(int argc, char *argv[]) {
+	int numMessages		= (argc > 1) ? atoi(argv[1]) : 200000;	//posted by each producer
+	int numProducers	= (argc > 2) ? atoi(argv[2]) : 4;
+	int capacity		= (argc > 3) ? atoi(argv[3]) : 256;		//small enough that the producers fill it
+
+	if(numProducers > MAX_PRODUCERS) {
+		numProducers = MAX_PRODUCERS;
+	}
+
+	cout << "MessageBusBenchmark: " << numProducers << " producers, " << numMessages << " messages each, queue of "
+		 << capacity << endl << endl;
+
+	XPLMStandInReset();
+	XPLMStandInSetQuiet(true);
+
+	RunPostDeliver(numMessages, numProducers, capacity);
+	RunFullQueue();
+	RunDeliveryChanges();
+	RunProfiling();
+
+	if(gFailures > 0) {
+		cout << endl << gFailures << " checks failed" << endl;
+		return 1;
+	}
+	cout << endl << "All checks passed" << endl;
+	return 0;
+}
+
+
+
+/*
+Producers post as fast as they can while the main thread runs frames (each delivers everything queued).  A producer
+which finds the queue full yields, as one pacing itself would, and so does the main thread between frames, so that
+both sides get to run on a single core
+*/
+bool RunPostDeliver(int numMessages, int numProducers, int capacity)
+{
+	XPCMessageBus		bus(capacity);
+	CheckingListener	listener;
+	bus.Subscribe(&listener, TEST_MESSAGE);
+
+	atomic<long long>	posted(0);
+	atomic<int>			running(numProducers);
+	vector<thread>		producers;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(int p = 0; p < numProducers; p++) {
+		producers.push_back(thread([&bus, &posted, &running, p, numMessages]() {
+			long long accepted = 0;
+			for(int i = 0; i < numMessages; i++) {
+				TestMessage message = { p, i, p * i };
+				if(bus.Post(TEST_MESSAGE, &message, sizeof(message))) {
+					accepted++;
+				} else {
+					this_thread::yield();
+				}
+			}
+			posted += accepted;
+			running--;
+		}));
+	}
+
+	XPLMStandInFrameTimes times;
+	long long frames = 0;
+	while(running > 0) {
+		XPLMStandInRunFrame(1.0 / 60.0, &times);
+		frames++;
+		this_thread::yield();
+	}
+	for(size_t p = 0; p < producers.size(); p++) {
+		producers[p].join();
+	}
+	XPLMStandInRunFrame(1.0 / 60.0, &times);	//what was posted after the last frame
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	long long total = (long long)numMessages * numProducers;
+	cout << "Post/deliver: " << listener.delivered << " delivered and " << bus.GetDroppedCount() << " dropped of "
+		 << total << " in " << frames << " frames, " << total / seconds / 1.0e6 << " million posts per second" << endl;
+
+	bool passed = true;
+	passed &= Check(listener.errors == 0, "messages arrive in order per producer with their data intact");
+	passed &= Check(listener.delivered == posted, "every accepted post is delivered");
+	passed &= Check(listener.delivered > total / 100 && listener.delivered > 4 * capacity,
+					"delivery keeps freeing the queue while the producers post");
+	passed &= Check(posted + bus.GetDroppedCount() == total, "every post is either accepted or counted as dropped");
+	passed &= Check(bus.DeliverMessages() == 0, "the queue is empty afterwards");
+	return passed;
+}
+
+
+
+/*
+A full queue drops posts (and counts them) until the sim thread delivers
+*/
+bool RunFullQueue()
+{
+	XPCMessageBus		bus(8);
+	CheckingListener	listener;
+	bus.Subscribe(&listener, TEST_MESSAGE);
+
+	int accepted = 0;
+	for(int i = 0; i < 12; i++) {
+		TestMessage message = { 0, i, 0 };
+		accepted += bus.Post(TEST_MESSAGE, &message, sizeof(message)) ? 1 : 0;
+	}
+	char tooLong[XPC_BUS_MAX_DATA + 1] = { 0 };
+
+	bool passed = true;
+	passed &= Check(accepted == 8, "a queue of 8 accepts 8 posts");
+	passed &= Check(bus.GetDroppedCount() == 4, "the 4 posts beyond it are counted as dropped");
+	passed &= Check(!bus.Post(TEST_MESSAGE, tooLong, sizeof(tooLong)) && bus.GetDroppedCount() == 5,
+					"a post with too much data is dropped");
+	passed &= Check(bus.DeliverMessages(3) == 3 && bus.DeliverMessages() == 5, "delivery honours the limit");
+	TestMessage message = { 0, 100, 0 };
+	passed &= Check(bus.Post(TEST_MESSAGE, &message, sizeof(message)) && bus.DeliverMessages() == 1,
+					"posts are accepted again once delivered");
+	passed &= Check(listener.delivered == 9 && listener.errors == 0, "the accepted posts are delivered in order");
+
+	cout << "Full queue: " << (passed ? "passed" : "FAILED") << endl;
+	return passed;
+}
+
+
+
+/*
+Listeners unsubscribe themselves, unsubscribe and delete other listeners, and post, while a message is being
+delivered
+*/
+bool RunDeliveryChanges()
+{
+	XPCMessageBus		bus(16);
+	ActingListener *	selfRemover		= new ActingListener(&bus);
+	ActingListener *	otherRemover	= new ActingListener(&bus);
+	ActingListener *	deleter			= new ActingListener(&bus);
+	ActingListener *	unsubscribed	= new ActingListener(&bus);
+	ActingListener *	deleted			= new ActingListener(&bus);
+	ActingListener *	poster			= new ActingListener(&bus);
+	ActingListener *	other			= new ActingListener(&bus);
+
+	selfRemover->unsubscribeSelf	= true;
+	otherRemover->unsubscribeOther	= unsubscribed;
+	deleter->deleteOther			= deleted;
+	poster->postMessage				= OTHER_MESSAGE;
+
+	bus.Subscribe(selfRemover, TEST_MESSAGE);
+	bus.Subscribe(otherRemover, TEST_MESSAGE);
+	bus.Subscribe(deleter, TEST_MESSAGE);
+	bus.Subscribe(unsubscribed, TEST_MESSAGE);
+	bus.Subscribe(unsubscribed, OTHER_MESSAGE);
+	bus.Subscribe(deleted, TEST_MESSAGE);
+	bus.Subscribe(poster, TEST_MESSAGE);
+	bus.Subscribe(other, OTHER_MESSAGE);
+
+	for(int i = 0; i < 3; i++) {
+		bus.Post(TEST_MESSAGE);
+	}
+	int delivered = bus.DeliverMessages();
+
+	bool passed = true;
+	passed &= Check(delivered == 4, "a message posted during delivery is delivered in the same cycle");
+	passed &= Check(selfRemover->received == 1, "a listener which unsubscribes itself gets no more messages");
+	passed &= Check(otherRemover->received == 3 && deleter->received == 3 && poster->received == 3,
+					"the other listeners get every message");
+	passed &= Check(unsubscribed->received == 0, "a listener unsubscribed before its turn is not called");
+	passed &= Check(other->received == 1, "the posted message reaches its own listeners");
+
+	//the bus must not call the deleted listener (a crash or a valgrind error here), and must forget the others
+	bus.Post(TEST_MESSAGE);
+	bus.Post(OTHER_MESSAGE);
+	bus.DeliverMessages();
+	passed &= Check(selfRemover->received == 1 && unsubscribed->received == 0 && other->received == 2,
+					"unsubscriptions made during delivery last");
+
+	delete selfRemover;
+	delete otherRemover;
+	delete deleter;
+	delete unsubscribed;
+	delete poster;
+	delete other;
+
+	cout << "Changes during delivery: " << (passed ? "passed" : "FAILED") << endl;
+	return passed;
+}
+
+
+
+/*
+Profile a process through the stand-in's flight loop: slow calls must land in the histogram buckets above the budget
+and be counted as over it, roll out of the histogram once XPC_PROFILE_WINDOW calls have followed them, and show up in
+the Chrome trace (which also has a track for the profiled bus)
+*/
+bool RunProfiling()
+{
+	XPLMStandInFrameTimes times;
+	XPCMessageBus bus;
+	BusyProcess process;
+	XPCProcessProfile profile;
+
+	bool passed = true;
+	passed &= Check(!process.GetProfile(&profile), "a process which is not profiled has no profile");
+
+	process.EnableProfiling("busy \"process\"", PROFILE_BUDGET);
+	bus.EnableProfiling("bus", PROFILE_BUDGET);
+	for(int i = 0; i < NUM_SLOW_CALLS + NUM_FAST_CALLS; i++) {
+		process.slow = (i % 4 == 0);			//5 of the 20
+		XPLMStandInRunFrame(1.0 / 60.0, &times);
+	}
+
+	//bucket n holds the calls under 2^n us, so the buckets up to PROFILE_BUDGET are the calls within it
+	int budgetBucket = 0;
+	while((1 << budgetBucket) * 1e-6 < PROFILE_BUDGET) {
+		budgetBucket++;
+	}
+
+	process.GetProfile(&profile);
+	int within = 0;
+	int over = 0;
+	for(int bucket = 0; bucket < XPC_PROFILE_BUCKETS; bucket++) {
+		if(bucket < budgetBucket) {
+			within += profile.histogram[bucket];
+		} else {
+			over += profile.histogram[bucket];
+		}
+	}
+	passed &= Check(profile.calls == NUM_SLOW_CALLS + NUM_FAST_CALLS && profile.totalCalls == profile.calls,
+					"every call is profiled");
+	passed &= Check(within == NUM_FAST_CALLS && over == NUM_SLOW_CALLS, "the histogram puts each call in its bucket");
+	passed &= Check(profile.overBudget == NUM_SLOW_CALLS, "the calls over the budget are counted");
+	passed &= Check(profile.maxSeconds >= SLOW_SECONDS && profile.p99Seconds > PROFILE_BUDGET &&
+					profile.p50Seconds <= PROFILE_BUDGET, "the percentiles and the maximum follow the histogram");
+
+	process.slow = false;
+	for(int i = 0; i < XPC_PROFILE_WINDOW; i++) {
+		XPLMStandInRunFrame(1.0 / 60.0, &times);
+	}
+	process.GetProfile(&profile);
+	int inWindow = 0;
+	for(int bucket = 0; bucket < XPC_PROFILE_BUCKETS; bucket++) {
+		inWindow += profile.histogram[bucket];
+	}
+	passed &= Check(profile.calls == XPC_PROFILE_WINDOW && inWindow == XPC_PROFILE_WINDOW &&
+					profile.maxSeconds < PROFILE_BUDGET, "the histogram only holds the last XPC_PROFILE_WINDOW calls");
+	passed &= Check(profile.overBudget == NUM_SLOW_CALLS, "the over budget count is kept for every call");
+
+	remove(TRACE_FILE);
+	passed &= Check(XPCProcess::WriteChromeTrace(TRACE_FILE), "the Chrome trace is written");
+	ifstream file(TRACE_FILE);
+	stringstream trace;
+	trace << file.rdbuf();
+	string text = trace.str();
+	remove(TRACE_FILE);
+
+	long long traced = NUM_SLOW_CALLS + NUM_FAST_CALLS + XPC_PROFILE_WINDOW;
+	passed &= Check(text.compare(0, 19, "{\"displayTimeUnit\":") == 0 && text.find("\n]}") != string::npos,
+					"the trace is a complete trace event object");
+	passed &= Check(CountOccurrences(text, "\"thread_name\"") == 2 &&
+					CountOccurrences(text, "\"args\":{\"name\":\"busy \\\"process\\\"\"}") == 1,
+					"the trace has a track for each profiled process, with its name escaped");
+	passed &= Check(CountOccurrences(text, "\"ph\":\"X\"") == 2 * traced,
+					"the trace has an event for every call of both processes");
+	passed &= Check(CountOccurrences(text, "\"over_budget\":true") == NUM_SLOW_CALLS,
+					"the trace marks the calls over the budget");
+
+	process.DisableProfiling();
+	bus.DisableProfiling();
+	passed &= Check(!process.GetProfile(&profile), "a process stops being profiled");
+
+	cout << "Profiling: " << (passed ? "passed" : "FAILED") << endl;
+	return passed;
+}
+
+
+
+int CountOccurrences(const string & text, const string & pattern)
+{
+	int count = 0;
+	for(size_t at = text.find(pattern); at != string::npos; at = text.find(pattern, at + pattern.size())) {
+		count++;
+	}
+	return count;
+}
+
+
+
+bool Check(bool condition, const char * what)
+{
+	if(!condition) {
+		cerr << "FAILED: " << what << endl;
+		gFailures++;
+	}
+	return condition;
+}
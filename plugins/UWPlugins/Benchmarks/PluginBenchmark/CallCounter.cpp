@@ -0,0 +1,396 @@
+/*
+CallCounter.cpp
+
+See CallCounter.h
+*/
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "CallCounter.h"
+
+//----------------------------GLOBAL VARIALBES----------------------------------------
+static thread_local bool		tCounting		= false;
+static thread_local long long	tAllocations	= 0;
+static thread_local long long	tSyscalls		= 0;
+
+extern "C" {
+void *	__libc_malloc(size_t size);
+void *	__libc_calloc(size_t count, size_t size);
+void *	__libc_realloc(void * pointer, size_t size);
+}
+
+//look up the libc function the wrapper replaces (once)
+#define REAL(name)	static decltype(&name) real = (decltype(&name))dlsym(RTLD_NEXT, #name)
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Start counting the calls made by this thread (from zero)
+*/
+void CallCounterStart()
+{
+	tAllocations	= 0;
+	tSyscalls		= 0;
+	tCounting		= true;
+}
+
+
+
+void CallCounterStop(CallCounts * outCounts)
+{
+	tCounting = false;
+	outCounts->allocations	= tAllocations;
+	outCounts->syscalls		= tSyscalls;
+}
+
+
+
+static inline void CountAllocation()
+{
+	if(tCounting) {
+		tAllocations++;
+	}
+}
+
+
+
+static inline void CountSyscall()
+{
+	if(tCounting) {
+		tSyscalls++;
+	}
+}
+
+
+
+//-------------------------REPLACE THE ALLOCATION FUNCTIONS---------------------------
+extern "C" {
+
+void * malloc(size_t size) __THROW
+{
+	CountAllocation();
+	return __libc_malloc(size);
+}
+
+
+
+void * calloc(size_t count, size_t size) __THROW
+{
+	CountAllocation();
+	return __libc_calloc(count, size);
+}
+
+
+
+void * realloc(void * pointer, size_t size) __THROW
+{
+	CountAllocation();
+	return __libc_realloc(pointer, size);
+}
+
+
+
+int posix_memalign(void ** outPointer, size_t alignment, size_t size) __THROW
+{
+	REAL(posix_memalign);
+	CountAllocation();
+	return real(outPointer, alignment, size);
+}
+
+
+
+void * aligned_alloc(size_t alignment, size_t size) __THROW
+{
+	REAL(aligned_alloc);
+	CountAllocation();
+	return real(alignment, size);
+}
+
+
+
+//-------------------------WRAP THE SYSTEM CALLS--------------------------------------
+ssize_t read(int fd, void * buffer, size_t length)
+{
+	REAL(read);
+	CountSyscall();
+	return real(fd, buffer, length);
+}
+
+
+
+ssize_t write(int fd, const void * buffer, size_t length)
+{
+	REAL(write);
+	CountSyscall();
+	return real(fd, buffer, length);
+}
+
+
+
+int open(const char * path, int flags, ...)
+{
+	REAL(open);
+	va_list args;
+	va_start(args, flags);
+	mode_t mode = (mode_t)va_arg(args, int);
+	va_end(args);
+	CountSyscall();
+	return real(path, flags, mode);
+}
+
+
+
+int close(int fd)
+{
+	REAL(close);
+	CountSyscall();
+	return real(fd);
+}
+
+
+
+int fcntl(int fd, int command, ...)
+{
+	REAL(fcntl);
+	va_list args;
+	va_start(args, command);
+	void * argument = va_arg(args, void *);
+	va_end(args);
+	CountSyscall();
+	return real(fd, command, argument);
+}
+
+
+
+int ioctl(int fd, unsigned long request, ...) __THROW
+{
+	REAL(ioctl);
+	va_list args;
+	va_start(args, request);
+	void * argument = va_arg(args, void *);
+	va_end(args);
+	CountSyscall();
+	return real(fd, request, argument);
+}
+
+
+
+int fstat(int fd, struct stat * outStat) __THROW
+{
+	REAL(fstat);
+	CountSyscall();
+	return real(fd, outStat);
+}
+
+
+
+int ftruncate(int fd, off_t length) __THROW
+{
+	REAL(ftruncate);
+	CountSyscall();
+	return real(fd, length);
+}
+
+
+
+int unlink(const char * path) __THROW
+{
+	REAL(unlink);
+	CountSyscall();
+	return real(path);
+}
+
+
+
+void * mmap(void * address, size_t length, int protection, int flags, int fd, off_t offset) __THROW
+{
+	REAL(mmap);
+	CountSyscall();
+	return real(address, length, protection, flags, fd, offset);
+}
+
+
+
+int munmap(void * address, size_t length) __THROW
+{
+	REAL(munmap);
+	CountSyscall();
+	return real(address, length);
+}
+
+
+
+int poll(struct pollfd * fds, nfds_t count, int timeout)
+{
+	REAL(poll);
+	CountSyscall();
+	return real(fds, count, timeout);
+}
+
+
+
+int select(int count, fd_set * readFds, fd_set * writeFds, fd_set * exceptFds, struct timeval * timeout)
+{
+	REAL(select);
+	CountSyscall();
+	return real(count, readFds, writeFds, exceptFds, timeout);
+}
+
+
+
+int nanosleep(const struct timespec * duration, struct timespec * remaining)
+{
+	REAL(nanosleep);
+	CountSyscall();
+	return real(duration, remaining);
+}
+
+
+
+int usleep(useconds_t microseconds)
+{
+	REAL(usleep);
+	CountSyscall();
+	return real(microseconds);
+}
+
+
+
+int socket(int domain, int type, int protocol) __THROW
+{
+	REAL(socket);
+	CountSyscall();
+	return real(domain, type, protocol);
+}
+
+
+
+int bind(int fd, const struct sockaddr * address, socklen_t length) __THROW
+{
+	REAL(bind);
+	CountSyscall();
+	return real(fd, address, length);
+}
+
+
+
+int connect(int fd, const struct sockaddr * address, socklen_t length)
+{
+	REAL(connect);
+	CountSyscall();
+	return real(fd, address, length);
+}
+
+
+
+int listen(int fd, int backlog) __THROW
+{
+	REAL(listen);
+	CountSyscall();
+	return real(fd, backlog);
+}
+
+
+
+int accept(int fd, struct sockaddr * outAddress, socklen_t * ioLength)
+{
+	REAL(accept);
+	CountSyscall();
+	return real(fd, outAddress, ioLength);
+}
+
+
+
+int setsockopt(int fd, int level, int option, const void * value, socklen_t length) __THROW
+{
+	REAL(setsockopt);
+	CountSyscall();
+	return real(fd, level, option, value, length);
+}
+
+
+
+ssize_t recv(int fd, void * buffer, size_t length, int flags)
+{
+	REAL(recv);
+	CountSyscall();
+	return real(fd, buffer, length, flags);
+}
+
+
+
+ssize_t recvfrom(int fd, void * buffer, size_t length, int flags, struct sockaddr * outAddress, socklen_t * ioLength)
+{
+	REAL(recvfrom);
+	CountSyscall();
+	return real(fd, buffer, length, flags, outAddress, ioLength);
+}
+
+
+
+ssize_t recvmsg(int fd, struct msghdr * message, int flags)
+{
+	REAL(recvmsg);
+	CountSyscall();
+	return real(fd, message, flags);
+}
+
+
+
+int recvmmsg(int fd, struct mmsghdr * messages, unsigned int count, int flags, struct timespec * timeout)
+{
+	REAL(recvmmsg);
+	CountSyscall();
+	return real(fd, messages, count, flags, timeout);
+}
+
+
+
+ssize_t send(int fd, const void * buffer, size_t length, int flags)
+{
+	REAL(send);
+	CountSyscall();
+	return real(fd, buffer, length, flags);
+}
+
+
+
+ssize_t sendto(int fd, const void * buffer, size_t length, int flags, const struct sockaddr * address,
+			   socklen_t addressLength)
+{
+	REAL(sendto);
+	CountSyscall();
+	return real(fd, buffer, length, flags, address, addressLength);
+}
+
+
+
+ssize_t sendmsg(int fd, const struct msghdr * message, int flags)
+{
+	REAL(sendmsg);
+	CountSyscall();
+	return real(fd, message, flags);
+}
+
+
+
+int sendmmsg(int fd, struct mmsghdr * messages, unsigned int count, int flags)
+{
+	REAL(sendmmsg);
+	CountSyscall();
+	return real(fd, messages, count, flags);
+}
+
+}
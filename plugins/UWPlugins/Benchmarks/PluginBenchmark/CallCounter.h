@@ -0,0 +1,28 @@
+/*
+CallCounter.h
+
+Counts the heap allocations and system calls a thread makes, for PluginBenchmark.  The program linked with
+CallCounter.cpp replaces malloc, calloc, realloc, posix_memalign and aligned_alloc, and the libc wrappers of the
+system calls the plugins make (sockets, file descriptors, polling, sleeping and mmap), so plugins
+loaded with dlopen call through them.  The program must be linked with -rdynamic so the plugins find them.
+
+Only calls made by the thread which called CallCounterStart are counted, until it calls CallCounterStop, so
+background threads of the plugin (e.g. the echo sender) are left out.  Calls made inside libc (e.g. the write
+behind fprintf) and system calls made without a libc wrapper are not counted.  Linux only.
+*/
+
+#ifndef _CallCounter_h_
+#define _CallCounter_h_
+
+struct CallCounts {
+	long long	allocations;
+	long long	syscalls;
+};
+
+
+
+void		CallCounterStart();
+
+void		CallCounterStop(CallCounts * outCounts);
+
+#endif
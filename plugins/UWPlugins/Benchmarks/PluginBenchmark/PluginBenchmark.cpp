@@ -0,0 +1,367 @@
+// PluginBenchmark.cpp : Measures how much time each UW plugin takes from the X-Plane main thread per frame.  Every
+// plugin listed in the limits file is loaded into the XPLM stand-in in a process of its own, fed poses by UDPSend
+// (from the same folder) and run in real time.  Per frame it measures the time spent in the plugin's callbacks and
+// counts the heap allocations and system calls the plugin made on the main thread (see CallCounter.h).
+//
+//	PluginBenchmark limits.txt [--rate HZ] [--duration S] [--only PLUGIN]
+//
+//	--rate HZ			simulated frame rate (default 60)
+//	--duration S		seconds measured for each plugin, after one second of warm up (default 5)
+//	--only PLUGIN		run only the plugin with this file name
+//
+// Each line of the limits file names a plugin and the most it may take:
+//
+//	plugin.xpl  hotkey  traffic  p99_us  max_us  allocs  syscalls  [UDPSend options]
+//
+// hotkey is pressed after the plugin is enabled (F1 to F12 or Shift+F1 to Shift+F12, several separated by commas to
+// press them in order, or - for none), traffic is the rate UDPSend sends
+// poses at (0 for none) and any options after the limits are passed on to UDPSend (e.g. --port or --format), p99_us and max_us are limits on the 99th percentile and the worst frame time in
+// microseconds, and allocs and syscalls are limits on the mean allocations and system calls per frame.  The exit
+// status is 1 if any plugin goes over a limit, so "make bench" catches regressions.
+//
+
+#include <iostream>            // For cout and cerr
+#include <cstdlib>             // For atoi() and atof()
+#include <cstdio>              // For printf() and sscanf()
+#include <cstring>             // For strcmp()
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "XPLMDefs.h"
+#include "XPLMStandIn.h"
+#include "CallCounter.h"
+
+using namespace std;
+
+#define WARM_UP_SECONDS		1.0		//run before measuring, so first packets and lazy setup are not counted
+#define MAX_NAME_LENGTH		256
+
+struct PluginLimits {
+	char		plugin[MAX_NAME_LENGTH];	//file name of the plugin, in the folder PluginBenchmark is in
+	char		hotKey[32];					//hot keys pressed in order, separated by commas
+	int			traffic;					//poses per second sent by UDPSend, 0 for none
+	double		p99Microseconds;
+	double		maxMicroseconds;
+	double		allocations;				//mean per frame
+	double		syscalls;					//mean per frame
+	vector<string>	senderOptions;			//more options for UDPSend
+};
+
+typedef int		(*XPluginStart_f)(char * outName, char * outSig, char * outDesc);
+typedef void	(*XPluginStop_f)(void);
+typedef int		(*XPluginEnable_f)(void);
+typedef void	(*XPluginDisable_f)(void);
+
+//Function prototypes
+bool ReadLimits(const char * fileName, vector<PluginLimits> & outLimits);
+pid_t StartTraffic(const string & folder, int rate, double seconds, const vector<string> & options);
+int RunPlugin(const PluginLimits * limits, const string & folder, int rate, double duration);
+bool ParseHotKey(const char * name, char * outVirtualKey, XPLMKeyFlags * outFlags);
+
+
+
+int main(int argc, char *argv[]) {
+	if(argc < 2 || argv[1][0] == '-') {
+		cerr << "Usage: PluginBenchmark limits.txt [--rate HZ] [--duration S] [--only PLUGIN]" << endl;
+		return 2;
+	}
+
+	int				rate		= 60;
+	double			duration	= 5.0;
+	const char *	only		= NULL;
+	for(int i = 2; i + 1 < argc; i += 2) {
+		if(strcmp(argv[i], "--rate") == 0) {
+			rate = atoi(argv[i + 1]);
+		} else if(strcmp(argv[i], "--duration") == 0) {
+			duration = atof(argv[i + 1]);
+		} else if(strcmp(argv[i], "--only") == 0) {
+			only = argv[i + 1];
+		}
+	}
+	if(rate <= 0 || duration * rate < 1.0) {
+		cerr << "Need a positive rate and at least one frame" << endl;
+		return 2;
+	}
+
+	vector<PluginLimits> limits;
+	if(!ReadLimits(argv[1], limits)) {
+		cerr << "Could not read " << argv[1] << endl;
+		return 2;
+	}
+
+	//the plugins and UDPSend are next to PluginBenchmark
+	string program = argv[0];
+	size_t slash = program.rfind('/');
+	string folder = (slash == string::npos) ? string(".") : program.substr(0, slash);
+
+	cout << "PluginBenchmark: " << rate << " Hz, " << duration << " s per plugin, times in microseconds per frame"
+		 << endl << endl;
+	printf("%-36s %8s %8s %8s %14s %14s\n", "plugin", "p50", "p99", "max", "allocs/frame", "syscalls/frame");
+	fflush(stdout);
+
+	int failures = 0;
+	for(size_t i = 0; i < limits.size(); i++) {
+		if(only != NULL && strcmp(only, limits[i].plugin) != 0) {
+			continue;
+		}
+
+		//each plugin gets a process of its own, so the plugins' globals and sockets start fresh
+		pid_t traffic = 0;
+		if(limits[i].traffic > 0) {
+			traffic = StartTraffic(folder, limits[i].traffic, WARM_UP_SECONDS + duration + 2.0, limits[i].senderOptions);
+		}
+
+		pid_t child = fork();
+		if(child == 0) {
+			_exit(RunPlugin(&limits[i], folder, rate, duration));
+		}
+
+		int status = 0;
+		waitpid(child, &status, 0);
+		if(traffic > 0) {
+			kill(traffic, SIGTERM);
+			waitpid(traffic, NULL, 0);
+		}
+
+		if(WIFSIGNALED(status)) {
+			printf("%-36s crashed (signal %d)\n", limits[i].plugin, WTERMSIG(status));
+			fflush(stdout);
+		}
+		if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			failures++;
+		}
+	}
+
+	cout << endl << (failures == 0 ? "All plugins within limits" : "Some plugins went over their limits") << endl;
+	return failures == 0 ? 0 : 1;
+}
+
+
+
+/*
+Read the limits file (see the top of this file).  Lines starting with # are comments.
+*/
+bool ReadLimits(const char * fileName, vector<PluginLimits> & outLimits)
+{
+	FILE * file = fopen(fileName, "r");
+	if(file == NULL) {
+		return false;
+	}
+
+	char line[1024];
+	while(fgets(line, sizeof(line), file) != NULL) {
+		PluginLimits limits;
+		if(line[0] == '#') {
+			continue;
+		}
+		int end = 0;
+		if(sscanf(line, "%255s %31s %d %lf %lf %lf %lf%n", limits.plugin, limits.hotKey, &limits.traffic,
+				  &limits.p99Microseconds, &limits.maxMicroseconds, &limits.allocations, &limits.syscalls, &end) == 7) {
+			//the rest of the line is options for UDPSend
+			char option[MAX_NAME_LENGTH];
+			int length = 0;
+			while(sscanf(line + end, "%255s%n", option, &length) == 1) {
+				limits.senderOptions.push_back(option);
+				end += length;
+			}
+			outLimits.push_back(limits);
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+
+
+/*
+Run UDPSend in the background, sending poses at rate for the given number of seconds (with the extra options).
+Returns its process id.
+*/
+pid_t StartTraffic(const string & folder, int rate, double seconds, const vector<string> & options)
+{
+	string sender = folder + "/UDPSend";
+	char rateText[32];
+	char secondsText[32];
+	sprintf(rateText, "%d", rate);
+	sprintf(secondsText, "%.1f", seconds);
+
+	vector<const char *> arguments;
+	arguments.push_back("UDPSend");
+	arguments.push_back("--rate");
+	arguments.push_back(rateText);
+	arguments.push_back("--duration");
+	arguments.push_back(secondsText);
+	for(size_t i = 0; i < options.size(); i++) {
+		arguments.push_back(options[i].c_str());
+	}
+	arguments.push_back(NULL);
+
+	pid_t child = fork();
+	if(child == 0) {
+		int null = open("/dev/null", O_WRONLY);
+		dup2(null, STDOUT_FILENO);
+		execv(sender.c_str(), (char * const *)&arguments[0]);
+		cerr << "Could not run " << sender << endl;
+		_exit(127);
+	}
+
+	//let the sender get going before the plugin starts listening
+	this_thread::sleep_for(chrono::milliseconds(100));
+	return child;
+}
+
+
+
+/*
+Load one plugin, run it and print its line of the results.  Returns 0 if it stayed within its limits, 1 if it went
+over and 2 if it could not be run.
+*/
+int RunPlugin(const PluginLimits * limits, const string & folder, int rate, double duration)
+{
+	string path = folder + "/" + limits->plugin;
+
+	XPLMStandInReset();
+	XPLMStandInAddStandardDataRefs();
+	XPLMStandInSetSystemPath((folder + "/").c_str());
+	XPLMStandInSetQuiet(true);
+
+	void * plugin = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if(plugin == NULL) {
+		printf("%-36s could not be loaded: %s\n", limits->plugin, dlerror());
+		return 2;
+	}
+
+	XPluginStart_f		pluginStart		= (XPluginStart_f)dlsym(plugin, "XPluginStart");
+	XPluginStop_f		pluginStop		= (XPluginStop_f)dlsym(plugin, "XPluginStop");
+	XPluginEnable_f		pluginEnable	= (XPluginEnable_f)dlsym(plugin, "XPluginEnable");
+	XPluginDisable_f	pluginDisable	= (XPluginDisable_f)dlsym(plugin, "XPluginDisable");
+	char name[256] = "";
+	char signature[256] = "";
+	char description[256] = "";
+	if(pluginStart == NULL || pluginStop == NULL || pluginEnable == NULL || pluginDisable == NULL ||
+	   !pluginStart(name, signature, description) || !pluginEnable()) {
+		printf("%-36s could not be started\n", limits->plugin);
+		return 2;
+	}
+
+	char hotKeys[sizeof(limits->hotKey)];
+	strcpy(hotKeys, limits->hotKey);
+	for(char * name = strtok(hotKeys, ","); name != NULL; name = strtok(NULL, ",")) {
+		char			hotKey;
+		XPLMKeyFlags	flags;
+		if(ParseHotKey(name, &hotKey, &flags)) {
+			XPLMStandInPressHotKey(hotKey, flags);
+		}
+	}
+
+	//warm up, then measure
+	int			warmUpFrames	= (int)(WARM_UP_SECONDS * rate + 0.5);
+	int			numFrames		= (int)(duration * rate + 0.5);
+	double		frameSeconds	= 1.0 / rate;
+	CallCounts	counts;
+	long long	totalAllocations	= 0;
+	long long	totalSyscalls		= 0;
+	long long	maxAllocations		= 0;
+	long long	maxSyscalls			= 0;
+
+	vector<double> microseconds;
+	microseconds.reserve(numFrames);
+
+	chrono::steady_clock::duration frameDuration =
+		chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(frameSeconds));
+	chrono::steady_clock::time_point nextFrame = chrono::steady_clock::now();
+	for(int frame = 0; frame < warmUpFrames + numFrames; frame++) {
+		nextFrame += frameDuration;
+		this_thread::sleep_until(nextFrame);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		CallCounterStart();
+		XPLMStandInRunFrame(frameSeconds, NULL);
+		CallCounterStop(&counts);
+		double elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+		if(frame < warmUpFrames) {
+			continue;
+		}
+		microseconds.push_back(elapsed);
+		totalAllocations	+= counts.allocations;
+		totalSyscalls		+= counts.syscalls;
+		maxAllocations		= max(maxAllocations, counts.allocations);
+		maxSyscalls			= max(maxSyscalls, counts.syscalls);
+	}
+
+	pluginDisable();
+	pluginStop();
+
+	//results
+	sort(microseconds.begin(), microseconds.end());
+	double p50				= microseconds[numFrames / 2];
+	double p99				= microseconds[(numFrames * 99) / 100];
+	double worst			= microseconds[numFrames - 1];
+	double meanAllocations	= (double)totalAllocations / numFrames;
+	double meanSyscalls		= (double)totalSyscalls / numFrames;
+
+	char allocationsText[32];
+	char syscallsText[32];
+	sprintf(allocationsText, "%.2f (%lld)", meanAllocations, maxAllocations);
+	sprintf(syscallsText, "%.2f (%lld)", meanSyscalls, maxSyscalls);
+	printf("%-36s %8.1f %8.1f %8.1f %14s %14s\n", limits->plugin, p50, p99, worst, allocationsText, syscallsText);
+
+	bool failed = false;
+	if(p99 > limits->p99Microseconds) {
+		printf("    REGRESSION: p99 %.1f us is over the limit of %.1f us\n", p99, limits->p99Microseconds);
+		failed = true;
+	}
+	if(worst > limits->maxMicroseconds) {
+		printf("    REGRESSION: worst frame %.1f us is over the limit of %.1f us\n", worst, limits->maxMicroseconds);
+		failed = true;
+	}
+	if(meanAllocations > limits->allocations) {
+		printf("    REGRESSION: %.2f allocations per frame is over the limit of %.2f\n", meanAllocations,
+			   limits->allocations);
+		failed = true;
+	}
+	if(meanSyscalls > limits->syscalls) {
+		printf("    REGRESSION: %.2f system calls per frame is over the limit of %.2f\n", meanSyscalls,
+			   limits->syscalls);
+		failed = true;
+	}
+	fflush(stdout);
+
+	return failed ? 1 : 0;
+}
+
+
+
+/*
+Turn "F1" to "F12", optionally prefixed with "Shift+", into the XPLM virtual key and the key flags to press it with
+*/
+bool ParseHotKey(const char * name, char * outVirtualKey, XPLMKeyFlags * outFlags)
+{
+	*outFlags = xplm_DownFlag;
+	if(strncmp(name, "Shift+", 6) == 0) {
+		*outFlags |= xplm_ShiftFlag;
+		name += 6;
+	}
+
+	if(name[0] != 'F' && name[0] != 'f') {
+		return false;
+	}
+
+	int number = atoi(name + 1);
+	if(number < 1 || number > 12) {
+		return false;
+	}
+
+	*outVirtualKey = (char)(XPLM_VK_F1 + number - 1);
+	return true;
+}
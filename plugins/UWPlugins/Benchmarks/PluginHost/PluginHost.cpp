@@ -0,0 +1,306 @@
+// PluginHost.cpp : Loads a UW plugin built for Linux (see Projects/Lin/Makefile) into the XPLM stand-in and drives
+// it as X-Plane would: XPluginStart, XPluginEnable, then the flight loop, camera and window callbacks once per
+// simulated frame.  Prints the distribution of the time the plugin took per frame and how many dataref writes it
+// made, and optionally saves every write with its frame and time stamps.
+//
+//	PluginHost plugin.xpl [options]
+//
+//	--rate HZ			simulated frame rate, 60 to 240 (default 60)
+//	--duration S		simulated seconds to run (default 10)
+//	--hotkey KEY		hot key to press after enabling the plugin, F1 to F12 or Shift+F1 to Shift+F12 (e.g. F5 starts
+//						UWTimedProcessingUDP listening and Shift+F5 shows its performance HUD); may be given more than
+//						once, the keys are pressed in order
+//	--command NAME[@S]	command to run S simulated seconds into the run (default 0, after the hot keys are pressed),
+//						e.g. uw/timed_processing_udp/port_up@2; may be given more than once
+//	--realtime			run the frames at wall clock rate (default: as fast as possible), needed when the poses
+//						come from a sender running in real time such as UDPSend
+//	--writes FILE		save every dataref write to FILE as comma separated values
+//	--system-path DIR	folder the plugin looks for its config file in (default ./)
+//	--origin LAT,LON	local origin for XPLMWorldToLocal (default 0,0)
+//	--terrain M[,H]		terrain found by XPLMProbeTerrainXYZ: M meters above mean sea level with hills H meters high
+//						(default 0,0)
+//	--verbose			print the plugin's XPLMDebugString output
+//
+
+#include <iostream>            // For cout and cerr
+#include <cstdlib>             // For atoi() and atof()
+#include <cstdio>              // For sscanf()
+#include <cstring>             // For strcmp()
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <dlfcn.h>
+
+#include "XPLMDefs.h"
+#include "XPLMStandIn.h"
+
+using namespace std;
+
+#define MIN_RATE		60
+#define MAX_RATE		240
+
+typedef int		(*XPluginStart_f)(char * outName, char * outSig, char * outDesc);
+typedef void	(*XPluginStop_f)(void);
+typedef int		(*XPluginEnable_f)(void);
+typedef void	(*XPluginDisable_f)(void);
+
+//Function prototypes
+void Usage();
+bool ParseHotKey(const char * name, char * outVirtualKey, XPLMKeyFlags * outFlags);
+void PrintDistribution(const char * name, vector<double> & milliseconds);
+
+
+
+int main(int argc, char *argv[]) {
+	if(argc < 2 || argv[1][0] == '-') {
+		Usage();
+		return 1;
+	}
+
+	const char *	pluginPath	= argv[1];
+	int				rate		= 60;
+	double			duration	= 10.0;
+	vector<const char *>	hotKeyNames;
+	vector<string>			commands;
+	vector<double>			commandTimes;
+	bool			realtime	= false;
+	const char *	writesPath	= NULL;
+	const char *	systemPath	= "./";
+	double			originLat	= 0.0;
+	double			originLon	= 0.0;
+	double			terrain		= 0.0;
+	double			hillHeight	= 0.0;
+	bool			verbose		= false;
+
+	for(int i = 2; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if(strcmp(argv[i], "--rate") == 0 && hasValue) {
+			rate = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--duration") == 0 && hasValue) {
+			duration = atof(argv[++i]);
+		} else if(strcmp(argv[i], "--hotkey") == 0 && hasValue) {
+			char			hotKey;
+			XPLMKeyFlags	flags;
+			hotKeyNames.push_back(argv[++i]);
+			if(!ParseHotKey(hotKeyNames.back(), &hotKey, &flags)) {
+				cerr << "Unknown hot key " << hotKeyNames.back() << endl;
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--command") == 0 && hasValue) {
+			string command = argv[++i];
+			size_t at = command.find('@');
+			commandTimes.push_back((at != string::npos) ? atof(command.c_str() + at + 1) : 0.0);
+			commands.push_back(command.substr(0, at));
+		} else if(strcmp(argv[i], "--realtime") == 0) {
+			realtime = true;
+		} else if(strcmp(argv[i], "--writes") == 0 && hasValue) {
+			writesPath = argv[++i];
+		} else if(strcmp(argv[i], "--system-path") == 0 && hasValue) {
+			systemPath = argv[++i];
+		} else if(strcmp(argv[i], "--origin") == 0 && hasValue) {
+			if(sscanf(argv[++i], "%lf,%lf", &originLat, &originLon) != 2) {
+				cerr << "--origin takes LAT,LON" << endl;
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--terrain") == 0 && hasValue) {
+			if(sscanf(argv[++i], "%lf,%lf", &terrain, &hillHeight) < 1) {
+				cerr << "--terrain takes M or M,H" << endl;
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--verbose") == 0) {
+			verbose = true;
+		} else {
+			Usage();
+			return 1;
+		}
+	}
+
+	if(rate < MIN_RATE || rate > MAX_RATE) {
+		cerr << "--rate must be between " << MIN_RATE << " and " << MAX_RATE << endl;
+		return 1;
+	}
+	if(duration * rate < 1.0) {
+		cerr << "--duration must be at least one frame" << endl;
+		return 1;
+	}
+
+	//the stand-in has to be ready before the plugin looks up its datarefs in XPluginStart
+	XPLMStandInReset();
+	XPLMStandInAddStandardDataRefs();
+	XPLMStandInSetSystemPath(systemPath);
+	XPLMStandInSetLocalOrigin(originLat, originLon);
+	XPLMStandInSetTerrain(terrain, hillHeight);
+	XPLMStandInSetQuiet(!verbose);
+
+	void * plugin = dlopen(pluginPath, RTLD_NOW | RTLD_LOCAL);
+	if(plugin == NULL) {
+		cerr << "Could not load " << pluginPath << ": " << dlerror() << endl;
+		return 1;
+	}
+
+	XPluginStart_f		pluginStart		= (XPluginStart_f)dlsym(plugin, "XPluginStart");
+	XPluginStop_f		pluginStop		= (XPluginStop_f)dlsym(plugin, "XPluginStop");
+	XPluginEnable_f		pluginEnable	= (XPluginEnable_f)dlsym(plugin, "XPluginEnable");
+	XPluginDisable_f	pluginDisable	= (XPluginDisable_f)dlsym(plugin, "XPluginDisable");
+	if(pluginStart == NULL || pluginStop == NULL || pluginEnable == NULL || pluginDisable == NULL) {
+		cerr << pluginPath << " is not an X-Plane plugin" << endl;
+		return 1;
+	}
+
+	char name[256] = "";
+	char signature[256] = "";
+	char description[256] = "";
+	if(!pluginStart(name, signature, description)) {
+		cerr << name << ": XPluginStart failed" << endl;
+		return 1;
+	}
+	if(!pluginEnable()) {
+		cerr << name << ": XPluginEnable failed" << endl;
+		pluginStop();
+		return 1;
+	}
+
+	cout << "PluginHost: " << name << " (" << signature << "), " << rate << " Hz, " << duration << " s"
+		 << (realtime ? ", real time" : ", as fast as possible") << endl;
+
+	for(size_t i = 0; i < hotKeyNames.size(); i++) {
+		char			hotKey;
+		XPLMKeyFlags	flags;
+		ParseHotKey(hotKeyNames[i], &hotKey, &flags);
+		if(XPLMStandInPressHotKey(hotKey, flags) == 0) {
+			cerr << "The plugin has no hot key " << hotKeyNames[i] << endl;
+		}
+	}
+
+	//run the frames
+	XPLMStandInResetStats();
+	XPLMStandInClearWrites();
+	XPLMStandInRecordWrites(true);
+
+	int						numFrames		= (int)(duration * rate + 0.5);
+	double					frameSeconds	= 1.0 / rate;
+	vector<double>			totalTimes;
+	vector<double>			flightLoopTimes;
+	vector<double>			drawTimes;
+	vector<double>			sceneTimes;
+	XPLMStandInFrameTimes	times;
+
+	totalTimes.reserve(numFrames);
+	flightLoopTimes.reserve(numFrames);
+	sceneTimes.reserve(numFrames);
+	drawTimes.reserve(numFrames);
+
+	chrono::steady_clock::time_point nextFrame = chrono::steady_clock::now();
+	for(int frame = 0; frame < numFrames; frame++) {
+		if(realtime) {
+			nextFrame += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(frameSeconds));
+			this_thread::sleep_until(nextFrame);
+		}
+
+		for(size_t i = 0; i < commands.size(); i++) {
+			if(commandTimes[i] >= frame * frameSeconds && commandTimes[i] < (frame + 1) * frameSeconds) {
+				if(XPLMStandInRunCommand(commands[i].c_str()) < 0) {
+					cerr << "The plugin has no command " << commands[i] << endl;
+				}
+			}
+		}
+
+		XPLMStandInRunFrame(frameSeconds, &times);
+		totalTimes.push_back((times.flightLoopSeconds + times.cameraSeconds + times.sceneSeconds + times.drawSeconds) * 1000.0);
+		flightLoopTimes.push_back(times.flightLoopSeconds * 1000.0);
+		sceneTimes.push_back(times.sceneSeconds * 1000.0);
+		drawTimes.push_back(times.drawSeconds * 1000.0);
+	}
+
+	XPLMStandInRecordWrites(false);
+
+	//results
+	const XPLMStandInStats * stats = XPLMStandInGetStats();
+	int numWrites;
+	XPLMStandInGetWrites(&numWrites);
+
+	cout << endl << "Time in the plugin per frame (ms), budget " << frameSeconds * 1000.0 << endl;
+	PrintDistribution("total", totalTimes);
+	PrintDistribution("flight loop", flightLoopTimes);
+	PrintDistribution("scenery", sceneTimes);
+	PrintDistribution("windows", drawTimes);
+
+	cout << endl << numFrames << " frames, " << stats->flightLoopCalls << " flight loop calls, "
+		 << stats->cameraCalls << " camera calls, " << stats->drawCalls << " window draws" << endl;
+	if(stats->sceneDrawCalls > 0) {
+		cout << stats->sceneDrawCalls << " draw callback calls, " << stats->drawObjectsCalls << " XPLMDrawObjects calls, "
+			 << (double)stats->objectsDrawn / numFrames << " objects drawn per frame" << endl;
+	}
+	if(stats->aircraftModelsSet > 0) {
+		cout << stats->aircraftModelsSet << " aircraft models set" << endl;
+	}
+	if(stats->glVertices > 0) {
+		cout << (double)stats->glVertices / numFrames << " line vertices drawn per frame" << endl;
+	}
+	cout << numWrites << " dataref writes (" << (double)numWrites / numFrames << " per frame), "
+		 << stats->getScalar + stats->getArray << " dataref reads" << endl;
+
+	if(writesPath != NULL) {
+		if(XPLMStandInSaveWrites(writesPath)) {
+			cout << "Writes saved to " << writesPath << endl;
+		} else {
+			cerr << "Could not write " << writesPath << endl;
+		}
+	}
+
+	pluginDisable();
+	pluginStop();
+	dlclose(plugin);
+	return 0;
+}
+
+
+
+void Usage()
+{
+	cerr << "Usage: PluginHost plugin.xpl [--rate HZ] [--duration S] [--hotkey [Shift+]F1-F12]" << endl
+		 << "                  [--command NAME[@S]] [--realtime] [--writes FILE] [--system-path DIR]" << endl
+		 << "                  [--origin LAT,LON] [--terrain M[,H]] [--verbose]" << endl;
+}
+
+
+
+/*
+Turn "F1" to "F12", optionally prefixed with "Shift+", into the XPLM virtual key and the key flags to press it with
+*/
+bool ParseHotKey(const char * name, char * outVirtualKey, XPLMKeyFlags * outFlags)
+{
+	*outFlags = xplm_DownFlag;
+	if(strncmp(name, "Shift+", 6) == 0) {
+		*outFlags |= xplm_ShiftFlag;
+		name += 6;
+	}
+
+	if(name[0] != 'F' && name[0] != 'f') {
+		return false;
+	}
+
+	int number = atoi(name + 1);
+	if(number < 1 || number > 12) {
+		return false;
+	}
+
+	*outVirtualKey = (char)(XPLM_VK_F1 + number - 1);
+	return true;
+}
+
+
+
+void PrintDistribution(const char * name, vector<double> & milliseconds)
+{
+	if(milliseconds.empty()) {
+		return;
+	}
+
+	sort(milliseconds.begin(), milliseconds.end());
+	size_t count = milliseconds.size();
+	printf("  %-12s p50 %8.4f  p99 %8.4f  max %8.4f\n", name, milliseconds[count / 2],
+		   milliseconds[(count * 99) / 100], milliseconds[count - 1]);
+}
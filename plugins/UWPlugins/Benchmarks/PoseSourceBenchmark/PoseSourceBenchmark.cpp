@@ -0,0 +1,200 @@
+// PoseSourceBenchmark.cpp : Checks the TCP pose source of UWPoseSource.h against the XPLM stand-in, with a sender on
+// the loopback interface the way an external simulation connects.
+//
+//	PoseSourceBenchmark [port]
+//
+// Binary pose records are sent interleaved with dataref stream packets and text packets.  Every frame which is not a
+// pose must arrive, and every pose must arrive unless a newer pose is buffered behind it; with keepEveryRecord set
+// (epoch mode) every pose must arrive.  Returns 1 if any check fails.
+//
+
+#include <iostream>            // For cout and cerr
+#include <cstdlib>             // For atoi()
+#include <cstring>             // For memcpy()
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include "XPLMStandIn.h"
+#include "UWPoseSource.h"
+#include "UWDataRefStreamProtocol.h"
+
+using namespace std;
+
+#define TCP_PORT_BENCHMARK	49105
+#define NUM_POSES			3
+#define SETTLE_SECONDS		0.05		//for everything sent to be buffered by the receiving socket
+
+struct Received {
+	vector<unsigned int>	sequences;			//of the pose records, in the order they arrived
+	int						streamPackets;
+	int						textPackets;
+};
+
+//Function prototypes
+bool RunInterleaved(unsigned short port, bool keepEveryRecord, bool burst);
+void AppendFrame(vector<char> & stream, const char * payload, int length);
+void AppendRound(vector<char> & stream, unsigned int sequence);
+void Drain(UWPoseSource * source, Received * received);
+bool Check(bool condition, const char * what);
+
+int gFailures = 0;
+
+
+
+int main(int argc, char *argv[]) {
+	unsigned short port = (unsigned short)((argc > 1) ? atoi(argv[1]) : TCP_PORT_BENCHMARK);
+
+	cout << "PoseSourceBenchmark: TCP port " << port << ", " << NUM_POSES << " poses interleaved with other frames"
+		 << endl << endl;
+
+	XPLMStandInReset();
+	XPLMStandInSetQuiet(true);
+
+	try {
+		RunInterleaved(port, false, false);
+		RunInterleaved(port, false, true);
+		RunInterleaved(port, true, true);
+	} catch (SocketException &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	if(gFailures > 0) {
+		cout << endl << gFailures << " checks failed" << endl;
+		return 1;
+	}
+	cout << endl << "All checks passed" << endl;
+	return 0;
+}
+
+
+
+/*
+Send NUM_POSES rounds of a pose, a dataref stream packet and a text packet, either one round per drain or all of
+them at once so that they are buffered together, and check what the source returns
+*/
+bool RunInterleaved(unsigned short port, bool keepEveryRecord, bool burst)
+{
+	UWPoseSourceSettings settings;
+	memset(&settings, 0, sizeof(settings));
+	settings.kind				= uwSource_TCP;
+	settings.port				= port;
+	settings.keepEveryRecord	= keepEveryRecord;
+
+	UWPoseSource * source = new UWPoseSource;
+	UWSourceInit(source);
+	if(!UWSourceOpen(source, &settings)) {
+		delete source;
+		return Check(false, "the TCP source opens");
+	}
+
+	TCPSocket sender("127.0.0.1", port);
+	Received received;
+	received.streamPackets	= 0;
+	received.textPackets	= 0;
+
+	vector<char> stream;
+	for(unsigned int sequence = 1; sequence <= NUM_POSES; sequence++) {
+		AppendRound(stream, sequence);
+		if(!burst || sequence == NUM_POSES) {
+			sender.send(&stream[0], (int)stream.size());
+			stream.clear();
+			this_thread::sleep_for(chrono::duration<double>(SETTLE_SECONDS));
+			Drain(source, &received);
+		}
+	}
+
+	unsigned int skipped = source->skippedRecords;
+	UWSourceClose(source);
+	delete source;
+
+	bool passed = true;
+	passed &= Check(received.streamPackets == NUM_POSES && received.textPackets == NUM_POSES,
+					"every dataref stream packet and text packet arrives");
+	if(burst && !keepEveryRecord) {
+		passed &= Check(received.sequences.size() == 1 && received.sequences[0] == NUM_POSES &&
+						skipped == NUM_POSES - 1, "only the newest of the buffered poses arrives");
+	} else {
+		bool inOrder = received.sequences.size() == NUM_POSES;
+		for(size_t n = 0; inOrder && n < received.sequences.size(); n++) {
+			inOrder = received.sequences[n] == n + 1;
+		}
+		passed &= Check(inOrder && skipped == 0, "every pose arrives, in order");
+	}
+
+	cout << (burst ? "Buffered together" : "One round at a time") << (keepEveryRecord ? " (keepEveryRecord): " : ": ")
+		 << received.sequences.size() << " poses, " << skipped << " skipped, " << received.streamPackets
+		 << " stream packets, " << received.textPackets << " text packets: " << (passed ? "passed" : "FAILED") << endl;
+	return passed;
+}
+
+
+
+/*
+Append a length-prefixed frame (see UWFrameDecoder.h)
+*/
+void AppendFrame(vector<char> & stream, const char * payload, int length)
+{
+	char header[UW_FRAME_HEADER_SIZE];
+	UWFrameEncodeHeader(header, length);
+	stream.insert(stream.end(), header, header + UW_FRAME_HEADER_SIZE);
+	stream.insert(stream.end(), payload, payload + length);
+}
+
+
+
+/*
+Append a pose record followed by a dataref stream packet and a text packet
+*/
+void AppendRound(vector<char> & stream, unsigned int sequence)
+{
+	UWPoseRecord record;
+	memset(&record, 0, sizeof(record));
+	record.sequence		= sequence;
+	record.numWords		= 6;
+	record.timestamp	= sequence * 0.01;
+	char pose[UW_POSE_WIRE_MAX_SIZE];
+	AppendFrame(stream, pose, UWPoseEncode(&record, pose));
+
+	UWStreamPacketHeader header;
+	memcpy(header.magic, UW_STREAM_MAGIC, 4);
+	header.count	= 0;
+	header.reserved	= 0;
+	AppendFrame(stream, (const char *)&header, sizeof(header));
+
+	const char * text = "0.0 0.0 0.0 0.0 0.0 0.0";
+	AppendFrame(stream, text, (int)strlen(text));
+}
+
+
+
+/*
+Take everything waiting off the source, as the plugin's flight loop does
+*/
+void Drain(UWPoseSource * source, Received * received)
+{
+	UWSourceMessage * message = new UWSourceMessage;
+	UWSourceMessageKind kind;
+	while((kind = UWSourceReceive(source, message)) != uwMessage_None) {
+		if(kind == uwMessage_Record) {
+			received->sequences.push_back(message->record.sequence);
+		} else if(message->length >= 4 && memcmp(message->packet, UW_STREAM_MAGIC, 4) == 0) {
+			received->streamPackets++;
+		} else {
+			received->textPackets++;
+		}
+	}
+	delete message;
+}
+
+
+
+bool Check(bool condition, const char * what)
+{
+	if(!condition) {
+		cerr << "FAILED: " << what << endl;
+		gFailures++;
+	}
+	return condition;
+}
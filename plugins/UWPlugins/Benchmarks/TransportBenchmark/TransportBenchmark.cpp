@@ -0,0 +1,204 @@
+// TransportBenchmark.cpp : Compares UDP over loopback against a Unix domain datagram socket for local pose
+// injection.  Both transports go through PracticalSocket exactly as the plugins use it.
+//
+//	TransportBenchmark [numPackets] [packetSize]
+//
+// Latency is measured with a ping-pong between two threads (one way = round trip / 2).  CPU per packet is
+// measured in one thread which sends a burst and then drains the non-blocking receiving socket the way the
+// plugin's flight loop does.
+//
+
+#include <iostream>            // For cout and cerr
+#include <cstdlib>             // For atoi()
+#include <cstring>             // For memset()
+#include <vector>
+#include <algorithm>           // For sort()
+#include <thread>
+#include <chrono>
+#include <time.h>              // For clock_gettime()
+
+#include "PracticalSocket.h"   // For UDPSocket, UnixDatagramSocket and SocketException
+
+using namespace std;
+
+#define UDP_PORT_BENCHMARK	49103
+#define UNIX_PATH_SERVER	"/tmp/UWTransportBenchmark.server"
+#define UNIX_PATH_CLIENT	"/tmp/UWTransportBenchmark.client"
+#define BURST_LENGTH		8			//packets sent before each drain in the CPU test (Linux queues at most 10
+									//datagrams on a Unix socket by default, after which the sender blocks)
+#define MAX_PACKET			4096
+#define QUIT_PACKET_LENGTH	1			//tells the echo thread to stop
+
+/*
+The two ends of one transport.  The server end is the plugin, the client end is the external simulation.
+*/
+class BenchmarkTransport {
+public:
+	virtual ~BenchmarkTransport() {}
+	virtual const char * name() = 0;
+	virtual void sendToServer(const char * buffer, int length) = 0;
+	virtual int recvAtServer(char * buffer, int length) = 0;		//-1 if non-blocking and nothing is waiting
+	virtual void replyToClient(const char * buffer, int length) = 0;	//to the sender of the last recvAtServer
+	virtual int recvAtClient(char * buffer, int length) = 0;
+	virtual void setServerBlocking(bool blocking) = 0;
+};
+
+class UDPTransport : public BenchmarkTransport {
+public:
+	UDPTransport() : server(UDP_PORT_BENCHMARK), sourcePort(0) {}
+	const char * name() { return "UDP loopback"; }
+	void sendToServer(const char * buffer, int length) { client.sendTo(buffer, length, "127.0.0.1", UDP_PORT_BENCHMARK); }
+	int recvAtServer(char * buffer, int length) { return server.recvFrom(buffer, length, sourceAddress, sourcePort); }
+	void replyToClient(const char * buffer, int length) { server.sendTo(buffer, length, sourceAddress, sourcePort); }
+	int recvAtClient(char * buffer, int length) { string a; unsigned short p; return client.recvFrom(buffer, length, a, p); }
+	void setServerBlocking(bool blocking) { server.setBlocking(blocking); }
+
+private:
+	UDPSocket		server;
+	UDPSocket		client;
+	string			sourceAddress;
+	unsigned short	sourcePort;
+};
+
+class UnixTransport : public BenchmarkTransport {
+public:
+	UnixTransport() : server(UNIX_PATH_SERVER), client(UNIX_PATH_CLIENT) {}
+	const char * name() { return "Unix datagram"; }
+	void sendToServer(const char * buffer, int length) { client.sendTo(buffer, length, UNIX_PATH_SERVER); }
+	int recvAtServer(char * buffer, int length) { return server.recvFrom(buffer, length, sourcePath); }
+	void replyToClient(const char * buffer, int length) { server.sendTo(buffer, length, sourcePath); }
+	int recvAtClient(char * buffer, int length) { string p; return client.recvFrom(buffer, length, p); }
+	void setServerBlocking(bool blocking) { server.setBlocking(blocking); }
+
+private:
+	UnixDatagramSocket	server;
+	UnixDatagramSocket	client;
+	string				sourcePath;
+};
+
+//Function prototypes
+void RunTransport(BenchmarkTransport * transport, int numPackets, int packetSize);
+void MeasureLatency(BenchmarkTransport * transport, int numPackets, int packetSize);
+void MeasureCPU(BenchmarkTransport * transport, int numPackets, int packetSize);
+double ThreadCPUSeconds();
+
+
+
+int main(int argc, char *argv[]) {
+	int numPackets	= (argc > 1) ? atoi(argv[1]) : 100000;
+	int packetSize	= (argc > 2) ? atoi(argv[2]) : 64;		//a text pose packet is about 64 bytes
+
+	if(packetSize < 2) {
+		packetSize = 2;
+	} else if(packetSize > MAX_PACKET) {
+		packetSize = MAX_PACKET;
+	}
+
+	cout << "TransportBenchmark: " << numPackets << " packets of " << packetSize << " bytes" << endl << endl;
+
+	try {
+		UDPTransport udp;
+		RunTransport(&udp, numPackets, packetSize);
+
+		UnixTransport unixDatagram;
+		RunTransport(&unixDatagram, numPackets, packetSize);
+
+	} catch (SocketException &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+
+
+void RunTransport(BenchmarkTransport * transport, int numPackets, int packetSize)
+{
+	cout << transport->name() << endl;
+	MeasureLatency(transport, numPackets, packetSize);
+	MeasureCPU(transport, numPackets, packetSize);
+	cout << endl;
+}
+
+
+
+/*
+Ping-pong between this thread (the sender) and an echo thread (the plugin) with blocking sockets
+*/
+void MeasureLatency(BenchmarkTransport * transport, int numPackets, int packetSize)
+{
+	transport->setServerBlocking(true);
+
+	thread echo([transport]() {
+		char buffer[MAX_PACKET];
+		int length;
+		while((length = transport->recvAtServer(buffer, MAX_PACKET)) != QUIT_PACKET_LENGTH) {
+			transport->replyToClient(buffer, length);
+		}
+	});
+
+	char packet[MAX_PACKET];
+	memset(packet, 'x', packetSize);
+
+	vector<double> oneWay(numPackets);
+	for(int i = 0; i < numPackets; i++) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		transport->sendToServer(packet, packetSize);
+		transport->recvAtClient(packet, MAX_PACKET);
+		chrono::duration<double, micro> roundTrip = chrono::steady_clock::now() - start;
+		oneWay[i] = roundTrip.count() / 2.0;
+	}
+
+	transport->sendToServer(packet, QUIT_PACKET_LENGTH);
+	echo.join();
+
+	sort(oneWay.begin(), oneWay.end());
+	cout << "  one way latency (us):   p50 " << oneWay[numPackets / 2]
+		 << "  p99 " << oneWay[(int)(numPackets * 0.99)]
+		 << "  max " << oneWay[numPackets - 1] << endl;
+}
+
+
+
+/*
+Send a burst, then drain the non-blocking server socket until it reports nothing waiting, like the flight loop
+*/
+void MeasureCPU(BenchmarkTransport * transport, int numPackets, int packetSize)
+{
+	transport->setServerBlocking(false);
+
+	char packet[MAX_PACKET];
+	memset(packet, 'x', packetSize);
+
+	long long received = 0;
+	double cpuStart = ThreadCPUSeconds();
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	for(int sent = 0; sent < numPackets; sent += BURST_LENGTH) {
+		for(int i = 0; i < BURST_LENGTH; i++) {
+			transport->sendToServer(packet, packetSize);
+		}
+		while(transport->recvAtServer(packet, MAX_PACKET) >= 0) {
+			received++;
+		}
+	}
+
+	double cpuSeconds = ThreadCPUSeconds() - cpuStart;
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	if(received == 0) {
+		received = 1;
+	}
+	cout << "  CPU per packet (ns):    " << cpuSeconds * 1e9 / received << "  (send + receive, "
+		 << received << " received, " << elapsed.count() * 1e9 / received << " ns wall)" << endl;
+}
+
+
+
+double ThreadCPUSeconds()
+{
+	timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
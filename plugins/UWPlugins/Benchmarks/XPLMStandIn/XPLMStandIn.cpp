@@ -0,0 +1,508 @@
+/*
+XPLMStandIn.cpp
+
+See XPLMStandIn.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "XPLMDataAccess.h"
+#include "XPLMStandInPrivate.h"
+
+using namespace std;
+
+//----------------------------GLOBAL VARIALBES----------------------------------------
+struct StandInDataRef {
+	string			name;
+	XPLMDataTypeID	types;
+	double			scalar;
+	vector<float>	floats;
+	vector<int>		ints;
+
+	//set for datarefs registered with XPLMRegisterDataAccessor (scalars only)
+	XPLMGetDatai_f	readInt;
+	XPLMSetDatai_f	writeInt;
+	XPLMGetDataf_f	readFloat;
+	XPLMSetDataf_f	writeFloat;
+	XPLMGetDatad_f	readDouble;
+	XPLMSetDatad_f	writeDouble;
+	void *			readRefcon;
+	void *			writeRefcon;
+};
+
+XPLMStandInStats				gStandInStats;
+
+static vector<StandInDataRef *>	sDataRefs;
+static long long				sCallCostNanoseconds = 0;
+static bool						sRecordWrites = false;
+static vector<XPLMStandInWrite>	sWrites;
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Spin for the configured per-call cost (models the time spent inside X-Plane)
+*/
+static void SpendCallCost()
+{
+	if(sCallCostNanoseconds <= 0) {
+		return;
+	}
+
+	chrono::steady_clock::time_point end = chrono::steady_clock::now() + chrono::nanoseconds(sCallCostNanoseconds);
+	while(chrono::steady_clock::now() < end) {
+	}
+}
+
+
+
+/*
+Keep a write in the log if writes are being recorded
+*/
+static void RecordWrite(const StandInDataRef * dataRef, int index, double value)
+{
+	if(!sRecordWrites) {
+		return;
+	}
+
+	XPLMStandInWrite write;
+	write.frame		= gStandInFrame;
+	write.simTime	= gStandInSimTime;
+	write.wallTime	= chrono::duration<double>(chrono::system_clock::now().time_since_epoch()).count();
+	write.dataRef	= dataRef->name.c_str();
+	write.index		= index;
+	write.value		= value;
+	sWrites.push_back(write);
+}
+
+
+
+/*
+Remove all datarefs, windows, hot keys and flight loop callbacks, and clear the statistics and recorded writes
+*/
+void XPLMStandInReset()
+{
+	for(size_t i = 0; i < sDataRefs.size(); i++) {
+		delete sDataRefs[i];
+	}
+	sDataRefs.clear();
+	sWrites.clear();
+	XPLMStandInResetStats();
+	XPLMStandInResetSim();
+}
+
+
+
+/*
+Add a dataref which XPLMFindDataRef can find.  Array datarefs get arraySize elements.
+*/
+XPLMDataRef XPLMStandInAddDataRef(const char * name, XPLMDataTypeID types, int arraySize)
+{
+	StandInDataRef * dataRef = new StandInDataRef;
+	dataRef->readInt		= NULL;
+	dataRef->writeInt		= NULL;
+	dataRef->readFloat		= NULL;
+	dataRef->writeFloat		= NULL;
+	dataRef->readDouble		= NULL;
+	dataRef->writeDouble	= NULL;
+	dataRef->readRefcon		= NULL;
+	dataRef->writeRefcon	= NULL;
+	dataRef->name	= name;
+	dataRef->types	= types;
+	dataRef->scalar	= 0.0;
+	if(types & xplmType_FloatArray) {
+		dataRef->floats.resize(arraySize);
+	}
+	if(types & xplmType_IntArray) {
+		dataRef->ints.resize(arraySize);
+	}
+
+	sDataRefs.push_back(dataRef);
+	return dataRef;
+}
+
+
+
+/*
+Add the sim datarefs the UW plugins use, with the types X-Plane gives them
+*/
+void XPLMStandInAddStandardDataRefs()
+{
+	XPLMStandInAddDataRef("sim/flightmodel/position/local_x",	xplmType_Double, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/local_y",	xplmType_Double, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/local_z",	xplmType_Double, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/lat_ref",	xplmType_Float, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/lon_ref",	xplmType_Float, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/theta",		xplmType_Float, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/phi",		xplmType_Float, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/psi",		xplmType_Float, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/latitude",	xplmType_Double, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/longitude",	xplmType_Double, 0);
+	XPLMStandInAddDataRef("sim/flightmodel/position/elevation",	xplmType_Double, 0);
+	XPLMStandInAddDataRef("sim/operation/override/override_planepath", xplmType_IntArray, 20);
+	XPLMSetDataf(XPLMStandInAddDataRef("sim/graphics/view/field_of_view_deg", xplmType_Float, 0), 60.0f);
+
+	//the multiplayer aircraft (plane 0 is the user's)
+	for(int plane = 1; plane < STANDIN_TOTAL_AIRCRAFT; plane++) {
+		const char * positions[] = { "x", "y", "z" };
+		const char * angles[] = { "the", "phi", "psi" };
+		char name[64];
+		for(int i = 0; i < 3; i++) {
+			sprintf(name, "sim/multiplayer/position/plane%d_%s", plane, positions[i]);
+			XPLMStandInAddDataRef(name, xplmType_Double, 0);
+			sprintf(name, "sim/multiplayer/position/plane%d_%s", plane, angles[i]);
+			XPLMStandInAddDataRef(name, xplmType_Float, 0);
+		}
+	}
+}
+
+
+
+void XPLMStandInSetCallCost(long long nanoseconds)
+{
+	sCallCostNanoseconds = nanoseconds;
+}
+
+
+
+const XPLMStandInStats * XPLMStandInGetStats()
+{
+	return &gStandInStats;
+}
+
+
+
+void XPLMStandInResetStats()
+{
+	memset(&gStandInStats, 0, sizeof(gStandInStats));
+}
+
+
+
+/*
+Start or stop recording every dataref write (see XPLMStandInGetWrites)
+*/
+void XPLMStandInRecordWrites(bool record)
+{
+	sRecordWrites = record;
+}
+
+
+
+const XPLMStandInWrite * XPLMStandInGetWrites(int * outCount)
+{
+	*outCount = (int)sWrites.size();
+	return sWrites.empty() ? NULL : &sWrites[0];
+}
+
+
+
+void XPLMStandInClearWrites()
+{
+	sWrites.clear();
+}
+
+
+
+/*
+Save the recorded writes as comma separated values, one write per line.  Returns false if the file can not be
+written.
+*/
+bool XPLMStandInSaveWrites(const char * fileName)
+{
+	FILE * file = fopen(fileName, "w");
+	if(file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "frame,sim_time,wall_time,dataref,index,value\n");
+	for(size_t i = 0; i < sWrites.size(); i++) {
+		const XPLMStandInWrite * write = &sWrites[i];
+		fprintf(file, "%d,%.6f,%.6f,%s,%d,%.9g\n", write->frame, write->simTime, write->wallTime, write->dataRef,
+				write->index, write->value);
+	}
+
+	fclose(file);
+	return true;
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM DATA ACCESS INTERFACE-------------------------
+XPLMDataRef XPLMFindDataRef(const char * inDataRefName)
+{
+	gStandInStats.findDataRef++;
+	for(size_t i = 0; i < sDataRefs.size(); i++) {
+		if(sDataRefs[i]->name == inDataRefName) {
+			return sDataRefs[i];
+		}
+	}
+	return NULL;
+}
+
+
+
+int XPLMCanWriteDataRef(XPLMDataRef inDataRef)
+{
+	return inDataRef != NULL;
+}
+
+
+
+int XPLMIsDataRefGood(XPLMDataRef inDataRef)
+{
+	return inDataRef != NULL;
+}
+
+
+
+XPLMDataTypeID XPLMGetDataRefTypes(XPLMDataRef inDataRef)
+{
+	return inDataRef ? ((StandInDataRef *)inDataRef)->types : xplmType_Unknown;
+}
+
+
+
+int XPLMGetDatai(XPLMDataRef inDataRef)
+{
+	gStandInStats.getScalar++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return 0;
+	}
+
+	StandInDataRef * dataRef = (StandInDataRef *)inDataRef;
+	if(dataRef->readInt != NULL) {
+		return dataRef->readInt(dataRef->readRefcon);
+	}
+	return (int)dataRef->scalar;
+}
+
+
+
+void XPLMSetDatai(XPLMDataRef inDataRef, int inValue)
+{
+	gStandInStats.setScalar++;
+	gStandInStats.valuesWritten++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return;
+	}
+
+	StandInDataRef * dataRef = (StandInDataRef *)inDataRef;
+	RecordWrite(dataRef, -1, inValue);
+	if(dataRef->writeInt != NULL) {
+		dataRef->writeInt(dataRef->writeRefcon, inValue);
+	} else {
+		dataRef->scalar = inValue;
+	}
+}
+
+
+
+float XPLMGetDataf(XPLMDataRef inDataRef)
+{
+	gStandInStats.getScalar++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return 0.0f;
+	}
+
+	StandInDataRef * dataRef = (StandInDataRef *)inDataRef;
+	if(dataRef->readFloat != NULL) {
+		return dataRef->readFloat(dataRef->readRefcon);
+	}
+	return (float)dataRef->scalar;
+}
+
+
+
+void XPLMSetDataf(XPLMDataRef inDataRef, float inValue)
+{
+	gStandInStats.setScalar++;
+	gStandInStats.valuesWritten++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return;
+	}
+
+	StandInDataRef * dataRef = (StandInDataRef *)inDataRef;
+	RecordWrite(dataRef, -1, inValue);
+	if(dataRef->writeFloat != NULL) {
+		dataRef->writeFloat(dataRef->writeRefcon, inValue);
+	} else {
+		dataRef->scalar = inValue;
+	}
+}
+
+
+
+double XPLMGetDatad(XPLMDataRef inDataRef)
+{
+	gStandInStats.getScalar++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return 0.0;
+	}
+
+	StandInDataRef * dataRef = (StandInDataRef *)inDataRef;
+	if(dataRef->readDouble != NULL) {
+		return dataRef->readDouble(dataRef->readRefcon);
+	}
+	return dataRef->scalar;
+}
+
+
+
+void XPLMSetDatad(XPLMDataRef inDataRef, double inValue)
+{
+	gStandInStats.setScalar++;
+	gStandInStats.valuesWritten++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return;
+	}
+
+	StandInDataRef * dataRef = (StandInDataRef *)inDataRef;
+	RecordWrite(dataRef, -1, inValue);
+	if(dataRef->writeDouble != NULL) {
+		dataRef->writeDouble(dataRef->writeRefcon, inValue);
+	} else {
+		dataRef->scalar = inValue;
+	}
+}
+
+
+
+int XPLMGetDatavi(XPLMDataRef inDataRef, int * outValues, int inOffset, int inMax)
+{
+	gStandInStats.getArray++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return 0;
+	}
+
+	vector<int> & ints = ((StandInDataRef *)inDataRef)->ints;
+	if(outValues == NULL) {
+		return (int)ints.size();
+	}
+
+	int count = 0;
+	for(int i = inOffset; i < (int)ints.size() && count < inMax; i++) {
+		outValues[count++] = ints[i];
+	}
+	return count;
+}
+
+
+
+void XPLMSetDatavi(XPLMDataRef inDataRef, int * inValues, int inOffset, int inCount)
+{
+	gStandInStats.setArray++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return;
+	}
+
+	vector<int> & ints = ((StandInDataRef *)inDataRef)->ints;
+	for(int i = 0; i < inCount && inOffset + i < (int)ints.size(); i++) {
+		ints[inOffset + i] = inValues[i];
+		gStandInStats.valuesWritten++;
+		RecordWrite((StandInDataRef *)inDataRef, inOffset + i, inValues[i]);
+	}
+}
+
+
+
+int XPLMGetDatavf(XPLMDataRef inDataRef, float * outValues, int inOffset, int inMax)
+{
+	gStandInStats.getArray++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return 0;
+	}
+
+	vector<float> & floats = ((StandInDataRef *)inDataRef)->floats;
+	if(outValues == NULL) {
+		return (int)floats.size();
+	}
+
+	int count = 0;
+	for(int i = inOffset; i < (int)floats.size() && count < inMax; i++) {
+		outValues[count++] = floats[i];
+	}
+	return count;
+}
+
+
+
+void XPLMSetDatavf(XPLMDataRef inDataRef, float * inValues, int inOffset, int inCount)
+{
+	gStandInStats.setArray++;
+	SpendCallCost();
+	if(inDataRef == NULL) {
+		return;
+	}
+
+	vector<float> & floats = ((StandInDataRef *)inDataRef)->floats;
+	for(int i = 0; i < inCount && inOffset + i < (int)floats.size(); i++) {
+		floats[inOffset + i] = inValues[i];
+		gStandInStats.valuesWritten++;
+		RecordWrite((StandInDataRef *)inDataRef, inOffset + i, inValues[i]);
+	}
+}
+
+
+
+/*
+Datarefs provided by a plugin.  Only the scalar accessors are supported.
+*/
+XPLMDataRef XPLMRegisterDataAccessor(
+						const char *		inDataName,
+						XPLMDataTypeID		inDataType,
+						int					inIsWritable,
+						XPLMGetDatai_f		inReadInt,
+						XPLMSetDatai_f		inWriteInt,
+						XPLMGetDataf_f		inReadFloat,
+						XPLMSetDataf_f		inWriteFloat,
+						XPLMGetDatad_f		inReadDouble,
+						XPLMSetDatad_f		inWriteDouble,
+						XPLMGetDatavi_f		inReadIntArray,
+						XPLMSetDatavi_f		inWriteIntArray,
+						XPLMGetDatavf_f		inReadFloatArray,
+						XPLMSetDatavf_f		inWriteFloatArray,
+						XPLMGetDatab_f		inReadData,
+						XPLMSetDatab_f		inWriteData,
+						void *				inReadRefcon,
+						void *				inWriteRefcon)
+{
+	StandInDataRef * dataRef = (StandInDataRef *)XPLMStandInAddDataRef(inDataName, inDataType, 0);
+	dataRef->readInt		= inReadInt;
+	dataRef->readFloat		= inReadFloat;
+	dataRef->readDouble		= inReadDouble;
+	dataRef->readRefcon		= inReadRefcon;
+	if(inIsWritable) {
+		dataRef->writeInt		= inWriteInt;
+		dataRef->writeFloat		= inWriteFloat;
+		dataRef->writeDouble	= inWriteDouble;
+		dataRef->writeRefcon	= inWriteRefcon;
+	}
+	return dataRef;
+}
+
+
+
+void XPLMUnregisterDataAccessor(XPLMDataRef inDataRef)
+{
+	for(size_t i = 0; i < sDataRefs.size(); i++) {
+		if(sDataRefs[i] == inDataRef) {
+			delete sDataRefs[i];
+			sDataRefs.erase(sDataRefs.begin() + i);
+			return;
+		}
+	}
+}
@@ -0,0 +1,107 @@
+/*
+XPLMStandIn.h
+
+A stand-in for the parts of the XPLM library used by the UW plugins, so plugin code can be run and benchmarked in
+a plain process without X-Plane.  Datarefs live in memory and every XPLM call is counted.
+
+Datarefs must be added with XPLMStandInAddDataRef (or XPLMStandInAddStandardDataRefs for the sim datarefs the UW
+plugins use) before XPLMFindDataRef can find them.  An optional per-call cost can be set to model the time it takes
+to call into X-Plane.  Every write to a dataref can be recorded with the frame and time it happened in.
+
+Besides data access the stand-in implements the flight loop, window, hot key, command, menu, camera, graphics,
+terrain probe, object, multiplayer aircraft, navigation and utility calls the plugins make, and the few immediate
+mode OpenGL calls they draw lines with.  Nothing is drawn; instead the host drives the simulation one frame at a
+time with XPLMStandInRunFrame, which
+
+	1. advances the simulated time (XPLMGetElapsedTime) by the frame time and completes the objects loaded with
+	   XPLMLoadObjectAsync during the previous frame
+	2. calls every flight loop callback which is due
+	3. calls the camera control function (if a plugin controls the camera)
+	4. calls the draw callbacks registered with XPLMRegisterDrawCallback (every phase, in order of registration)
+	5. calls the draw callback of every visible window
+
+so a plugin is driven exactly as X-Plane would drive it.  See Benchmarks/PluginHost for a host which loads a
+plugin built for Linux and runs it at 60-240 Hz.
+*/
+
+#ifndef _XPLMStandIn_h_
+#define _XPLMStandIn_h_
+
+#include "XPLMDataAccess.h"
+#include "XPLMDefs.h"
+
+struct XPLMStandInStats {
+	long long	findDataRef;			//XPLMFindDataRef calls
+	long long	getScalar;				//XPLMGetDatai/f/d calls
+	long long	setScalar;				//XPLMSetDatai/f/d calls
+	long long	getArray;				//XPLMGetDatavi/vf calls
+	long long	setArray;				//XPLMSetDatavi/vf calls
+	long long	valuesWritten;			//number of scalar values and array elements written
+	long long	flightLoopCalls;		//flight loop callbacks called by XPLMStandInRunFrame
+	long long	cameraCalls;			//camera control function calls
+	long long	drawCalls;				//window draw callback calls
+	long long	sceneDrawCalls;			//XPLMRegisterDrawCallback callback calls
+	long long	drawObjectsCalls;		//XPLMDrawObjects calls
+	long long	objectsDrawn;			//instances drawn by XPLMDrawObjects
+	long long	aircraftModelsSet;		//XPLMSetAircraftModel calls
+	long long	navaidInfoCalls;		//XPLMGetNavAidInfo calls
+	long long	drawStrings;			//XPLMDrawString calls
+	long long	glVertices;				//glVertex2f calls (lines drawn by the plugins)
+	long long	worldToLocal;			//XPLMWorldToLocal calls
+	long long	terrainProbes;			//XPLMProbeTerrainXYZ calls
+	long long	debugStrings;			//XPLMDebugString calls
+};
+
+struct XPLMStandInWrite {
+	int				frame;				//XPLMGetCycleNumber when written
+	double			simTime;			//XPLMGetElapsedTime when written
+	double			wallTime;			//system clock seconds since 1970 (to compare with sender time stamps)
+	const char *	dataRef;			//name of the dataref (valid until XPLMStandInReset)
+	int				index;				//array element, or -1 for a scalar
+	double			value;
+};
+
+struct XPLMStandInFrameTimes {
+	double		flightLoopSeconds;		//spent in flight loop callbacks
+	double		cameraSeconds;			//spent in the camera control function
+	double		sceneSeconds;			//spent in the XPLMRegisterDrawCallback callbacks
+	double		drawSeconds;			//spent in window draw callbacks
+};
+
+
+
+void						XPLMStandInReset();
+
+XPLMDataRef					XPLMStandInAddDataRef(const char * name, XPLMDataTypeID types, int arraySize);
+
+void						XPLMStandInAddStandardDataRefs();
+
+void						XPLMStandInSetCallCost(long long nanoseconds);
+
+const XPLMStandInStats *	XPLMStandInGetStats();
+
+void						XPLMStandInResetStats();
+
+void						XPLMStandInRecordWrites(bool record);
+
+const XPLMStandInWrite *	XPLMStandInGetWrites(int * outCount);
+
+void						XPLMStandInClearWrites();
+
+bool						XPLMStandInSaveWrites(const char * fileName);
+
+void						XPLMStandInRunFrame(double frameSeconds, XPLMStandInFrameTimes * outTimes);
+
+int							XPLMStandInPressHotKey(char virtualKey, XPLMKeyFlags flags);
+
+int							XPLMStandInRunCommand(const char * name);
+
+void						XPLMStandInSetSystemPath(const char * systemPath);
+
+void						XPLMStandInSetLocalOrigin(double latitudeDeg, double longitudeDeg);
+
+void						XPLMStandInSetTerrain(double elevation, double hillHeight);
+
+void						XPLMStandInSetQuiet(bool quiet);
+
+#endif
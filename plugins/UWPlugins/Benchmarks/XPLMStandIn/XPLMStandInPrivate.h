@@ -0,0 +1,21 @@
+/*
+XPLMStandInPrivate.h
+
+State shared between the parts of the XPLM stand-in (see XPLMStandIn.h).  Not for use by hosts or plugins.
+*/
+
+#ifndef _XPLMStandInPrivate_h_
+#define _XPLMStandInPrivate_h_
+
+#include "XPLMStandIn.h"
+
+#define STANDIN_TOTAL_AIRCRAFT		20				//multiplayer aircraft, counting the user's
+
+extern XPLMStandInStats		gStandInStats;
+extern int					gStandInFrame;			//frames run by XPLMStandInRunFrame
+extern double				gStandInSimTime;		//seconds simulated by XPLMStandInRunFrame
+extern bool					gStandInQuiet;			//XPLMDebugString prints nothing
+
+void						XPLMStandInResetSim();
+
+#endif
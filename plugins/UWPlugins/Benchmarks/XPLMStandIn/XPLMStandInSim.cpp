@@ -0,0 +1,1290 @@
+/*
+XPLMStandInSim.cpp
+
+The simulation part of the XPLM stand-in: flight loops, windows, hot keys, the camera, graphics, navigation and
+utilities.  See XPLMStandIn.h
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <GL/gl.h>
+
+#include "XPLMCamera.h"
+#include "XPLMDisplay.h"
+#include "XPLMGraphics.h"
+#include "XPLMMenus.h"
+#include "XPLMNavigation.h"
+#include "XPLMPlanes.h"
+#include "XPLMProcessing.h"
+#include "XPLMScenery.h"
+#include "XPLMUtilities.h"
+#include "XPLMStandInPrivate.h"
+
+using namespace std;
+
+#define EARTH_RADIUS				6378137.0				//meters (flat earth about the local origin)
+#define DEGREES_TO_RADIANS			(3.14159265358979323846 / 180.0)
+#define STANDIN_NAVAIDS_NEAR_ORIGIN	2.0						//degrees about the local origin a third of the navaids are in
+#define HILL_WAVELENGTH				500.0					//meters between the tops of the stand-in terrain's hills
+
+//----------------------------GLOBAL VARIALBES----------------------------------------
+struct StandInFlightLoop {
+	XPLMFlightLoop_f	callback;
+	void *				refcon;
+	double				nextTime;			//simulated time the callback is due (interval in seconds)
+	int					nextFrame;			//frame the callback is due (interval in frames), -1 if timed
+	bool				scheduled;			//false after an interval of 0
+	double				lastCallTime;
+	bool				removed;			//unregistered while the flight loops were running
+};
+
+struct StandInWindow {
+	int					left;
+	int					top;
+	int					right;
+	int					bottom;
+	int					visible;
+	XPLMDrawWindow_f	draw;
+	void *				refcon;
+	bool				removed;			//destroyed while the windows were being drawn
+};
+
+struct StandInDrawCallback {
+	XPLMDrawCallback_f	callback;
+	XPLMDrawingPhase	phase;
+	int					before;
+	void *				refcon;
+	bool				removed;			//unregistered while the draw callbacks were being called
+};
+
+struct StandInObjectLoad {
+	string				path;
+	XPLMObjectLoaded_f	callback;
+	void *				refcon;
+};
+
+struct StandInNavaid {
+	XPLMNavType			type;
+	float				latitude;
+	float				longitude;
+	int					frequency;
+	char				id[8];
+};
+
+struct StandInHotKey {
+	char				virtualKey;
+	XPLMKeyFlags		flags;
+	XPLMHotKey_f		callback;
+	void *				refcon;
+};
+
+struct StandInCommandHandler {
+	XPLMCommandCallback_f	callback;
+	int					before;
+	void *				refcon;
+};
+
+struct StandInCommand {
+	string				name;
+	string				description;
+	vector<StandInCommandHandler>	handlers;
+};
+
+struct StandInMenu {
+	string				name;
+	XPLMMenuHandler_f	handler;
+	void *				menuRef;
+	vector<string>		items;				//names of the items (empty for separators)
+	vector<void *>		itemRefs;
+};
+
+int									gStandInFrame		= 0;
+double								gStandInSimTime		= 0.0;
+bool								gStandInQuiet		= false;
+
+static vector<StandInFlightLoop *>	sFlightLoops;
+static vector<StandInWindow *>		sWindows;
+static vector<StandInHotKey *>		sHotKeys;
+static vector<StandInDrawCallback *>	sDrawCallbacks;
+static vector<StandInCommand *>		sCommands;
+static vector<StandInMenu *>		sMenus;				//made with XPLMCreateMenu
+static StandInMenu					sPluginsMenu;
+static vector<StandInObjectLoad>	sObjectLoads;		//completed at the start of the next frame
+static bool							sRunningFrame		= false;	//flight loops or windows are being iterated
+
+static XPLMCameraControl_f			sCameraControl		= NULL;
+static void *						sCameraRefcon		= NULL;
+static XPLMCameraControlDuration	sCameraDuration		= 0;
+static XPLMCameraPosition_t			sCameraPosition;
+
+static string						sSystemPath			= "./";
+static double						sOriginLatitude		= 0.0;
+static double						sOriginLongitude	= 0.0;
+static double						sTerrainElevation	= 0.0;
+static double						sTerrainHillHeight	= 0.0;
+
+static bool							sPlanesAcquired		= false;
+static int							sActiveAircraft		= 1;
+static XPLMPlanesAvailable_f		sPlanesAvailable	= NULL;		//waiting for the planes to be released
+static void *						sPlanesRefcon		= NULL;
+
+static vector<StandInNavaid>		sNavaids;			//made on first use, like-typed navaids next to each other
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+static double Seconds(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+
+/*
+Set when a flight loop callback is next due.  Positive intervals are seconds, negative intervals are frames and
+0 stops the callback.
+*/
+static void ScheduleFlightLoop(StandInFlightLoop * loop, float interval)
+{
+	loop->scheduled = interval != 0.0f;
+	if(interval > 0.0f) {
+		loop->nextTime	= gStandInSimTime + interval;
+		loop->nextFrame	= -1;
+	} else if(interval < 0.0f) {
+		loop->nextFrame	= gStandInFrame + (int)floor(-interval + 0.5);
+	}
+}
+
+
+
+static bool IsFlightLoopDue(const StandInFlightLoop * loop)
+{
+	if(!loop->scheduled || loop->removed) {
+		return false;
+	}
+	if(loop->nextFrame >= 0) {
+		return gStandInFrame >= loop->nextFrame;
+	}
+	return gStandInSimTime >= loop->nextTime - 1e-9;
+}
+
+
+
+static StandInFlightLoop * FindFlightLoop(XPLMFlightLoop_f callback, void * refcon)
+{
+	for(size_t i = 0; i < sFlightLoops.size(); i++) {
+		StandInFlightLoop * loop = sFlightLoops[i];
+		if(loop->callback == callback && loop->refcon == refcon && !loop->removed) {
+			return loop;
+		}
+	}
+	return NULL;
+}
+
+
+
+/*
+Delete the flight loops, windows and draw callbacks which were removed while XPLMStandInRunFrame was iterating over them
+*/
+static void PurgeRemoved()
+{
+	for(size_t i = 0; i < sFlightLoops.size(); ) {
+		if(sFlightLoops[i]->removed) {
+			delete sFlightLoops[i];
+			sFlightLoops.erase(sFlightLoops.begin() + i);
+		} else {
+			i++;
+		}
+	}
+
+	for(size_t i = 0; i < sWindows.size(); ) {
+		if(sWindows[i]->removed) {
+			delete sWindows[i];
+			sWindows.erase(sWindows.begin() + i);
+		} else {
+			i++;
+		}
+	}
+
+	for(size_t i = 0; i < sDrawCallbacks.size(); ) {
+		if(sDrawCallbacks[i]->removed) {
+			delete sDrawCallbacks[i];
+			sDrawCallbacks.erase(sDrawCallbacks.begin() + i);
+		} else {
+			i++;
+		}
+	}
+}
+
+
+
+/*
+A made up navaid database about as big as X-Plane's, in order of type: 5000 airports, 3000 NDBs, 4000 VORs, 2000
+ILSs, 1000 DMEs and 15000 fixes.  Every third navaid is within STANDIN_NAVAIDS_NEAR_ORIGIN degrees of the local
+origin (so the plugins find some near the streamed position); the others are spread over the world.  The same
+origin always gives the same database.
+*/
+static void MakeNavaids()
+{
+	static const XPLMNavType	types[]	= { xplm_Nav_Airport, xplm_Nav_NDB, xplm_Nav_VOR, xplm_Nav_ILS, xplm_Nav_DME,
+											xplm_Nav_Fix };
+	static const int			counts[]	= { 5000, 3000, 4000, 2000, 1000, 15000 };
+
+	unsigned int seed = 12345;
+	for(int t = 0; t < (int)(sizeof(counts) / sizeof(counts[0])); t++) {
+		for(int i = 0; i < counts[t]; i++) {
+			double random[2];
+			for(int j = 0; j < 2; j++) {
+				seed = seed*1664525u + 1013904223u;
+				random[j] = (seed >> 8) / 16777216.0;
+			}
+
+			StandInNavaid navaid;
+			navaid.type = types[t];
+			if(sNavaids.size() % 3 == 0) {
+				navaid.latitude		= (float)(sOriginLatitude + STANDIN_NAVAIDS_NEAR_ORIGIN*(2.0*random[0] - 1.0));
+				navaid.longitude	= (float)(sOriginLongitude + STANDIN_NAVAIDS_NEAR_ORIGIN*(2.0*random[1] - 1.0));
+			} else {
+				navaid.latitude		= (float)(asin(2.0*random[0] - 1.0) / DEGREES_TO_RADIANS);
+				navaid.longitude	= (float)(360.0*random[1] - 180.0);
+			}
+			navaid.frequency	= (types[t] == xplm_Nav_NDB) ? 190 + i % 1500
+								: (types[t] & (xplm_Nav_VOR | xplm_Nav_ILS | xplm_Nav_DME)) ? 10800 + 5*(i % 400) : 0;
+			snprintf(navaid.id, sizeof(navaid.id), "%c%04d", "ANVIDF"[t], i % 10000);
+			sNavaids.push_back(navaid);
+		}
+	}
+}
+
+
+
+/*
+Remove all flight loops, windows, draw callbacks, hot keys, commands and menus, forget the objects being loaded,
+release the camera and start the simulated time over
+*/
+void XPLMStandInResetSim()
+{
+	for(size_t i = 0; i < sFlightLoops.size(); i++) {
+		delete sFlightLoops[i];
+	}
+	sFlightLoops.clear();
+
+	for(size_t i = 0; i < sWindows.size(); i++) {
+		delete sWindows[i];
+	}
+	sWindows.clear();
+
+	for(size_t i = 0; i < sHotKeys.size(); i++) {
+		delete sHotKeys[i];
+	}
+	sHotKeys.clear();
+
+	for(size_t i = 0; i < sDrawCallbacks.size(); i++) {
+		delete sDrawCallbacks[i];
+	}
+	sDrawCallbacks.clear();
+	sObjectLoads.clear();
+
+	for(size_t i = 0; i < sCommands.size(); i++) {
+		delete sCommands[i];
+	}
+	sCommands.clear();
+
+	for(size_t i = 0; i < sMenus.size(); i++) {
+		delete sMenus[i];
+	}
+	sMenus.clear();
+	sPluginsMenu.items.clear();
+	sPluginsMenu.itemRefs.clear();
+
+	sCameraControl	= NULL;
+	sCameraRefcon	= NULL;
+	memset(&sCameraPosition, 0, sizeof(sCameraPosition));
+	sCameraPosition.zoom = 1.0f;
+
+	sPlanesAcquired		= false;
+	sActiveAircraft		= 1;
+	sPlanesAvailable	= NULL;
+
+	gStandInFrame	= 0;
+	gStandInSimTime	= 0.0;
+}
+
+
+
+/*
+Run one simulated frame of frameSeconds: the object loads of the previous frame, the due flight loop callbacks, the
+camera control function, the draw callbacks and the window draw callbacks, in that order.  The wall clock time spent
+in each (but the object loads) is returned in outTimes (which may be NULL).
+*/
+void XPLMStandInRunFrame(double frameSeconds, XPLMStandInFrameTimes * outTimes)
+{
+	gStandInFrame++;
+	gStandInSimTime += frameSeconds;
+
+	//objects loaded asynchronously are ready by the next frame (loads started by the callbacks wait for the next)
+	vector<StandInObjectLoad> loads;
+	loads.swap(sObjectLoads);
+	for(size_t i = 0; i < loads.size(); i++) {
+		loads[i].callback(XPLMLoadObject(loads[i].path.c_str()), loads[i].refcon);
+	}
+
+	sRunningFrame = true;
+
+	//flight loops (callbacks registered during the frame first run in the next one)
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	size_t count = sFlightLoops.size();
+	for(size_t i = 0; i < count; i++) {
+		StandInFlightLoop * loop = sFlightLoops[i];
+		if(!IsFlightLoopDue(loop)) {
+			continue;
+		}
+
+		float sinceLastCall = (float)(gStandInSimTime - loop->lastCallTime);
+		loop->lastCallTime = gStandInSimTime;
+		gStandInStats.flightLoopCalls++;
+		float interval = loop->callback(sinceLastCall, (float)frameSeconds, gStandInFrame, loop->refcon);
+		if(!loop->removed) {
+			ScheduleFlightLoop(loop, interval);
+		}
+	}
+	double flightLoopSeconds = Seconds(start);
+
+	//camera
+	start = chrono::steady_clock::now();
+	if(sCameraControl != NULL) {
+		XPLMCameraPosition_t position = sCameraPosition;
+		gStandInStats.cameraCalls++;
+		if(sCameraControl(&position, 0, sCameraRefcon)) {
+			sCameraPosition = position;
+		} else {
+			sCameraControl = NULL;
+		}
+	}
+	double cameraSeconds = Seconds(start);
+
+	//scenery draw callbacks (called once for every phase they are registered for)
+	start = chrono::steady_clock::now();
+	count = sDrawCallbacks.size();
+	for(size_t i = 0; i < count; i++) {
+		StandInDrawCallback * draw = sDrawCallbacks[i];
+		if(!draw->removed) {
+			gStandInStats.sceneDrawCalls++;
+			draw->callback(draw->phase, draw->before, draw->refcon);
+		}
+	}
+	double sceneSeconds = Seconds(start);
+
+	//windows
+	start = chrono::steady_clock::now();
+	count = sWindows.size();
+	for(size_t i = 0; i < count; i++) {
+		StandInWindow * window = sWindows[i];
+		if(window->visible && !window->removed && window->draw != NULL) {
+			gStandInStats.drawCalls++;
+			window->draw(window, window->refcon);
+		}
+	}
+	double drawSeconds = Seconds(start);
+
+	sRunningFrame = false;
+	PurgeRemoved();
+
+	if(outTimes != NULL) {
+		outTimes->flightLoopSeconds	= flightLoopSeconds;
+		outTimes->cameraSeconds		= cameraSeconds;
+		outTimes->sceneSeconds		= sceneSeconds;
+		outTimes->drawSeconds		= drawSeconds;
+	}
+}
+
+
+
+/*
+Press a hot key: call every hot key callback registered for the key and flags.  Returns the number of callbacks
+called.
+*/
+int XPLMStandInPressHotKey(char virtualKey, XPLMKeyFlags flags)
+{
+	int called = 0;
+	for(size_t i = 0; i < sHotKeys.size(); i++) {
+		StandInHotKey * hotKey = sHotKeys[i];
+		if(hotKey->virtualKey == virtualKey && hotKey->flags == flags) {
+			hotKey->callback(hotKey->refcon);
+			called++;
+		}
+	}
+	return called;
+}
+
+
+
+/*
+Run a command once (as a key or button bound to it would): call its handlers with xplm_CommandBegin and then
+xplm_CommandEnd.  Returns the number of handlers, or -1 if no plugin created the command.
+*/
+int XPLMStandInRunCommand(const char * name)
+{
+	XPLMCommandRef command = XPLMFindCommand(name);
+	if(command == NULL) {
+		return -1;
+	}
+
+	XPLMCommandOnce(command);
+	return (int)((StandInCommand *)command)->handlers.size();
+}
+
+
+
+/*
+The folder XPLMGetSystemPath returns, which is where the plugins look for their config files (must end in /)
+*/
+void XPLMStandInSetSystemPath(const char * systemPath)
+{
+	sSystemPath = systemPath;
+}
+
+
+
+/*
+The latitude and longitude of the local origin used by XPLMWorldToLocal and XPLMLocalToWorld
+*/
+void XPLMStandInSetLocalOrigin(double latitudeDeg, double longitudeDeg)
+{
+	sOriginLatitude		= latitudeDeg;
+	sOriginLongitude	= longitudeDeg;
+
+	//made now rather than on first use, so a plugin reading the database is not timed making it
+	sNavaids.clear();
+	MakeNavaids();
+}
+
+
+
+/*
+The terrain XPLMProbeTerrainXYZ finds: hills hillHeight meters high (0 for flat terrain) about an elevation in
+meters above mean sea level
+*/
+void XPLMStandInSetTerrain(double elevation, double hillHeight)
+{
+	sTerrainElevation	= elevation;
+	sTerrainHillHeight	= hillHeight;
+}
+
+
+
+/*
+Stop XPLMDebugString from printing (the calls are still counted)
+*/
+void XPLMStandInSetQuiet(bool quiet)
+{
+	gStandInQuiet = quiet;
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM PROCESSING INTERFACE--------------------------
+float XPLMGetElapsedTime(void)
+{
+	return (float)gStandInSimTime;
+}
+
+
+
+int XPLMGetCycleNumber(void)
+{
+	return gStandInFrame;
+}
+
+
+
+void XPLMRegisterFlightLoopCallback(XPLMFlightLoop_f inFlightLoop, float inInterval, void * inRefcon)
+{
+	StandInFlightLoop * loop = new StandInFlightLoop;
+	loop->callback		= inFlightLoop;
+	loop->refcon		= inRefcon;
+	loop->nextTime		= 0.0;
+	loop->nextFrame		= -1;
+	loop->lastCallTime	= gStandInSimTime;
+	loop->removed		= false;
+	ScheduleFlightLoop(loop, inInterval);
+	sFlightLoops.push_back(loop);
+}
+
+
+
+void XPLMUnregisterFlightLoopCallback(XPLMFlightLoop_f inFlightLoop, void * inRefcon)
+{
+	StandInFlightLoop * loop = FindFlightLoop(inFlightLoop, inRefcon);
+	if(loop == NULL) {
+		return;
+	}
+
+	loop->removed = true;
+	if(!sRunningFrame) {
+		PurgeRemoved();
+	}
+}
+
+
+
+/*
+Only intervals relative to now are supported (as X-Plane, relative to the last call is treated the same when the
+callback has not been called yet)
+*/
+void XPLMSetFlightLoopCallbackInterval(XPLMFlightLoop_f inFlightLoop, float inInterval, int inRelativeToNow,
+									   void * inRefcon)
+{
+	StandInFlightLoop * loop = FindFlightLoop(inFlightLoop, inRefcon);
+	if(loop != NULL) {
+		ScheduleFlightLoop(loop, inInterval);
+	}
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM DISPLAY INTERFACE-----------------------------
+XPLMWindowID XPLMCreateWindow(int inLeft, int inTop, int inRight, int inBottom, int inIsVisible,
+							  XPLMDrawWindow_f inDrawCallback, XPLMHandleKey_f inKeyCallback,
+							  XPLMHandleMouseClick_f inMouseCallback, void * inRefcon)
+{
+	StandInWindow * window = new StandInWindow;
+	window->left	= inLeft;
+	window->top		= inTop;
+	window->right	= inRight;
+	window->bottom	= inBottom;
+	window->visible	= inIsVisible;
+	window->draw	= inDrawCallback;
+	window->refcon	= inRefcon;
+	window->removed	= false;
+	sWindows.push_back(window);
+	return window;
+}
+
+
+
+void XPLMDestroyWindow(XPLMWindowID inWindowID)
+{
+	for(size_t i = 0; i < sWindows.size(); i++) {
+		if(sWindows[i] == inWindowID) {
+			sWindows[i]->removed = true;
+		}
+	}
+	if(!sRunningFrame) {
+		PurgeRemoved();
+	}
+}
+
+
+
+void XPLMGetWindowGeometry(XPLMWindowID inWindowID, int * outLeft, int * outTop, int * outRight, int * outBottom)
+{
+	StandInWindow * window = (StandInWindow *)inWindowID;
+	if(outLeft)		*outLeft	= window->left;
+	if(outTop)		*outTop		= window->top;
+	if(outRight)	*outRight	= window->right;
+	if(outBottom)	*outBottom	= window->bottom;
+}
+
+
+
+int XPLMGetWindowIsVisible(XPLMWindowID inWindowID)
+{
+	return ((StandInWindow *)inWindowID)->visible;
+}
+
+
+
+void XPLMSetWindowIsVisible(XPLMWindowID inWindowID, int inIsVisible)
+{
+	((StandInWindow *)inWindowID)->visible = inIsVisible;
+}
+
+
+
+/*
+The simulated screen is 1024 x 768
+*/
+void XPLMGetScreenSize(int * outWidth, int * outHeight)
+{
+	if(outWidth)	*outWidth	= 1024;
+	if(outHeight)	*outHeight	= 768;
+}
+
+
+
+XPLMHotKeyID XPLMRegisterHotKey(char inVirtualKey, XPLMKeyFlags inFlags, const char * inDescription,
+								XPLMHotKey_f inCallback, void * inRefcon)
+{
+	StandInHotKey * hotKey = new StandInHotKey;
+	hotKey->virtualKey	= inVirtualKey;
+	hotKey->flags		= inFlags;
+	hotKey->callback	= inCallback;
+	hotKey->refcon		= inRefcon;
+	sHotKeys.push_back(hotKey);
+	return hotKey;
+}
+
+
+
+void XPLMUnregisterHotKey(XPLMHotKeyID inHotKey)
+{
+	for(size_t i = 0; i < sHotKeys.size(); i++) {
+		if(sHotKeys[i] == inHotKey) {
+			delete sHotKeys[i];
+			sHotKeys.erase(sHotKeys.begin() + i);
+			return;
+		}
+	}
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM CAMERA INTERFACE------------------------------
+void XPLMControlCamera(XPLMCameraControlDuration inHowLong, XPLMCameraControl_f inControlFunc, void * inRefcon)
+{
+	sCameraControl	= inControlFunc;
+	sCameraRefcon	= inRefcon;
+	sCameraDuration	= inHowLong;
+}
+
+
+
+void XPLMDontControlCamera(void)
+{
+	sCameraControl = NULL;
+}
+
+
+
+int XPLMIsCameraBeingControlled(XPLMCameraControlDuration * outCameraControlDuration)
+{
+	if(sCameraControl != NULL && outCameraControlDuration != NULL) {
+		*outCameraControlDuration = sCameraDuration;
+	}
+	return sCameraControl != NULL;
+}
+
+
+
+void XPLMReadCameraPosition(XPLMCameraPosition_t * outCameraPosition)
+{
+	*outCameraPosition = sCameraPosition;
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM DISPLAY INTERFACE (DRAW CALLBACKS)------------
+int XPLMRegisterDrawCallback(XPLMDrawCallback_f inCallback, XPLMDrawingPhase inPhase, int inWantsBefore,
+							 void * inRefcon)
+{
+	StandInDrawCallback * draw = new StandInDrawCallback;
+	draw->callback	= inCallback;
+	draw->phase		= inPhase;
+	draw->before	= inWantsBefore;
+	draw->refcon	= inRefcon;
+	draw->removed	= false;
+	sDrawCallbacks.push_back(draw);
+	return 1;
+}
+
+
+
+int XPLMUnregisterDrawCallback(XPLMDrawCallback_f inCallback, XPLMDrawingPhase inPhase, int inWantsBefore,
+							   void * inRefcon)
+{
+	for(size_t i = 0; i < sDrawCallbacks.size(); i++) {
+		StandInDrawCallback * draw = sDrawCallbacks[i];
+		if(!draw->removed && draw->callback == inCallback && draw->phase == inPhase && draw->before == inWantsBefore &&
+		   draw->refcon == inRefcon) {
+			draw->removed = true;
+			if(!sRunningFrame) {
+				PurgeRemoved();
+			}
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM GRAPHICS INTERFACE----------------------------
+/*
+Flat earth about the local origin: x east, y up, z south (as X-Plane's local coordinates)
+*/
+void XPLMWorldToLocal(double inLatitude, double inLongitude, double inAltitude, double * outX, double * outY,
+					  double * outZ)
+{
+	gStandInStats.worldToLocal++;
+	*outX = (inLongitude - sOriginLongitude) * DEGREES_TO_RADIANS * EARTH_RADIUS * cos(sOriginLatitude * DEGREES_TO_RADIANS);
+	*outY = inAltitude;
+	*outZ = -(inLatitude - sOriginLatitude) * DEGREES_TO_RADIANS * EARTH_RADIUS;
+}
+
+
+
+void XPLMLocalToWorld(double inX, double inY, double inZ, double * outLatitude, double * outLongitude,
+					  double * outAltitude)
+{
+	*outLatitude	= sOriginLatitude - inZ / (DEGREES_TO_RADIANS * EARTH_RADIUS);
+	*outLongitude	= sOriginLongitude + inX / (DEGREES_TO_RADIANS * EARTH_RADIUS * cos(sOriginLatitude * DEGREES_TO_RADIANS));
+	*outAltitude	= inY;
+}
+
+
+
+void XPLMDrawTranslucentDarkBox(int inLeft, int inTop, int inRight, int inBottom)
+{
+}
+
+
+
+void XPLMDrawString(float * inColorRGB, int inXOffset, int inYOffset, char * inChar, int * inWordWrapWidth,
+					XPLMFontID inFontID)
+{
+	gStandInStats.drawStrings++;
+}
+
+
+
+void XPLMSetGraphicsState(int inEnableFog, int inNumberTexUnits, int inEnableLighting, int inEnableAlphaTesting,
+						  int inEnableAlphaBlending, int inEnableDepthTesting, int inEnableDepthWriting)
+{
+}
+
+
+
+//-------------------IMPLEMENT THE OPENGL CALLS MADE FROM DRAW CALLBACKS--------------
+/*
+The immediate mode calls the plugins draw with, so a plugin which draws lines runs without an OpenGL context (and
+without linking libGL).  Only the vertices are counted.
+*/
+void glColor3f(GLfloat red, GLfloat green, GLfloat blue)
+{
+}
+
+
+
+void glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+}
+
+
+
+void glBegin(GLenum mode)
+{
+}
+
+
+
+void glVertex2f(GLfloat x, GLfloat y)
+{
+	gStandInStats.glVertices++;
+}
+
+
+
+void glEnd(void)
+{
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM SCENERY INTERFACE-----------------------------
+XPLMProbeRef XPLMCreateProbe(XPLMProbeType inProbeType)
+{
+	return (XPLMProbeRef)new XPLMProbeType(inProbeType);
+}
+
+
+
+void XPLMDestroyProbe(XPLMProbeRef inProbe)
+{
+	delete (XPLMProbeType *)inProbe;
+}
+
+
+
+XPLMProbeResult XPLMProbeTerrainXYZ(XPLMProbeRef inProbe, float inX, float inY, float inZ, XPLMProbeInfo_t * outInfo)
+{
+	gStandInStats.terrainProbes++;
+	if(inProbe == NULL || outInfo == NULL || outInfo->structSize != sizeof(XPLMProbeInfo_t)) {
+		return xplm_ProbeError;
+	}
+
+	double phase = 2.0 * 3.14159265358979323846 / HILL_WAVELENGTH;
+	memset((char *)outInfo + sizeof(int), 0, sizeof(XPLMProbeInfo_t) - sizeof(int));
+	outInfo->locationX	= inX;
+	outInfo->locationY	= (float)(sTerrainElevation + 0.5*sTerrainHillHeight*(1.0 + sin(phase*inX)*cos(phase*inZ)));
+	outInfo->locationZ	= inZ;
+	outInfo->normalY	= 1.0f;
+	return xplm_ProbeHitTerrain;
+}
+
+
+
+/*
+Objects are never drawn, so any path loads (except an empty one) and the handle just keeps the path
+*/
+XPLMObjectRef XPLMLoadObject(const char * inPath)
+{
+	if(inPath == NULL || inPath[0] == '\0') {
+		return NULL;
+	}
+	return (XPLMObjectRef)new string(inPath);
+}
+
+
+
+void XPLMLoadObjectAsync(const char * inPath, XPLMObjectLoaded_f inCallback, void * inRefcon)
+{
+	StandInObjectLoad load;
+	load.path		= (inPath != NULL) ? inPath : "";
+	load.callback	= inCallback;
+	load.refcon		= inRefcon;
+	sObjectLoads.push_back(load);
+}
+
+
+
+void XPLMUnloadObject(XPLMObjectRef inObject)
+{
+	delete (string *)inObject;
+}
+
+
+
+void XPLMDrawObjects(XPLMObjectRef inObject, int inCount, XPLMDrawInfo_t * inLocations, int lighting, int earth_relative)
+{
+	gStandInStats.drawObjectsCalls++;
+	gStandInStats.objectsDrawn += inCount;
+}
+
+
+
+/*
+The library has no objects, so the path is never found (callers fall back to loading it as a file)
+*/
+int XPLMLookupObjects(const char * inPath, float inLatitude, float inLongitude, XPLMLibraryEnumerator_f enumerator,
+					  void * ref)
+{
+	return 0;
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM PLANES INTERFACE------------------------------
+/*
+The stand-in has STANDIN_TOTAL_AIRCRAFT aircraft; the plugin which acquired them is reported as plugin 0
+*/
+void XPLMCountAircraft(int * outTotalAircraft, int * outActiveAircraft, XPLMPluginID * outController)
+{
+	*outTotalAircraft	= STANDIN_TOTAL_AIRCRAFT;
+	*outActiveAircraft	= sActiveAircraft;
+	*outController		= sPlanesAcquired ? 0 : XPLM_NO_PLUGIN_ID;
+}
+
+
+
+/*
+The aircraft listed in inAircraft are not loaded (nothing is drawn)
+*/
+int XPLMAcquirePlanes(char ** inAircraft, XPLMPlanesAvailable_f inCallback, void * inRefcon)
+{
+	if(sPlanesAcquired) {
+		sPlanesAvailable	= inCallback;
+		sPlanesRefcon		= inRefcon;
+		return 0;
+	}
+	sPlanesAcquired = true;
+	return 1;
+}
+
+
+
+void XPLMReleasePlanes(void)
+{
+	sPlanesAcquired = false;
+	sActiveAircraft = 1;
+
+	XPLMPlanesAvailable_f callback = sPlanesAvailable;
+	sPlanesAvailable = NULL;
+	if(callback != NULL) {
+		callback(sPlanesRefcon);
+	}
+}
+
+
+
+void XPLMSetActiveAircraftCount(int inCount)
+{
+	sActiveAircraft = (inCount < STANDIN_TOTAL_AIRCRAFT) ? inCount : STANDIN_TOTAL_AIRCRAFT;
+}
+
+
+
+/*
+Only counted (X-Plane loads the aircraft before returning, which can take a long time)
+*/
+void XPLMSetAircraftModel(int inIndex, const char * inAircraftPath)
+{
+	gStandInStats.aircraftModelsSet++;
+}
+
+
+
+void XPLMDisableAIForPlane(int inPlaneIndex)
+{
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM NAVIGATION INTERFACE--------------------------
+XPLMNavRef XPLMGetFirstNavAid(void)
+{
+	if(sNavaids.empty()) {
+		MakeNavaids();
+	}
+	return sNavaids.empty() ? XPLM_NAV_NOT_FOUND : 0;
+}
+
+
+
+XPLMNavRef XPLMGetNextNavAid(XPLMNavRef inNavAidRef)
+{
+	return (inNavAidRef >= 0 && inNavAidRef + 1 < (int)sNavaids.size()) ? inNavAidRef + 1 : XPLM_NAV_NOT_FOUND;
+}
+
+
+
+XPLMNavRef XPLMFindFirstNavAidOfType(XPLMNavType inType)
+{
+	if(sNavaids.empty()) {
+		MakeNavaids();
+	}
+	for(size_t i = 0; i < sNavaids.size(); i++) {
+		if(sNavaids[i].type == inType) {
+			return (XPLMNavRef)i;
+		}
+	}
+	return XPLM_NAV_NOT_FOUND;
+}
+
+
+
+XPLMNavRef XPLMFindLastNavAidOfType(XPLMNavType inType)
+{
+	if(sNavaids.empty()) {
+		MakeNavaids();
+	}
+	for(size_t i = sNavaids.size(); i > 0; i--) {
+		if(sNavaids[i - 1].type == inType) {
+			return (XPLMNavRef)(i - 1);
+		}
+	}
+	return XPLM_NAV_NOT_FOUND;
+}
+
+
+
+void XPLMGetNavAidInfo(XPLMNavRef inRef, XPLMNavType * outType, float * outLatitude, float * outLongitude,
+					   float * outHeight, int * outFrequency, float * outHeading, char * outID, char * outName,
+					   char * outReg)
+{
+	gStandInStats.navaidInfoCalls++;
+	if(inRef < 0 || inRef >= (int)sNavaids.size()) {
+		return;
+	}
+
+	const StandInNavaid * navaid = &sNavaids[inRef];
+	if(outType != NULL) {
+		*outType = navaid->type;
+	}
+	if(outLatitude != NULL) {
+		*outLatitude = navaid->latitude;
+	}
+	if(outLongitude != NULL) {
+		*outLongitude = navaid->longitude;
+	}
+	if(outHeight != NULL) {
+		*outHeight = 0.0f;
+	}
+	if(outFrequency != NULL) {
+		*outFrequency = navaid->frequency;
+	}
+	if(outHeading != NULL) {
+		*outHeading = 0.0f;
+	}
+	if(outID != NULL) {
+		strcpy(outID, navaid->id);
+	}
+	if(outName != NULL) {
+		strcpy(outName, navaid->id);
+	}
+	if(outReg != NULL) {
+		*outReg = 0;
+	}
+}
+
+
+
+/*
+The stand-in's FMS is always empty
+*/
+int XPLMCountFMSEntries(void)
+{
+	return 0;
+}
+
+
+
+int XPLMGetDestinationFMSEntry(void)
+{
+	return 0;
+}
+
+
+
+void XPLMGetFMSEntryInfo(int inIndex, XPLMNavType * outType, char * outID, XPLMNavRef * outRef, int * outAltitude,
+						 float * outLat, float * outLon)
+{
+	if(outType != NULL) {
+		*outType = xplm_Nav_Unknown;
+	}
+	if(outID != NULL) {
+		outID[0] = '\0';
+	}
+	if(outRef != NULL) {
+		*outRef = XPLM_NAV_NOT_FOUND;
+	}
+	if(outAltitude != NULL) {
+		*outAltitude = 0;
+	}
+	if(outLat != NULL) {
+		*outLat = 0.0f;
+	}
+	if(outLon != NULL) {
+		*outLon = 0.0f;
+	}
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM UTILITIES INTERFACE---------------------------
+void XPLMDebugString(const char * inString)
+{
+	gStandInStats.debugStrings++;
+	if(!gStandInQuiet) {
+		fputs(inString, stderr);
+	}
+}
+
+
+
+void XPLMGetSystemPath(char * outSystemPath)
+{
+	strcpy(outSystemPath, sSystemPath.c_str());
+}
+
+
+
+const char * XPLMGetDirectorySeparator(void)
+{
+	return "/";
+}
+
+
+
+void XPLMCommandButtonPress(XPLMCommandButtonID inButton)
+{
+}
+
+
+
+void XPLMCommandButtonRelease(XPLMCommandButtonID inButton)
+{
+}
+
+
+
+XPLMCommandRef XPLMFindCommand(const char * inName)
+{
+	for(size_t i = 0; i < sCommands.size(); i++) {
+		if(sCommands[i]->name == inName) {
+			return sCommands[i];
+		}
+	}
+	return NULL;
+}
+
+
+
+static void RunCommandPhase(XPLMCommandRef inCommand, XPLMCommandPhase phase)
+{
+	StandInCommand * command = (StandInCommand *)inCommand;
+
+	//handlers may be unregistered by the handlers, so iterate over a copy
+	vector<StandInCommandHandler> handlers = command->handlers;
+	for(int before = 1; before >= 0; before--) {
+		for(size_t i = 0; i < handlers.size(); i++) {
+			if(handlers[i].before == before) {
+				handlers[i].callback(inCommand, phase, handlers[i].refcon);
+			}
+		}
+	}
+}
+
+
+
+void XPLMCommandBegin(XPLMCommandRef inCommand)
+{
+	RunCommandPhase(inCommand, xplm_CommandBegin);
+}
+
+
+
+void XPLMCommandEnd(XPLMCommandRef inCommand)
+{
+	RunCommandPhase(inCommand, xplm_CommandEnd);
+}
+
+
+
+void XPLMCommandOnce(XPLMCommandRef inCommand)
+{
+	XPLMCommandBegin(inCommand);
+	XPLMCommandEnd(inCommand);
+}
+
+
+
+XPLMCommandRef XPLMCreateCommand(const char * inName, const char * inDescription)
+{
+	XPLMCommandRef existing = XPLMFindCommand(inName);
+	if(existing != NULL) {
+		return existing;
+	}
+
+	StandInCommand * command = new StandInCommand;
+	command->name			= inName;
+	command->description	= inDescription;
+	sCommands.push_back(command);
+	return command;
+}
+
+
+
+void XPLMRegisterCommandHandler(XPLMCommandRef inComand, XPLMCommandCallback_f inHandler, int inBefore,
+								void * inRefcon)
+{
+	StandInCommandHandler handler;
+	handler.callback	= inHandler;
+	handler.before		= inBefore;
+	handler.refcon		= inRefcon;
+	((StandInCommand *)inComand)->handlers.push_back(handler);
+}
+
+
+
+void XPLMUnregisterCommandHandler(XPLMCommandRef inComand, XPLMCommandCallback_f inHandler, int inBefore,
+								  void * inRefcon)
+{
+	vector<StandInCommandHandler> & handlers = ((StandInCommand *)inComand)->handlers;
+	for(size_t i = 0; i < handlers.size(); i++) {
+		if(handlers[i].callback == inHandler && handlers[i].before == inBefore && handlers[i].refcon == inRefcon) {
+			handlers.erase(handlers.begin() + i);
+			return;
+		}
+	}
+}
+
+
+
+//-------------------IMPLEMENT THE XPLM MENUS INTERFACE-------------------------------
+/*
+Menus are only kept, never shown: their items can be named and renamed but not picked (run the commands they
+stand for with XPLMStandInRunCommand instead)
+*/
+XPLMMenuID XPLMFindPluginsMenu(void)
+{
+	sPluginsMenu.name = "Plugins";
+	return &sPluginsMenu;
+}
+
+
+
+XPLMMenuID XPLMCreateMenu(const char * inName, XPLMMenuID inParentMenu, int inParentItem, XPLMMenuHandler_f inHandler,
+						  void * inMenuRef)
+{
+	StandInMenu * menu = new StandInMenu;
+	menu->name		= inName;
+	menu->handler	= inHandler;
+	menu->menuRef	= inMenuRef;
+	sMenus.push_back(menu);
+	return menu;
+}
+
+
+
+void XPLMDestroyMenu(XPLMMenuID inMenuID)
+{
+	for(size_t i = 0; i < sMenus.size(); i++) {
+		if(sMenus[i] == inMenuID) {
+			delete sMenus[i];
+			sMenus.erase(sMenus.begin() + i);
+			return;
+		}
+	}
+}
+
+
+
+void XPLMClearAllMenuItems(XPLMMenuID inMenuID)
+{
+	StandInMenu * menu = (StandInMenu *)inMenuID;
+	menu->items.clear();
+	menu->itemRefs.clear();
+}
+
+
+
+int XPLMAppendMenuItem(XPLMMenuID inMenu, const char * inItemName, void * inItemRef, int inForceEnglish)
+{
+	StandInMenu * menu = (StandInMenu *)inMenu;
+	menu->items.push_back(inItemName);
+	menu->itemRefs.push_back(inItemRef);
+	return (int)menu->items.size() - 1;
+}
+
+
+
+void XPLMAppendMenuSeparator(XPLMMenuID inMenu)
+{
+	XPLMAppendMenuItem(inMenu, "", NULL, 0);
+}
+
+
+
+void XPLMSetMenuItemName(XPLMMenuID inMenu, int inIndex, const char * inItemName, int inForceEnglish)
+{
+	StandInMenu * menu = (StandInMenu *)inMenu;
+	if(inIndex >= 0 && inIndex < (int)menu->items.size()) {
+		menu->items[inIndex] = inItemName;
+	}
+}
+
+
+
+void XPLMRemoveMenuItem(XPLMMenuID inMenu, int inIndex)
+{
+	StandInMenu * menu = (StandInMenu *)inMenu;
+	if(inIndex >= 0 && inIndex < (int)menu->items.size()) {
+		menu->items.erase(menu->items.begin() + inIndex);
+		menu->itemRefs.erase(menu->itemRefs.begin() + inIndex);
+	}
+}
@@ -2,20 +2,33 @@
 //
 
 #include "PracticalSocket.h"   // For UDPSocket and SocketException
+#include "UWClock.h"           // For UWClockWallSeconds
+#include "UWEchoRecord.h"      // For the echoes of UWTimedProcessingUDP
 #include <iostream>            // For cout and cerr
+#include <iomanip>             // For setprecision
 #include <cstdlib>             // For atoi()
+#include <cstring>             // For strcmp()
+#include <vector>
+#include <algorithm>           // For sort()
 
 const int MAXRCVSTRING = 4096; // Longest string to receive
+const unsigned short LATENCY_PORT = 49011; // Default port of the latency analyzer (echo_port in the plugin's config file)
 
 
 //Function prototypes
 void UDPReceiveSimple();
 void UDPReceiveByteArray();
 void UDPReceiveByteArrayDeliniated();
+void UDPLatencyAnalyzer(unsigned short port);
 
 
 int main(int argc, char *argv[]) {
 
+	//"UDPReceive latency [port]" runs the latency analyzer
+	if(argc > 1 && strcmp(argv[1], "latency") == 0) {
+		UDPLatencyAnalyzer((argc > 2) ? (unsigned short)atoi(argv[2]) : LATENCY_PORT);
+		return 0;
+	}
 
 	UDPReceiveSimple();
 	//UDPReceiveByteArray();
@@ -141,12 +154,12 @@ void UDPReceiveByteArrayDeliniated()
 		cout << "sourcePort: " << sourcePort << endl << endl;
 
 		//Convert the recieved string to values
-		double phiDegDouble;
-		double thetaDegDouble;
-		double psiDegDouble;
-		double latitudeDeg;
-		double longitudeDeg;
-		double altitudeMeters;
+		double phiDegDouble = 0.0;
+		double thetaDegDouble = 0.0;
+		double psiDegDouble = 0.0;
+		double latitudeDeg = 0.0;
+		double longitudeDeg = 0.0;
+		double altitudeMeters = 0.0;
 
 		char *pch;			
 		pch = strtok(recvString," ");
@@ -211,4 +224,112 @@ void UDPReceiveByteArrayDeliniated()
 	cout << "Press any key then Enter to exit..." << endl;
 	int dummy;
 	cin >> dummy;
-}
\ No newline at end of file
+}
+
+
+
+/*
+Print the 50th and 99th percentiles and the maximum of samples (seconds) in milliseconds
+*/
+void PrintDistribution(const char * name, vector<double> & samples)
+{
+	cout << "  " << setw(14) << left << name << right;
+	if(samples.empty()) {
+		cout << "            -" << endl;
+		return;
+	}
+
+	sort(samples.begin(), samples.end());
+	double p50 = samples[samples.size()/2];
+	double p99 = samples[(samples.size()*99)/100];
+	double maximum = samples.back();
+
+	cout << fixed << setprecision(3)
+		 << " p50 " << setw(9) << 1000.0*p50
+		 << " p99 " << setw(9) << 1000.0*p99
+		 << " max " << setw(9) << 1000.0*maximum << " ms" << endl;
+}
+
+
+
+/*
+Latency analyzer for the echo mode of UWTimedProcessingUDP (see UWEchoSender.h).  Run it on the machine of the
+sender, so the sender's clock is the local clock, and set echo_port in the plugin's config file to port.  Once a
+second the distributions of the echoes received in that second are printed
+
+	round trip		pose time stamp to the echo arriving here (includes up to 10 ms of echo batching)
+	to plugin		pose time stamp to the plugin taking the pose off its socket
+	in plugin		plugin receive to the pose being set to the datarefs (waiting for the flight loop)
+	to apply		pose time stamp to the pose being set to the datarefs
+	back			pose being set to the echo arriving here
+
+The one-way times rely on the plugin's clock being mapped onto the sender's (see UWClockSync.h).  Poses which
+were received but never applied (a newer pose arrived in the same flight loop) show up as skipped.
+*/
+void UDPLatencyAnalyzer(unsigned short port)
+{
+	cout << "UDPLatencyAnalyzer on port " << port << endl;
+
+	try {
+		UDPSocket sock(port);
+
+		char packet[UW_ECHO_WIRE_MAX_SIZE];
+		string sourceAddress;
+		unsigned short sourcePort;
+		UWEchoRecord echoes[UW_ECHO_MAX_BATCH];
+
+		vector<double> roundTrip, toPlugin, inPlugin, toApply, back;
+		long long skipped = 0;
+		bool haveSequence = false;
+		unsigned int lastSequence = 0;
+		double nextPrintTime = UWClockWallSeconds() + 1.0;
+
+		while(true) {
+			int length = sock.recvFrom(packet, UW_ECHO_WIRE_MAX_SIZE, sourceAddress, sourcePort);
+			double arrivalTime = UWClockWallSeconds();
+
+			int count = UWEchoDecode(packet, length, echoes);
+			for(int i = 0; i < count; i++) {
+				const UWEchoRecord * echo = &echoes[i];
+
+				if(haveSequence && echo->sequence > lastSequence + 1) {
+					skipped += echo->sequence - lastSequence - 1;
+				}
+				haveSequence = true;
+				lastSequence = echo->sequence;
+
+				roundTrip.push_back(arrivalTime - echo->timestamp);
+				toApply.push_back(echo->applyTime - echo->timestamp);
+				back.push_back(arrivalTime - echo->applyTime);
+				if(echo->receiveTime != 0.0) {
+					toPlugin.push_back(echo->receiveTime - echo->timestamp);
+					inPlugin.push_back(echo->applyTime - echo->receiveTime);
+				}
+			}
+
+			if(arrivalTime >= nextPrintTime) {
+				nextPrintTime = arrivalTime + 1.0;
+
+				cout << roundTrip.size() << " poses applied, " << skipped << " skipped" << endl;
+				PrintDistribution("round trip", roundTrip);
+				PrintDistribution("to plugin", toPlugin);
+				PrintDistribution("in plugin", inPlugin);
+				PrintDistribution("to apply", toApply);
+				PrintDistribution("back", back);
+				cout << endl;
+
+				roundTrip.clear();
+				toPlugin.clear();
+				inPlugin.clear();
+				toApply.clear();
+				back.clear();
+				skipped = 0;
+			}
+		}
+
+	} catch (SocketException &e) {
+		cerr << "PROBLEM!" << endl;
+		cerr << e.what() << endl;
+
+	}
+}
@@ -1,44 +1,327 @@
-// UDPSend.cpp : Implements a simple sender that repeatedly broadcasts a single UDP datagram.
+// UDPSend.cpp : Implements a rate-controlled load generator which sends pose trajectories over UDP to the UW
+// timed processing plugins, for benchmarking and stressing the receive path.
 //
+// Usage: UDPSend [options]
+//
+//	--address A			destination address (default 127.0.0.1)
+//	--port P			destination port (default 49003)
+//	--rate HZ			poses per second for every entity, 1 to 10000 (default 60)
+//	--entities N		number of entities, 1 to 10000 (default 1)
+//	--trajectory T		circle, figure8, or the name of a recorded file (default circle)
+//	--format F			text, binary or entities (default text)
+//	--models N			number of models the entities are spread over in the entities format (default 1)
+//	--duration S		seconds to run, 0 to run until stopped (default 0)
+//	--loss P			probability that a packet is dropped (default 0)
+//	--reorder P			probability that a packet is held back until after the entity's next packet (default 0)
+//	--duplicate P		probability that a packet is sent twice (default 0)
+//	--jitter MS			every packet is delayed by a random 0 to MS milliseconds (default 0)
+//	--seed N			seed of the random impairments (default 1)
+//
+// Text packets are laid out as
+//
+//	'phiDeg thetaDeg psiDeg latitudeDeg longitudeDeg altitudeMeters timestamp sequence entity'
+//
+// so the default schema of the plugins uses the first six words and a schema file can pick up the time stamp and
+// sequence number.  Binary packets are pose records (see UWPoseRecord.h) with the same first six words and the
+// entity number as the seventh.  In the entities format the poses of all of the entities are packed into entity
+// packets for UWStreamedEntities (see UWEntityProtocol.h; send them to its port with --port 49005), up to
+// UW_ENTITY_MAX_RECORDS entities per packet, and the impairments apply to whole packets.  A recorded file has one pose per line
+//
+//	'time phiDeg thetaDeg psiDeg latitudeDeg longitudeDeg altitudeMeters'
+//
+// and is played back in a loop.  Every entity flies the same trajectory, spread out along it and stacked in height.
+//
+// Packets are handed to the socket in batches (sendmmsg on Linux, see UDPSocket::sendBatch).  Once a second the
+// achieved rates are printed.
 
 #include "stdafx.h"
 #include <iostream>           // For cout and cerr
+#include <fstream>            // For reading recorded trajectories
 #include <cstdlib>            // For atoi()
+#include <cstring>            // For strcmp()
+#include <cmath>
+#include <string>
+#include <vector>
+#include <queue>              // For the packets delayed by the impairments
+#include <random>
+#include <thread>             // For sleeping until the next tick
+#include <chrono>
 
 #include "PracticalSocket.h"  // For UDPSocket and SocketException
-
-#ifdef WIN32
-#include <windows.h>          // For ::Sleep()
-void sleep(unsigned int seconds) {::Sleep(seconds * 1000);}
-#else
-#include <unistd.h>           // For sleep()
-#endif
+#include "UWClock.h"          // For UWClockWallSeconds() and UWClockMonotonicSeconds()
+#include "UWPoseRecord.h"     // For binary packets
+#include "UWEntityProtocol.h" // For entity packets
 
 using namespace std;
 
+const double PI = 3.14159265358979;
+const double EARTH_RADIUS_M = 6371000.0;
+const double GRAVITY_MPS2 = 9.81;
+
+const double BASE_LATITUDE_DEG = 47.26045;    // Centre of the generated trajectories
+const double BASE_LONGITUDE_DEG = 11.34712;
+const double BASE_ALTITUDE_M = 914.4;
+const double TRAJECTORY_RADIUS_M = 2000.0;
+const double TRAJECTORY_SPEED_MPS = 60.0;
+const int ENTITIES_PER_LAYER = 100;           // Entities spread along the trajectory before the next layer up
+const double LAYER_HEIGHT_M = 30.0;
+
+const int SEND_BATCH = 256;                   // Packets handed to sendBatch() at once
+const int MAX_PACKET = 256;                   // Longest text packet
+
+enum PacketFormat {
+	format_Text,
+	format_Binary,
+	format_Entities
+};
+
+enum TrajectoryKind {
+	trajectory_Circle,
+	trajectory_Figure8,
+	trajectory_Recorded
+};
+
+struct Settings {
+	string			address;
+	unsigned short	port;
+	double			rate;
+	int				entities;
+	TrajectoryKind	trajectory;
+	string			recordedFile;
+	PacketFormat	format;
+	int				models;
+	double			duration;
+	double			loss;
+	double			reorder;
+	double			duplicate;
+	double			jitter;					// seconds
+	unsigned int	seed;
+};
+
+struct Pose {
+	double	phiDeg;
+	double	thetaDeg;
+	double	psiDeg;
+	double	latitudeDeg;
+	double	longitudeDeg;
+	double	altitudeM;
+};
+
+struct RecordedPose {
+	double	time;
+	Pose	pose;
+};
+
+struct PendingPacket {
+	double				sendTime;			// UWClockMonotonicSeconds()
+	unsigned long long	order;				// keeps packets due at the same time in order
+	string				data;
+};
+
+struct SendsLaterFirst {
+	bool operator()(const PendingPacket &a, const PendingPacket &b) const {
+		return a.sendTime > b.sendTime || (a.sendTime == b.sendTime && a.order > b.order);
+	}
+};
+
+struct Statistics {
+	long long	generated;
+	long long	sent;
+	long long	lost;
+	long long	duplicated;
+	long long	reordered;
+	long long	batches;
+	long long	missedTicks;
+};
+
+
+//Function prototypes
+void PrintUsage(const char * program);
+bool ReadSettings(int argc, char *argv[], Settings & settings);
+bool LoadRecordedTrajectory(const string & fileName, vector<RecordedPose> & recorded);
+void TrajectoryPosition(TrajectoryKind trajectory, double t, double & east, double & north);
+Pose GeneratedPose(TrajectoryKind trajectory, double t, double altitudeM);
+Pose RecordedPoseAt(const vector<RecordedPose> & recorded, double t);
+int FormatPacket(const Settings & settings, const Pose & pose, double timestamp, unsigned int sequence, int entity, char * packet);
+void SendPackets(UDPSocket & sock, const Settings & settings, vector<string> & packets, Statistics & statistics);
+
+
 int main(int argc, char *argv[]) {
-	//if ((argc < 3) || (argc > 4)) {   // Test for correct number of arguments
-	//	cerr << "Usage: " << argv[0] 
-	//	<< " <Destination Address> <Destination Port> <Send String>\n";
-	//	exit(1);
-	//}
+	Settings settings;
+	if (!ReadSettings(argc, argv, settings)) {
+		PrintUsage(argv[0]);
+		exit(1);
+	}
+
+	vector<RecordedPose> recorded;
+	if (settings.trajectory == trajectory_Recorded && !LoadRecordedTrajectory(settings.recordedFile, recorded)) {
+		cerr << "Unable to read a trajectory from " << settings.recordedFile << endl;
+		exit(1);
+	}
+	double recordedDuration = recorded.empty() ? 0.0 : recorded.back().time - recorded.front().time;
 
-	//string destAddress = argv[1];             // First arg:  destination address
-	//unsigned short destPort = atoi(argv[2]);  // Second arg: destination port
-	//char* sendString = argv[3];               // Third arg:  string to broadcast
+	//how far apart the entities are along the trajectory (in seconds of flight)
+	double circuitTime = 2.0*PI*TRAJECTORY_RADIUS_M/TRAJECTORY_SPEED_MPS;
+	double loopTime = (settings.trajectory == trajectory_Recorded) ? recordedDuration : circuitTime;
+	int entitiesPerLayer = (settings.entities < ENTITIES_PER_LAYER) ? settings.entities : ENTITIES_PER_LAYER;
+	double entitySpacing = loopTime/entitiesPerLayer;
 
-	string destAddress = "172.25.33.243";             // First arg:  destination address
-	
-	unsigned short destPort = 49003;  // Second arg: destination port
-	char* sendString = "testing the outputs from the new project. 2342 342!34";               // Third arg:  string to broadcast
+	const char * formatNames[] = { "text", "binary", "entities" };
+	cout << "Sending " << formatNames[settings.format] << " poses of " << settings.entities << " entities at "
+		 << settings.rate << " Hz to " << settings.address << ":" << settings.port << endl;
 
 	try {
 		UDPSocket sock;
 
-		// Repeatedly send the string (not including \0) to the server
+		mt19937 random(settings.seed);
+		uniform_real_distribution<double> uniform(0.0, 1.0);
+		bool impaired = settings.jitter > 0.0 || settings.reorder > 0.0;
+
+		priority_queue<PendingPacket, vector<PendingPacket>, SendsLaterFirst> pending;
+		unsigned long long order = 0;
+		vector<string> outgoing;
+		outgoing.reserve(SEND_BATCH);
+		vector<unsigned int> sequences(settings.entities, 0);
+
+		Statistics statistics;
+		memset(&statistics, 0, sizeof(statistics));
+
+		double period = 1.0/settings.rate;
+		double start = UWClockMonotonicSeconds();
+		double nextPrintTime = start + 1.0;
+		long long tick = 0;
+		char packet[MAX_PACKET + UW_POSE_WIRE_MAX_SIZE];
+		char entityPacket[UW_ENTITY_MAX_PACKET];
+		int entityPacketLength = 0;
+
+		//hand a packet to the impairments, which send it now or queue it to be sent later (or drop it)
+		auto sendPacket = [&](const char * data, int length, double now) {
+			if (uniform(random) < settings.loss) {
+				statistics.lost++;
+				return;
+			}
+			int copies = 1;
+			if (uniform(random) < settings.duplicate) {
+				statistics.duplicated++;
+				copies = 2;
+			}
+
+			for (int copy = 0; copy < copies; copy++) {
+				if (!impaired) {
+					outgoing.push_back(string(data, length));
+					if ((int)outgoing.size() >= SEND_BATCH) {
+						SendPackets(sock, settings, outgoing, statistics);
+					}
+					continue;
+				}
+
+				PendingPacket pendingPacket;
+				pendingPacket.sendTime = now + uniform(random)*settings.jitter;
+				if (uniform(random) < settings.reorder) {
+					pendingPacket.sendTime += period + settings.jitter;		// after the entity's next packet
+					statistics.reordered++;
+				}
+				pendingPacket.order = order++;
+				pendingPacket.data.assign(data, length);
+				pending.push(pendingPacket);
+			}
+		};
+
 		for (;;) {
-			sock.sendTo(sendString, strlen(sendString), destAddress, destPort);
-			sleep(3);
+			double now = UWClockMonotonicSeconds();
+			if (settings.duration > 0.0 && now - start >= settings.duration) {
+				break;
+			}
+
+			//generate the poses of every entity once per tick (ticks which were missed are skipped and counted)
+			double tickTime = start + tick*period;
+			if (now >= tickTime) {
+				long long dueTick = (long long)((now - start)/period);
+				if (dueTick > tick) {
+					statistics.missedTicks += dueTick - tick;
+					tick = dueTick;
+				}
+				double t = tick*period;
+				double timestamp = UWClockWallSeconds();
+				tick++;
+
+				for (int entity = 0; entity < settings.entities; entity++) {
+					double entityTime = t + (entity % entitiesPerLayer)*entitySpacing;
+					double altitudeM = BASE_ALTITUDE_M + (entity/ENTITIES_PER_LAYER)*LAYER_HEIGHT_M;
+
+					Pose pose;
+					if (settings.trajectory == trajectory_Recorded) {
+						pose = RecordedPoseAt(recorded, entityTime);
+						pose.altitudeM += altitudeM - BASE_ALTITUDE_M;
+					} else {
+						pose = GeneratedPose(settings.trajectory, entityTime, altitudeM);
+					}
+
+					statistics.generated++;
+
+					//entity records are packed until the packet is full
+					if (settings.format == format_Entities) {
+						if (entityPacketLength == 0) {
+							entityPacketLength = UWEntityBeginPacket(entityPacket);
+						}
+						UWEntityRecord record;
+						record.id			= (unsigned int)entity;
+						record.model		= (unsigned short)(entity % settings.models);
+						record.flags		= 0;
+						record.latitude		= pose.latitudeDeg;
+						record.longitude	= pose.longitudeDeg;
+						record.altitude		= pose.altitudeM;
+						record.phi			= (float)pose.phiDeg;
+						record.theta		= (float)pose.thetaDeg;
+						record.psi			= (float)pose.psiDeg;
+						entityPacketLength = UWEntityAddRecord(entityPacket, &record);
+						if (entityPacketLength == UW_ENTITY_MAX_PACKET) {
+							sendPacket(entityPacket, entityPacketLength, now);
+							entityPacketLength = 0;
+						}
+						continue;
+					}
+
+					int length = FormatPacket(settings, pose, timestamp, sequences[entity]++, entity, packet);
+					sendPacket(packet, length, now);
+				}
+
+				if (entityPacketLength > 0) {
+					sendPacket(entityPacket, entityPacketLength, now);
+					entityPacketLength = 0;
+				}
+			}
+
+			//send the delayed packets which are due
+			while (!pending.empty() && pending.top().sendTime <= now) {
+				outgoing.push_back(pending.top().data);
+				pending.pop();
+				if ((int)outgoing.size() >= SEND_BATCH) {
+					SendPackets(sock, settings, outgoing, statistics);
+				}
+			}
+			SendPackets(sock, settings, outgoing, statistics);
+
+			if (now >= nextPrintTime) {
+				nextPrintTime += 1.0;
+				cout << "generated " << statistics.generated << "/s, sent " << statistics.sent << "/s in "
+					 << statistics.batches << " batches, lost " << statistics.lost << ", duplicated "
+					 << statistics.duplicated << ", reordered " << statistics.reordered << ", missed ticks "
+					 << statistics.missedTicks << endl;
+				memset(&statistics, 0, sizeof(statistics));
+			}
+
+			//sleep until the next tick or delayed packet (the last millisecond is spun to keep high rates accurate)
+			double wakeTime = start + tick*period;
+			if (!pending.empty() && pending.top().sendTime < wakeTime) {
+				wakeTime = pending.top().sendTime;
+			}
+			double wait = wakeTime - UWClockMonotonicSeconds();
+			if (wait > 0.002) {
+				this_thread::sleep_for(chrono::microseconds((long long)((wait - 0.001)*1e6)));
+			} else if (wait > 0.0) {
+				this_thread::yield();
+			}
 		}
 	} catch (SocketException &e) {
 		cerr << e.what() << endl;
@@ -47,3 +330,272 @@ int main(int argc, char *argv[]) {
 
 	return 0;
 }
+
+
+
+/*
+Print the command line options
+*/
+void PrintUsage(const char * program)
+{
+	cerr << "Usage: " << program << " [--address A] [--port P] [--rate HZ] [--entities N]" << endl
+		 << "       [--trajectory circle|figure8|FILE] [--format text|binary|entities]" << endl
+		 << "       [--models N] [--duration S] [--loss P] [--reorder P] [--duplicate P] [--jitter MS] [--seed N]" << endl;
+}
+
+
+
+/*
+Read the command line options into settings.  Returns false if an option is unknown or out of range.
+*/
+bool ReadSettings(int argc, char *argv[], Settings & settings)
+{
+	settings.address		= "127.0.0.1";
+	settings.port			= 49003;
+	settings.rate			= 60.0;
+	settings.entities		= 1;
+	settings.trajectory		= trajectory_Circle;
+	settings.format			= format_Text;
+	settings.models			= 1;
+	settings.duration		= 0.0;
+	settings.loss			= 0.0;
+	settings.reorder		= 0.0;
+	settings.duplicate		= 0.0;
+	settings.jitter			= 0.0;
+	settings.seed			= 1;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		string option = argv[i];
+		const char * value = argv[i + 1];
+
+		if (option == "--address") {
+			settings.address = value;
+		} else if (option == "--port") {
+			settings.port = (unsigned short)atoi(value);
+		} else if (option == "--rate") {
+			settings.rate = atof(value);
+		} else if (option == "--entities") {
+			settings.entities = atoi(value);
+		} else if (option == "--trajectory") {
+			if (strcmp(value, "circle") == 0) {
+				settings.trajectory = trajectory_Circle;
+			} else if (strcmp(value, "figure8") == 0) {
+				settings.trajectory = trajectory_Figure8;
+			} else {
+				settings.trajectory = trajectory_Recorded;
+				settings.recordedFile = value;
+			}
+		} else if (option == "--format") {
+			if (strcmp(value, "text") == 0) {
+				settings.format = format_Text;
+			} else if (strcmp(value, "binary") == 0) {
+				settings.format = format_Binary;
+			} else if (strcmp(value, "entities") == 0) {
+				settings.format = format_Entities;
+			} else {
+				return false;
+			}
+		} else if (option == "--models") {
+			settings.models = atoi(value);
+		} else if (option == "--duration") {
+			settings.duration = atof(value);
+		} else if (option == "--loss") {
+			settings.loss = atof(value);
+		} else if (option == "--reorder") {
+			settings.reorder = atof(value);
+		} else if (option == "--duplicate") {
+			settings.duplicate = atof(value);
+		} else if (option == "--jitter") {
+			settings.jitter = atof(value)/1000.0;
+		} else if (option == "--seed") {
+			settings.seed = (unsigned int)atoi(value);
+		} else {
+			return false;
+		}
+	}
+
+	//an option without a value
+	if (argc % 2 == 0) {
+		return false;
+	}
+
+	return settings.rate >= 1.0 && settings.rate <= 10000.0 && settings.entities >= 1 && settings.entities <= 10000 &&
+		   settings.models >= 1 && settings.port != 0 && settings.jitter >= 0.0;
+}
+
+
+
+/*
+Read a recorded trajectory ('time phiDeg thetaDeg psiDeg latitudeDeg longitudeDeg altitudeMeters' per line, in
+increasing time).  Lines which do not hold seven numbers (e.g. a header) are skipped.
+*/
+bool LoadRecordedTrajectory(const string & fileName, vector<RecordedPose> & recorded)
+{
+	ifstream file(fileName.c_str());
+	string line;
+	while (getline(file, line)) {
+		RecordedPose entry;
+		Pose & pose = entry.pose;
+		if (sscanf(line.c_str(), "%lf %lf %lf %lf %lf %lf %lf", &entry.time, &pose.phiDeg, &pose.thetaDeg, &pose.psiDeg,
+				   &pose.latitudeDeg, &pose.longitudeDeg, &pose.altitudeM) == 7) {
+			if (recorded.empty() || entry.time > recorded.back().time) {
+				recorded.push_back(entry);
+			}
+		}
+	}
+
+	return recorded.size() >= 2;
+}
+
+
+
+/*
+Position (meters east and north of the centre) t seconds along a generated trajectory
+*/
+void TrajectoryPosition(TrajectoryKind trajectory, double t, double & east, double & north)
+{
+	double angle = t*TRAJECTORY_SPEED_MPS/TRAJECTORY_RADIUS_M;
+
+	if (trajectory == trajectory_Figure8) {
+		//lemniscate of Gerono
+		east	= TRAJECTORY_RADIUS_M*sin(angle);
+		north	= TRAJECTORY_RADIUS_M*sin(angle)*cos(angle);
+	} else {
+		east	= TRAJECTORY_RADIUS_M*cos(angle);
+		north	= TRAJECTORY_RADIUS_M*sin(angle);
+	}
+}
+
+
+
+/*
+Pose t seconds along a generated trajectory.  The heading follows the velocity and the aircraft banks as a
+coordinated turn would (both are found by differentiating the position numerically).
+*/
+Pose GeneratedPose(TrajectoryKind trajectory, double t, double altitudeM)
+{
+	const double h = 0.01;
+	double east, north, eastBefore, northBefore, eastAfter, northAfter;
+	TrajectoryPosition(trajectory, t, east, north);
+	TrajectoryPosition(trajectory, t - h, eastBefore, northBefore);
+	TrajectoryPosition(trajectory, t + h, eastAfter, northAfter);
+
+	double velocityEast		= (eastAfter - eastBefore)/(2.0*h);
+	double velocityNorth	= (northAfter - northBefore)/(2.0*h);
+	double accelerationEast	= (eastAfter - 2.0*east + eastBefore)/(h*h);
+	double accelerationNorth = (northAfter - 2.0*north + northBefore)/(h*h);
+	double speed			= sqrt(velocityEast*velocityEast + velocityNorth*velocityNorth);
+
+	//sideways acceleration, positive when turning left
+	double lateral = (speed > 0.0) ? (velocityEast*accelerationNorth - velocityNorth*accelerationEast)/speed : 0.0;
+
+	Pose pose;
+	pose.phiDeg			= atan2(-lateral, GRAVITY_MPS2)*180.0/PI;
+	pose.thetaDeg		= 0.0;
+	pose.psiDeg			= atan2(velocityEast, velocityNorth)*180.0/PI;
+	pose.latitudeDeg	= BASE_LATITUDE_DEG + (north/EARTH_RADIUS_M)*180.0/PI;
+	pose.longitudeDeg	= BASE_LONGITUDE_DEG + (east/(EARTH_RADIUS_M*cos(BASE_LATITUDE_DEG*PI/180.0)))*180.0/PI;
+	pose.altitudeM		= altitudeM;
+	if (pose.psiDeg < 0.0) {
+		pose.psiDeg += 360.0;
+	}
+	return pose;
+}
+
+
+
+/*
+Pose t seconds into a recorded trajectory (played in a loop), interpolated between the recorded poses
+*/
+Pose RecordedPoseAt(const vector<RecordedPose> & recorded, double t)
+{
+	double duration = recorded.back().time - recorded.front().time;
+	double time = recorded.front().time + fmod(t, duration);
+
+	//first recorded pose after time
+	size_t low = 0;
+	size_t high = recorded.size() - 1;
+	while (high - low > 1) {
+		size_t middle = (low + high)/2;
+		if (recorded[middle].time <= time) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+
+	const Pose & a = recorded[low].pose;
+	const Pose & b = recorded[high].pose;
+	double f = (time - recorded[low].time)/(recorded[high].time - recorded[low].time);
+
+	//the heading is interpolated the short way round
+	double psiChange = b.psiDeg - a.psiDeg;
+	if (psiChange > 180.0) {
+		psiChange -= 360.0;
+	} else if (psiChange < -180.0) {
+		psiChange += 360.0;
+	}
+
+	Pose pose;
+	pose.phiDeg			= a.phiDeg + f*(b.phiDeg - a.phiDeg);
+	pose.thetaDeg		= a.thetaDeg + f*(b.thetaDeg - a.thetaDeg);
+	pose.psiDeg			= a.psiDeg + f*psiChange;
+	pose.latitudeDeg	= a.latitudeDeg + f*(b.latitudeDeg - a.latitudeDeg);
+	pose.longitudeDeg	= a.longitudeDeg + f*(b.longitudeDeg - a.longitudeDeg);
+	pose.altitudeM		= a.altitudeM + f*(b.altitudeM - a.altitudeM);
+	return pose;
+}
+
+
+
+/*
+Write the packet for one pose of one entity.  Returns its length.
+*/
+int FormatPacket(const Settings & settings, const Pose & pose, double timestamp, unsigned int sequence, int entity, char * packet)
+{
+	if (settings.format == format_Binary) {
+		UWPoseRecord record;
+		record.sequence		= sequence;
+		record.numWords		= 7;
+		record.timestamp	= timestamp;
+		record.words[0]		= pose.phiDeg;
+		record.words[1]		= pose.thetaDeg;
+		record.words[2]		= pose.psiDeg;
+		record.words[3]		= pose.latitudeDeg;
+		record.words[4]		= pose.longitudeDeg;
+		record.words[5]		= pose.altitudeM;
+		record.words[6]		= entity;
+		return UWPoseEncode(&record, packet);
+	}
+
+	return sprintf(packet, "%.6f %.6f %.6f %.8f %.8f %.3f %.6f %u %d", pose.phiDeg, pose.thetaDeg, pose.psiDeg,
+				   pose.latitudeDeg, pose.longitudeDeg, pose.altitudeM, timestamp, sequence, entity);
+}
+
+
+
+/*
+Hand the outgoing packets to the socket in one batch and empty the list
+*/
+void SendPackets(UDPSocket & sock, const Settings & settings, vector<string> & packets, Statistics & statistics)
+{
+	if (packets.empty()) {
+		return;
+	}
+
+	const void * buffers[SEND_BATCH];
+	int lengths[SEND_BATCH];
+	int count = (int)packets.size();
+	for (int i = 0; i < count; i++) {
+		buffers[i] = packets[i].data();
+		lengths[i] = (int)packets[i].size();
+	}
+
+	try {
+		statistics.sent += sock.sendBatch(buffers, lengths, count, settings.address, settings.port);
+	} catch (SocketException &e) {
+		//e.g. nobody listening on the local port (ICMP port unreachable), keep generating
+	}
+	statistics.batches++;
+	packets.clear();
+}
@@ -5,10 +5,15 @@
 
 #pragma once
 
+#ifdef WIN32
 #include "targetver.h"
+#endif
 
 #include <stdio.h>
+
+#ifdef WIN32
 #include <tchar.h>
+#endif
 
 
 
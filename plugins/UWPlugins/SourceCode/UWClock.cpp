@@ -0,0 +1,28 @@
+/*
+UWClock.cpp
+
+See UWClock.h
+*/
+
+#include <chrono>
+
+#include "UWClock.h"
+
+using namespace std;
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+double UWClockWallSeconds()
+{
+	chrono::duration<double> sinceEpoch = chrono::system_clock::now().time_since_epoch();
+	return sinceEpoch.count();
+}
+
+
+
+double UWClockMonotonicSeconds()
+{
+	chrono::duration<double> sinceStart = chrono::steady_clock::now().time_since_epoch();
+	return sinceStart.count();
+}
@@ -0,0 +1,21 @@
+/*
+UWClock.h
+
+Clocks used to time-stamp and schedule poses.
+
+UWClockWallSeconds is the system clock (seconds since 1970).  When the sender and all of the render nodes keep
+their system clocks in step (NTP/PTP) a pose time stamp taken with it means the same instant on every node, and
+clock_offset (sender clock minus local clock, from the config file) corrects for a known constant difference.
+Otherwise the sender synchronizes with the plugin by pinging it (see UWClockSync.h).
+
+UWClockMonotonicSeconds never jumps and is used to measure intervals.
+*/
+
+#ifndef _UWClock_h_
+#define _UWClock_h_
+
+double	UWClockWallSeconds();
+
+double	UWClockMonotonicSeconds();
+
+#endif
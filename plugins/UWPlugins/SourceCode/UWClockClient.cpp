@@ -0,0 +1,130 @@
+/*
+UWClockClient.cpp
+
+See UWClockClient.h
+*/
+
+#include <string>
+
+#include "PracticalSocket.h"
+#include "UWClock.h"
+#include "UWClockSync.h"
+#include "UWClockClient.h"
+
+using namespace std;
+
+struct UWClockClient {
+	UDPSocket *		socket;
+	string			pluginAddress;
+	unsigned short	pluginPort;
+	double			nextPingTime;				//UWClockMonotonicSeconds
+	UWClockSync		sync;
+};
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+UWClockClient * UWClockClientOpen(const char * pluginAddress, unsigned short pluginPort)
+{
+	UWClockClient * client = new UWClockClient;
+	client->pluginAddress	= pluginAddress;
+	client->pluginPort		= pluginPort;
+	client->nextPingTime	= 0.0;
+	UWClockSyncInit(&client->sync);
+
+	try {
+		client->socket = new UDPSocket();
+		client->socket->setBlocking(false);
+	} catch (SocketException &e) {
+		delete client;
+		return NULL;
+	}
+	return client;
+}
+
+
+
+void UWClockClientPoll(UWClockClient * client)
+{
+	if(client == NULL) {
+		return;
+	}
+
+	char packet[UW_CLOCK_MESSAGE_LENGTH];
+	string sourceAddress;
+	unsigned short sourcePort;
+
+	try {
+		//the receive time is taken as soon as each pong is off the socket
+		int length;
+		while((length = client->socket->recvFrom(packet, UW_CLOCK_MESSAGE_LENGTH - 1, sourceAddress, sourcePort)) >= 0) {
+			packet[length] = '\0';
+			UWClockHandlePong(&client->sync, packet, length, UWClockWallSeconds());
+		}
+
+		double now = UWClockMonotonicSeconds();
+		if(now >= client->nextPingTime) {
+			client->nextPingTime = now + UW_CLOCK_PING_INTERVAL;
+
+			int pingLength = UWClockBuildPing(&client->sync, UWClockWallSeconds(), packet);
+			client->socket->sendTo(packet, pingLength, client->pluginAddress, client->pluginPort);
+		}
+	} catch (SocketException &e) {
+		//the plugin may not be listening yet (e.g. ICMP port unreachable), so just try again next time
+	}
+}
+
+
+
+double UWClockClientNow(void)
+{
+	return UWClockWallSeconds();
+}
+
+
+
+int UWClockClientSynchronized(const UWClockClient * client)
+{
+	return (client != NULL && client->sync.estimate.synchronized) ? 1 : 0;
+}
+
+
+
+double UWClockClientOffset(const UWClockClient * client, double senderTime)
+{
+	if(client == NULL) {
+		return 0.0;
+	}
+
+	const UWClockEstimate * estimate = &client->sync.estimate;
+	return estimate->offset + estimate->drift*(senderTime - estimate->reference);
+}
+
+
+
+double UWClockClientUncertainty(const UWClockClient * client)
+{
+	return (client != NULL) ? client->sync.estimate.uncertainty : 0.0;
+}
+
+
+
+double UWClockClientToPlugin(const UWClockClient * client, double senderTime)
+{
+	if(client == NULL) {
+		return senderTime;
+	}
+	return UWClockToPlugin(&client->sync.estimate, senderTime);
+}
+
+
+
+void UWClockClientClose(UWClockClient * client)
+{
+	if(client == NULL) {
+		return;
+	}
+
+	delete client->socket;
+	delete client;
+}
@@ -0,0 +1,69 @@
+/*
+UWClockClient.h
+
+C interface for the external simulation to synchronize its clock with a UW timed processing plugin (see
+UWClockSync.h).  Build it as a shared library with Projects/Lin/Makefile (libUWClockClient.so) and call it from C,
+C++, or a Simulink S-function.
+
+The client pings the plugin's UDP port from its own socket and estimates the offset and drift between the two
+clocks.  Stamp the poses with UWClockClientNow() (in the timestamp schema field, or the time stamp of a binary pose
+record) and the plugin maps them onto its own clock.
+
+	UWClockClient * clock = UWClockClientOpen("192.168.1.10", 49003);
+	...
+	UWClockClientPoll(clock);					//once per simulation step (it never blocks)
+	t = UWClockClientNow();						//time stamp of the pose sent this step
+	...
+	UWClockClientClose(clock);
+*/
+
+#ifndef _UWClockClient_h_
+#define _UWClockClient_h_
+
+#define UW_CLOCK_PING_INTERVAL	0.2				//seconds between pings
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct UWClockClient UWClockClient;
+
+/*
+Open a client which pings the plugin at pluginAddress:pluginPort.  Returns NULL on failure.
+*/
+UWClockClient *	UWClockClientOpen(const char * pluginAddress, unsigned short pluginPort);
+
+/*
+Read the pongs which have arrived and send a ping if UW_CLOCK_PING_INTERVAL has passed since the last one
+*/
+void			UWClockClientPoll(UWClockClient * client);
+
+/*
+The sender clock (seconds since 1970) to time stamp poses with
+*/
+double			UWClockClientNow(void);
+
+/*
+1 once enough pongs have arrived for the estimate to be used
+*/
+int				UWClockClientSynchronized(const UWClockClient * client);
+
+/*
+Sender clock minus plugin clock at senderTime, and its uncertainty, in seconds
+*/
+double			UWClockClientOffset(const UWClockClient * client, double senderTime);
+
+double			UWClockClientUncertainty(const UWClockClient * client);
+
+/*
+Map a sender clock time onto the plugin clock
+*/
+double			UWClockClientToPlugin(const UWClockClient * client, double senderTime);
+
+void			UWClockClientClose(UWClockClient * client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
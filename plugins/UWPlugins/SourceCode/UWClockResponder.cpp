@@ -0,0 +1,178 @@
+/*
+UWClockResponder.cpp
+
+See UWClockResponder.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "UWClock.h"
+#include "UWClockResponder.h"
+
+using namespace std;
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Sender clock minus plugin clock now, including the drift since the estimate was made
+*/
+static double CurrentOffset(const UWClockResponder * responder)
+{
+	const UWClockEstimate * estimate = &responder->estimate;
+	if(!estimate->synchronized) {
+		return responder->fallbackOffset;
+	}
+
+	double senderNow = UWClockToSender(estimate, UWClockWallSeconds());
+	return estimate->offset + estimate->drift*(senderNow - estimate->reference);
+}
+
+
+
+static int GetSynchronized(void * inRefcon)
+{
+	return ((const UWClockResponder *)inRefcon)->estimate.synchronized ? 1 : 0;
+}
+
+
+
+static double GetOffset(void * inRefcon)
+{
+	return CurrentOffset((const UWClockResponder *)inRefcon);
+}
+
+
+
+static double GetUncertainty(void * inRefcon)
+{
+	return ((const UWClockResponder *)inRefcon)->estimate.uncertainty;
+}
+
+
+
+static double GetDrift(void * inRefcon)
+{
+	return ((const UWClockResponder *)inRefcon)->estimate.drift;
+}
+
+
+
+static XPLMDataRef RegisterDataRef(const char * prefix, const char * name, XPLMDataTypeID type,
+								   XPLMGetDatai_f readInt, XPLMGetDatad_f readDouble, void * refcon)
+{
+	char dataRefName[256];
+	sprintf(dataRefName, "%.200s/%s", prefix, name);
+
+	return XPLMRegisterDataAccessor(dataRefName, type, 0,
+									readInt, NULL, NULL, NULL, readDouble, NULL,
+									NULL, NULL, NULL, NULL, NULL, NULL,
+									refcon, NULL);
+}
+
+
+
+/*
+Start with no estimate (fallbackOffset is used until the sender is synchronized) and register the datarefs
+*/
+void UWClockResponderInit(UWClockResponder * responder, double fallbackOffset, const char * dataRefPrefix)
+{
+	memset(&responder->estimate, 0, sizeof(UWClockEstimate));
+	responder->estimate.synchronized	= false;
+	responder->fallbackOffset			= fallbackOffset;
+	responder->pings					= 0;
+
+	responder->dataRefs[0] = RegisterDataRef(dataRefPrefix, "clock_synchronized", xplmType_Int, GetSynchronized, NULL, responder);
+	responder->dataRefs[1] = RegisterDataRef(dataRefPrefix, "clock_offset", xplmType_Double, NULL, GetOffset, responder);
+	responder->dataRefs[2] = RegisterDataRef(dataRefPrefix, "clock_uncertainty", xplmType_Double, NULL, GetUncertainty, responder);
+	responder->dataRefs[3] = RegisterDataRef(dataRefPrefix, "clock_drift", xplmType_Double, NULL, GetDrift, responder);
+}
+
+
+
+void UWClockResponderStop(UWClockResponder * responder)
+{
+	for(int i = 0; i < UW_CLOCK_NUM_DATAREFS; i++) {
+		if(responder->dataRefs[i] != NULL) {
+			XPLMUnregisterDataAccessor(responder->dataRefs[i]);
+			responder->dataRefs[i] = NULL;
+		}
+	}
+}
+
+
+
+/*
+If the message is a ping, answer it to its sender and keep the estimate it carries.  Returns false if the message
+is not a ping.
+*/
+bool UWClockResponderAnswer(UWClockResponder * responder, UWPoseSource * source, const UWSourceMessage * message)
+{
+	if(message->kind != uwMessage_Packet || !UWClockIsPing(message->packet, message->length)) {
+		return false;
+	}
+
+	char reply[UW_CLOCK_MESSAGE_LENGTH];
+	UWClockEstimate estimate;
+	int length = UWClockAnswerPing(message->packet, message->length, message->receiveTime, UWClockWallSeconds(),
+								   reply, &estimate);
+	if(length > 0) {
+		UWSourceReply(source, reply, length, message->sourceAddress, message->sourcePort);
+		responder->estimate = estimate;
+		responder->pings++;
+	}
+	return true;
+}
+
+
+
+/*
+Map a sender time stamp onto the plugin clock
+*/
+double UWClockResponderToPlugin(const UWClockResponder * responder, double senderTime)
+{
+	if(!responder->estimate.synchronized) {
+		return senderTime - responder->fallbackOffset;
+	}
+	return UWClockToPlugin(&responder->estimate, senderTime);
+}
+
+
+
+/*
+Map a plugin clock time (UWClockWallSeconds) onto the sender clock
+*/
+double UWClockResponderToSender(const UWClockResponder * responder, double pluginTime)
+{
+	if(!responder->estimate.synchronized) {
+		return pluginTime + responder->fallbackOffset;
+	}
+	return UWClockToSender(&responder->estimate, pluginTime);
+}
+
+
+
+/*
+The sender clock now
+*/
+double UWClockResponderSenderTime(const UWClockResponder * responder)
+{
+	return UWClockResponderToSender(responder, UWClockWallSeconds());
+}
+
+
+
+/*
+One line for the overlay, e.g. "Clock offset 12.345 ms +- 0.120 ms".  outText must hold
+UW_CLOCK_DESCRIPTION_LENGTH characters.
+*/
+void UWClockResponderDescribe(const UWClockResponder * responder, char * outText)
+{
+	if(!responder->estimate.synchronized) {
+		sprintf(outText, "Clock offset %.3f ms (not synchronized)", 1000.0*responder->fallbackOffset);
+		return;
+	}
+	sprintf(outText, "Clock offset %.3f ms +- %.3f ms", 1000.0*CurrentOffset(responder),
+			1000.0*responder->estimate.uncertainty);
+}
@@ -0,0 +1,50 @@
+/*
+UWClockResponder.h
+
+Plugin side of the clock synchronization (see UWClockSync.h).  Pings received on the pose source are answered
+straight away and the sender's estimate they carry is kept, so sender time stamps can be mapped onto the plugin's
+clock.  The current estimate is published as read-only datarefs
+
+	<prefix>/clock_synchronized		int		1 once the sender has a usable estimate
+	<prefix>/clock_offset			double	sender clock minus plugin clock (seconds)
+	<prefix>/clock_uncertainty		double	seconds
+	<prefix>/clock_drift			double	seconds per second
+
+Until a synchronized estimate arrives the configured clock_offset is used instead (see UWEpochApply.h).
+*/
+
+#ifndef _UWClockResponder_h_
+#define _UWClockResponder_h_
+
+#include "XPLMDataAccess.h"
+
+#include "UWClockSync.h"
+#include "UWPoseSource.h"
+
+#define UW_CLOCK_NUM_DATAREFS		4
+#define UW_CLOCK_DESCRIPTION_LENGTH	64			//see UWClockResponderDescribe
+
+struct UWClockResponder {
+	UWClockEstimate		estimate;				//carried by the last ping
+	double				fallbackOffset;			//clock_offset from the config file
+	long long			pings;
+	XPLMDataRef			dataRefs[UW_CLOCK_NUM_DATAREFS];
+};
+
+
+
+void		UWClockResponderInit(UWClockResponder * responder, double fallbackOffset, const char * dataRefPrefix);
+
+void		UWClockResponderStop(UWClockResponder * responder);
+
+bool		UWClockResponderAnswer(UWClockResponder * responder, UWPoseSource * source, const UWSourceMessage * message);
+
+double		UWClockResponderToPlugin(const UWClockResponder * responder, double senderTime);
+
+double		UWClockResponderToSender(const UWClockResponder * responder, double pluginTime);
+
+double		UWClockResponderSenderTime(const UWClockResponder * responder);
+
+void		UWClockResponderDescribe(const UWClockResponder * responder, char * outText);
+
+#endif
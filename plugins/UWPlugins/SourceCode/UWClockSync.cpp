@@ -0,0 +1,208 @@
+/*
+UWClockSync.cpp
+
+See UWClockSync.h
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "UWClockSync.h"
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWClockSyncInit(UWClockSync * sync)
+{
+	sync->next			= 0;
+	sync->count			= 0;
+	sync->pingSequence	= 0;
+
+	sync->estimate.synchronized	= false;
+	sync->estimate.offset		= 0.0;
+	sync->estimate.drift		= 0.0;
+	sync->estimate.reference	= 0.0;
+	sync->estimate.uncertainty	= 0.0;
+}
+
+
+
+/*
+Write the next ping (sent at sender clock time now) into outPacket, which must hold UW_CLOCK_MESSAGE_LENGTH
+characters.  Returns its length.
+*/
+int UWClockBuildPing(UWClockSync * sync, double now, char * outPacket)
+{
+	const UWClockEstimate * estimate = &sync->estimate;
+	return sprintf(outPacket, "UWPING %u %.6f %d %.9f %.6e %.6f %.9f", sync->pingSequence++, now,
+				   estimate->synchronized ? 1 : 0, estimate->offset, estimate->drift, estimate->reference, estimate->uncertainty);
+}
+
+
+
+/*
+Fit the estimate to the samples whose delay is close to the smallest delay in the window
+*/
+static void UpdateEstimate(UWClockSync * sync)
+{
+	double minDelay = UW_CLOCK_MAX_DELAY;
+	for(int i = 0; i < sync->count; i++) {
+		if(sync->samples[i].delay < minDelay) {
+			minDelay = sync->samples[i].delay;
+		}
+	}
+
+	//a sample whose delay is more than twice the best one (plus 0.5 ms for timer noise) was held up on the way
+	double maxDelay = 2.0*minDelay + 0.0005;
+
+	int		n		= 0;
+	double	sumTime	= 0.0;
+	double	sumOffset = 0.0;
+	for(int i = 0; i < sync->count; i++) {
+		if(sync->samples[i].delay <= maxDelay) {
+			n++;
+			sumTime		+= sync->samples[i].time;
+			sumOffset	+= sync->samples[i].offset;
+		}
+	}
+
+	double reference	= sumTime/n;
+	double meanOffset	= sumOffset/n;
+
+	//least squares fit of the drift about the mean sample time
+	double sumTT = 0.0;
+	double sumTO = 0.0;
+	for(int i = 0; i < sync->count; i++) {
+		if(sync->samples[i].delay <= maxDelay) {
+			double t = sync->samples[i].time - reference;
+			sumTT += t*t;
+			sumTO += t*(sync->samples[i].offset - meanOffset);
+		}
+	}
+
+	//with too few samples or too short a window the drift is noise, so only the offset is used
+	double drift = 0.0;
+	if(n >= UW_CLOCK_MIN_SAMPLES && sumTT > 0.0) {
+		drift = sumTO/sumTT;
+		if(fabs(drift) > UW_CLOCK_MAX_DRIFT) {
+			drift = 0.0;
+		}
+	}
+
+	double sumResidual = 0.0;
+	for(int i = 0; i < sync->count; i++) {
+		if(sync->samples[i].delay <= maxDelay) {
+			double residual = sync->samples[i].offset - meanOffset - drift*(sync->samples[i].time - reference);
+			sumResidual += residual*residual;
+		}
+	}
+
+	UWClockEstimate * estimate = &sync->estimate;
+	estimate->synchronized	= sync->count >= UW_CLOCK_MIN_SAMPLES;
+	estimate->offset		= meanOffset;
+	estimate->drift			= drift;
+	estimate->reference		= reference;
+	estimate->uncertainty	= minDelay/2.0 + sqrt(sumResidual/n);
+}
+
+
+
+/*
+Take one sample from a pong received at sender clock time receiveTime and update the estimate.  Returns false if
+the packet is not a pong or the round trip is out of range.
+*/
+bool UWClockHandlePong(UWClockSync * sync, const char * packet, int length, double receiveTime)
+{
+	if(!UWClockIsPong(packet, length)) {
+		return false;
+	}
+
+	unsigned int sequence;
+	double t1, t2, t3;
+	if(sscanf(packet + 6, "%u %lf %lf %lf", &sequence, &t1, &t2, &t3) != 4) {
+		return false;
+	}
+
+	double t4		= receiveTime;
+	double delay	= (t4 - t1) - (t3 - t2);
+	if(delay < 0.0 || delay > UW_CLOCK_MAX_DELAY) {
+		return false;
+	}
+
+	UWClockSample * sample = &sync->samples[sync->next];
+	sample->time	= (t1 + t4)/2.0;
+	sample->offset	= ((t1 - t2) + (t4 - t3))/2.0;
+	sample->delay	= delay;
+
+	sync->next = (sync->next + 1) % UW_CLOCK_SAMPLES;
+	if(sync->count < UW_CLOCK_SAMPLES) {
+		sync->count++;
+	}
+
+	UpdateEstimate(sync);
+	return true;
+}
+
+
+
+bool UWClockIsPing(const char * packet, int length)
+{
+	return length >= 6 && memcmp(packet, "UWPING", 6) == 0;
+}
+
+
+
+bool UWClockIsPong(const char * packet, int length)
+{
+	return length >= 6 && memcmp(packet, "UWPONG", 6) == 0;
+}
+
+
+
+/*
+Plugin side: write the pong for a ping received at plugin clock time receiveTime into outReply (which must hold
+UW_CLOCK_MESSAGE_LENGTH characters) and copy the sender's estimate carried by the ping into outEstimate.  packet
+must be '\0' terminated.  Returns the length of the pong, or 0 if the ping is badly formed.
+*/
+int UWClockAnswerPing(const char * packet, int length, double receiveTime, double sendTime,
+					  char * outReply, UWClockEstimate * outEstimate)
+{
+	if(!UWClockIsPing(packet, length)) {
+		return 0;
+	}
+
+	unsigned int sequence;
+	double t1;
+	int synchronized;
+	UWClockEstimate estimate;
+	if(sscanf(packet + 6, "%u %lf %d %lf %lf %lf %lf", &sequence, &t1, &synchronized,
+			  &estimate.offset, &estimate.drift, &estimate.reference, &estimate.uncertainty) != 7) {
+		return 0;
+	}
+
+	estimate.synchronized	= synchronized != 0;
+	*outEstimate			= estimate;
+
+	return sprintf(outReply, "UWPONG %u %.6f %.6f %.6f", sequence, t1, receiveTime, sendTime);
+}
+
+
+
+/*
+Map a sender clock time onto the plugin clock
+*/
+double UWClockToPlugin(const UWClockEstimate * estimate, double senderTime)
+{
+	return senderTime - (estimate->offset + estimate->drift*(senderTime - estimate->reference));
+}
+
+
+
+/*
+Map a plugin clock time onto the sender clock (the inverse of UWClockToPlugin)
+*/
+double UWClockToSender(const UWClockEstimate * estimate, double pluginTime)
+{
+	return (pluginTime + estimate->offset - estimate->drift*estimate->reference)/(1.0 - estimate->drift);
+}
@@ -0,0 +1,83 @@
+/*
+UWClockSync.h
+
+Clock synchronization between the external simulation (the sender) and the plugin, so that the time stamps the
+sender puts on poses can be mapped onto the plugin's clock instead of the plugin stamping poses when they arrive.
+
+The sender pings the plugin over the same socket it sends poses on and the plugin answers straight away
+
+	UWPING <seq> <t1> <synchronized> <offset> <drift> <reference> <uncertainty>
+	UWPONG <seq> <t1> <t2> <t3>
+
+	t1	sender clock when the ping was sent
+	t2	plugin clock when the ping was received
+	t3	plugin clock when the pong was sent
+	t4	sender clock when the pong was received (not sent)
+
+Each exchange gives one sample of the offset (sender clock minus plugin clock) and of the round trip delay
+
+	offset	= ((t1 - t2) + (t4 - t3)) / 2
+	delay	= (t4 - t1) - (t3 - t2)
+
+The error of a sample is at most delay / 2, so the estimator (UWClockHandlePong) keeps the last UW_CLOCK_SAMPLES
+samples, throws away the ones whose delay is well above the smallest delay in the window (they were queued
+somewhere on the way) and fits offset + drift * (t - reference) to the rest by least squares.  The uncertainty is
+half the smallest delay plus the rms residual of the fit.
+
+Every ping carries the sender's current estimate, so the plugin always has the mapping without estimating
+anything itself (see UWClockResponder.h).  Both clocks are UWClockWallSeconds.
+
+This header does not depend on the X-Plane SDK so the sender can use it (see UWClockClient.h).
+*/
+
+#ifndef _UWClockSync_h_
+#define _UWClockSync_h_
+
+#define UW_CLOCK_SAMPLES		64				//samples kept by the estimator (about 13 s at the default ping rate)
+#define UW_CLOCK_MIN_SAMPLES	4				//samples needed before the estimate is used
+#define UW_CLOCK_MAX_DELAY		1.0				//seconds, round trips longer than this are ignored
+#define UW_CLOCK_MAX_DRIFT		500e-6			//largest believable drift (500 ppm)
+#define UW_CLOCK_MESSAGE_LENGTH	192				//longest ping or pong including the '\0'
+
+struct UWClockEstimate {
+	bool			synchronized;				//false until UW_CLOCK_MIN_SAMPLES samples have been taken
+	double			offset;						//sender clock minus plugin clock at reference (seconds)
+	double			drift;						//change of the offset per second of sender clock
+	double			reference;					//sender clock time of the offset
+	double			uncertainty;				//seconds
+};
+
+struct UWClockSample {
+	double			time;						//sender clock half way through the exchange
+	double			offset;
+	double			delay;
+};
+
+struct UWClockSync {
+	UWClockSample	samples[UW_CLOCK_SAMPLES];	//ring of the most recent samples
+	int				next;
+	int				count;
+	unsigned int	pingSequence;
+	UWClockEstimate	estimate;
+};
+
+
+
+void			UWClockSyncInit(UWClockSync * sync);
+
+int				UWClockBuildPing(UWClockSync * sync, double now, char * outPacket);
+
+bool			UWClockHandlePong(UWClockSync * sync, const char * packet, int length, double receiveTime);
+
+bool			UWClockIsPing(const char * packet, int length);
+
+bool			UWClockIsPong(const char * packet, int length);
+
+int				UWClockAnswerPing(const char * packet, int length, double receiveTime, double sendTime,
+								  char * outReply, UWClockEstimate * outEstimate);
+
+double			UWClockToPlugin(const UWClockEstimate * estimate, double senderTime);
+
+double			UWClockToSender(const UWClockEstimate * estimate, double pluginTime);
+
+#endif
@@ -0,0 +1,200 @@
+/*
+UWDataRefBatch.cpp
+
+See UWDataRefBatch.h
+*/
+
+#include <string.h>
+#include "XPLMDataAccess.h"
+
+#include "UWDataRefBatch.h"
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Remove all registered datarefs and pending writes
+*/
+void UWBatchInit(UWDataRefBatch * batch)
+{
+	batch->numEntries		= 0;
+	batch->numDirty			= 0;
+	batch->numValues		= 0;
+	batch->lastFlushCalls	= 0;
+	memset(batch->written, 0, sizeof(batch->written));
+}
+
+
+
+/*
+Register a dataref with the batch.  The type and array size are resolved here, once.  Registering the same
+dataref twice returns the same handle.
+
+Returns the handle used to write to the dataref, or -1 if the dataref is NULL, has no usable type or the batch
+is full.
+*/
+int UWBatchRegister(UWDataRefBatch * batch, XPLMDataRef dataRef)
+{
+	if(dataRef == NULL) {
+		return -1;
+	}
+
+	for(int i = 0; i < batch->numEntries; i++) {
+		if(batch->entries[i].dataRef == dataRef) {
+			return i;
+		}
+	}
+
+	if(batch->numEntries >= UW_BATCH_MAX_DATAREFS) {
+		return -1;
+	}
+
+	UWBatchKind		kind;
+	int				arraySize = 1;
+	XPLMDataTypeID	types = XPLMGetDataRefTypes(dataRef);
+
+	if(types & xplmType_FloatArray) {
+		kind		= uwBatch_FloatArray;
+		arraySize	= XPLMGetDatavf(dataRef, NULL, 0, 0);
+	} else if(types & xplmType_IntArray) {
+		kind		= uwBatch_IntArray;
+		arraySize	= XPLMGetDatavi(dataRef, NULL, 0, 0);
+	} else if(types & xplmType_Double) {
+		kind		= uwBatch_Double;
+	} else if(types & xplmType_Float) {
+		kind		= uwBatch_Float;
+	} else if(types & xplmType_Int) {
+		kind		= uwBatch_Int;
+	} else {
+		return -1;
+	}
+
+	if(arraySize <= 0 || batch->numValues + arraySize > UW_BATCH_MAX_VALUES) {
+		return -1;
+	}
+
+	UWBatchEntry * entry = &batch->entries[batch->numEntries];
+	entry->dataRef		= dataRef;
+	entry->kind			= kind;
+	entry->arraySize	= arraySize;
+	entry->firstValue	= batch->numValues;
+	entry->dirtyBegin	= 0;
+	entry->dirtyEnd		= 0;
+
+	batch->numValues += arraySize;
+
+	return batch->numEntries++;
+}
+
+
+
+/*
+Record a write of one element (use index 0 for scalar datarefs).  Nothing is sent to X-Plane until UWBatchFlush.
+*/
+void UWBatchSet(UWDataRefBatch * batch, int handle, int index, double value)
+{
+	if(handle < 0 || handle >= batch->numEntries) {
+		return;
+	}
+
+	UWBatchEntry * entry = &batch->entries[handle];
+	if(index < 0 || index >= entry->arraySize) {
+		return;
+	}
+
+	int valueIndex = entry->firstValue + index;
+	batch->values[valueIndex]	= value;
+	batch->written[valueIndex]	= 1;
+
+	if(entry->dirtyBegin == entry->dirtyEnd) {
+		//first write to this dataref since the last flush
+		batch->dirtyEntries[batch->numDirty++] = handle;
+		entry->dirtyBegin	= index;
+		entry->dirtyEnd		= index + 1;
+	} else {
+		if(index < entry->dirtyBegin) {
+			entry->dirtyBegin = index;
+		}
+		if(index + 1 > entry->dirtyEnd) {
+			entry->dirtyEnd = index + 1;
+		}
+	}
+}
+
+
+
+/*
+Record a write of count elements starting at offset
+*/
+void UWBatchSetv(UWDataRefBatch * batch, int handle, const double * values, int offset, int count)
+{
+	for(int i = 0; i < count; i++) {
+		UWBatchSet(batch, handle, offset + i, values[i]);
+	}
+}
+
+
+
+/*
+Send every pending write to X-Plane.  Each array dataref gets one XPLMSetDatavf/XPLMSetDatavi call per contiguous
+run of written elements (normally just one) and each scalar dataref gets one XPLMSetData* call.
+
+Returns the number of XPLMSetData* calls that were made.
+*/
+int UWBatchFlush(UWDataRefBatch * batch)
+{
+	int numCalls = 0;
+
+	for(int d = 0; d < batch->numDirty; d++) {
+		UWBatchEntry * entry = &batch->entries[batch->dirtyEntries[d]];
+		const double * values = batch->values + entry->firstValue;
+		unsigned char * written = batch->written + entry->firstValue;
+
+		switch(entry->kind) {
+			case uwBatch_Float:		XPLMSetDataf(entry->dataRef, (float)values[0]);	numCalls++;	break;
+			case uwBatch_Double:	XPLMSetDatad(entry->dataRef, values[0]);		numCalls++;	break;
+			case uwBatch_Int:		XPLMSetDatai(entry->dataRef, (int)values[0]);	numCalls++;	break;
+
+			case uwBatch_FloatArray:
+			case uwBatch_IntArray:
+				{
+					int i = entry->dirtyBegin;
+					while(i < entry->dirtyEnd) {
+						//skip elements which were not written
+						if(!written[i]) {
+							i++;
+							continue;
+						}
+
+						//find the end of this run of written elements
+						int runBegin = i;
+						while(i < entry->dirtyEnd && written[i]) {
+							if(entry->kind == uwBatch_FloatArray) {
+								batch->floatScratch[i - runBegin] = (float)values[i];
+							} else {
+								batch->intScratch[i - runBegin] = (int)values[i];
+							}
+							i++;
+						}
+
+						if(entry->kind == uwBatch_FloatArray) {
+							XPLMSetDatavf(entry->dataRef, batch->floatScratch, runBegin, i - runBegin);
+						} else {
+							XPLMSetDatavi(entry->dataRef, batch->intScratch, runBegin, i - runBegin);
+						}
+						numCalls++;
+					}
+				}
+				break;
+		}
+
+		memset(written + entry->dirtyBegin, 0, entry->dirtyEnd - entry->dirtyBegin);
+		entry->dirtyBegin	= 0;
+		entry->dirtyEnd		= 0;
+	}
+
+	batch->numDirty			= 0;
+	batch->lastFlushCalls	= numCalls;
+
+	return numCalls;
+}
@@ -0,0 +1,71 @@
+/*
+UWDataRefBatch.h
+
+A batched write layer for datarefs.  Writes made during a frame are only recorded (grouped by dataref) and
+UWBatchFlush then issues them all at once:
+
+	array datarefs		one XPLMSetDatavf/XPLMSetDatavi call per contiguous run of written slots (so writing all
+						20 slots of a multi-aircraft array is a single call instead of 20)
+	scalar datarefs		one XPLMSetData* call with the last value written during the frame
+
+Datarefs are registered once at startup (their type and array size are resolved then) and are written through
+the returned handle.  Nothing is allocated after UWBatchInit.
+
+Note that the SDK does not have a double array type (there is no XPLMSetDatavd), so double values written to
+an array dataref are converted to the type of the dataref.
+*/
+
+#ifndef _UWDataRefBatch_h_
+#define _UWDataRefBatch_h_
+
+#include "XPLMDataAccess.h"
+
+#define UW_BATCH_MAX_DATAREFS	256			//most datarefs which can be registered
+#define UW_BATCH_MAX_VALUES		8192		//most array elements over all of the registered datarefs
+
+enum UWBatchKind {
+	uwBatch_Float		= 0,
+	uwBatch_Double		= 1,
+	uwBatch_Int			= 2,
+	uwBatch_FloatArray	= 3,
+	uwBatch_IntArray	= 4
+};
+
+struct UWBatchEntry {
+	XPLMDataRef		dataRef;
+	UWBatchKind		kind;
+	int				arraySize;				//number of elements (1 for scalars)
+	int				firstValue;				//index of the first element in the storage of the batch
+	int				dirtyBegin;				//range of written elements [dirtyBegin, dirtyEnd), empty if not written
+	int				dirtyEnd;
+};
+
+struct UWDataRefBatch {
+	int				numEntries;
+	UWBatchEntry	entries[UW_BATCH_MAX_DATAREFS];
+
+	int				numDirty;
+	int				dirtyEntries[UW_BATCH_MAX_DATAREFS];	//entries written since the last flush
+
+	int				numValues;
+	double			values[UW_BATCH_MAX_VALUES];			//pending value of every element
+	unsigned char	written[UW_BATCH_MAX_VALUES];			//1 if the element was written since the last flush
+	float			floatScratch[UW_BATCH_MAX_VALUES];		//used to hand contiguous runs to XPLMSetDatavf
+	int				intScratch[UW_BATCH_MAX_VALUES];		//used to hand contiguous runs to XPLMSetDatavi
+
+	int				lastFlushCalls;							//number of XPLMSetData* calls made by the last flush
+};
+
+
+
+void	UWBatchInit(UWDataRefBatch * batch);
+
+int		UWBatchRegister(UWDataRefBatch * batch, XPLMDataRef dataRef);
+
+void	UWBatchSet(UWDataRefBatch * batch, int handle, int index, double value);
+
+void	UWBatchSetv(UWDataRefBatch * batch, int handle, const double * values, int offset, int count);
+
+int		UWBatchFlush(UWDataRefBatch * batch);
+
+#endif
@@ -0,0 +1,312 @@
+/*
+UWDataRefSchema.cpp
+
+See UWDataRefSchema.h
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "XPLMDataAccess.h"
+#include "XPLMUtilities.h"
+
+#include "UWDataRefSchema.h"
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Remove all fields from the schema
+*/
+void UWSchemaClear(UWDataRefSchema * schema)
+{
+	schema->numFields		= 0;
+	schema->numPacketWords	= 0;
+	schema->numBindings		= 0;
+}
+
+
+
+/*
+Add a field to the schema.  Returns the index of the new field or -1 if the schema is full or packetOffset is out
+of range.
+
+Pass a packetOffset of -1 if the field is not read from the packet and a NULL (or "-") dataRefString if the
+field is not written to a dataref.  UWSchemaResolve must be called after all of the fields have been added.
+*/
+int UWSchemaAddField(
+					UWDataRefSchema *	schema,
+					const char *		name,
+					int					packetOffset,
+					UWFieldType			type,
+					double				scale,
+					const char *		dataRefString)
+{
+	if(schema->numFields >= UW_SCHEMA_MAX_FIELDS || packetOffset < -1 || packetOffset >= UW_SCHEMA_MAX_WORDS) {
+		return -1;
+	}
+
+	UWSchemaField * field = &schema->fields[schema->numFields];
+
+	strncpy(field->name, name, UW_SCHEMA_NAME_LENGTH - 1);
+	field->name[UW_SCHEMA_NAME_LENGTH - 1] = '\0';
+
+	if(dataRefString == NULL || strcmp(dataRefString, "-") == 0) {
+		field->dataRefString[0] = '\0';
+	} else {
+		strncpy(field->dataRefString, dataRefString, UW_SCHEMA_DATAREF_LENGTH - 1);
+		field->dataRefString[UW_SCHEMA_DATAREF_LENGTH - 1] = '\0';
+	}
+
+	field->packetOffset	= packetOffset;
+	field->type			= type;
+	field->scale		= scale;
+	field->dataRef		= NULL;
+
+	return schema->numFields++;
+}
+
+
+
+/*
+Load the schema from the specified file in the X-System folder.  Returns the number of fields that were loaded.
+
+If the file cannot be opened the schema is left untouched and 0 is returned, so the caller can fall back to its
+default table.
+*/
+int UWSchemaLoad(UWDataRefSchema * schema, const char * fileName)
+{
+	char	inputPath[512];
+	XPLMGetSystemPath(inputPath);
+	strncat(inputPath, fileName, sizeof(inputPath) - strlen(inputPath) - 1);
+
+	FILE * inputFile = fopen(inputPath, "r");
+	if(inputFile == NULL) {
+		return 0;
+	}
+
+	UWSchemaClear(schema);
+
+	char line[512];
+	while(fgets(line, sizeof(line), inputFile) != NULL) {
+		//strip comments
+		char * comment = strchr(line, '#');
+		if(comment != NULL) {
+			*comment = '\0';
+		}
+
+		char	name[UW_SCHEMA_NAME_LENGTH];
+		int		packetOffset;
+		char	typeString[16];
+		double	scale;
+		char	dataRefString[UW_SCHEMA_DATAREF_LENGTH];
+
+		if(sscanf(line, "%31s %d %15s %lf %254s", name, &packetOffset, typeString, &scale, dataRefString) != 5) {
+			continue;		//blank line or badly formed line
+		}
+
+		UWFieldType type = uwFieldType_Float;
+		if(strcmp(typeString, "double") == 0) {
+			type = uwFieldType_Double;
+		} else if(strcmp(typeString, "int") == 0) {
+			type = uwFieldType_Int;
+		} else if(strcmp(typeString, "float") != 0) {
+			char message[300];
+			sprintf(message, "UWDataRefSchema: unknown type %s for field %s, read as float\n", typeString, name);
+			XPLMDebugString(message);
+		}
+
+		if(UWSchemaAddField(schema, name, packetOffset, type, scale, dataRefString) < 0) {
+			char message[300];
+			sprintf(message, "UWDataRefSchema: field %s skipped (offset %d out of range or too many fields)\n", name,
+					packetOffset);
+			XPLMDebugString(message);
+		}
+	}
+
+	fclose(inputFile);
+
+	return schema->numFields;
+}
+
+
+
+/*
+Resolve every dataref handle and type once and build the compact array of bindings used by UWSchemaApply.
+
+If a dataref does not support the requested type, the closest type it does support is used instead.
+*/
+void UWSchemaResolve(UWDataRefSchema * schema)
+{
+	schema->numPacketWords	= 0;
+	schema->numBindings		= 0;
+
+	for(int i = 0; i < schema->numFields; i++) {
+		UWSchemaField * field = &schema->fields[i];
+
+		if(field->packetOffset + 1 > schema->numPacketWords) {
+			schema->numPacketWords = field->packetOffset + 1;
+		}
+
+		field->dataRef = NULL;
+		if(field->dataRefString[0] == '\0') {
+			continue;
+		}
+
+		XPLMDataRef dataRef = XPLMFindDataRef(field->dataRefString);
+		if(dataRef == NULL) {
+			char message[300];
+			sprintf(message, "UWDataRefSchema: unable to find dataref %s\n", field->dataRefString);
+			XPLMDebugString(message);
+			continue;
+		}
+
+		XPLMDataTypeID types = XPLMGetDataRefTypes(dataRef);
+		XPLMDataTypeID requested = (field->type == uwFieldType_Double) ? xplmType_Double :
+								   (field->type == uwFieldType_Int) ? xplmType_Int : xplmType_Float;
+
+		if((types & requested) == 0) {
+			if(types & xplmType_Double) {
+				field->type = uwFieldType_Double;
+			} else if(types & xplmType_Float) {
+				field->type = uwFieldType_Float;
+			} else if(types & xplmType_Int) {
+				field->type = uwFieldType_Int;
+			} else {
+				char message[300];
+				sprintf(message, "UWDataRefSchema: dataref %s is not a scalar\n", field->dataRefString);
+				XPLMDebugString(message);
+				continue;
+			}
+		}
+
+		field->dataRef = dataRef;
+
+		if(field->packetOffset >= 0) {
+			UWSchemaBinding * binding = &schema->bindings[schema->numBindings++];
+			binding->dataRef		= dataRef;
+			binding->packetOffset	= field->packetOffset;
+			binding->type			= field->type;
+			binding->scale			= field->scale;
+		}
+	}
+}
+
+
+
+/*
+Find the index of the field with the specified name.  Returns -1 if there is no such field.
+*/
+int UWSchemaFindField(const UWDataRefSchema * schema, const char * name)
+{
+	for(int i = 0; i < schema->numFields; i++) {
+		if(strcmp(schema->fields[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+
+/*
+Convert a space (or comma) deliniated packet into words.  Only as many words as the schema needs are parsed.
+Returns the number of words that were parsed.
+*/
+int UWSchemaParsePacket(const UWDataRefSchema * schema, const char * packet, double * outWords)
+{
+	int numWords = 0;
+	const char * pch = packet;
+
+	while(numWords < schema->numPacketWords) {
+		while(*pch == ' ' || *pch == ',' || *pch == '\t' || *pch == '\r' || *pch == '\n') {
+			pch++;
+		}
+
+		char * end;
+		double value = strtod(pch, &end);
+		if(end == pch) {
+			break;			//end of packet (or not a number)
+		}
+
+		outWords[numWords++] = value;
+		pch = end;
+	}
+
+	return numWords;
+}
+
+
+
+/*
+Write every bound packet word to its dataref
+*/
+void UWSchemaApply(const UWDataRefSchema * schema, const double * words)
+{
+	const UWSchemaBinding * binding = schema->bindings;
+	const UWSchemaBinding * end = binding + schema->numBindings;
+
+	for(; binding < end; binding++) {
+		double value = words[binding->packetOffset] * binding->scale;
+
+		switch(binding->type) {
+			case uwFieldType_Float:		XPLMSetDataf(binding->dataRef, (float)value);	break;
+			case uwFieldType_Double:	XPLMSetDatad(binding->dataRef, value);			break;
+			case uwFieldType_Int:		XPLMSetDatai(binding->dataRef, (int)value);		break;
+		}
+	}
+}
+
+
+
+/*
+Get the (scaled) value of a field from the packet words.  Returns 0 if the field is not read from the packet.
+*/
+double UWSchemaGetValue(const UWDataRefSchema * schema, int fieldIndex, const double * words)
+{
+	if(fieldIndex < 0 || schema->fields[fieldIndex].packetOffset < 0) {
+		return 0.0;
+	}
+
+	const UWSchemaField * field = &schema->fields[fieldIndex];
+	return words[field->packetOffset] * field->scale;
+}
+
+
+
+/*
+Write a value to the dataref of a field (used for fields which are computed by the plugin, e.g. local_x)
+*/
+void UWSchemaSetField(const UWDataRefSchema * schema, int fieldIndex, double value)
+{
+	if(fieldIndex < 0 || schema->fields[fieldIndex].dataRef == NULL) {
+		return;
+	}
+
+	const UWSchemaField * field = &schema->fields[fieldIndex];
+	switch(field->type) {
+		case uwFieldType_Float:		XPLMSetDataf(field->dataRef, (float)value);	break;
+		case uwFieldType_Double:	XPLMSetDatad(field->dataRef, value);		break;
+		case uwFieldType_Int:		XPLMSetDatai(field->dataRef, (int)value);	break;
+	}
+}
+
+
+
+/*
+Read the current value of the dataref of a field using its resolved type
+*/
+double UWSchemaReadField(const UWDataRefSchema * schema, int fieldIndex)
+{
+	if(fieldIndex < 0 || schema->fields[fieldIndex].dataRef == NULL) {
+		return 0.0;
+	}
+
+	const UWSchemaField * field = &schema->fields[fieldIndex];
+	switch(field->type) {
+		case uwFieldType_Float:		return XPLMGetDataf(field->dataRef);
+		case uwFieldType_Double:	return XPLMGetDatad(field->dataRef);
+		case uwFieldType_Int:		return XPLMGetDatai(field->dataRef);
+	}
+	return 0.0;
+}
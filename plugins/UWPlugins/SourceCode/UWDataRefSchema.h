@@ -0,0 +1,107 @@
+/*
+UWDataRefSchema.h
+
+A data-driven table which describes how the words of a received packet map onto X-Plane datarefs.  Each field
+lists a name, the word number in the packet, the type to write, a scale factor and the target dataref.
+
+The schema is built once at startup (from a text file in the X-System folder, or from a default table supplied
+by the plugin) and every dataref handle and type is then resolved once with XPLMFindDataRef/XPLMGetDataRefTypes.
+The per-frame path (UWSchemaApply) is a tight loop over a compact precomputed array of bindings.
+
+Schema file format (one field per line, '#' starts a comment)
+
+	name	offset	type	scale	dataref
+
+	name	short name used by the plugin to find the field (e.g. latitude)
+	offset	word number in the packet, or -1 if the field is not read from the packet (e.g. local_x)
+	type	float, double or int (the type written to the dataref)
+	scale	the packet word is multiplied by this before it is written
+	dataref	the dataref to write, or - if the word is not written to a dataref (e.g. camera values)
+
+For example
+
+	phi			0	float	1.0	sim/flightmodel/position/phi
+	latitude	3	double	1.0	sim/flightmodel/position/latitude
+	local_x		-1	double	1.0	sim/flightmodel/position/local_x
+*/
+
+#ifndef _UWDataRefSchema_h_
+#define _UWDataRefSchema_h_
+
+#include "XPLMDataAccess.h"
+
+#define UW_SCHEMA_MAX_FIELDS		64		//maximum number of fields in a schema
+#define UW_SCHEMA_MAX_WORDS			64		//maximum number of words that are parsed from a packet
+#define UW_SCHEMA_NAME_LENGTH		32		//longest field name
+#define UW_SCHEMA_DATAREF_LENGTH	255		//longest dataref string
+
+enum UWFieldType {
+	uwFieldType_Float	= 0,
+	uwFieldType_Double	= 1,
+	uwFieldType_Int		= 2
+};
+
+/*
+One field of the schema as it was described at startup
+*/
+struct UWSchemaField {
+	char			name[UW_SCHEMA_NAME_LENGTH];
+	int				packetOffset;							//word number in the packet (-1 if not read from the packet)
+	UWFieldType		type;									//type written to the dataref (after resolving against the dataref)
+	double			scale;									//packet word is multiplied by this before it is written
+	char			dataRefString[UW_SCHEMA_DATAREF_LENGTH];	//empty if the field is not written to a dataref
+	XPLMDataRef		dataRef;								//resolved handle (NULL if not found or not used)
+};
+
+/*
+The compact per-frame form of a field which is both read from the packet and written to a dataref
+*/
+struct UWSchemaBinding {
+	XPLMDataRef		dataRef;
+	int				packetOffset;
+	UWFieldType		type;
+	double			scale;
+};
+
+struct UWDataRefSchema {
+	int				numFields;
+	UWSchemaField	fields[UW_SCHEMA_MAX_FIELDS];
+
+	int				numPacketWords;							//number of words a packet must carry (largest packetOffset + 1)
+	int				numBindings;
+	UWSchemaBinding	bindings[UW_SCHEMA_MAX_FIELDS];			//filled in by UWSchemaResolve
+};
+
+
+
+//----------------------------STARTUP (NOT ON THE PER-FRAME PATH)----------------------------
+void	UWSchemaClear(UWDataRefSchema * schema);
+
+int		UWSchemaAddField(
+					UWDataRefSchema *	schema,
+					const char *		name,
+					int					packetOffset,
+					UWFieldType			type,
+					double				scale,
+					const char *		dataRefString);
+
+int		UWSchemaLoad(UWDataRefSchema * schema, const char * fileName);
+
+void	UWSchemaResolve(UWDataRefSchema * schema);
+
+int		UWSchemaFindField(const UWDataRefSchema * schema, const char * name);
+
+
+
+//----------------------------PER-FRAME-------------------------------------------------------
+int		UWSchemaParsePacket(const UWDataRefSchema * schema, const char * packet, double * outWords);
+
+void	UWSchemaApply(const UWDataRefSchema * schema, const double * words);
+
+double	UWSchemaGetValue(const UWDataRefSchema * schema, int fieldIndex, const double * words);
+
+void	UWSchemaSetField(const UWDataRefSchema * schema, int fieldIndex, double value);
+
+double	UWSchemaReadField(const UWDataRefSchema * schema, int fieldIndex);
+
+#endif
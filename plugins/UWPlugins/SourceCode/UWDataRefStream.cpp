@@ -0,0 +1,245 @@
+/*
+UWDataRefStream.cpp
+
+See UWDataRefStream.h
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "XPLMDataAccess.h"
+
+#include "UWDataRefStream.h"
+
+//----------------------------GLOBAL VARIALBES----------------------------------------
+#define MAX_STREAM_VALUES (UW_STREAM_MAX_PACKET / 4)		//most values that can be carried by one entry
+
+static float	sFloatValues[MAX_STREAM_VALUES];			//scratch buffers so nothing is allocated per readback
+static int		sIntValues[MAX_STREAM_VALUES];
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Remove all subscriptions and outputs.  Incoming values are written to the batch, which the caller flushes.  The
+batch belongs to the stream: UWRESET clears its registrations too, so renegotiating never runs it out of room.
+*/
+void UWStreamInit(UWDataRefStream * stream, UWDataRefBatch * batch)
+{
+	memset(stream->subscriptions, 0, sizeof(stream->subscriptions));
+	stream->numOutputs	= 0;
+	stream->batch		= batch;
+}
+
+
+
+/*
+Handle one of the text subscription messages (UWSUB, UWOUT, UWRESET).  This is where all of the dataref strings are
+resolved, so it only happens when the sender (re)negotiates, never per frame.
+
+Returns the length of the reply written to outReply (0 if there is nothing to reply).
+*/
+int UWStreamHandleControl(UWDataRefStream * stream, const char * packet, int length, char * outReply, int replySize)
+{
+	char message[512];
+	if(length > (int)sizeof(message) - 1) {
+		length = sizeof(message) - 1;
+	}
+	memcpy(message, packet, length);
+	message[length] = '\0';
+
+	char reply[64];
+	reply[0] = '\0';
+
+	if(strncmp(message, "UWSUB", 5) == 0) {
+		int		id;
+		char	dataRefString[255];
+		if(sscanf(message + 5, "%d %254s", &id, dataRefString) != 2 || id < 0 || id >= UW_STREAM_MAX_IDS) {
+			return 0;
+		}
+
+		UWStreamSubscription * subscription = &stream->subscriptions[id];
+		subscription->dataRef	= XPLMFindDataRef(dataRefString);
+		subscription->types		= 0;
+		subscription->arraySize	= 0;
+
+		if(subscription->dataRef != NULL && !XPLMCanWriteDataRef(subscription->dataRef)) {
+			//read only: the values sent for it would be lost
+			subscription->dataRef = NULL;
+		}
+
+		if(subscription->dataRef == NULL) {
+			sprintf(reply, "UWNAK %d", id);
+		} else {
+			subscription->types = XPLMGetDataRefTypes(subscription->dataRef);
+			if(subscription->types & xplmType_FloatArray) {
+				subscription->arraySize = XPLMGetDatavf(subscription->dataRef, NULL, 0, 0);
+			} else if(subscription->types & xplmType_IntArray) {
+				subscription->arraySize = XPLMGetDatavi(subscription->dataRef, NULL, 0, 0);
+			}
+			subscription->batchHandle = UWBatchRegister(stream->batch, subscription->dataRef);
+			if(subscription->batchHandle < 0) {
+				//no usable type, or the batch is full: writes could not reach the dataref
+				subscription->dataRef = NULL;
+				sprintf(reply, "UWNAK %d", id);
+			} else {
+				sprintf(reply, "UWACK %d %d %d", id, (int)subscription->types, subscription->arraySize);
+			}
+		}
+
+	} else if(strncmp(message, "UWOUT", 5) == 0) {
+		stream->numOutputs = 0;
+
+		char * pch = message + 5;
+		char * end;
+		while(stream->numOutputs < UW_STREAM_MAX_OUTPUTS) {
+			long id = strtol(pch, &end, 10);
+			if(end == pch) {
+				break;
+			}
+			if(id >= 0 && id < UW_STREAM_MAX_IDS) {
+				stream->outputs[stream->numOutputs++] = (unsigned short)id;
+			}
+			pch = end;
+		}
+		sprintf(reply, "UWACK OUT %d", stream->numOutputs);
+
+	} else if(strncmp(message, "UWRESET", 7) == 0) {
+		UWBatchInit(stream->batch);
+		UWStreamInit(stream, stream->batch);
+		strcpy(reply, "UWACK RESET");
+
+	} else {
+		return 0;
+	}
+
+	int replyLength = strlen(reply);
+	if(replyLength >= replySize) {
+		return 0;
+	}
+	memcpy(outReply, reply, replyLength + 1);
+	return replyLength;
+}
+
+
+
+/*
+Apply a binary data packet to the subscribed datarefs.  Entries with ids which were not subscribed are skipped.
+The values are only recorded in the batch; they reach X-Plane when the batch is flushed.
+
+Returns the number of entries which were applied.
+*/
+int UWStreamApplyData(const UWDataRefStream * stream, const char * packet, int length)
+{
+	if(!UWStreamIsDataPacket(packet, length)) {
+		return 0;
+	}
+
+	UWStreamPacketHeader header;
+	memcpy(&header, packet, sizeof(header));
+
+	int position = sizeof(header);
+	int numApplied = 0;
+
+	for(int i = 0; i < header.count; i++) {
+		if(position + (int)sizeof(UWStreamEntryHeader) > length) {
+			break;
+		}
+
+		UWStreamEntryHeader entry;
+		memcpy(&entry, packet + position, sizeof(entry));
+		position += sizeof(entry);
+
+		int valueSize = UWStreamValueSize(entry.kind);
+		const char * values = packet + position;
+		position += entry.numValues * valueSize;
+		if(position > length || entry.numValues > MAX_STREAM_VALUES || entry.numValues == 0) {
+			break;
+		}
+
+		if(entry.id >= UW_STREAM_MAX_IDS) {
+			continue;
+		}
+
+		const UWStreamSubscription * subscription = &stream->subscriptions[entry.id];
+		if(subscription->dataRef == NULL || subscription->batchHandle < 0) {
+			continue;
+		}
+
+		//record the values in the batch (array datarefs are written from offset, scalars only use the first value)
+		int numValues = (subscription->arraySize > 0) ? entry.numValues : 1;
+		for(int v = 0; v < numValues; v++) {
+			double value;
+			if(entry.kind == uwStreamValue_Double) {
+				memcpy(&value, values + 8*v, 8);
+			} else if(entry.kind == uwStreamValue_Int) {
+				int intValue;
+				memcpy(&intValue, values + 4*v, 4);
+				value = intValue;
+			} else {
+				float floatValue;
+				memcpy(&floatValue, values + 4*v, 4);
+				value = floatValue;
+			}
+
+			UWBatchSet(stream->batch, subscription->batchHandle, entry.offset + v, value);
+		}
+
+		numApplied++;
+	}
+
+	return numApplied;
+}
+
+
+
+/*
+Build the readback packet which holds the current values of all of the output ids.
+
+Returns the length of the packet, or 0 if there are no outputs.
+*/
+int UWStreamBuildReadback(const UWDataRefStream * stream, char * outPacket, int packetSize)
+{
+	if(stream->numOutputs == 0 || packetSize < (int)sizeof(UWStreamPacketHeader)) {
+		return 0;
+	}
+
+	int length = UWStreamBeginPacket(outPacket);
+
+	for(int i = 0; i < stream->numOutputs; i++) {
+		unsigned short id = stream->outputs[i];
+		const UWStreamSubscription * subscription = &stream->subscriptions[id];
+		if(subscription->dataRef == NULL) {
+			continue;
+		}
+
+		int newLength = -1;
+		if(subscription->types & xplmType_FloatArray) {
+			int numValues = XPLMGetDatavf(subscription->dataRef, sFloatValues, 0, subscription->arraySize < MAX_STREAM_VALUES ? subscription->arraySize : MAX_STREAM_VALUES);
+			newLength = UWStreamAddEntry(outPacket, length, packetSize, id, 0, (unsigned short)numValues, uwStreamValue_Float, sFloatValues);
+
+		} else if(subscription->types & xplmType_IntArray) {
+			int numValues = XPLMGetDatavi(subscription->dataRef, sIntValues, 0, subscription->arraySize < MAX_STREAM_VALUES ? subscription->arraySize : MAX_STREAM_VALUES);
+			newLength = UWStreamAddEntry(outPacket, length, packetSize, id, 0, (unsigned short)numValues, uwStreamValue_Int, sIntValues);
+
+		} else if(subscription->types & xplmType_Double) {
+			double value = XPLMGetDatad(subscription->dataRef);
+			newLength = UWStreamAddEntry(outPacket, length, packetSize, id, 0, 1, uwStreamValue_Double, &value);
+
+		} else if(subscription->types & xplmType_Float) {
+			float value = XPLMGetDataf(subscription->dataRef);
+			newLength = UWStreamAddEntry(outPacket, length, packetSize, id, 0, 1, uwStreamValue_Float, &value);
+
+		} else if(subscription->types & xplmType_Int) {
+			int value = XPLMGetDatai(subscription->dataRef);
+			newLength = UWStreamAddEntry(outPacket, length, packetSize, id, 0, 1, uwStreamValue_Int, &value);
+		}
+
+		if(newLength < 0) {
+			break;			//packet is full
+		}
+		length = newLength;
+	}
+
+	return length;
+}
@@ -0,0 +1,41 @@
+/*
+UWDataRefStream.h
+
+The plugin side of the dataref streaming protocol (see UWDataRefStreamProtocol.h).  The subscription messages are
+resolved once into a table indexed by the numeric id, so applying a data packet is a loop over the entries which
+indexes the table and records the raw values in a UWDataRefBatch.  The plugin flushes the batch once per frame,
+so every array dataref written by the packets of a frame costs a single XPLMSetDatavf/XPLMSetDatavi call.
+*/
+
+#ifndef _UWDataRefStream_h_
+#define _UWDataRefStream_h_
+
+#include "XPLMDataAccess.h"
+#include "UWDataRefStreamProtocol.h"
+#include "UWDataRefBatch.h"
+
+struct UWStreamSubscription {
+	XPLMDataRef		dataRef;			//NULL if the id has not been subscribed
+	XPLMDataTypeID	types;				//resolved with XPLMGetDataRefTypes
+	int				arraySize;			//number of elements for array datarefs (0 for scalars)
+	int				batchHandle;		//handle of the dataref in the batch
+};
+
+struct UWDataRefStream {
+	UWDataRefBatch *		batch;								//where the incoming values are written
+	UWStreamSubscription	subscriptions[UW_STREAM_MAX_IDS];
+	int						numOutputs;
+	unsigned short			outputs[UW_STREAM_MAX_OUTPUTS];		//ids sent back to the sender after each flight loop
+};
+
+
+
+void	UWStreamInit(UWDataRefStream * stream, UWDataRefBatch * batch);
+
+int		UWStreamHandleControl(UWDataRefStream * stream, const char * packet, int length, char * outReply, int replySize);
+
+int		UWStreamApplyData(const UWDataRefStream * stream, const char * packet, int length);
+
+int		UWStreamBuildReadback(const UWDataRefStream * stream, char * outPacket, int packetSize);
+
+#endif
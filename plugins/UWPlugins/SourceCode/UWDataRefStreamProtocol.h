@@ -0,0 +1,152 @@
+/*
+UWDataRefStreamProtocol.h
+
+The packet layout used to stream arbitrary datarefs to and from the UDP plugins.  This header does not depend on
+the X-Plane SDK so it can be included by the external simulation which sends the packets.
+
+Subscriptions are negotiated once with short text messages.  The sender picks a small numeric id for each dataref
+it wants to use:
+
+	UWSUB <id> <dataref>			subscribe the dataref to the id
+									reply: UWACK <id> <types> <arraySize>  or  UWNAK <id>
+									(UWNAK if the dataref is unknown, read only or of no type
+									which can be written, so only writable datarefs are read back)
+	UWOUT <id> [<id> ...]			send the values of these ids back to the sender after every flight loop
+									reply: UWACK OUT <numOutputs>
+	UWRESET							remove all subscriptions and outputs
+									reply: UWACK RESET
+
+After that every data packet only carries the numeric ids and the raw values (no dataref strings):
+
+	UWStreamPacketHeader			magic "UWDV" and the number of entries
+	UWStreamEntryHeader				id, first array element, number of values and value kind
+	values							numValues * 4 bytes (float, int) or numValues * 8 bytes (double)
+	UWStreamEntryHeader ...			repeated count times
+
+The values of scalar datarefs are sent with offset 0 and numValues 1.  For array datarefs (XPLMSetDatavf and
+XPLMSetDatavi) the values are written starting at the offset.  The readback packets which the plugin sends to
+the subscriber use the same layout.
+
+All values are little-endian.
+*/
+
+#ifndef _UWDataRefStreamProtocol_h_
+#define _UWDataRefStreamProtocol_h_
+
+#include <string.h>
+
+#include "UWPacketSize.h"
+
+#define UW_STREAM_MAGIC			"UWDV"		//first 4 bytes of a data packet
+#define UW_STREAM_MAX_IDS		1024		//ids must be less than this
+#define UW_STREAM_MAX_OUTPUTS	128			//most ids that can be sent back to the sender
+#define UW_STREAM_MAX_PACKET	UW_MAX_PACKET_SIZE	//largest data packet (see UWPacketSize.h)
+
+enum UWStreamValueKind {
+	uwStreamValue_Float		= 0,
+	uwStreamValue_Double	= 1,
+	uwStreamValue_Int		= 2
+};
+
+#pragma pack(push, 1)
+struct UWStreamPacketHeader {
+	char			magic[4];			//UW_STREAM_MAGIC
+	unsigned short	count;				//number of entries which follow
+	unsigned short	reserved;
+};
+
+struct UWStreamEntryHeader {
+	unsigned short	id;					//id negotiated with UWSUB
+	unsigned short	offset;				//first array element (0 for scalars)
+	unsigned short	numValues;			//number of values which follow (1 for scalars)
+	unsigned char	kind;				//UWStreamValueKind
+	unsigned char	reserved;
+};
+#pragma pack(pop)
+
+
+
+/*
+Size in bytes of one value of the specified kind
+*/
+inline int UWStreamValueSize(int kind)
+{
+	return (kind == uwStreamValue_Double) ? 8 : 4;
+}
+
+
+
+/*
+Start a new data packet in the buffer.  Returns the number of bytes used.
+*/
+inline int UWStreamBeginPacket(char * buffer)
+{
+	UWStreamPacketHeader header;
+	memcpy(header.magic, UW_STREAM_MAGIC, 4);
+	header.count	= 0;
+	header.reserved	= 0;
+	memcpy(buffer, &header, sizeof(header));
+	return sizeof(header);
+}
+
+
+
+/*
+Append an entry to a data packet which was started with UWStreamBeginPacket.  Returns the new length of the packet
+or -1 if the entry does not fit in bufferSize bytes.
+*/
+inline int UWStreamAddEntry(
+					char *			buffer,
+					int				length,
+					int				bufferSize,
+					unsigned short	id,
+					unsigned short	offset,
+					unsigned short	numValues,
+					int				kind,
+					const void *	values)
+{
+	int valuesSize = numValues * UWStreamValueSize(kind);
+	if(length + (int)sizeof(UWStreamEntryHeader) + valuesSize > bufferSize) {
+		return -1;
+	}
+
+	UWStreamEntryHeader entry;
+	entry.id		= id;
+	entry.offset	= offset;
+	entry.numValues	= numValues;
+	entry.kind		= (unsigned char)kind;
+	entry.reserved	= 0;
+	memcpy(buffer + length, &entry, sizeof(entry));
+	memcpy(buffer + length + sizeof(entry), values, valuesSize);
+
+	//bump the entry count in the packet header
+	UWStreamPacketHeader header;
+	memcpy(&header, buffer, sizeof(header));
+	header.count++;
+	memcpy(buffer, &header, sizeof(header));
+
+	return length + sizeof(entry) + valuesSize;
+}
+
+
+
+/*
+Returns true if the packet is a binary data packet
+*/
+inline bool UWStreamIsDataPacket(const char * packet, int length)
+{
+	return length >= (int)sizeof(UWStreamPacketHeader) && memcmp(packet, UW_STREAM_MAGIC, 4) == 0;
+}
+
+
+
+/*
+Returns true if the packet is one of the text subscription messages
+*/
+inline bool UWStreamIsControlPacket(const char * packet, int length)
+{
+	return length >= 5 && (memcmp(packet, "UWSUB", 5) == 0 || memcmp(packet, "UWOUT", 5) == 0 ||
+						   (length >= 7 && memcmp(packet, "UWRESET", 7) == 0));
+}
+
+#endif
@@ -8,10 +8,14 @@
  * 
  */
 
+#include <stdio.h>
+#include <string.h>
 #include "XPLMDataAccess.h"
 #include "XPLMDisplay.h"
 #include "XPLMGraphics.h"
 
+#include "UWStatusOverlay.h"
+
 
 //----------------------------GLOBAL VARIALBES----------------------------------------
 #define NUM_VEHICLES 20		//number of vehicles in the sim/operation/override/override_planepath array
@@ -20,6 +24,7 @@ XPLMHotKeyID	gHotKey = NULL;
 XPLMDataRef		gOverRidePlanePosition = NULL;
 XPLMWindowID	gWindow = NULL;					
 int				gClicked = 0;
+UWStatusOverlay	gOverlay;						//text of the status window (see UWStatusOverlay.h)
 bool			gPhysicsEngineDisabled;		//set this to true to disable the physics engine (it should start as false so X-Plane will not appear frozen (disabled) at startup)
 bool			gDisplayOverlay = false;	//set this to true to display the overlay on the X-Plane window which shows plugin information (useful for debugging).
 
@@ -63,6 +68,8 @@ PLUGIN_API int XPluginStart(
 	/* Prefetch the sim variables we will use. */
 	gOverRidePlanePosition = XPLMFindDataRef("sim/operation/override/override_planepath");
 	
+	UWOverlayInit(&gOverlay, UW_OVERLAY_REFRESH_RATE);
+
 	if(gDisplayOverlay) {
 
 		/* Now we create a window.  We pass in a rectangle in left, top,
@@ -126,6 +133,9 @@ Disable/enable the physics engine
 */
 void	MyHotKeyCallback(void *               inRefcon)
 {
+	//show what the hot key changed right away
+	UWOverlayInvalidate(&gOverlay);
+
 	//user pressed the hot-key, take approriate action
 	int intVals[NUM_VEHICLES];
 	memset(intVals, 0, sizeof(intVals));
@@ -184,8 +194,10 @@ int MyHandleMouseClickCallback(
 {
 	/* If we get a down or up, toggle our status click.  We will
 	 * never get a down without an up if we accept the down. */
-	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp))
+	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp)) {
 		gClicked = 1 - gClicked;
+		UWOverlayInvalidate(&gOverlay);
+	}
 	
 	/* Returning 1 tells X-Plane that we 'accepted' the click; otherwise
 	 * it would be passed to the next window behind us.  If we accept
@@ -212,48 +224,21 @@ void MyDrawWindowCallback(
                                    XPLMWindowID         inWindowID,    
                                    void *               inRefcon)
 {
-	int		left, top, right, bottom;
-	float	color[] = { 1.0, 1.0, 1.0 }; 	/* RGB White */
-	int		verticalLineSpacing = 10;
-	
-	/* First we get the location of the window passed in to us. */
-	XPLMGetWindowGeometry(inWindowID, &left, &top, &right, &bottom);
-	
-	/* We now use an XPLMGraphics routine to draw a translucent dark
-	 * rectangle that is our window's shape. */
-	XPLMDrawTranslucentDarkBox(left, top, right, bottom);
-
-	/* Finally we draw the text into the window, also using XPLMGraphics
-	 * routines.  The NULL indicates no word wrapping. */
-		
-	//Line 1 (display plugin info)
-	XPLMDrawString(color, left + 5, top - 1*verticalLineSpacing, 
-		(char*)(gClicked ? "You are clicking here" : "UWDiablePhysicsEngine"), NULL, xplmFont_Basic);
-	
-	//Line 2 (Instruction on how to operate plugin)
-	XPLMDrawString(color, left + 5, top - 2*verticalLineSpacing, "F9 to toggle physics engine on/off", NULL, xplmFont_Basic);
-
-	////Line 2 (did the data reference get set ok?)
-	//if(gOverRidePlanePosition==NULL) {
-	//	XPLMDrawString(color, left + 5, top - 2*verticalLineSpacing, 
-	//	"gOverRidePlanePosition is NULL", NULL, xplmFont_Basic);
-	//
-	//} else {
-	//	XPLMDrawString(color, left + 5, top - 2*verticalLineSpacing, 
-	//	"gOverRidePlanePosition is OK", NULL, xplmFont_Basic);
-	//
-	//}
-	
-	//Line 3 & 4 (get the status of the physics engine and display it to the window)
-	int outValues[NUM_VEHICLES];
-	int inOffset = 0;
-	int inMax = NUM_VEHICLES;
-	int arraySize = XPLMGetDatavi(gOverRidePlanePosition, outValues, inOffset, inMax);
-	int overRidePlanePosition = outValues[0];
-	char overRidePlanePosition_char[10];
-	itoa(overRidePlanePosition, overRidePlanePosition_char, 10);
-	
-	XPLMDrawString(color, left + 5, top - 3*verticalLineSpacing, "Physics engine disabled? (0=no, 1=yes)", NULL, xplmFont_Basic);
-	XPLMDrawString(color, left + 5, top - 4*verticalLineSpacing, overRidePlanePosition_char, NULL, xplmFont_Basic);
+	//format the text only when it is due, and draw the lines kept from the last refresh (see UWStatusOverlay.h)
+	if(UWOverlayBeginRefresh(&gOverlay)) {
+		//Line 1 (display plugin info)
+		UWOverlaySetText(&gOverlay, 1, gClicked ? "You are clicking here" : "UWDiablePhysicsEngine");
+
+		//Line 2 (Instruction on how to operate plugin)
+		UWOverlaySetText(&gOverlay, 2, "F9 to toggle physics engine on/off");
+
+		//Line 3 & 4 (get the status of the physics engine and display it to the window)
+		int outValues[NUM_VEHICLES];
+		XPLMGetDatavi(gOverRidePlanePosition, outValues, 0, NUM_VEHICLES);
+
+		UWOverlaySetText(&gOverlay, 3, "Physics engine disabled? (0=no, 1=yes)");
+		UWOverlayPrintf(&gOverlay, 4, "%d", outValues[0]);
+	}
 
+	UWOverlayDraw(&gOverlay, inWindowID);
 } 
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*
+UWEchoRecord.h
+
+The latency echo sent back by the timed processing plugin for every pose it applies (see UWEchoSender.h).  Each
+echo holds the pose's sequence number and three times on the sender's clock (the plugin maps its own clock onto
+the sender's, see UWClockSync.h)
+
+	timestamp		when the sender says the pose was valid (normally when it was sent)
+	receiveTime		when the plugin took the pose off the socket (kept with the pose in the epoch apply mode)
+	applyTime		when the plugin set the pose to the datarefs
+
+so the receiver of the echo can split the latency into the way there, the wait in the plugin until the next flight
+loop (or target display time) and the way back.  Several echoes are batched into one packet
+
+	offset	size
+	0		4		magic "UWEC"
+	4		4		count (int)
+	8		32*n	echoes: sequence (unsigned int), reserved (0), timestamp, receiveTime, applyTime (double)
+
+in the sender's byte order (little-endian on every platform we run on).
+
+This header does not depend on the X-Plane SDK and is plain C, so it can be included by the external simulation.
+*/
+
+#ifndef _UWEchoRecord_h_
+#define _UWEchoRecord_h_
+
+#include <string.h>
+
+#include "UWPoseRecord.h"						//for UW_POSE_INLINE
+
+#define UW_ECHO_WIRE_MAGIC			"UWEC"
+#define UW_ECHO_WIRE_HEADER_SIZE	8
+#define UW_ECHO_WIRE_RECORD_SIZE	32
+#define UW_ECHO_MAX_BATCH			32			//echoes per packet
+#define UW_ECHO_WIRE_MAX_SIZE		(UW_ECHO_WIRE_HEADER_SIZE + UW_ECHO_WIRE_RECORD_SIZE * UW_ECHO_MAX_BATCH)
+
+struct UWEchoRecord {
+	unsigned int	sequence;
+	double			timestamp;
+	double			receiveTime;
+	double			applyTime;
+};
+
+
+
+/*
+Write count (at most UW_ECHO_MAX_BATCH) echoes into buffer (at least UW_ECHO_WIRE_MAX_SIZE bytes).  Returns the
+packet length.
+*/
+UW_POSE_INLINE int UWEchoEncode(const struct UWEchoRecord * echoes, int count, char * buffer)
+{
+	int reserved = 0;
+	int i;
+
+	memcpy(buffer,		UW_ECHO_WIRE_MAGIC,	4);
+	memcpy(buffer + 4,	&count,				4);
+
+	for(i = 0; i < count; i++) {
+		char * record = buffer + UW_ECHO_WIRE_HEADER_SIZE + i*UW_ECHO_WIRE_RECORD_SIZE;
+		memcpy(record,		&echoes[i].sequence,	4);
+		memcpy(record + 4,	&reserved,				4);
+		memcpy(record + 8,	&echoes[i].timestamp,	8);
+		memcpy(record + 16,	&echoes[i].receiveTime,	8);
+		memcpy(record + 24,	&echoes[i].applyTime,	8);
+	}
+
+	return UW_ECHO_WIRE_HEADER_SIZE + count*UW_ECHO_WIRE_RECORD_SIZE;
+}
+
+
+
+/*
+Read a packet back into outEchoes (room for UW_ECHO_MAX_BATCH).  Returns the number of echoes, or 0 if the packet
+is not a well formed echo packet.
+*/
+UW_POSE_INLINE int UWEchoDecode(const char * packet, int length, struct UWEchoRecord * outEchoes)
+{
+	int count;
+	int i;
+
+	if(length < UW_ECHO_WIRE_HEADER_SIZE || memcmp(packet, UW_ECHO_WIRE_MAGIC, 4) != 0) {
+		return 0;
+	}
+
+	memcpy(&count, packet + 4, 4);
+	if(count < 0 || count > UW_ECHO_MAX_BATCH || length != UW_ECHO_WIRE_HEADER_SIZE + count*UW_ECHO_WIRE_RECORD_SIZE) {
+		return 0;
+	}
+
+	for(i = 0; i < count; i++) {
+		const char * record = packet + UW_ECHO_WIRE_HEADER_SIZE + i*UW_ECHO_WIRE_RECORD_SIZE;
+		memcpy(&outEchoes[i].sequence,		record,			4);
+		memcpy(&outEchoes[i].timestamp,		record + 8,		8);
+		memcpy(&outEchoes[i].receiveTime,	record + 16,	8);
+		memcpy(&outEchoes[i].applyTime,		record + 24,	8);
+	}
+
+	return count;
+}
+
+#endif
@@ -0,0 +1,166 @@
+/*
+UWEchoSender.cpp
+
+See UWEchoSender.h
+*/
+
+#include <chrono>
+
+#include "UWEchoSender.h"
+
+using namespace std;
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWEchoReadSettings(UWEchoSender * sender, const UWPluginConfig * config)
+{
+	sender->address	= UWConfigGetString(config, "echo_address", "");
+	sender->port	= (unsigned short)UWConfigGetInt(config, "echo_port", 0);
+	sender->thread	= NULL;
+	sender->dropped	= 0;
+	sender->head.store(0);
+	sender->tail.store(0);
+	sender->running.store(false);
+}
+
+
+
+/*
+True while the background thread is running (i.e. echoes pushed now are sent)
+*/
+bool UWEchoIsEnabled(const UWEchoSender * sender)
+{
+	return sender->thread != NULL;
+}
+
+
+
+/*
+The background thread: send whatever the flight loop has queued, up to UW_ECHO_MAX_BATCH echoes per packet.
+When stopped it sends what is left in the queue and returns.
+*/
+static void SendEchoes(UWEchoSender * sender)
+{
+	UDPSocket * socket;
+	try {
+		socket = new UDPSocket();
+	} catch (SocketException &e) {
+		return;
+	}
+
+	UWEchoRecord	batch[UW_ECHO_MAX_BATCH];
+	char			packet[UW_ECHO_WIRE_MAX_SIZE];
+	string			destination;
+
+	while(true) {
+		bool stopping		= !sender->running.load();
+		unsigned int head	= sender->head.load(memory_order_relaxed);
+		unsigned int tail	= sender->tail.load(memory_order_acquire);
+
+		if(head == tail) {
+			if(stopping) {
+				break;
+			}
+			this_thread::sleep_for(chrono::milliseconds(UW_ECHO_SEND_INTERVAL));
+			continue;
+		}
+
+		int count = 0;
+		while(head != tail && count < UW_ECHO_MAX_BATCH) {
+			batch[count++] = sender->queue[head & (UW_ECHO_QUEUE_CAPACITY - 1)];
+			head++;
+		}
+		sender->head.store(head, memory_order_release);
+
+		{
+			lock_guard<mutex> lock(sender->destinationMutex);
+			destination = sender->destination;
+		}
+		if(destination.empty()) {
+			continue;
+		}
+
+		int length = UWEchoEncode(batch, count, packet);
+		try {
+			socket->sendTo(packet, length, destination, sender->port);
+		} catch (SocketException &e) {
+			//nobody listening yet, the echoes are only for measuring so they are dropped
+		}
+	}
+
+	delete socket;
+}
+
+
+
+/*
+Start the background thread if echo mode is on.  Called when the plugin starts listening.
+*/
+void UWEchoStart(UWEchoSender * sender)
+{
+	UWEchoStop(sender);
+	if(sender->port == 0) {
+		return;
+	}
+
+	sender->head.store(0);
+	sender->tail.store(0);
+	sender->poseAddress.clear();
+	sender->destination = sender->address;
+
+	sender->running.store(true);
+	sender->thread = new thread(SendEchoes, sender);
+}
+
+
+
+void UWEchoStop(UWEchoSender * sender)
+{
+	if(sender->thread == NULL) {
+		return;
+	}
+
+	sender->running.store(false);
+	sender->thread->join();
+	delete sender->thread;
+	sender->thread = NULL;
+}
+
+
+
+/*
+Tell the sender where the poses come from.  Unless echo_address is set the echoes go back there.  Only takes the
+lock when the address changes.
+*/
+void UWEchoSetPoseAddress(UWEchoSender * sender, const string & address)
+{
+	if(!sender->address.empty() || address == sender->poseAddress) {
+		return;
+	}
+
+	sender->poseAddress = address;
+
+	lock_guard<mutex> lock(sender->destinationMutex);
+	sender->destination = address;
+}
+
+
+
+/*
+Queue one echo for the background thread.  Called from the flight loop only.  Returns false (and counts the echo
+as dropped) if the queue is full.
+*/
+bool UWEchoPush(UWEchoSender * sender, const UWEchoRecord * echo)
+{
+	unsigned int tail = sender->tail.load(memory_order_relaxed);
+	unsigned int head = sender->head.load(memory_order_acquire);
+	if(tail - head >= UW_ECHO_QUEUE_CAPACITY) {
+		sender->dropped++;
+		return false;
+	}
+
+	sender->queue[tail & (UW_ECHO_QUEUE_CAPACITY - 1)] = *echo;
+	sender->tail.store(tail + 1, memory_order_release);
+	return true;
+}
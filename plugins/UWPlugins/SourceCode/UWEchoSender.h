@@ -0,0 +1,63 @@
+/*
+UWEchoSender.h
+
+Optional echo mode of UWTimedProcessingUDP for measuring latency.  For every pose set to the datarefs the flight
+loop queues an echo (see UWEchoRecord.h) and a background thread sends the queued echoes in batches, so the
+flight loop never waits on a socket.  The queue is a fixed single producer/single consumer ring, so queuing an
+echo neither locks nor allocates; if the thread falls behind the newest echoes are dropped and counted.
+
+UDPReceive (Projects/Win/UDPReceive) run with "latency" listens for the echoes and prints the latency
+distributions.
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	echo_port		port the echoes are sent to (default 0: echo mode off)
+	echo_address	where the echoes are sent (default: the address the poses come from)
+*/
+
+#ifndef _UWEchoSender_h_
+#define _UWEchoSender_h_
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "PracticalSocket.h"
+#include "UWPluginConfig.h"
+#include "UWEchoRecord.h"
+
+#define UW_ECHO_QUEUE_CAPACITY		1024		//echoes waiting for the thread (a power of two)
+#define UW_ECHO_SEND_INTERVAL		10			//milliseconds the thread sleeps when the queue is empty
+
+struct UWEchoSender {
+	std::string					address;				//echo_address (empty: the address the poses come from)
+	unsigned short				port;					//0 if echo mode is off
+	std::string					poseAddress;			//last address passed to UWEchoSetPoseAddress (flight loop only)
+
+	UWEchoRecord				queue[UW_ECHO_QUEUE_CAPACITY];
+	std::atomic<unsigned int>	head;					//next echo the thread sends
+	std::atomic<unsigned int>	tail;					//next free slot for the flight loop
+	long long					dropped;				//echoes which did not fit in the queue
+
+	std::thread *				thread;					//running while the plugin is listening
+	std::atomic<bool>			running;
+	std::mutex					destinationMutex;		//guards destination
+	std::string					destination;
+};
+
+
+
+void		UWEchoReadSettings(UWEchoSender * sender, const UWPluginConfig * config);
+
+bool		UWEchoIsEnabled(const UWEchoSender * sender);
+
+void		UWEchoStart(UWEchoSender * sender);
+
+void		UWEchoStop(UWEchoSender * sender);
+
+void		UWEchoSetPoseAddress(UWEchoSender * sender, const std::string & address);
+
+bool		UWEchoPush(UWEchoSender * sender, const UWEchoRecord * echo);
+
+#endif
@@ -0,0 +1,154 @@
+/*
+UWEntityCulling.cpp
+
+See UWEntityCulling.h
+*/
+
+#include <math.h>
+
+#include "XPLMCamera.h"
+#include "XPLMDisplay.h"
+#include "XPLMGraphics.h"
+
+#include "UWEntityCulling.h"
+
+#define METERS_PER_DEGREE		111320.0		//along a meridian
+#define DEGREES_TO_RADIANS		0.017453292519943295
+#define DEFAULT_FIELD_OF_VIEW	60.0			//degrees, horizontal, if X-Plane does not say
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWEntityCullingReadSettings(UWEntityCulling * culling, const UWPluginConfig * config)
+{
+	culling->cullDistance	= UWConfigGetDouble(config, "cull_distance", 20000.0);
+	culling->frustum		= UWConfigGetInt(config, "cull_frustum", 1) != 0;
+	culling->radius			= UWConfigGetDouble(config, "cull_radius", 50.0);
+	culling->nearDistance	= UWConfigGetDouble(config, "lod_near", 2000.0);
+	culling->farDistance	= UWConfigGetDouble(config, "lod_far", 8000.0);
+	culling->farFrames		= UWConfigGetInt(config, "lod_far_frames", 4);
+	if(culling->farFrames < 1) {
+		culling->farFrames = 1;
+	}
+
+	culling->fieldOfViewRef	= XPLMFindDataRef("sim/graphics/view/field_of_view_deg");
+
+	//nothing is culled until the first frame
+	culling->cameraLatitude				= 0.0;
+	culling->cameraLongitude			= 0.0;
+	culling->cameraAltitude				= 0.0;
+	culling->metersPerDegreeLatitude	= METERS_PER_DEGREE;
+	culling->metersPerDegreeLongitude	= METERS_PER_DEGREE;
+	culling->forward[0]					= 0.0;
+	culling->forward[1]					= 0.0;
+	culling->forward[2]					= -1.0;
+	culling->tanHalfAngle				= 1.0;
+	culling->secHalfAngle				= sqrt(2.0);
+}
+
+
+
+/*
+Read the camera for this frame (before the entities are tested)
+*/
+void UWEntityCullingBegin(UWEntityCulling * culling)
+{
+	XPLMCameraPosition_t camera;
+	XPLMReadCameraPosition(&camera);
+
+	XPLMLocalToWorld(camera.x, camera.y, camera.z, &culling->cameraLatitude, &culling->cameraLongitude,
+					 &culling->cameraAltitude);
+	culling->metersPerDegreeLatitude	= METERS_PER_DEGREE;
+	culling->metersPerDegreeLongitude	= METERS_PER_DEGREE * cos(culling->cameraLatitude * DEGREES_TO_RADIANS);
+
+	//x east, y up, z south; the heading is clockwise from north
+	double pitch	= camera.pitch * DEGREES_TO_RADIANS;
+	double heading	= camera.heading * DEGREES_TO_RADIANS;
+	culling->forward[0]	= cos(pitch) * sin(heading);
+	culling->forward[1]	= sin(pitch);
+	culling->forward[2]	= -cos(pitch) * cos(heading);
+
+	//the cone through the corners of the screen
+	double fieldOfView = (culling->fieldOfViewRef != NULL) ? XPLMGetDataf(culling->fieldOfViewRef) : 0.0;
+	if(fieldOfView <= 0.0 || fieldOfView >= 180.0) {
+		fieldOfView = DEFAULT_FIELD_OF_VIEW;
+	}
+	int width, height;
+	XPLMGetScreenSize(&width, &height);
+	double aspect	= (width > 0) ? (double)height / width : 0.75;
+	double zoom		= (camera.zoom > 0.0f) ? camera.zoom : 1.0;
+
+	culling->tanHalfAngle	= tan(0.5 * fieldOfView * DEGREES_TO_RADIANS) / zoom * sqrt(1.0 + aspect*aspect);
+	culling->secHalfAngle	= sqrt(1.0 + culling->tanHalfAngle*culling->tanHalfAngle);
+}
+
+
+
+/*
+Returns the level of detail tier of an entity at the position, or uwLOD_Culled
+*/
+UWEntityLOD UWEntityCullingTest(const UWEntityCulling * culling, double latitude, double longitude, double altitude)
+{
+	//offset from the camera in local coordinates
+	double dx = (longitude - culling->cameraLongitude) * culling->metersPerDegreeLongitude;
+	double dy = altitude - culling->cameraAltitude;
+	double dz = -(latitude - culling->cameraLatitude) * culling->metersPerDegreeLatitude;
+	double distance2 = dx*dx + dy*dy + dz*dz;
+
+	if(culling->cullDistance > 0.0) {
+		double limit = culling->cullDistance + culling->radius;
+		if(distance2 > limit*limit) {
+			return uwLOD_Culled;
+		}
+	}
+
+	if(culling->frustum) {
+		//outside the cone, allowing for the radius of the entity
+		double along = dx*culling->forward[0] + dy*culling->forward[1] + dz*culling->forward[2];
+		double reach = along*culling->tanHalfAngle + culling->radius*culling->secHalfAngle;
+		if(reach < 0.0 || distance2 - along*along > reach*reach) {
+			return uwLOD_Culled;
+		}
+	}
+
+	if(distance2 < culling->nearDistance*culling->nearDistance) {
+		return uwLOD_Near;
+	}
+	if(distance2 < culling->farDistance*culling->farDistance) {
+		return uwLOD_Mid;
+	}
+	return uwLOD_Far;
+}
+
+
+
+/*
+Returns false if no entity within reach meters (horizontally) of the position, at any altitude, can pass
+UWEntityCullingTest
+*/
+bool UWEntityCullingTestColumn(const UWEntityCulling * culling, double latitude, double longitude, double reach)
+{
+	double dx = (longitude - culling->cameraLongitude) * culling->metersPerDegreeLongitude;
+	double dz = -(latitude - culling->cameraLatitude) * culling->metersPerDegreeLatitude;
+	double horizontal = sqrt(dx*dx + dz*dz);
+	double margin = reach + culling->radius;
+
+	if(culling->cullDistance > 0.0 && horizontal - margin > culling->cullDistance) {
+		return false;
+	}
+
+	if(culling->frustum && horizontal > margin) {
+		//smallest angle between the view direction and a point of the column's axis: the cosine is largest where the
+		//plane through the view direction and the vertical meets the axis, or towards the zenith or nadir if the
+		//column is behind the camera
+		double along = (dx*culling->forward[0] + dz*culling->forward[2]) / horizontal;
+		double up = culling->forward[1];
+		double largestCosine = (along > 0.0) ? sqrt(along*along + up*up) : fabs(up);
+		double angle = acos((largestCosine < 1.0) ? largestCosine : 1.0);
+		if(angle - asin(margin / horizontal) > atan(culling->tanHalfAngle)) {
+			return false;
+		}
+	}
+
+	return true;
+}
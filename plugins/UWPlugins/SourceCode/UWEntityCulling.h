@@ -0,0 +1,76 @@
+/*
+UWEntityCulling.h
+
+Decides, once per frame and entity, whether a streamed entity (see UWEntityTable.h) is worth any work and how much.
+An entity is culled when it is farther from the camera than cull_distance or outside the camera's field of view;
+a culled entity is not converted to local coordinates, not interpolated and not drawn.  The others fall into a
+level of detail tier by their distance from the camera
+
+	uwLOD_Near		closer than lod_near: moved smoothly between records every frame
+	uwLOD_Mid		closer than lod_far: drawn at the newest record (no interpolation)
+	uwLOD_Far		the rest: drawn at the newest record, which is only converted every lod_far_frames frames
+
+The test works on the world position of the newest record, so it needs no XPLMWorldToLocal call: the offset from
+the camera is approximated in meters east, north and up from the camera's latitude and longitude (found once per
+frame), which is accurate to well within cull_radius over the distances entities are drawn at.  The field of view
+is tested as a cone around the camera's view direction which just contains the screen's corners, so it does not
+depend on the camera's roll.  UWEntityCullingTestColumn makes the same tests for a vertical column of the world at
+once (a cell of UWEntityGrid.h), so whole cells of entities can be skipped without testing them.
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	cull_distance		meters from the camera beyond which entities are culled (default 20000, 0 for no limit)
+	cull_frustum		1 to cull the entities outside the field of view, 0 not to (default 1)
+	cull_radius			meters an entity's object reaches from its reference point (default 50)
+	lod_near			meters (default 2000)
+	lod_far				meters (default 8000)
+	lod_far_frames		frames between updates of the far entities (default 4)
+*/
+
+#ifndef _UWEntityCulling_h_
+#define _UWEntityCulling_h_
+
+#include "XPLMDataAccess.h"
+
+#include "UWPluginConfig.h"
+
+#define UW_LOD_TIERS		3
+
+enum UWEntityLOD {
+	uwLOD_Culled		= -1,
+	uwLOD_Near			= 0,
+	uwLOD_Mid			= 1,
+	uwLOD_Far			= 2
+};
+
+struct UWEntityCulling {
+	double			cullDistance;					//meters, 0 for no limit
+	bool			frustum;
+	double			radius;
+	double			nearDistance;
+	double			farDistance;
+	int				farFrames;
+	XPLMDataRef		fieldOfViewRef;					//sim/graphics/view/field_of_view_deg
+
+	//the camera this frame (see UWEntityCullingBegin)
+	double			cameraLatitude;
+	double			cameraLongitude;
+	double			cameraAltitude;
+	double			metersPerDegreeLatitude;
+	double			metersPerDegreeLongitude;
+	double			forward[3];						//view direction in local coordinates
+	double			tanHalfAngle;					//of the cone around the view direction
+	double			secHalfAngle;
+};
+
+
+
+void		UWEntityCullingReadSettings(UWEntityCulling * culling, const UWPluginConfig * config);
+
+void		UWEntityCullingBegin(UWEntityCulling * culling);
+
+UWEntityLOD	UWEntityCullingTest(const UWEntityCulling * culling, double latitude, double longitude, double altitude);
+
+bool		UWEntityCullingTestColumn(const UWEntityCulling * culling, double latitude, double longitude, double reach);
+
+#endif
@@ -0,0 +1,421 @@
+/*
+UWEntityGrid.cpp
+
+See UWEntityGrid.h
+*/
+
+#include <math.h>
+
+#include "UWEntityGrid.h"
+
+#define METERS_PER_DEGREE		111320.0		//along a meridian
+#define DEGREES_TO_RADIANS		0.017453292519943295
+#define CELL_REACH				0.75			//of grid_cell: meters from a cell's center to its farthest corner
+#define MAX_BOX_METERS			1.0e7			//beyond this radius every occupied cell is gathered
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Allocate everything for capacity entities (nothing is allocated after this)
+*/
+void UWEntityGridInit(UWEntityGrid * grid, const UWPluginConfig * config, int capacity)
+{
+	grid->capacity		= (capacity > 0) ? capacity : 1;
+	grid->cellMeters	= UWConfigGetDouble(config, "grid_cell", 500.0);
+	if(grid->cellMeters < 1.0) {
+		grid->cellMeters = 1.0;
+	}
+	grid->rowDegrees	= grid->cellMeters / METERS_PER_DEGREE;
+
+	grid->hashBits = 1;
+	while((1 << grid->hashBits) < 2*grid->capacity) {
+		grid->hashBits++;
+	}
+
+	grid->cells				= new UWGridCell[grid->capacity];
+	grid->hash				= new int[1 << grid->hashBits];
+	grid->gathered			= new int[grid->capacity];
+	grid->entityCell		= new int[grid->capacity];
+	grid->nextInCell		= new int[grid->capacity];
+	grid->previousInCell	= new int[grid->capacity];
+	grid->latitudes			= new double[grid->capacity];
+	grid->longitudes		= new double[grid->capacity];
+	grid->altitudes			= new double[grid->capacity];
+
+	UWEntityGridClear(grid);
+}
+
+
+
+void UWEntityGridStop(UWEntityGrid * grid)
+{
+	delete [] grid->cells;
+	delete [] grid->hash;
+	delete [] grid->gathered;
+	delete [] grid->entityCell;
+	delete [] grid->nextInCell;
+	delete [] grid->previousInCell;
+	delete [] grid->latitudes;
+	delete [] grid->longitudes;
+	delete [] grid->altitudes;
+	grid->cells				= NULL;
+	grid->hash				= NULL;
+	grid->gathered			= NULL;
+	grid->entityCell		= NULL;
+	grid->nextInCell		= NULL;
+	grid->previousInCell	= NULL;
+	grid->latitudes			= NULL;
+	grid->longitudes		= NULL;
+	grid->altitudes			= NULL;
+}
+
+
+
+/*
+Take every entity out of the grid
+*/
+void UWEntityGridClear(UWEntityGrid * grid)
+{
+	for(int i = 0; i < grid->capacity; i++) {
+		grid->cells[i].first	= -1;
+		grid->cells[i].next		= (i + 1 < grid->capacity) ? i + 1 : -1;
+		grid->entityCell[i]		= -1;
+	}
+	grid->firstFree		= 0;
+	grid->firstOccupied	= -1;
+	grid->numCells		= 0;
+
+	for(int i = 0; i < (1 << grid->hashBits); i++) {
+		grid->hash[i] = -1;
+	}
+	grid->cellsVisited	= 0;
+}
+
+
+
+static int RowOf(const UWEntityGrid * grid, double latitude)
+{
+	return (int)floor(latitude / grid->rowDegrees);
+}
+
+
+
+/*
+Degrees of longitude across a cell of the row (a cell is as wide as it is high at the row's center)
+*/
+static double ColumnDegrees(const UWEntityGrid * grid, int row)
+{
+	double c = cos((row + 0.5) * grid->rowDegrees * DEGREES_TO_RADIANS);
+	return grid->rowDegrees / ((c > 0.01) ? c : 0.01);
+}
+
+
+
+static int ColumnOf(const UWEntityGrid * grid, int row, double longitude)
+{
+	return (int)floor(longitude / ColumnDegrees(grid, row));
+}
+
+
+
+/*
+The hash table slot a cell starts probing at
+*/
+static int HomeSlot(const UWEntityGrid * grid, int row, int column)
+{
+	unsigned int key = ((unsigned int)row * 0x9E3779B1u) ^ ((unsigned int)column * 0x85EBCA77u);
+	return (int)((key * 2654435769u) >> (32 - grid->hashBits));
+}
+
+
+
+/*
+Returns the hash table slot which holds the cell, or the empty slot where it would go
+*/
+static int FindSlot(const UWEntityGrid * grid, int row, int column)
+{
+	int mask = (1 << grid->hashBits) - 1;
+	int slot = HomeSlot(grid, row, column);
+	while(grid->hash[slot] >= 0) {
+		const UWGridCell * cell = &grid->cells[grid->hash[slot]];
+		if(cell->row == row && cell->column == column) {
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+
+
+/*
+Empty a hash table slot, moving the entries after it back so that every entry can still be found by probing from
+its home slot (as in UWEntityTable.cpp)
+*/
+static void EraseSlot(UWEntityGrid * grid, int slot)
+{
+	int mask = (1 << grid->hashBits) - 1;
+	grid->hash[slot] = -1;
+
+	int next = slot;
+	while(true) {
+		next = (next + 1) & mask;
+		if(grid->hash[next] < 0) {
+			return;
+		}
+
+		const UWGridCell * cell = &grid->cells[grid->hash[next]];
+		int home = HomeSlot(grid, cell->row, cell->column);
+		bool reachable = (slot <= next) ? (slot < home && home <= next) : (slot < home || home <= next);
+		if(!reachable) {
+			grid->hash[slot]	= grid->hash[next];
+			grid->hash[next]	= -1;
+			slot = next;
+		}
+	}
+}
+
+
+
+/*
+Returns the cell, taking it from the arena if it has no entities yet
+*/
+static int GetCell(UWEntityGrid * grid, int row, int column)
+{
+	int slot = FindSlot(grid, row, column);
+	if(grid->hash[slot] >= 0) {
+		return grid->hash[slot];
+	}
+
+	//there are never more occupied cells than entities, so the arena cannot run out
+	int index = grid->firstFree;
+	UWGridCell * cell = &grid->cells[index];
+	grid->firstFree = cell->next;
+	grid->hash[slot] = index;
+
+	cell->row		= row;
+	cell->column	= column;
+	double columnDegrees = ColumnDegrees(grid, row);
+	cell->south		= row * grid->rowDegrees;
+	cell->north		= (row + 1) * grid->rowDegrees;
+	cell->west		= column * columnDegrees;
+	cell->east		= (column + 1) * columnDegrees;
+	cell->latitude	= 0.5 * (cell->south + cell->north);
+	cell->longitude	= 0.5 * (cell->west + cell->east);
+	cell->first		= -1;
+	cell->count		= 0;
+
+	cell->previous	= -1;
+	cell->next		= grid->firstOccupied;
+	if(grid->firstOccupied >= 0) {
+		grid->cells[grid->firstOccupied].previous = index;
+	}
+	grid->firstOccupied = index;
+	grid->numCells++;
+	return index;
+}
+
+
+
+/*
+Unlink the entity from its cell, giving the cell back to the arena if it is left empty
+*/
+static void Unlink(UWEntityGrid * grid, int entity)
+{
+	int index = grid->entityCell[entity];
+	UWGridCell * cell = &grid->cells[index];
+
+	int previous	= grid->previousInCell[entity];
+	int next		= grid->nextInCell[entity];
+	if(previous >= 0) {
+		grid->nextInCell[previous] = next;
+	} else {
+		cell->first = next;
+	}
+	if(next >= 0) {
+		grid->previousInCell[next] = previous;
+	}
+	grid->entityCell[entity] = -1;
+
+	if(--cell->count > 0) {
+		return;
+	}
+
+	EraseSlot(grid, FindSlot(grid, cell->row, cell->column));
+	if(cell->previous >= 0) {
+		grid->cells[cell->previous].next = cell->next;
+	} else {
+		grid->firstOccupied = cell->next;
+	}
+	if(cell->next >= 0) {
+		grid->cells[cell->next].previous = cell->previous;
+	}
+	cell->first		= -1;
+	cell->next		= grid->firstFree;
+	grid->firstFree	= index;
+	grid->numCells--;
+}
+
+
+
+/*
+Index the entity (0 to capacity-1) at its new position, adding it to the grid if it is not in it yet
+*/
+void UWEntityGridMove(UWEntityGrid * grid, int entity, double latitude, double longitude, double altitude)
+{
+	grid->latitudes[entity]		= latitude;
+	grid->longitudes[entity]	= longitude;
+	grid->altitudes[entity]		= altitude;
+
+	int current	= grid->entityCell[entity];
+	if(current >= 0) {
+		const UWGridCell * cell = &grid->cells[current];
+		if(latitude >= cell->south && latitude < cell->north && longitude >= cell->west && longitude < cell->east) {
+			return;
+		}
+	}
+
+	int row		= RowOf(grid, latitude);
+	int column	= ColumnOf(grid, row, longitude);
+	if(current >= 0) {
+		if(grid->cells[current].row == row && grid->cells[current].column == column) {
+			return;
+		}
+		Unlink(grid, entity);
+	}
+
+	int index = GetCell(grid, row, column);
+	UWGridCell * cell = &grid->cells[index];
+	grid->entityCell[entity]		= index;
+	grid->previousInCell[entity]	= -1;
+	grid->nextInCell[entity]		= cell->first;
+	if(cell->first >= 0) {
+		grid->previousInCell[cell->first] = entity;
+	}
+	cell->first = entity;
+	cell->count++;
+}
+
+
+
+void UWEntityGridRemove(UWEntityGrid * grid, int entity)
+{
+	if(grid->entityCell[entity] >= 0) {
+		Unlink(grid, entity);
+	}
+}
+
+
+
+/*
+Gather into grid->gathered the occupied cells which may hold entities within radiusMeters (horizontally) of the
+position: the cells over the bounding box if there are fewer of them than occupied cells, or else every occupied
+cell.  A radius of 0 or less (or beyond MAX_BOX_METERS) gathers every occupied cell.  Returns the number of cells gathered.
+*/
+static int GatherCells(UWEntityGrid * grid, double latitude, double longitude, double radiusMeters)
+{
+	int gathered = 0;
+
+	if(radiusMeters > 0.0 && radiusMeters < MAX_BOX_METERS) {
+		double reach = radiusMeters + CELL_REACH*grid->cellMeters;
+		int firstRow	= RowOf(grid, latitude - reach / METERS_PER_DEGREE);
+		int lastRow		= RowOf(grid, latitude + reach / METERS_PER_DEGREE);
+
+		//count the cells over the box, giving up as soon as there are more than occupied ones
+		long long boxCells = 0;
+		for(int row = firstRow; row <= lastRow && boxCells <= grid->numCells; row++) {
+			double span = ColumnDegrees(grid, row) / grid->rowDegrees * reach / METERS_PER_DEGREE;
+			boxCells += ColumnOf(grid, row, longitude + span) - ColumnOf(grid, row, longitude - span) + 1;
+		}
+
+		if(boxCells <= grid->numCells) {
+			for(int row = firstRow; row <= lastRow; row++) {
+				double span = ColumnDegrees(grid, row) / grid->rowDegrees * reach / METERS_PER_DEGREE;
+				int lastColumn = ColumnOf(grid, row, longitude + span);
+				for(int column = ColumnOf(grid, row, longitude - span); column <= lastColumn; column++) {
+					int index = grid->hash[FindSlot(grid, row, column)];
+					if(index >= 0) {
+						grid->gathered[gathered++] = index;
+					}
+				}
+			}
+			return gathered;
+		}
+	}
+
+	for(int index = grid->firstOccupied; index >= 0; index = grid->cells[index].next) {
+		grid->gathered[gathered++] = index;
+	}
+	return gathered;
+}
+
+
+
+/*
+Write into outEntities (up to maxCount) the entities within radiusMeters of the position, measured horizontally.
+Returns how many were written.
+*/
+int UWEntityGridQueryRadius(UWEntityGrid * grid, double latitude, double longitude, double radiusMeters,
+							int * outEntities, int maxCount)
+{
+	double metersPerDegreeLongitude = METERS_PER_DEGREE * cos(latitude * DEGREES_TO_RADIANS);
+	double cellReach = CELL_REACH * grid->cellMeters;
+	double radius2 = radiusMeters * radiusMeters;
+	int count = 0;
+
+	int numCells = GatherCells(grid, latitude, longitude, (radiusMeters > 0.0) ? radiusMeters : 0.0);
+	grid->cellsVisited = numCells;
+	for(int i = 0; i < numCells && count < maxCount; i++) {
+		const UWGridCell * cell = &grid->cells[grid->gathered[i]];
+		double dx = (cell->longitude - longitude) * metersPerDegreeLongitude;
+		double dy = (cell->latitude - latitude) * METERS_PER_DEGREE;
+		if(sqrt(dx*dx + dy*dy) - cellReach > radiusMeters) {
+			continue;
+		}
+
+		for(int entity = cell->first; entity >= 0 && count < maxCount; entity = grid->nextInCell[entity]) {
+			dx = (grid->longitudes[entity] - longitude) * metersPerDegreeLongitude;
+			dy = (grid->latitudes[entity] - latitude) * METERS_PER_DEGREE;
+			if(dx*dx + dy*dy <= radius2) {
+				outEntities[count++] = entity;
+			}
+		}
+	}
+	return count;
+}
+
+
+
+/*
+Write into outEntities (up to maxCount) the entities which pass UWEntityCullingTest for the camera of this frame
+(see UWEntityCullingBegin), and into outLODs their tiers.  Only the cells which may be in view are visited.
+Returns how many were written.
+*/
+int UWEntityGridQueryView(UWEntityGrid * grid, const UWEntityCulling * culling, int * outEntities,
+						  UWEntityLOD * outLODs, int maxCount)
+{
+	double cellReach = CELL_REACH * grid->cellMeters;
+	double radius = (culling->cullDistance > 0.0) ? culling->cullDistance + culling->radius : 0.0;
+	int count = 0;
+
+	int numCells = GatherCells(grid, culling->cameraLatitude, culling->cameraLongitude, radius);
+	grid->cellsVisited = numCells;
+	for(int i = 0; i < numCells && count < maxCount; i++) {
+		const UWGridCell * cell = &grid->cells[grid->gathered[i]];
+		if(!UWEntityCullingTestColumn(culling, cell->latitude, cell->longitude, cellReach)) {
+			continue;
+		}
+
+		for(int entity = cell->first; entity >= 0 && count < maxCount; entity = grid->nextInCell[entity]) {
+			UWEntityLOD lod = UWEntityCullingTest(culling, grid->latitudes[entity], grid->longitudes[entity],
+												  grid->altitudes[entity]);
+			if(lod != uwLOD_Culled) {
+				outEntities[count]	= entity;
+				outLODs[count]		= lod;
+				count++;
+			}
+		}
+	}
+	return count;
+}
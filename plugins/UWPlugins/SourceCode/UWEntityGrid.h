@@ -0,0 +1,84 @@
+/*
+UWEntityGrid.h
+
+A spatial index over the streamed entities (see UWEntityTable.h), so that finding the entities near a point or in
+view costs in proportion to the entities found rather than to every entity there is.
+
+The world is divided into cells about grid_cell meters on a side: rows of equal latitude, each divided into cells
+of equal longitude so the cells stay square away from the equator.  Only the cells which hold entities exist.  A
+cell is found from its row and column through a hash table, and holds its entities in a doubly linked list
+threaded through per entity arrays, so moving an entity to another cell, adding it or removing it is O(1) and
+nothing is rebuilt per frame.  Cells come from an arena allocated once (one cell per entity is always enough) and
+go back to it when they empty.
+
+Queries write entity indices into an array supplied by the caller, visiting either the cells over the query's
+bounding box or the occupied cells, whichever are fewer.  They do not wrap across the antimeridian.
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	grid_cell			meters on a side of a cell (default 500)
+*/
+
+#ifndef _UWEntityGrid_h_
+#define _UWEntityGrid_h_
+
+#include "UWPluginConfig.h"
+#include "UWEntityCulling.h"
+
+struct UWGridCell {
+	int				row;
+	int				column;
+	double			latitude;						//center
+	double			longitude;
+	double			south;							//bounds, so an entity moving within the cell costs no lookup
+	double			north;
+	double			west;
+	double			east;
+	int				first;							//first entity in the cell, -1 while the cell is free
+	int				count;
+	int				previous;						//occupied cells list (the free list while the cell is free)
+	int				next;
+};
+
+struct UWEntityGrid {
+	int				capacity;						//entities
+	double			cellMeters;
+	double			rowDegrees;						//latitude step between rows
+
+	UWGridCell *	cells;							//capacity cells
+	int				firstFree;
+	int				firstOccupied;
+	int				numCells;						//occupied
+	int *			hash;							//cell index for every slot, -1 if the slot is empty
+	int				hashBits;
+	int *			gathered;						//cells to visit, for the queries
+
+	int *			entityCell;						//per entity: its cell, -1 if it is not in the grid
+	int *			nextInCell;
+	int *			previousInCell;
+	double *		latitudes;						//per entity: the position it is indexed at
+	double *		longitudes;
+	double *		altitudes;
+
+	int				cellsVisited;					//by the last query
+};
+
+
+
+void		UWEntityGridInit(UWEntityGrid * grid, const UWPluginConfig * config, int capacity);
+
+void		UWEntityGridStop(UWEntityGrid * grid);
+
+void		UWEntityGridClear(UWEntityGrid * grid);
+
+void		UWEntityGridMove(UWEntityGrid * grid, int entity, double latitude, double longitude, double altitude);
+
+void		UWEntityGridRemove(UWEntityGrid * grid, int entity);
+
+int			UWEntityGridQueryRadius(UWEntityGrid * grid, double latitude, double longitude, double radiusMeters,
+									int * outEntities, int maxCount);
+
+int			UWEntityGridQueryView(UWEntityGrid * grid, const UWEntityCulling * culling, int * outEntities,
+								  UWEntityLOD * outLODs, int maxCount);
+
+#endif
@@ -0,0 +1,152 @@
+/*
+UWEntityModels.cpp
+
+See UWEntityModels.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "XPLMDataAccess.h"
+#include "XPLMUtilities.h"
+
+#include "UWEntityModels.h"
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWEntityModelsReadSettings(UWEntityModels * models, const UWPluginConfig * config)
+{
+	models->numModels = 0;
+	for(int i = 0; i < UW_ENTITY_MAX_MODELS; i++) {
+		char key[UW_CONFIG_KEY_LENGTH];
+		sprintf(key, "model%d", i);
+
+		const char * path = UWConfigGetString(config, key, "");
+		if(path[0] == '\0') {
+			break;
+		}
+
+		UWEntityModel * model = &models->models[models->numModels++];
+		strncpy(model->path, path, sizeof(model->path) - 1);
+		model->path[sizeof(model->path) - 1] = '\0';
+		model->state	= uwModel_Unused;
+		model->object	= NULL;
+	}
+}
+
+
+
+/*
+Called by XPLMLookupObjects for every library object matching a virtual path; the first one is kept
+*/
+static void FirstLibraryObject(const char * inFilePath, void * inRef)
+{
+	char * path = (char *)inRef;
+	if(path[0] == '\0') {
+		strncpy(path, inFilePath, UW_CONFIG_VALUE_LENGTH - 1);
+		path[UW_CONFIG_VALUE_LENGTH - 1] = '\0';
+	}
+}
+
+
+
+/*
+Called by X-Plane when an object started by UWEntityModelsLoad has loaded (inObject is NULL if it failed).  If
+the models were unloaded in the meantime the object is not wanted any more.
+*/
+static void ObjectLoaded(XPLMObjectRef inObject, void * inRefcon)
+{
+	UWEntityModel * model = (UWEntityModel *)inRefcon;
+
+	if(model->state != uwModel_Loading) {
+		if(inObject != NULL) {
+			XPLMUnloadObject(inObject);
+		}
+		return;
+	}
+
+	if(inObject == NULL) {
+		char message[UW_CONFIG_VALUE_LENGTH + 64];
+		sprintf(message, "UWStreamedEntities: unable to load %s\n", model->path);
+		XPLMDebugString(message);
+		model->state = uwModel_Failed;
+		return;
+	}
+
+	model->object	= inObject;
+	model->state	= uwModel_Loaded;
+}
+
+
+
+/*
+Start loading every model which is not loaded or loading yet.  Returns straight away; the models become available
+to UWEntityModelObject over the next frames.
+*/
+void UWEntityModelsLoad(UWEntityModels * models)
+{
+	XPLMDataRef latitudeRef		= XPLMFindDataRef("sim/flightmodel/position/latitude");
+	XPLMDataRef longitudeRef	= XPLMFindDataRef("sim/flightmodel/position/longitude");
+	float latitude	= (latitudeRef != NULL) ? (float)XPLMGetDatad(latitudeRef) : 0.0f;
+	float longitude	= (longitudeRef != NULL) ? (float)XPLMGetDatad(longitudeRef) : 0.0f;
+
+	for(int i = 0; i < models->numModels; i++) {
+		UWEntityModel * model = &models->models[i];
+		if(model->state != uwModel_Unused) {
+			continue;
+		}
+
+		//a library path is loaded as the object it stands for here, anything else as a file
+		char path[UW_CONFIG_VALUE_LENGTH];
+		path[0] = '\0';
+		XPLMLookupObjects(model->path, latitude, longitude, FirstLibraryObject, path);
+
+		model->state = uwModel_Loading;
+		XPLMLoadObjectAsync((path[0] != '\0') ? path : model->path, ObjectLoaded, model);
+	}
+}
+
+
+
+/*
+Unload the loaded models.  Models which are still loading are unloaded by ObjectLoaded when they arrive.
+*/
+void UWEntityModelsUnload(UWEntityModels * models)
+{
+	for(int i = 0; i < models->numModels; i++) {
+		UWEntityModel * model = &models->models[i];
+		if(model->object != NULL) {
+			XPLMUnloadObject(model->object);
+			model->object = NULL;
+		}
+		model->state = uwModel_Unused;
+	}
+}
+
+
+
+/*
+Returns the object to draw the model with, or NULL if it is not loaded (yet)
+*/
+XPLMObjectRef UWEntityModelObject(const UWEntityModels * models, int model)
+{
+	return models->models[model].object;
+}
+
+
+
+/*
+One line for the overlay, e.g. "Models 3 of 4 loaded (1 loading, 0 failed)".  outText must hold
+UW_ENTITY_MODELS_DESCRIPTION_LENGTH characters.
+*/
+void UWEntityModelsDescribe(const UWEntityModels * models, char * outText)
+{
+	int counts[4] = { 0, 0, 0, 0 };
+	for(int i = 0; i < models->numModels; i++) {
+		counts[models->models[i].state]++;
+	}
+
+	sprintf(outText, "Models %d of %d loaded (%d loading, %d failed)", counts[uwModel_Loaded], models->numModels,
+			counts[uwModel_Loading], counts[uwModel_Failed]);
+}
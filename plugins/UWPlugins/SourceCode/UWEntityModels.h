@@ -0,0 +1,56 @@
+/*
+UWEntityModels.h
+
+The objects UWStreamedEntities draws the entities with.  The models are listed in the plugin's config file (see
+UWPluginConfig.h) as model0, model1, ... (up to UW_ENTITY_MAX_MODELS of them, stopping at the first missing key),
+each the path of an OBJ file relative to the X-System folder or a virtual path in X-Plane's library, e.g.
+
+	model0		lib/airport/vehicles/pushback/tug.obj
+	model1		Custom Scenery/MyVehicles/bus.obj
+
+The models are loaded with XPLMLoadObjectAsync, so X-Plane reads the files and textures off the main thread and
+the sim never stutters while they load; an entity whose model is not loaded yet is tracked but not drawn.  Library
+paths are resolved (with XPLMLookupObjects, at the aircraft's position) to the first object which matches.
+*/
+
+#ifndef _UWEntityModels_h_
+#define _UWEntityModels_h_
+
+#include "XPLMScenery.h"
+
+#include "UWPluginConfig.h"
+
+#define UW_ENTITY_MAX_MODELS				32
+#define UW_ENTITY_MODELS_DESCRIPTION_LENGTH	64		//see UWEntityModelsDescribe
+
+enum UWModelState {
+	uwModel_Unused,									//not loaded (yet)
+	uwModel_Loading,								//waiting for XPLMLoadObjectAsync
+	uwModel_Loaded,
+	uwModel_Failed									//the object could not be loaded
+};
+
+struct UWEntityModel {
+	char			path[UW_CONFIG_VALUE_LENGTH];
+	UWModelState	state;
+	XPLMObjectRef	object;							//NULL unless loaded
+};
+
+struct UWEntityModels {
+	int				numModels;
+	UWEntityModel	models[UW_ENTITY_MAX_MODELS];
+};
+
+
+
+void		UWEntityModelsReadSettings(UWEntityModels * models, const UWPluginConfig * config);
+
+void		UWEntityModelsLoad(UWEntityModels * models);
+
+void		UWEntityModelsUnload(UWEntityModels * models);
+
+XPLMObjectRef	UWEntityModelObject(const UWEntityModels * models, int model);
+
+void		UWEntityModelsDescribe(const UWEntityModels * models, char * outText);
+
+#endif
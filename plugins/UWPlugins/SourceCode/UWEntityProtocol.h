@@ -0,0 +1,118 @@
+/*
+UWEntityProtocol.h
+
+The packet layout the external simulation uses to stream the poses of other entities (traffic, vehicles, people,
+...) to UWStreamedEntities, which draws them as instanced objects.  This header does not depend on the X-Plane SDK
+so it can be included by the external simulation which sends the packets.
+
+A packet holds the changes of any number of entities, so a simulation with many entities spreads them over
+several packets per frame
+
+	UWEntityHeader					magic "UWEN" and the number of records
+	UWEntityRecord ...				one per entity, repeated count times
+
+An entity is created by the first record with its id, and moves to the pose of every later record.  The model is
+an index into the models listed in the plugin's config file and may change at any time.  A record with the
+uwEntity_Remove flag removes the entity (the rest of the record is ignored); entities which are not updated for a
+while are removed as well (see UWEntityTable.h).
+
+All values are little-endian.
+*/
+
+#ifndef _UWEntityProtocol_h_
+#define _UWEntityProtocol_h_
+
+#include <string.h>
+
+#define UW_ENTITY_MAGIC				"UWEN"		//first 4 bytes of a packet
+#define UW_ENTITY_MAX_RECORDS		90			//most records in one packet (so it fits in 4096 bytes)
+
+enum UWEntityFlags {
+	uwEntity_Remove				= 1
+};
+
+#pragma pack(push, 1)
+struct UWEntityHeader {
+	char			magic[4];			//UW_ENTITY_MAGIC
+	unsigned short	count;				//number of records which follow
+	unsigned short	reserved;
+};
+
+struct UWEntityRecord {
+	unsigned int	id;					//chosen by the sender
+	unsigned short	model;				//index of the model in the plugin's config file
+	unsigned short	flags;				//UWEntityFlags
+	double			latitude;			//degrees
+	double			longitude;			//degrees
+	double			altitude;			//meters above mean sea level
+	float			phi;				//roll, degrees
+	float			theta;				//pitch, degrees
+	float			psi;				//true heading, degrees
+};
+#pragma pack(pop)
+
+#define UW_ENTITY_MAX_PACKET		((int)(sizeof(UWEntityHeader) + UW_ENTITY_MAX_RECORDS*sizeof(UWEntityRecord)))
+
+
+
+/*
+Start a packet with no records in the buffer, which must hold UW_ENTITY_MAX_PACKET bytes.  Returns its length.
+*/
+inline int UWEntityBeginPacket(char * buffer)
+{
+	UWEntityHeader header;
+	memcpy(header.magic, UW_ENTITY_MAGIC, 4);
+	header.count	= 0;
+	header.reserved	= 0;
+	memcpy(buffer, &header, sizeof(header));
+	return sizeof(header);
+}
+
+
+
+/*
+Append a record to a packet started with UWEntityBeginPacket.  Returns the new length of the packet or -1 if it
+already holds UW_ENTITY_MAX_RECORDS records.
+*/
+inline int UWEntityAddRecord(char * buffer, const UWEntityRecord * record)
+{
+	UWEntityHeader header;
+	memcpy(&header, buffer, sizeof(header));
+	if(header.count >= UW_ENTITY_MAX_RECORDS) {
+		return -1;
+	}
+
+	int length = sizeof(header) + header.count * sizeof(UWEntityRecord);
+	memcpy(buffer + length, record, sizeof(UWEntityRecord));
+	header.count++;
+	memcpy(buffer, &header, sizeof(header));
+	return length + sizeof(UWEntityRecord);
+}
+
+
+
+/*
+Returns true if the packet is an entity packet
+*/
+inline bool UWEntityIsPacket(const char * packet, int length)
+{
+	return length >= (int)sizeof(UWEntityHeader) && memcmp(packet, UW_ENTITY_MAGIC, 4) == 0;
+}
+
+
+
+/*
+Returns the number of records in an entity packet or -1 if the length does not match
+*/
+inline int UWEntityRecordCount(const char * packet, int length)
+{
+	UWEntityHeader header;
+	memcpy(&header, packet, sizeof(header));
+	if(header.count > UW_ENTITY_MAX_RECORDS ||
+	   length != (int)(sizeof(UWEntityHeader) + header.count * sizeof(UWEntityRecord))) {
+		return -1;
+	}
+	return header.count;
+}
+
+#endif
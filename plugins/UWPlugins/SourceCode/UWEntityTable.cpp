@@ -0,0 +1,480 @@
+/*
+UWEntityTable.cpp
+
+See UWEntityTable.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "XPLMGraphics.h"
+
+#include "UWClock.h"
+#include "UWEntityTable.h"
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Allocate everything for max_entities entities of numModels models (nothing is allocated after this)
+*/
+void UWEntityTableInit(UWEntityTable * table, const UWPluginConfig * config, int numModels)
+{
+	table->capacity		= UWConfigGetInt(config, "max_entities", 4096);
+	table->timeout		= UWConfigGetDouble(config, "entity_timeout", 5.0);
+	table->numModels	= numModels;
+	if(table->capacity < 1) {
+		table->capacity = 1;
+	}
+
+	table->hashBits = 1;
+	while((1 << table->hashBits) < 2*table->capacity) {
+		table->hashBits++;
+	}
+
+	int numInstances = (numModels > 0) ? numModels * table->capacity : 1;
+	table->entities		= new UWEntity[table->capacity];
+	table->hash			= new int[1 << table->hashBits];
+	table->drawInfo		= new XPLMDrawInfo_t[numInstances];
+	table->visible		= new int[table->capacity];
+	table->visibleLODs	= new UWEntityLOD[table->capacity];
+
+	for(int i = 0; i < numInstances; i++) {
+		table->drawInfo[i].structSize = sizeof(XPLMDrawInfo_t);
+	}
+
+	UWEntityCullingReadSettings(&table->culling, config);
+	UWEntityGridInit(&table->grid, config, table->capacity);
+
+	table->latRefRef	= XPLMFindDataRef("sim/flightmodel/position/lat_ref");
+	table->lonRefRef	= XPLMFindDataRef("sim/flightmodel/position/lon_ref");
+
+	UWEntityTableClear(table);
+}
+
+
+
+void UWEntityTableStop(UWEntityTable * table)
+{
+	delete [] table->entities;
+	delete [] table->hash;
+	delete [] table->drawInfo;
+	delete [] table->visible;
+	delete [] table->visibleLODs;
+	table->entities		= NULL;
+	table->hash			= NULL;
+	table->drawInfo		= NULL;
+	table->visible		= NULL;
+	table->visibleLODs	= NULL;
+
+	UWEntityGridStop(&table->grid);
+}
+
+
+
+/*
+Remove every entity and reset the statistics
+*/
+void UWEntityTableClear(UWEntityTable * table)
+{
+	for(int i = 0; i < table->capacity; i++) {
+		table->entities[i].model	= -1;
+		table->entities[i].nextFree	= (i + 1 < table->capacity) ? i + 1 : -1;
+	}
+	table->firstFree	= 0;
+	table->numEntities	= 0;
+	table->sweep		= 0;
+	UWEntityGridClear(&table->grid);
+
+	for(int i = 0; i < (1 << table->hashBits); i++) {
+		table->hash[i] = -1;
+	}
+	memset(table->drawCounts, 0, sizeof(table->drawCounts));
+	memset(table->tiers, 0, sizeof(table->tiers));
+	table->frame		= 0;
+
+	table->latRef		= 0.0f;
+	table->lonRef		= 0.0f;
+	table->originMoved	= false;
+	table->records		= 0;
+	table->rejected		= 0;
+	table->timedOut		= 0;
+	table->converted	= 0;
+	table->cellsVisited	= 0;
+	table->stepSeconds	= 0.0;
+}
+
+
+
+/*
+The hash table slot an id starts probing at (Fibonacci hashing, so consecutive ids spread over the table)
+*/
+static int HomeSlot(const UWEntityTable * table, unsigned int id)
+{
+	return (int)((id * 2654435769u) >> (32 - table->hashBits));
+}
+
+
+
+/*
+Returns the hash table slot which holds the entity with the id, or the empty slot where it would go
+*/
+static int FindSlot(const UWEntityTable * table, unsigned int id)
+{
+	int mask = (1 << table->hashBits) - 1;
+	int slot = HomeSlot(table, id);
+	while(table->hash[slot] >= 0 && table->entities[table->hash[slot]].id != id) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+
+
+/*
+Empty a hash table slot, moving the entries after it back so that every entry can still be found by probing from
+its home slot
+*/
+static void EraseSlot(UWEntityTable * table, int slot)
+{
+	int mask = (1 << table->hashBits) - 1;
+	table->hash[slot] = -1;
+
+	int next = slot;
+	while(true) {
+		next = (next + 1) & mask;
+		if(table->hash[next] < 0) {
+			return;
+		}
+
+		//the entry can move back into the empty slot unless its home slot lies cyclically in (slot, next]
+		int home = HomeSlot(table, table->entities[table->hash[next]].id);
+		bool reachable = (slot <= next) ? (slot < home && home <= next) : (slot < home || home <= next);
+		if(!reachable) {
+			table->hash[slot]	= table->hash[next];
+			table->hash[next]	= -1;
+			slot = next;
+		}
+	}
+}
+
+
+
+static void RemoveEntity(UWEntityTable * table, int index)
+{
+	UWEntity * entity = &table->entities[index];
+	UWEntityGridRemove(&table->grid, index);
+	EraseSlot(table, FindSlot(table, entity->id));
+
+	entity->model		= -1;
+	entity->nextFree	= table->firstFree;
+	table->firstFree	= index;
+	table->numEntities--;
+}
+
+
+
+/*
+Wrap an angle difference into [-180, 180) degrees
+*/
+static float WrapDegrees(float angle)
+{
+	while(angle >= 180.0f) {
+		angle -= 360.0f;
+	}
+	while(angle < -180.0f) {
+		angle += 360.0f;
+	}
+	return angle;
+}
+
+
+
+/*
+The pose of the entity at the time now, between its previous and its newest pose
+*/
+static void Interpolate(const UWEntity * entity, double now, float * outPose)
+{
+	float t = (float)((now - entity->updateTime) / entity->interval);
+	if(t >= 1.0f) {
+		memcpy(outPose, entity->to, sizeof(entity->to));
+		return;
+	}
+	if(t < 0.0f) {
+		t = 0.0f;
+	}
+
+	for(int i = 0; i < uwPose_Count; i++) {
+		float delta = entity->to[i] - entity->from[i];
+		if(i >= uwPose_Pitch) {
+			delta = WrapDegrees(delta);
+		}
+		outPose[i] = entity->from[i] + t*delta;
+	}
+}
+
+
+
+/*
+Apply one record.  Returns false if it was rejected.
+*/
+static bool ApplyRecord(UWEntityTable * table, const UWEntityRecord * record, double now)
+{
+	int slot = FindSlot(table, record->id);
+	int index = table->hash[slot];
+
+	if(record->flags & uwEntity_Remove) {
+		if(index >= 0) {
+			RemoveEntity(table, index);
+		}
+		return true;
+	}
+
+	if(record->model >= table->numModels) {
+		return false;
+	}
+
+	UWEntity * entity;
+	if(index < 0) {
+		//a new entity
+		if(table->firstFree < 0) {
+			return false;
+		}
+		index				= table->firstFree;
+		entity				= &table->entities[index];
+		table->firstFree	= entity->nextFree;
+		table->hash[slot]	= index;
+		table->numEntities++;
+
+		entity->id			= record->id;
+		entity->model		= record->model;
+		entity->snap		= true;
+		entity->drawnFrame	= -1;
+		entity->trafficSlot	= -1;
+		entity->interval	= UW_ENTITY_FIRST_INTERVAL;
+	} else {
+		entity = &table->entities[index];
+		entity->model = record->model;
+
+		//start from where the entity is now (unless the previous record has not even been converted yet)
+		if(!entity->dirty) {
+			Interpolate(entity, now, entity->from);
+		}
+
+		double interval = now - entity->updateTime;
+		if(interval > 1.0) {
+			interval = 1.0;
+		}
+		entity->interval = 0.8*entity->interval + 0.2*interval;
+		if(entity->interval < 0.001) {
+			entity->interval = 0.001;
+		}
+	}
+
+	entity->latitude	= record->latitude;
+	entity->longitude	= record->longitude;
+	entity->altitude	= record->altitude;
+	entity->phi			= record->phi;
+	entity->theta		= record->theta;
+	entity->psi			= record->psi;
+	entity->dirty		= true;
+	entity->updateTime	= now;
+	UWEntityGridMove(&table->grid, index, entity->latitude, entity->longitude, entity->altitude);
+	return true;
+}
+
+
+
+/*
+Apply every record of an entity packet received at the time now (in the same time base as UWEntityTableStep).
+Returns the number of records applied.
+*/
+int UWEntityTableApplyPacket(UWEntityTable * table, const char * packet, int length, double now)
+{
+	int count = UWEntityRecordCount(packet, length);
+	if(count < 0) {
+		table->rejected++;
+		return 0;
+	}
+
+	int applied = 0;
+	for(int i = 0; i < count; i++) {
+		UWEntityRecord record;
+		memcpy(&record, packet + sizeof(UWEntityHeader) + i*sizeof(UWEntityRecord), sizeof(record));
+		if(ApplyRecord(table, &record, now)) {
+			applied++;
+		} else {
+			table->rejected++;
+		}
+	}
+
+	table->records += applied;
+	return applied;
+}
+
+
+
+/*
+Convert the newest record of the entity to local coordinates
+*/
+static void Convert(UWEntity * entity)
+{
+	double x, y, z;
+	XPLMWorldToLocal(entity->latitude, entity->longitude, entity->altitude, &x, &y, &z);
+
+	entity->to[uwPose_X]		= (float)x;
+	entity->to[uwPose_Y]		= (float)y;
+	entity->to[uwPose_Z]		= (float)z;
+	entity->to[uwPose_Pitch]	= entity->theta;
+	entity->to[uwPose_Heading]	= entity->psi;
+	entity->to[uwPose_Roll]		= entity->phi;
+	entity->dirty				= false;
+
+	if(entity->snap) {
+		memcpy(entity->from, entity->to, sizeof(entity->to));
+		entity->snap = false;
+	}
+}
+
+
+
+/*
+Once per frame, before the entities are drawn: remove the entities which timed out, find the entities in view,
+convert the dirty ones and pack their poses at the time now into the arrays to draw
+*/
+void UWEntityTableStep(UWEntityTable * table, double now)
+{
+	double start = UWClockMonotonicSeconds();
+	UWEntityCullingBegin(&table->culling);
+	table->frame++;
+
+	//if X-Plane moved its local origin every local pose is out of date
+	table->originMoved = false;
+	if(table->latRefRef != NULL && table->lonRefRef != NULL) {
+		float latRef = XPLMGetDataf(table->latRefRef);
+		float lonRef = XPLMGetDataf(table->lonRefRef);
+		table->originMoved = (latRef != table->latRef || lonRef != table->lonRef);
+		table->latRef = latRef;
+		table->lonRef = lonRef;
+	}
+
+	//the entities out of view are checked for timeouts a share at a time
+	int sweep = table->capacity / UW_ENTITY_SWEEP_FRAMES + 1;
+	for(int i = 0; i < sweep; i++) {
+		int index = table->sweep;
+		table->sweep = (index + 1 < table->capacity) ? index + 1 : 0;
+		if(table->entities[index].model >= 0 && now - table->entities[index].updateTime > table->timeout) {
+			RemoveEntity(table, index);
+			table->timedOut++;
+		}
+	}
+
+	int numVisible = UWEntityGridQueryView(&table->grid, &table->culling, table->visible, table->visibleLODs,
+										   table->capacity);
+
+	int converted = 0;
+	int tiers[UW_LOD_TIERS] = { 0, 0, 0 };
+	memset(table->drawCounts, 0, sizeof(table->drawCounts));
+	for(int i = 0; i < numVisible; i++) {
+		int index = table->visible[i];
+		UWEntityLOD lod = table->visibleLODs[i];
+		UWEntity * entity = &table->entities[index];
+
+		if(now - entity->updateTime > table->timeout) {
+			RemoveEntity(table, index);
+			table->timedOut++;
+			continue;
+		}
+
+		//a multiplayer aircraft stands for the entity
+		if(entity->trafficSlot >= 0) {
+			continue;
+		}
+
+		//an entity which was not drawn last frame (new or culled) is put at its newest pose
+		if(table->originMoved || entity->drawnFrame != table->frame - 1) {
+			entity->snap	= true;
+			entity->dirty	= true;
+		}
+		entity->drawnFrame = table->frame;
+
+		//the far entities take turns to be converted (but new and returning ones are converted straight away)
+		bool due = (lod != uwLOD_Far) || entity->snap || (table->frame + index) % table->culling.farFrames == 0;
+		if(entity->dirty && due) {
+			Convert(entity);
+			converted++;
+		}
+
+		//only the near entities are interpolated, the rest are drawn at their newest pose
+		float pose[uwPose_Count];
+		if(lod == uwLOD_Near) {
+			Interpolate(entity, now, pose);
+		} else {
+			memcpy(pose, entity->to, sizeof(pose));
+			memcpy(entity->from, entity->to, sizeof(entity->from));
+		}
+		tiers[lod]++;
+
+		XPLMDrawInfo_t * info = &table->drawInfo[entity->model * table->capacity + table->drawCounts[entity->model]++];
+		info->x			= pose[uwPose_X];
+		info->y			= pose[uwPose_Y];
+		info->z			= pose[uwPose_Z];
+		info->pitch		= pose[uwPose_Pitch];
+		info->heading	= pose[uwPose_Heading];
+		info->roll		= pose[uwPose_Roll];
+	}
+
+	memcpy(table->tiers, tiers, sizeof(tiers));
+	table->converted	= converted;
+	table->cellsVisited	= table->grid.cellsVisited;
+	table->stepSeconds	= UWClockMonotonicSeconds() - start;
+}
+
+
+
+/*
+The pose of an entity at the time now, for an entity the table does not draw (see UWEntityTraffic.h).  Called
+after UWEntityTableStep, every frame while it stands in for the entity.
+*/
+void UWEntityTablePose(UWEntityTable * table, int index, double now, float * outPose)
+{
+	UWEntity * entity = &table->entities[index];
+	if(table->originMoved) {
+		entity->snap	= true;
+		entity->dirty	= true;
+	}
+	if(entity->dirty) {
+		Convert(entity);
+	}
+	Interpolate(entity, now, outPose);
+}
+
+
+
+/*
+Draw the entities, one XPLMDrawObjects call per model which is loaded and has instances.  Called from a draw
+callback in the xplm_Phase_Objects phase.
+*/
+void UWEntityTableDraw(const UWEntityTable * table, const UWEntityModels * models, int lighting)
+{
+	for(int model = 0; model < table->numModels; model++) {
+		XPLMObjectRef object = UWEntityModelObject(models, model);
+		if(object != NULL && table->drawCounts[model] > 0) {
+			XPLMDrawObjects(object, table->drawCounts[model], &table->drawInfo[model * table->capacity], lighting, 1);
+		}
+	}
+}
+
+
+
+/*
+One line for the overlay, e.g. "Entities 5000 of 8192 in 812 cells, drawn 40/300/900 (near/mid/far) from 95 cells,
+120 converted in 0.21 ms, 0 rejected, 3 timed out".  outText must hold UW_ENTITY_TABLE_DESCRIPTION_LENGTH characters.
+*/
+void UWEntityTableDescribe(const UWEntityTable * table, char * outText)
+{
+	sprintf(outText, "Entities %d of %d in %d cells, drawn %d/%d/%d (near/mid/far) from %d cells, %d converted in "
+			"%.2f ms, %lld rejected, %lld timed out", table->numEntities, table->capacity, table->grid.numCells,
+			table->tiers[uwLOD_Near], table->tiers[uwLOD_Mid], table->tiers[uwLOD_Far], table->cellsVisited,
+			table->converted, 1000.0*table->stepSeconds, table->rejected, table->timedOut);
+}
@@ -0,0 +1,134 @@
+/*
+UWEntityTable.h
+
+The entities streamed to UWStreamedEntities (see UWEntityProtocol.h), kept so that drawing thousands of them costs
+one XPLMDrawObjects call per model and per frame.
+
+Everything is allocated once, by UWEntityTableInit, for max_entities entities: the entities themselves, a hash
+table from entity id to entity (open addressing with linear probing, so a record is applied with a lookup and no
+allocation), a spatial index of the entities' positions (see UWEntityGrid.h) and, for every model, an array of
+XPLMDrawInfo_t for the instances drawn this frame.
+
+Records only store the world position (latitude, longitude, altitude) of an entity, move it in the spatial index
+if it left its cell and mark it dirty.  Once per frame UWEntityTableStep asks the spatial index for the entities in
+view (see UWEntityCulling.h), so the entities in cells out of view or too far away cost nothing at all.  It
+converts the dirty entities in view to X-Plane's local coordinates (one XPLMWorldToLocal call each, however many
+records arrived for it), moves the near entities between their previous and their newest pose over the time it
+took the newest one to arrive, so entities updated at a lower rate than the frame rate move smoothly, and packs
+the instances to draw into the arrays handed to XPLMDrawObjects.  An entity which was not drawn in the previous
+frame (it is new or was culled) is put at its newest pose.  When X-Plane moves its local origin (lat_ref/lon_ref
+change) every entity is converted again, as it is drawn, and put at its newest pose.  Entities which have not been
+updated for entity_timeout seconds are removed: every step checks the entities in view and a share of the rest, so
+every entity is checked at least every UW_ENTITY_SWEEP_FRAMES frames.
+
+An entity which a multiplayer aircraft stands for (see UWEntityTraffic.h) is not drawn; UWEntityTablePose gives
+its pose to whoever moves the aircraft.
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	max_entities		most entities tracked at the same time (default 4096); records for new entities beyond
+						this are dropped
+	entity_timeout		seconds without a record after which an entity is removed (default 5)
+*/
+
+#ifndef _UWEntityTable_h_
+#define _UWEntityTable_h_
+
+#include "XPLMDataAccess.h"
+#include "XPLMScenery.h"
+
+#include "UWPluginConfig.h"
+#include "UWEntityProtocol.h"
+#include "UWEntityModels.h"
+#include "UWEntityCulling.h"
+#include "UWEntityGrid.h"
+
+#define UW_ENTITY_TABLE_DESCRIPTION_LENGTH	160		//see UWEntityTableDescribe
+#define UW_ENTITY_FIRST_INTERVAL			0.05	//seconds between records assumed for a new entity
+#define UW_ENTITY_SWEEP_FRAMES				32		//frames to check every entity for a timeout
+
+enum UWEntityPose {
+	uwPose_X,										//local coordinates, meters
+	uwPose_Y,
+	uwPose_Z,
+	uwPose_Pitch,									//degrees
+	uwPose_Heading,
+	uwPose_Roll,
+	uwPose_Count
+};
+
+struct UWEntity {
+	unsigned int	id;
+	int				model;							//-1 while the entity is free
+	int				nextFree;						//next free entity (while the entity is free)
+	long long		drawnFrame;						//step which last drew the entity
+	int				trafficSlot;					//multiplayer aircraft which stands for the entity, -1 if none
+
+	double			latitude;						//newest record
+	double			longitude;
+	double			altitude;
+	float			phi;
+	float			theta;
+	float			psi;
+	bool			dirty;							//the newest record has not been converted to local coordinates
+	bool			snap;							//put the entity at the newest pose (it is new or was culled)
+
+	float			from[uwPose_Count];				//pose at updateTime
+	float			to[uwPose_Count];				//newest pose, reached at updateTime + interval
+	double			updateTime;						//when the newest record arrived
+	double			interval;						//smoothed time between records
+};
+
+struct UWEntityTable {
+	int				capacity;						//max_entities
+	int				numModels;
+	double			timeout;
+
+	UWEntity *		entities;						//capacity entities
+	int				firstFree;						//-1 if every entity is used
+	int				numEntities;
+	int *			hash;							//entity index for every slot, -1 if the slot is empty
+	int				hashBits;						//the hash table has 2^hashBits slots (at least 2*capacity)
+	UWEntityGrid	grid;							//where the entities are
+	int *			visible;						//capacity entities in view, for the step
+	UWEntityLOD *	visibleLODs;
+	int				sweep;							//next entity to check for a timeout
+	XPLMDrawInfo_t *	drawInfo;					//numModels arrays of capacity instances, drawn this frame
+	int				drawCounts[UW_ENTITY_MAX_MODELS];	//instances to draw of every model
+	UWEntityCulling	culling;
+	long long		frame;							//steps taken, to spread the updates of the far entities
+
+	XPLMDataRef		latRefRef;						//X-Plane's local origin
+	XPLMDataRef		lonRefRef;
+	float			latRef;
+	float			lonRef;
+	bool			originMoved;					//by the last step
+
+	long long		records;						//applied
+	long long		rejected;						//unknown model, malformed packet or no room for a new entity
+	long long		timedOut;
+	int				converted;						//entities converted to local coordinates by the last step
+	int				cellsVisited;					//spatial index cells looked at by the last step
+	int				tiers[UW_LOD_TIERS];			//entities drawn in every level of detail tier by the last step
+	double			stepSeconds;					//time taken by the last step
+};
+
+
+
+void		UWEntityTableInit(UWEntityTable * table, const UWPluginConfig * config, int numModels);
+
+void		UWEntityTableStop(UWEntityTable * table);
+
+void		UWEntityTableClear(UWEntityTable * table);
+
+int			UWEntityTableApplyPacket(UWEntityTable * table, const char * packet, int length, double now);
+
+void		UWEntityTableStep(UWEntityTable * table, double now);
+
+void		UWEntityTablePose(UWEntityTable * table, int index, double now, float * outPose);
+
+void		UWEntityTableDraw(const UWEntityTable * table, const UWEntityModels * models, int lighting);
+
+void		UWEntityTableDescribe(const UWEntityTable * table, char * outText);
+
+#endif
@@ -0,0 +1,405 @@
+/*
+UWEntityTraffic.cpp
+
+See UWEntityTraffic.h
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "XPLMPlanes.h"
+#include "XPLMUtilities.h"
+
+#include "UWEntityTraffic.h"
+
+#define KEEP_RANGE		1.25			//of traffic_range: an entity keeps its slot this far from the camera
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWEntityTrafficInit(UWEntityTraffic * traffic, const UWPluginConfig * config, int capacity)
+{
+	traffic->enabled		= UWConfigGetInt(config, "traffic", 0) != 0;
+	traffic->maxSlots		= UWConfigGetInt(config, "traffic_slots", UW_TRAFFIC_MAX_SLOTS);
+	traffic->range			= UWConfigGetDouble(config, "traffic_range", 20000.0);
+	traffic->loadInterval	= UWConfigGetDouble(config, "aircraft_load_interval", 2.0);
+	if(traffic->maxSlots > UW_TRAFFIC_MAX_SLOTS) {
+		traffic->maxSlots = UW_TRAFFIC_MAX_SLOTS;
+	}
+	if(traffic->loadInterval < 0.1) {
+		traffic->loadInterval = 0.1;
+	}
+
+	for(int i = 0; i < UW_ENTITY_MAX_MODELS; i++) {
+		char key[UW_CONFIG_KEY_LENGTH];
+		sprintf(key, "aircraft%d", i);
+		strncpy(traffic->aircraft[i], UWConfigGetString(config, key, ""), UW_CONFIG_VALUE_LENGTH - 1);
+		traffic->aircraft[i][UW_CONFIG_VALUE_LENGTH - 1] = '\0';
+	}
+
+	for(int i = 0; i < UW_TRAFFIC_MAX_SLOTS; i++) {
+		UWTrafficSlot * slot = &traffic->slots[i];
+		char name[64];
+		sprintf(name, "sim/multiplayer/position/plane%d_x", i + 1);
+		slot->xRef		= XPLMFindDataRef(name);
+		sprintf(name, "sim/multiplayer/position/plane%d_y", i + 1);
+		slot->yRef		= XPLMFindDataRef(name);
+		sprintf(name, "sim/multiplayer/position/plane%d_z", i + 1);
+		slot->zRef		= XPLMFindDataRef(name);
+		sprintf(name, "sim/multiplayer/position/plane%d_the", i + 1);
+		slot->thetaRef	= XPLMFindDataRef(name);
+		sprintf(name, "sim/multiplayer/position/plane%d_phi", i + 1);
+		slot->phiRef	= XPLMFindDataRef(name);
+		sprintf(name, "sim/multiplayer/position/plane%d_psi", i + 1);
+		slot->psiRef	= XPLMFindDataRef(name);
+
+		slot->entity			= -1;
+		slot->aircraft			= -1;
+		slot->wantedAircraft	= -1;
+	}
+
+	traffic->candidates		= new int[(capacity > 0) ? capacity : 1];
+	traffic->state			= uwTraffic_Off;
+	traffic->numSlots		= 0;
+	traffic->numOwned		= 0;
+	traffic->nextAssignTime	= 0.0;
+	traffic->loads			= 0;
+}
+
+
+
+void UWEntityTrafficStop(UWEntityTraffic * traffic, UWEntityTable * table)
+{
+	UWEntityTrafficRelease(traffic, table);
+
+	delete [] traffic->candidates;
+	traffic->candidates = NULL;
+}
+
+
+
+/*
+Move a slot's aircraft out of the way
+*/
+static void Park(UWTrafficSlot * slot)
+{
+	if(slot->xRef != NULL && slot->yRef != NULL && slot->zRef != NULL) {
+		XPLMSetDatad(slot->xRef, 0.0);
+		XPLMSetDatad(slot->yRef, -UW_TRAFFIC_PARK_DEPTH);
+		XPLMSetDatad(slot->zRef, 0.0);
+	}
+}
+
+
+
+/*
+Activate the aircraft we have just acquired and turn their AI off.  What they have loaded is not known, so every
+slot loads its aircraft before it is used.
+*/
+static void TakePlanes(UWEntityTraffic * traffic)
+{
+	int total, active;
+	XPLMPluginID controller;
+	XPLMCountAircraft(&total, &active, &controller);
+
+	traffic->numSlots = (total - 1 < traffic->maxSlots) ? total - 1 : traffic->maxSlots;
+	if(traffic->numSlots < 0) {
+		traffic->numSlots = 0;
+	}
+	XPLMSetActiveAircraftCount(traffic->numSlots + 1);
+
+	for(int i = 0; i < traffic->numSlots; i++) {
+		UWTrafficSlot * slot = &traffic->slots[i];
+		XPLMDisableAIForPlane(i + 1);
+		slot->entity			= -1;
+		slot->aircraft			= -1;
+		slot->wantedAircraft	= -1;
+		Park(slot);
+	}
+
+	traffic->state			= uwTraffic_Owned;
+	traffic->numOwned		= 0;
+	traffic->nextAssignTime	= 0.0;
+}
+
+
+
+/*
+Called by X-Plane when another plugin releases the aircraft we asked for
+*/
+static void PlanesAvailable(void * inRefcon)
+{
+	UWEntityTraffic * traffic = (UWEntityTraffic *)inRefcon;
+	if(traffic->state == uwTraffic_Waiting && XPLMAcquirePlanes(NULL, PlanesAvailable, traffic)) {
+		TakePlanes(traffic);
+	}
+}
+
+
+
+/*
+Take the multiplayer aircraft, or wait for them if another plugin has them (if traffic is on)
+*/
+void UWEntityTrafficAcquire(UWEntityTraffic * traffic)
+{
+	if(!traffic->enabled || traffic->state != uwTraffic_Off) {
+		return;
+	}
+
+	if(XPLMAcquirePlanes(NULL, PlanesAvailable, traffic)) {
+		TakePlanes(traffic);
+	} else {
+		traffic->state = uwTraffic_Waiting;
+		XPLMDebugString("UWStreamedEntities: waiting for another plugin to release the multiplayer aircraft\n");
+	}
+}
+
+
+
+/*
+Give the slot's entity back to the table (unless the entity is gone) and park the aircraft
+*/
+static void FreeSlot(UWEntityTraffic * traffic, UWEntityTable * table, int index)
+{
+	UWTrafficSlot * slot = &traffic->slots[index];
+	UWEntity * entity = &table->entities[slot->entity];
+	if(entity->model >= 0 && entity->id == slot->id && entity->trafficSlot == index) {
+		entity->trafficSlot = -1;
+	}
+
+	slot->entity = -1;
+	traffic->numOwned--;
+	Park(slot);
+}
+
+
+
+/*
+Give every entity back to the table and the aircraft back to X-Plane
+*/
+void UWEntityTrafficRelease(UWEntityTraffic * traffic, UWEntityTable * table)
+{
+	if(traffic->state == uwTraffic_Owned) {
+		for(int i = 0; i < traffic->numSlots; i++) {
+			if(traffic->slots[i].entity >= 0) {
+				FreeSlot(traffic, table, i);
+			}
+		}
+		XPLMReleasePlanes();
+	}
+
+	//if we were waiting PlanesAvailable ignores the aircraft when they come
+	traffic->state		= uwTraffic_Off;
+	traffic->numSlots	= 0;
+}
+
+
+
+/*
+Horizontal meters from the camera of this frame (see UWEntityCullingBegin) to the entity
+*/
+static double CameraDistance(const UWEntityTable * table, const UWEntity * entity)
+{
+	const UWEntityCulling * culling = &table->culling;
+	double dx = (entity->longitude - culling->cameraLongitude) * culling->metersPerDegreeLongitude;
+	double dy = (entity->latitude - culling->cameraLatitude) * culling->metersPerDegreeLatitude;
+	return sqrt(dx*dx + dy*dy);
+}
+
+
+
+/*
+Put the slot's aircraft where its entity is at the time now
+*/
+static void MovePlane(const UWTrafficSlot * slot, UWEntityTable * table, double now)
+{
+	float pose[uwPose_Count];
+	UWEntityTablePose(table, slot->entity, now, pose);
+
+	if(slot->xRef != NULL && slot->yRef != NULL && slot->zRef != NULL) {
+		XPLMSetDatad(slot->xRef, pose[uwPose_X]);
+		XPLMSetDatad(slot->yRef, pose[uwPose_Y]);
+		XPLMSetDatad(slot->zRef, pose[uwPose_Z]);
+	}
+	if(slot->thetaRef != NULL && slot->phiRef != NULL && slot->psiRef != NULL) {
+		XPLMSetDataf(slot->thetaRef, pose[uwPose_Pitch]);
+		XPLMSetDataf(slot->phiRef, pose[uwPose_Roll]);
+		XPLMSetDataf(slot->psiRef, pose[uwPose_Heading]);
+	}
+}
+
+
+
+/*
+Hand the free slots to the nearest entities within range which have no slot.  An entity gets a slot which has its
+aircraft loaded; if there is none a free slot is queued to load it (see UWEntityTrafficLoadAircraft).
+*/
+static void AssignSlots(UWEntityTraffic * traffic, UWEntityTable * table, double now)
+{
+	int wanted = traffic->numSlots - traffic->numOwned;
+	int count = UWEntityGridQueryRadius(&table->grid, table->culling.cameraLatitude, table->culling.cameraLongitude,
+										traffic->range, traffic->candidates, table->capacity);
+
+	//the nearest entities, nearest first (there are never more than UW_TRAFFIC_MAX_SLOTS of them)
+	int nearest[UW_TRAFFIC_MAX_SLOTS];
+	double distances[UW_TRAFFIC_MAX_SLOTS];
+	int numNearest = 0;
+	for(int i = 0; i < count; i++) {
+		const UWEntity * entity = &table->entities[traffic->candidates[i]];
+		if(entity->trafficSlot >= 0 || traffic->aircraft[entity->model][0] == '\0') {
+			continue;
+		}
+
+		double distance = CameraDistance(table, entity);
+		if(numNearest == wanted && distance >= distances[numNearest - 1]) {
+			continue;
+		}
+		int at = (numNearest < wanted) ? numNearest++ : numNearest - 1;
+		while(at > 0 && distances[at - 1] > distance) {
+			nearest[at]		= nearest[at - 1];
+			distances[at]	= distances[at - 1];
+			at--;
+		}
+		nearest[at]		= traffic->candidates[i];
+		distances[at]	= distance;
+	}
+
+	//a slot already queued to load an entity's aircraft serves that entity, so it is not queued twice
+	bool claimed[UW_TRAFFIC_MAX_SLOTS];
+	memset(claimed, 0, sizeof(claimed));
+
+	for(int n = 0; n < numNearest; n++) {
+		UWEntity * entity = &table->entities[nearest[n]];
+
+		int loaded = -1;
+		int queued = -1;
+		int load = -1;
+		for(int i = 0; i < traffic->numSlots && loaded < 0; i++) {
+			const UWTrafficSlot * slot = &traffic->slots[i];
+			if(slot->entity >= 0 || claimed[i]) {
+				continue;
+			}
+			if(slot->aircraft == entity->model) {
+				loaded = i;
+			} else if(slot->wantedAircraft == entity->model) {
+				queued = i;
+			} else if(slot->wantedAircraft < 0 && (load < 0 || slot->aircraft < 0)) {
+				load = i;
+			}
+		}
+
+		if(loaded >= 0) {
+			UWTrafficSlot * slot = &traffic->slots[loaded];
+			slot->entity			= nearest[n];
+			slot->id				= entity->id;
+			slot->wantedAircraft	= -1;
+			entity->trafficSlot		= loaded;
+			entity->snap			= true;
+			entity->dirty			= true;
+			traffic->numOwned++;
+			MovePlane(slot, table, now);
+		} else if(queued >= 0) {
+			claimed[queued] = true;
+		} else if(load >= 0) {
+			traffic->slots[load].wantedAircraft = entity->model;
+			claimed[load] = true;
+		}
+	}
+}
+
+
+
+/*
+Once per frame, after UWEntityTableStep: free the slots whose entities are gone (or were created again), changed
+model or went out of range, move the aircraft of the others to their entities' poses at the time now and, every
+UW_TRAFFIC_ASSIGN_INTERVAL seconds, hand out the free slots
+*/
+void UWEntityTrafficStep(UWEntityTraffic * traffic, UWEntityTable * table, double now)
+{
+	if(traffic->state != uwTraffic_Owned) {
+		return;
+	}
+
+	for(int i = 0; i < traffic->numSlots; i++) {
+		UWTrafficSlot * slot = &traffic->slots[i];
+		if(slot->entity < 0) {
+			continue;
+		}
+
+		const UWEntity * entity = &table->entities[slot->entity];
+		//an entity removed and created again in the same place of the table no longer points back at the slot
+		if(entity->model < 0 || entity->id != slot->id || entity->model != slot->aircraft || entity->trafficSlot != i ||
+		   CameraDistance(table, entity) > KEEP_RANGE*traffic->range) {
+			FreeSlot(traffic, table, i);
+			continue;
+		}
+
+		MovePlane(slot, table, now);
+	}
+
+	if(now >= traffic->nextAssignTime && traffic->numOwned < traffic->numSlots) {
+		traffic->nextAssignTime = now + UW_TRAFFIC_ASSIGN_INTERVAL;
+		AssignSlots(traffic, table, now);
+	}
+}
+
+
+
+/*
+Load the aircraft one free slot is queued for, if any.  XPLMSetAircraftModel only returns once the aircraft is
+loaded, so this is called from its own flight loop, every aircraft_load_interval seconds, never from the flight
+loop which moves the entities.
+*/
+void UWEntityTrafficLoadAircraft(UWEntityTraffic * traffic)
+{
+	if(traffic->state != uwTraffic_Owned) {
+		return;
+	}
+
+	for(int i = 0; i < traffic->numSlots; i++) {
+		UWTrafficSlot * slot = &traffic->slots[i];
+		if(slot->entity >= 0 || slot->wantedAircraft < 0) {
+			continue;
+		}
+
+		char path[512];
+		XPLMGetSystemPath(path);
+		strncat(path, traffic->aircraft[slot->wantedAircraft], sizeof(path) - strlen(path) - 1);
+		XPLMSetAircraftModel(i + 1, path);
+		XPLMDisableAIForPlane(i + 1);
+		Park(slot);
+
+		slot->aircraft			= slot->wantedAircraft;
+		slot->wantedAircraft	= -1;
+		traffic->loads++;
+		return;
+	}
+}
+
+
+
+/*
+One line for the overlay, e.g. "Traffic: 5 of 19 aircraft in use, 2 queued to load, 12 loaded".  outText must hold
+UW_TRAFFIC_DESCRIPTION_LENGTH characters.
+*/
+void UWEntityTrafficDescribe(const UWEntityTraffic * traffic, char * outText)
+{
+	if(traffic->state == uwTraffic_Off) {
+		strcpy(outText, traffic->enabled ? "Traffic: the multiplayer aircraft are not ours" : "Traffic: off");
+		return;
+	}
+	if(traffic->state == uwTraffic_Waiting) {
+		strcpy(outText, "Traffic: waiting for another plugin to release the multiplayer aircraft");
+		return;
+	}
+
+	int queued = 0;
+	for(int i = 0; i < traffic->numSlots; i++) {
+		if(traffic->slots[i].wantedAircraft >= 0) {
+			queued++;
+		}
+	}
+	sprintf(outText, "Traffic: %d of %d aircraft in use, %d queued to load, %lld loaded", traffic->numOwned,
+			traffic->numSlots, queued, traffic->loads);
+}
@@ -0,0 +1,97 @@
+/*
+UWEntityTraffic.h
+
+Hands the streamed entities (see UWEntityTable.h) nearest the camera to X-Plane's multiplayer aircraft, so they
+show up as real aircraft (on TCAS, the map, ...) and X-Plane's own AI stops flying those aircraft against them.
+
+The plugin takes the aircraft with XPLMAcquirePlanes (waiting for them if another plugin has them), activates as
+many as there are slots and turns their AI off, so X-Plane spends no time flying them.  Every entity model may name
+the aircraft which stands for its entities (aircraft0, aircraft1, ... for model0, model1, ...); entities of models
+without one are never handed to an aircraft.
+
+Slots are handed out every UW_TRAFFIC_ASSIGN_INTERVAL seconds to the nearest entities within traffic_range of the
+camera (found with the spatial index, see UWEntityGrid.h), and only to slots which already have the entity's
+aircraft loaded.  An entity keeps its slot until it is removed, changes model or goes beyond 1.25 traffic_range.
+A free slot loaded with the wrong aircraft is queued to load the right one, and the entity is drawn as an object
+in the meantime.  XPLMSetAircraftModel loads the aircraft before it returns, so the loads are never made by
+UWEntityTrafficStep (which runs every frame): UWEntityTrafficLoadAircraft makes at most one, and is meant to be
+called from a flight loop of its own every aircraft_load_interval seconds.  Free slots are parked
+UW_TRAFFIC_PARK_DEPTH meters below the local origin.
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	traffic					1 to hand entities to multiplayer aircraft, 0 not to (default 0)
+	traffic_slots			most aircraft to use (default, and at most, UW_TRAFFIC_MAX_SLOTS)
+	traffic_range			meters from the camera (default 20000)
+	aircraft_load_interval	seconds between aircraft loads (default 2)
+	aircraft0, aircraft1...	the .acf file standing for the entities of model0, model1, ... relative to the X-System
+							folder
+*/
+
+#ifndef _UWEntityTraffic_h_
+#define _UWEntityTraffic_h_
+
+#include "XPLMDataAccess.h"
+
+#include "UWPluginConfig.h"
+#include "UWEntityTable.h"
+
+#define UW_TRAFFIC_MAX_SLOTS			19			//X-Plane's multiplayer aircraft, besides the user's
+#define UW_TRAFFIC_ASSIGN_INTERVAL		0.5			//seconds between handing out free slots
+#define UW_TRAFFIC_PARK_DEPTH			10000.0		//meters below the local origin a free slot waits at
+#define UW_TRAFFIC_DESCRIPTION_LENGTH	96			//see UWEntityTrafficDescribe
+
+enum UWTrafficState {
+	uwTraffic_Off,									//the aircraft are not ours
+	uwTraffic_Waiting,								//for another plugin to release the aircraft
+	uwTraffic_Owned
+};
+
+struct UWTrafficSlot {
+	int				entity;							//index in the entity table, -1 if the slot is free
+	unsigned int	id;								//of the entity
+	int				aircraft;						//model whose aircraft is loaded, -1 if not one of ours
+	int				wantedAircraft;					//model whose aircraft is to be loaded, -1 if none
+
+	XPLMDataRef		xRef;							//sim/multiplayer/position/planeN_...
+	XPLMDataRef		yRef;
+	XPLMDataRef		zRef;
+	XPLMDataRef		thetaRef;
+	XPLMDataRef		phiRef;
+	XPLMDataRef		psiRef;
+};
+
+struct UWEntityTraffic {
+	bool			enabled;
+	int				maxSlots;
+	double			range;
+	double			loadInterval;
+	char			aircraft[UW_ENTITY_MAX_MODELS][UW_CONFIG_VALUE_LENGTH];	//"" for models without one
+
+	UWTrafficState	state;
+	int				numSlots;						//aircraft activated when they were acquired
+	UWTrafficSlot	slots[UW_TRAFFIC_MAX_SLOTS];
+	int *			candidates;						//entities within range, for handing out slots
+	double			nextAssignTime;
+
+	int				numOwned;						//slots standing for an entity
+	long long		loads;							//aircraft loaded
+};
+
+
+
+void		UWEntityTrafficInit(UWEntityTraffic * traffic, const UWPluginConfig * config, int capacity);
+
+void		UWEntityTrafficStop(UWEntityTraffic * traffic, UWEntityTable * table);
+
+void		UWEntityTrafficAcquire(UWEntityTraffic * traffic);
+
+void		UWEntityTrafficRelease(UWEntityTraffic * traffic, UWEntityTable * table);
+
+void		UWEntityTrafficStep(UWEntityTraffic * traffic, UWEntityTable * table, double now);
+
+void		UWEntityTrafficLoadAircraft(UWEntityTraffic * traffic);
+
+void		UWEntityTrafficDescribe(const UWEntityTraffic * traffic, char * outText);
+
+#endif
@@ -0,0 +1,127 @@
+/*
+UWEpochApply.cpp
+
+See UWEpochApply.h
+*/
+
+#include <string.h>
+
+#include "UWClock.h"
+#include "UWEpochApply.h"
+
+using namespace std;
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWEpochReadSettings(UWEpochApply * epoch, const UWPluginConfig * config, const UWClockResponder * clock)
+{
+	epoch->enabled			= strcmp(UWConfigGetString(config, "apply_mode", "latest"), "epoch") == 0;
+	epoch->delay			= UWConfigGetDouble(config, "epoch_delay", 0.05);
+	epoch->clock			= clock;
+	epoch->statusAddress	= UWConfigGetString(config, "status_address", "127.0.0.1");
+	epoch->statusPort		= (unsigned short)UWConfigGetInt(config, "status_port", UW_EPOCH_STATUS_PORT);
+	epoch->nodeName			= UWConfigGetString(config, "node_name", "xplane");
+	epoch->statusSocket		= NULL;
+
+	UWJitterInit(&epoch->jitter, UWConfigGetDouble(config, "stale_after", 0.25));
+	epoch->lastAppliedTimestamp = 0.0;
+}
+
+
+
+/*
+Called when the plugin starts listening.  Empties the jitter buffer and opens the socket for the skew reports.
+*/
+void UWEpochStart(UWEpochApply * epoch)
+{
+	UWEpochStop(epoch);
+	if(!epoch->enabled) {
+		return;
+	}
+
+	UWJitterInit(&epoch->jitter, epoch->jitter.staleAfter);
+	epoch->lastAppliedTimestamp	= 0.0;
+	epoch->nextStatusTime		= UWClockMonotonicSeconds() + UW_EPOCH_STATUS_INTERVAL;
+
+	if(epoch->statusPort != 0) {
+		try {
+			epoch->statusSocket = new UDPSocket();
+		} catch (SocketException &e) {
+			epoch->statusSocket = NULL;
+		}
+	}
+}
+
+
+
+void UWEpochStop(UWEpochApply * epoch)
+{
+	delete epoch->statusSocket;
+	epoch->statusSocket = NULL;
+}
+
+
+
+/*
+The shared clock (the sender's time base) now
+*/
+double UWEpochSharedTime(const UWEpochApply * epoch)
+{
+	return UWClockResponderSenderTime(epoch->clock);
+}
+
+
+
+/*
+Buffer a pose received at receiveTime (kept with the pose for UWEpochSelect)
+*/
+void UWEpochPush(UWEpochApply * epoch, const UWPoseRecord * pose, double receiveTime)
+{
+	UWJitterPush(&epoch->jitter, pose, receiveTime);
+}
+
+
+
+/*
+Pick the pose for this frame's target display time.  Returns NULL if there is no pose or the pose has already
+been applied.  The time the pose was received is written to outReceiveTime (if not NULL).
+*/
+const UWPoseRecord * UWEpochSelect(UWEpochApply * epoch, double * outReceiveTime)
+{
+	const UWPoseRecord * pose = UWJitterSelect(&epoch->jitter, UWEpochSharedTime(epoch) - epoch->delay,
+											   outReceiveTime);
+	if(pose == NULL || pose->timestamp == epoch->lastAppliedTimestamp) {
+		return NULL;
+	}
+
+	epoch->lastAppliedTimestamp = pose->timestamp;
+	return pose;
+}
+
+
+
+/*
+Send the skew statistics to the status port once every UW_EPOCH_STATUS_INTERVAL seconds
+*/
+void UWEpochReport(UWEpochApply * epoch)
+{
+	if(epoch->statusSocket == NULL) {
+		return;
+	}
+
+	double now = UWClockMonotonicSeconds();
+	if(now < epoch->nextStatusTime) {
+		return;
+	}
+	epoch->nextStatusTime = now + UW_EPOCH_STATUS_INTERVAL;
+
+	char report[UW_JITTER_STATS_LENGTH];
+	int length = UWJitterFormatStats(&epoch->jitter, epoch->nodeName.c_str(), report);
+	try {
+		epoch->statusSocket->sendTo(report, length, epoch->statusAddress, epoch->statusPort);
+	} catch (SocketException &e) {
+
+	}
+	UWJitterResetStats(&epoch->jitter);
+}
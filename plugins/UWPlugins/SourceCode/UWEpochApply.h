@@ -0,0 +1,73 @@
+/*
+UWEpochApply.h
+
+The epoch apply mode of the timed processing plugins, for multi-node (dome) rendering.  Received poses go into a
+jitter buffer (see UWJitterBuffer.h) and every frame the node applies the pose for the target display time
+
+	target = sender clock now - delay
+
+so every node fed the same stream shows the same pose on the same frame.  Poses are time stamped by the sender
+(binary pose records carry a time stamp; a text pose packet can carry one in a schema field called timestamp).
+Untimed poses are stamped with the sender clock when they arrive.  The sender clock is mapped from the local
+clock with the estimate kept by the clock responder (see UWClockResponder.h), or with clock_offset until the
+sender has synchronized.
+
+Once a second the node sends its skew statistics as one line of text (see UWJitterFormatStats) in a UDP datagram
+to statusAddress:statusPort, where a monitor can collect the reports of every node.
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	apply_mode		latest (the default: apply the newest pose) or epoch
+	epoch_delay		seconds the target display time lags the shared clock (default 0.05)
+	clock_offset	sender clock minus local clock in seconds until the sender pings the plugin (default 0, i.e. the
+					clocks are synchronized by NTP/PTP)
+	stale_after		seconds after which the newest pose counts as stale (default 0.25)
+	status_address	where the skew reports are sent (default 127.0.0.1)
+	status_port		port the skew reports are sent to (default 49010, 0 to turn them off)
+	node_name		name of this node in the skew reports (default xplane)
+*/
+
+#ifndef _UWEpochApply_h_
+#define _UWEpochApply_h_
+
+#include <string>
+
+#include "PracticalSocket.h"
+#include "UWPluginConfig.h"
+#include "UWJitterBuffer.h"
+#include "UWClockResponder.h"
+
+#define UW_EPOCH_STATUS_PORT		49010
+#define UW_EPOCH_STATUS_INTERVAL	1.0			//seconds between skew reports
+
+struct UWEpochApply {
+	bool				enabled;				//apply_mode epoch
+	double				delay;
+	const UWClockResponder *	clock;		//maps the local clock onto the sender clock
+	UWJitterBuffer		jitter;
+	double				lastAppliedTimestamp;	//time stamp of the pose applied last (so it is not applied twice)
+
+	UDPSocket *			statusSocket;			//open while the plugin is listening
+	std::string			statusAddress;
+	unsigned short		statusPort;
+	std::string			nodeName;
+	double				nextStatusTime;
+};
+
+
+
+void					UWEpochReadSettings(UWEpochApply * epoch, const UWPluginConfig * config, const UWClockResponder * clock);
+
+void					UWEpochStart(UWEpochApply * epoch);
+
+void					UWEpochStop(UWEpochApply * epoch);
+
+double					UWEpochSharedTime(const UWEpochApply * epoch);
+
+void					UWEpochPush(UWEpochApply * epoch, const UWPoseRecord * pose, double receiveTime);
+
+const UWPoseRecord *	UWEpochSelect(UWEpochApply * epoch, double * outReceiveTime);
+
+void					UWEpochReport(UWEpochApply * epoch);
+
+#endif
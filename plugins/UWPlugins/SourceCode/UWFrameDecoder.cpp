@@ -0,0 +1,133 @@
+/*
+UWFrameDecoder.cpp
+
+See UWFrameDecoder.h
+*/
+
+#include <string.h>
+
+#include "UWFrameDecoder.h"
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Read the payload length of the frame starting at header
+*/
+static int DecodeLength(const char * header)
+{
+	const unsigned char * bytes = (const unsigned char *)header;
+	return (int)(((unsigned int)bytes[0] << 24) | ((unsigned int)bytes[1] << 16) | ((unsigned int)bytes[2] << 8) | bytes[3]);
+}
+
+
+
+void UWFrameInit(UWFrameDecoder * decoder)
+{
+	decoder->begin	= 0;
+	decoder->end	= 0;
+}
+
+
+
+/*
+Return where the next received bytes should be written and how many fit.  Bytes which have already been taken out
+are dropped first by moving the partial frame to the front of the buffer.
+*/
+char * UWFrameWriteSpace(UWFrameDecoder * decoder, int * outSpace)
+{
+	if(decoder->begin > 0) {
+		memmove(decoder->buffer, decoder->buffer + decoder->begin, decoder->end - decoder->begin);
+		decoder->end	-= decoder->begin;
+		decoder->begin	= 0;
+	}
+
+	*outSpace = UW_FRAME_BUFFER_SIZE - decoder->end;
+	return decoder->buffer + decoder->end;
+}
+
+
+
+void UWFrameCommit(UWFrameDecoder * decoder, int numBytes)
+{
+	decoder->end += numBytes;
+}
+
+
+
+/*
+Take the next complete frame out of the buffer.  outPayload points into the decoder's buffer and stays valid
+until the next call to UWFrameWriteSpace.  Returns the payload length, UW_FRAME_INCOMPLETE if no complete frame
+is buffered, or UW_FRAME_BAD if the stream is corrupt (the connection should then be dropped).
+*/
+int UWFrameNext(UWFrameDecoder * decoder, const char ** outPayload)
+{
+	int available = decoder->end - decoder->begin;
+	if(available < UW_FRAME_HEADER_SIZE) {
+		return UW_FRAME_INCOMPLETE;
+	}
+
+	int length = DecodeLength(decoder->buffer + decoder->begin);
+	if(length < 0 || length > UW_FRAME_MAX_PAYLOAD) {
+		return UW_FRAME_BAD;
+	}
+	if(available < UW_FRAME_HEADER_SIZE + length) {
+		return UW_FRAME_INCOMPLETE;
+	}
+
+	*outPayload = decoder->buffer + decoder->begin + UW_FRAME_HEADER_SIZE;
+	decoder->begin += UW_FRAME_HEADER_SIZE + length;
+	return length;
+}
+
+
+
+/*
+True if another complete frame is buffered
+*/
+bool UWFrameHasNext(const UWFrameDecoder * decoder)
+{
+	int available = decoder->end - decoder->begin;
+	if(available < UW_FRAME_HEADER_SIZE) {
+		return false;
+	}
+
+	int length = DecodeLength(decoder->buffer + decoder->begin);
+	return length >= 0 && length <= UW_FRAME_MAX_PAYLOAD && available >= UW_FRAME_HEADER_SIZE + length;
+}
+
+
+
+/*
+True if any complete frame still buffered has a payload which starts with the 4 bytes of magic (used to skip a
+stale pose only when a newer pose is already waiting behind it)
+*/
+bool UWFrameHasLater(const UWFrameDecoder * decoder, const char * magic)
+{
+	int begin = decoder->begin;
+	while(decoder->end - begin >= UW_FRAME_HEADER_SIZE) {
+		int length = DecodeLength(decoder->buffer + begin);
+		if(length < 0 || length > UW_FRAME_MAX_PAYLOAD || decoder->end - begin < UW_FRAME_HEADER_SIZE + length) {
+			return false;
+		}
+		if(length >= 4 && memcmp(decoder->buffer + begin + UW_FRAME_HEADER_SIZE, magic, 4) == 0) {
+			return true;
+		}
+		begin += UW_FRAME_HEADER_SIZE + length;
+	}
+	return false;
+}
+
+
+
+/*
+Write the 4 byte header of a frame with payloadLength bytes of payload
+*/
+void UWFrameEncodeHeader(char * buffer, int payloadLength)
+{
+	unsigned int length = (unsigned int)payloadLength;
+	buffer[0] = (char)((length >> 24) & 0xff);
+	buffer[1] = (char)((length >> 16) & 0xff);
+	buffer[2] = (char)((length >> 8) & 0xff);
+	buffer[3] = (char)(length & 0xff);
+}
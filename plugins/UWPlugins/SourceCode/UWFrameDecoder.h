@@ -0,0 +1,49 @@
+/*
+UWFrameDecoder.h
+
+Length-prefixed framing for the TCP pose source.  Each frame is a 4 byte length in network byte order followed by
+that many bytes of payload.  The payload is anything which could be sent as a UDP datagram: a binary pose record
+(see UWPoseRecord.h), a text pose packet, or a dataref stream packet (see UWDataRefStreamProtocol.h).
+
+The decoder works incrementally on a fixed buffer, so partial reads are handled without allocating.  Received
+bytes are written into the space returned by UWFrameWriteSpace and committed, then complete frames are taken out
+with UWFrameNext.
+
+This header does not depend on the X-Plane SDK so the external simulation can use UWFrameEncodeHeader.
+*/
+
+#ifndef _UWFrameDecoder_h_
+#define _UWFrameDecoder_h_
+
+#include "UWPacketSize.h"
+
+#define UW_FRAME_HEADER_SIZE		4
+#define UW_FRAME_MAX_PAYLOAD		UW_MAX_PACKET_SIZE	//see UWPacketSize.h
+#define UW_FRAME_BUFFER_SIZE		(8 * (UW_FRAME_HEADER_SIZE + UW_FRAME_MAX_PAYLOAD))
+
+#define UW_FRAME_INCOMPLETE			-1				//returned by UWFrameNext when no complete frame is buffered
+#define UW_FRAME_BAD				-2				//returned by UWFrameNext when the length is out of range
+
+struct UWFrameDecoder {
+	int		begin;									//first byte which has not been taken out
+	int		end;									//one past the last byte received
+	char	buffer[UW_FRAME_BUFFER_SIZE];
+};
+
+
+
+void	UWFrameInit(UWFrameDecoder * decoder);
+
+char *	UWFrameWriteSpace(UWFrameDecoder * decoder, int * outSpace);
+
+void	UWFrameCommit(UWFrameDecoder * decoder, int numBytes);
+
+int		UWFrameNext(UWFrameDecoder * decoder, const char ** outPayload);
+
+bool	UWFrameHasNext(const UWFrameDecoder * decoder);
+
+bool	UWFrameHasLater(const UWFrameDecoder * decoder, const char * magic);
+
+void	UWFrameEncodeHeader(char * buffer, int payloadLength);
+
+#endif
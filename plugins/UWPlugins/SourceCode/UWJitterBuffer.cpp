@@ -0,0 +1,163 @@
+/*
+UWJitterBuffer.cpp
+
+See UWJitterBuffer.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "UWJitterBuffer.h"
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Ring index of the i'th oldest pose
+*/
+static int Slot(const UWJitterBuffer * buffer, int i)
+{
+	return (buffer->head + i) % UW_JITTER_CAPACITY;
+}
+
+
+
+void UWJitterInit(UWJitterBuffer * buffer, double staleAfter)
+{
+	buffer->head		= 0;
+	buffer->count		= 0;
+	buffer->staleAfter	= staleAfter;
+	UWJitterResetStats(buffer);
+}
+
+
+
+/*
+Add a pose, keeping the buffer ordered by time stamp.  When the buffer is full the oldest pose is dropped, and a
+pose older than everything in a full buffer (or a duplicate) is not kept.  receiveTime is kept with the pose and
+handed back by UWJitterSelect.
+*/
+void UWJitterPush(UWJitterBuffer * buffer, const UWPoseRecord * pose, double receiveTime)
+{
+	//find where the pose goes (almost always at the end)
+	int position = buffer->count;
+	while(position > 0 && buffer->poses[Slot(buffer, position - 1)].timestamp > pose->timestamp) {
+		position--;
+	}
+
+	if(position > 0) {
+		const UWPoseRecord * previous = &buffer->poses[Slot(buffer, position - 1)];
+		if(previous->timestamp == pose->timestamp && previous->sequence == pose->sequence) {
+			buffer->stats.dropped++;
+			return;
+		}
+	}
+
+	if(buffer->count == UW_JITTER_CAPACITY) {
+		if(position == 0) {
+			buffer->stats.dropped++;
+			return;
+		}
+		buffer->head = Slot(buffer, 1);
+		buffer->count--;
+		position--;
+	}
+
+	//make room by moving the newer poses up one slot
+	for(int i = buffer->count; i > position; i--) {
+		buffer->poses[Slot(buffer, i)]			= buffer->poses[Slot(buffer, i - 1)];
+		buffer->receiveTimes[Slot(buffer, i)]	= buffer->receiveTimes[Slot(buffer, i - 1)];
+	}
+	buffer->poses[Slot(buffer, position)]			= *pose;
+	buffer->receiveTimes[Slot(buffer, position)]	= receiveTime;
+	buffer->count++;
+}
+
+
+
+/*
+Return the newest pose whose time stamp is not after targetTime (or the oldest pose if they are all newer).
+Poses older than the one returned are discarded.  Returns NULL if the buffer is empty.  The time the pose was
+received is written to outReceiveTime (if not NULL).
+*/
+const UWPoseRecord * UWJitterSelect(UWJitterBuffer * buffer, double targetTime, double * outReceiveTime)
+{
+	if(buffer->count == 0) {
+		return NULL;
+	}
+
+	int selected = buffer->count - 1;
+	while(selected >= 0 && buffer->poses[Slot(buffer, selected)].timestamp > targetTime) {
+		selected--;
+	}
+
+	if(selected < 0) {
+		buffer->stats.underflows++;
+		selected = 0;
+	}
+
+	const UWPoseRecord * pose = &buffer->poses[Slot(buffer, selected)];
+	double skew = pose->timestamp - targetTime;
+	if(selected == buffer->count - 1 && -skew > buffer->staleAfter) {
+		buffer->stats.stale++;
+	}
+
+	UWJitterStats * stats = &buffer->stats;
+	if(stats->selections == 0 || skew < stats->minSkew) {
+		stats->minSkew = skew;
+	}
+	if(stats->selections == 0 || skew > stats->maxSkew) {
+		stats->maxSkew = skew;
+	}
+	stats->sumSkew			+= skew;
+	stats->sumSkewSquared	+= skew * skew;
+	stats->selections++;
+
+	//the selected pose becomes the oldest one kept
+	buffer->head	= Slot(buffer, selected);
+	buffer->count	-= selected;
+	if(outReceiveTime != NULL) {
+		*outReceiveTime = buffer->receiveTimes[buffer->head];
+	}
+	return pose;
+}
+
+
+
+int UWJitterDepth(const UWJitterBuffer * buffer)
+{
+	return buffer->count;
+}
+
+
+
+void UWJitterResetStats(UWJitterBuffer * buffer)
+{
+	memset(&buffer->stats, 0, sizeof(UWJitterStats));
+}
+
+
+
+/*
+Write the statistics since the last reset as one line of text (into at least UW_JITTER_STATS_LENGTH characters)
+
+	UWSKEW <node> frames <n> mean_ms <x> std_ms <x> min_ms <x> max_ms <x> underflows <n> stale <n> dropped <n> depth <n>
+
+Returns the length of the line.
+*/
+int UWJitterFormatStats(const UWJitterBuffer * buffer, const char * nodeName, char * outText)
+{
+	const UWJitterStats * stats = &buffer->stats;
+
+	double mean		= 0.0;
+	double variance	= 0.0;
+	if(stats->selections > 0) {
+		mean		= stats->sumSkew / stats->selections;
+		variance	= stats->sumSkewSquared / stats->selections - mean * mean;
+	}
+
+	return sprintf(outText, "UWSKEW %.*s frames %lld mean_ms %.3f std_ms %.3f min_ms %.3f max_ms %.3f underflows %lld stale %lld dropped %lld depth %d\n",
+				   UW_JITTER_NAME_LENGTH, nodeName, stats->selections, mean * 1000.0, sqrt(variance > 0.0 ? variance : 0.0) * 1000.0,
+				   stats->minSkew * 1000.0, stats->maxSkew * 1000.0, stats->underflows, stats->stale, stats->dropped, buffer->count);
+}
@@ -0,0 +1,61 @@
+/*
+UWJitterBuffer.h
+
+A short, time-ordered history of received poses for the epoch apply mode.  Instead of applying whichever packet
+arrived last, every render node asks the buffer for the pose at the same target display time (the shared clock
+time minus a fixed delay), so nodes which receive the same stream show the same pose on the same frame and the
+seams between projectors line up.
+
+UWJitterSelect returns the newest pose whose time stamp is not after the target time.  Each call also records the
+skew (selected time stamp minus target time) so the node can report how well it is keeping up:
+
+	underflow	every buffered pose is newer than the target (the delay is too short for the network)
+	stale		the newest pose is older than the target by more than staleAfter (the sender is late or stopped)
+
+The buffer is a fixed ring, so nothing is allocated while running.
+*/
+
+#ifndef _UWJitterBuffer_h_
+#define _UWJitterBuffer_h_
+
+#include "UWPoseRecord.h"
+
+#define UW_JITTER_CAPACITY		64				//poses kept (about a second at 60 Hz)
+#define UW_JITTER_STATS_LENGTH	256				//see UWJitterFormatStats
+#define UW_JITTER_NAME_LENGTH	32				//longest node name printed by UWJitterFormatStats
+
+struct UWJitterStats {
+	long long		selections;					//calls to UWJitterSelect which returned a pose
+	long long		underflows;
+	long long		stale;
+	long long		dropped;					//poses which arrived too late or out of range to be kept
+	double			sumSkew;					//seconds, for the mean
+	double			sumSkewSquared;				//for the standard deviation
+	double			minSkew;
+	double			maxSkew;
+};
+
+struct UWJitterBuffer {
+	int				head;						//index of the oldest pose
+	int				count;
+	UWPoseRecord	poses[UW_JITTER_CAPACITY];	//ordered by time stamp from head
+	double			receiveTimes[UW_JITTER_CAPACITY];	//when each pose was received (the caller's clock)
+	double			staleAfter;					//seconds
+	UWJitterStats	stats;
+};
+
+
+
+void					UWJitterInit(UWJitterBuffer * buffer, double staleAfter);
+
+void					UWJitterPush(UWJitterBuffer * buffer, const UWPoseRecord * pose, double receiveTime);
+
+const UWPoseRecord *	UWJitterSelect(UWJitterBuffer * buffer, double targetTime, double * outReceiveTime);
+
+int						UWJitterDepth(const UWJitterBuffer * buffer);
+
+void					UWJitterResetStats(UWJitterBuffer * buffer);
+
+int						UWJitterFormatStats(const UWJitterBuffer * buffer, const char * nodeName, char * outText);
+
+#endif
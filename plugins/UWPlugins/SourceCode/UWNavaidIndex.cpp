@@ -0,0 +1,415 @@
+/*
+UWNavaidIndex.cpp
+
+See UWNavaidIndex.h
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "XPLMUtilities.h"
+
+#include "UWClock.h"
+#include "UWNavaidIndex.h"
+
+#define DEGREES_TO_RADIANS		0.017453292519943295
+#define FIRST_READ_CAPACITY		4096			//navaids, doubled as needed while reading
+#define READS_PER_CLOCK			64				//navaids read between looks at the clock
+#define LAST_TYPE_BIT			xplm_Nav_DME
+
+//the navaid_types names and the types they stand for
+static const char *	sTypeNames[]	= { "airport", "ndb", "vor", "ils", "localizer", "glideslope", "marker", "fix",
+										"dme" };
+static const int	sTypeFlags[]	= { xplm_Nav_Airport, xplm_Nav_NDB, xplm_Nav_VOR, xplm_Nav_ILS, xplm_Nav_Localizer,
+										xplm_Nav_GlideSlope,
+										xplm_Nav_OuterMarker | xplm_Nav_MiddleMarker | xplm_Nav_InnerMarker,
+										xplm_Nav_Fix, xplm_Nav_DME };
+#define NUM_TYPE_NAMES			(int)(sizeof(sTypeFlags) / sizeof(sTypeFlags[0]))
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWNavaidReadSettings(UWNavaidIndex * index, const UWPluginConfig * config)
+{
+	index->range	= UWConfigGetDouble(config, "navaid_range", 25.0);
+	index->budget	= UWConfigGetDouble(config, "navaid_build_budget", 1.0) / 1000.0;
+
+	char types[UW_CONFIG_VALUE_LENGTH];
+	strncpy(types, UWConfigGetString(config, "navaid_types", "ndb,vor,ils,localizer,dme,fix"), sizeof(types) - 1);
+	types[sizeof(types) - 1] = '\0';
+
+	index->types = 0;
+	for(char * name = strtok(types, ","); name != NULL; name = strtok(NULL, ",")) {
+		for(int i = 0; i < NUM_TYPE_NAMES; i++) {
+			if(strcmp(name, sTypeNames[i]) == 0) {
+				index->types |= sTypeFlags[i];
+			}
+		}
+	}
+
+	index->read			= NULL;
+	index->readCells	= NULL;
+	index->numRead		= 0;
+	index->readCapacity	= 0;
+	index->navaids		= NULL;
+	index->numNavaids	= 0;
+	index->cellStart	= NULL;
+	index->buildSeconds	= 0.0;
+	index->buildSteps	= 0;
+	index->numHits		= 0;
+	index->numInRange	= 0;
+	index->querySeconds	= 0.0;
+
+	index->latitudeRef	= XPLMFindDataRef("sim/flightmodel/position/latitude");
+	index->longitudeRef	= XPLMFindDataRef("sim/flightmodel/position/longitude");
+
+	//the first build step starts reading the database
+	index->state	= (UWConfigGetInt(config, "navaid_index", 1) != 0 && index->types != 0) ? uwNavaid_Reading
+																						: uwNavaid_Off;
+	index->typeBit	= 0;
+	index->next		= XPLM_NAV_NOT_FOUND;
+	index->last		= XPLM_NAV_NOT_FOUND;
+
+	//the navaids are counted per cell as they are read, so sorting them takes a single pass
+	if(index->state == uwNavaid_Reading) {
+		index->cellStart = new int[UW_NAVAID_ROWS*UW_NAVAID_COLUMNS + 1];
+		memset(index->cellStart, 0, (UW_NAVAID_ROWS*UW_NAVAID_COLUMNS + 1) * sizeof(int));
+	}
+}
+
+
+
+void UWNavaidStop(UWNavaidIndex * index)
+{
+	delete [] index->read;
+	delete [] index->readCells;
+	delete [] index->navaids;
+	delete [] index->cellStart;
+	index->read			= NULL;
+	index->readCells	= NULL;
+	index->navaids		= NULL;
+	index->cellStart	= NULL;
+	index->numNavaids	= 0;
+	index->state		= uwNavaid_Off;
+}
+
+
+
+static int CellOf(float latitude, float longitude)
+{
+	int row		= (int)floor(latitude + 90.0f);
+	int column	= (int)floor(longitude + 180.0f);
+	row		= (row < 0) ? 0 : (row >= UW_NAVAID_ROWS) ? UW_NAVAID_ROWS - 1 : row;
+	column	= (column < 0) ? 0 : (column >= UW_NAVAID_COLUMNS) ? UW_NAVAID_COLUMNS - 1 : column;
+	return row*UW_NAVAID_COLUMNS + column;
+}
+
+
+
+/*
+Move on to the next wanted type which has navaids.  Returns false when every type has been read.
+*/
+static bool NextType(UWNavaidIndex * index)
+{
+	while(true) {
+		index->typeBit = (index->typeBit == 0) ? 1 : index->typeBit << 1;
+		if(index->typeBit > LAST_TYPE_BIT) {
+			return false;
+		}
+		if(index->types & index->typeBit) {
+			index->next = XPLMFindFirstNavAidOfType((XPLMNavType)index->typeBit);
+			index->last = XPLMFindLastNavAidOfType((XPLMNavType)index->typeBit);
+			if(index->next != XPLM_NAV_NOT_FOUND) {
+				return true;
+			}
+		}
+	}
+}
+
+
+
+static void Append(UWNavaidIndex * index, const UWNavaid * navaid)
+{
+	if(index->numRead == index->readCapacity) {
+		int capacity = (index->readCapacity > 0) ? 2*index->readCapacity : FIRST_READ_CAPACITY;
+		UWNavaid * read = new UWNavaid[capacity];
+		int * readCells = new int[capacity];
+		if(index->numRead > 0) {
+			memcpy(read, index->read, index->numRead * sizeof(UWNavaid));
+			memcpy(readCells, index->readCells, index->numRead * sizeof(int));
+		}
+		delete [] index->read;
+		delete [] index->readCells;
+		index->read			= read;
+		index->readCells	= readCells;
+		index->readCapacity	= capacity;
+	}
+
+	int cell = CellOf(navaid->latitude, navaid->longitude);
+	index->cellStart[cell + 1]++;
+	index->readCells[index->numRead] = cell;
+	index->read[index->numRead++] = *navaid;
+}
+
+
+
+/*
+Sort the navaids read into their cells (a counting sort, the navaids were counted per cell as they were read)
+*/
+static void Finish(UWNavaidIndex * index)
+{
+	int numCells = UW_NAVAID_ROWS * UW_NAVAID_COLUMNS;
+	index->navaids		= new UWNavaid[(index->numRead > 0) ? index->numRead : 1];
+	index->numNavaids	= index->numRead;
+
+	for(int cell = 0; cell < numCells; cell++) {
+		index->cellStart[cell + 1] += index->cellStart[cell];
+	}
+
+	//place every navaid at the end of its cell so far, then shift the starts back
+	for(int i = 0; i < index->numRead; i++) {
+		index->navaids[index->cellStart[index->readCells[i]]++] = index->read[i];
+	}
+	for(int cell = numCells; cell > 0; cell--) {
+		index->cellStart[cell] = index->cellStart[cell - 1];
+	}
+	index->cellStart[0] = 0;
+
+	delete [] index->read;
+	delete [] index->readCells;
+	index->read			= NULL;
+	index->readCells	= NULL;
+	index->readCapacity	= 0;
+	index->state		= uwNavaid_Ready;
+}
+
+
+
+/*
+Read the navaid database for at most navaid_build_budget milliseconds.  Called every frame until it returns true,
+once the index is built (or if it is not wanted).
+*/
+bool UWNavaidBuildStep(UWNavaidIndex * index)
+{
+	if(index->state != uwNavaid_Reading && index->state != uwNavaid_Sorting) {
+		return true;
+	}
+
+	double start = UWClockMonotonicSeconds();
+	index->buildSteps++;
+
+	//sorting gets a step of its own, so it does not add to a step spent reading
+	if(index->state == uwNavaid_Sorting) {
+		Finish(index);
+		index->buildSeconds += UWClockMonotonicSeconds() - start;
+		return true;
+	}
+
+	if(index->next == XPLM_NAV_NOT_FOUND && !NextType(index)) {
+		index->state = uwNavaid_Sorting;
+	}
+
+	for(int count = 1; index->state == uwNavaid_Reading; count++) {
+		UWNavaid navaid;
+		XPLMNavType type;
+		char id[32];
+		XPLMGetNavAidInfo(index->next, &type, &navaid.latitude, &navaid.longitude, NULL, &navaid.frequency, NULL, id,
+						  NULL, NULL);
+		navaid.type = type;
+		strncpy(navaid.id, id, UW_NAVAID_ID_LENGTH - 1);
+		navaid.id[UW_NAVAID_ID_LENGTH - 1] = '\0';
+		Append(index, &navaid);
+
+		//the navaids of a type are next to each other, from the first to the last
+		bool lastOfType = (index->next == index->last);
+		index->next = lastOfType ? XPLM_NAV_NOT_FOUND : XPLMGetNextNavAid(index->next);
+		if(index->next == XPLM_NAV_NOT_FOUND && !NextType(index)) {
+			index->state = uwNavaid_Sorting;
+		}
+
+		if(count % READS_PER_CLOCK == 0 && UWClockMonotonicSeconds() - start > index->budget) {
+			break;
+		}
+	}
+
+	index->buildSeconds += UWClockMonotonicSeconds() - start;
+	return false;
+}
+
+
+
+/*
+Write into outHits the (up to maxHits) navaids nearest the position within range nautical miles, nearest first.
+outInRange (which may be NULL) gets how many navaids are within range.  Returns the number of hits.
+*/
+int UWNavaidQuery(const UWNavaidIndex * index, double latitude, double longitude, double range,
+				  UWNavaidHit * outHits, int maxHits, int * outInRange)
+{
+	int numHits = 0;
+	int inRange = 0;
+
+	if(index->state == uwNavaid_Ready) {
+		double cosLatitude = cos(latitude * DEGREES_TO_RADIANS);
+		double rangeDegrees = range / 60.0;
+		int firstRow	= (int)floor(latitude - rangeDegrees + 90.0);
+		int lastRow		= (int)floor(latitude + rangeDegrees + 90.0);
+		firstRow	= (firstRow < 0) ? 0 : firstRow;
+		lastRow		= (lastRow >= UW_NAVAID_ROWS) ? UW_NAVAID_ROWS - 1 : lastRow;
+
+		//the columns wrap around at the antimeridian (and near the poles every column is in range)
+		int firstColumn = 0;
+		int numColumns = UW_NAVAID_COLUMNS;
+		if(cosLatitude > rangeDegrees / 90.0) {
+			double columnDegrees = rangeDegrees / cosLatitude;
+			firstColumn	= (int)floor(longitude - columnDegrees + 180.0);
+			numColumns	= (int)floor(longitude + columnDegrees + 180.0) - firstColumn + 1;
+			if(numColumns > UW_NAVAID_COLUMNS) {
+				numColumns = UW_NAVAID_COLUMNS;
+			}
+		}
+
+		for(int row = firstRow; row <= lastRow; row++) {
+			for(int c = 0; c < numColumns; c++) {
+				int column = ((firstColumn + c) % UW_NAVAID_COLUMNS + UW_NAVAID_COLUMNS) % UW_NAVAID_COLUMNS;
+				int cell = row*UW_NAVAID_COLUMNS + column;
+
+				for(int i = index->cellStart[cell]; i < index->cellStart[cell + 1]; i++) {
+					const UWNavaid * navaid = &index->navaids[i];
+					double deltaLongitude = navaid->longitude - longitude;
+					if(deltaLongitude > 180.0) {
+						deltaLongitude -= 360.0;
+					} else if(deltaLongitude < -180.0) {
+						deltaLongitude += 360.0;
+					}
+					double east		= 60.0 * deltaLongitude * cosLatitude;
+					double north	= 60.0 * (navaid->latitude - latitude);
+					double distance = sqrt(east*east + north*north);
+					if(distance > range) {
+						continue;
+					}
+					inRange++;
+
+					//keep the nearest maxHits, nearest first
+					if(numHits == maxHits && (maxHits == 0 || distance >= outHits[numHits - 1].distance)) {
+						continue;
+					}
+					int at = (numHits < maxHits) ? numHits++ : numHits - 1;
+					while(at > 0 && outHits[at - 1].distance > distance) {
+						outHits[at] = outHits[at - 1];
+						at--;
+					}
+					double bearing = atan2(east, north) / DEGREES_TO_RADIANS;
+					outHits[at].navaid		= i;
+					outHits[at].distance	= (float)distance;
+					outHits[at].bearing		= (float)((bearing < 0.0) ? bearing + 360.0 : bearing);
+				}
+			}
+		}
+	}
+
+	if(outInRange != NULL) {
+		*outInRange = inRange;
+	}
+	return numHits;
+}
+
+
+
+/*
+Find the navaids nearest the streamed position for the overlay (see UWNavaidDescribe and UWNavaidDescribeHit)
+*/
+void UWNavaidQueryOverlay(UWNavaidIndex * index)
+{
+	if(index->state != uwNavaid_Ready || index->latitudeRef == NULL || index->longitudeRef == NULL) {
+		index->numHits = 0;
+		return;
+	}
+
+	double start = UWClockMonotonicSeconds();
+	index->numHits = UWNavaidQuery(index, XPLMGetDatad(index->latitudeRef), XPLMGetDatad(index->longitudeRef),
+								   index->range, index->hits, UW_NAVAID_OVERLAY_HITS, &index->numInRange);
+	index->querySeconds = UWClockMonotonicSeconds() - start;
+}
+
+
+
+/*
+One line for the overlay, e.g. "Navaids within 25 nm: 14 (found in 3 us, 31250 indexed in 42 ms)".  outText must
+hold UW_NAVAID_DESCRIPTION_LENGTH characters.
+*/
+void UWNavaidDescribe(const UWNavaidIndex * index, char * outText)
+{
+	if(index->state == uwNavaid_Off) {
+		strcpy(outText, "Navaids: not indexed");
+	} else if(index->state != uwNavaid_Ready) {
+		sprintf(outText, "Navaids: indexing (%d read)", index->numRead);
+	} else {
+		sprintf(outText, "Navaids within %.0f nm: %d (found in %.0f us, %d indexed in %.0f ms)", index->range,
+				index->numInRange, 1e6*index->querySeconds, index->numNavaids, 1000.0*index->buildSeconds);
+	}
+}
+
+
+
+static const char * TypeName(int type)
+{
+	for(int i = 0; i < NUM_TYPE_NAMES; i++) {
+		if(type & sTypeFlags[i]) {
+			return sTypeNames[i];
+		}
+	}
+	return "navaid";
+}
+
+
+
+/*
+One line for the overlay per hit of the last UWNavaidQueryOverlay, nearest first, e.g. "  vor   INN    112.50
+4.2 nm 123"; empty if there is no such hit.  outText must hold UW_NAVAID_DESCRIPTION_LENGTH characters.
+*/
+void UWNavaidDescribeHit(const UWNavaidIndex * index, int hit, char * outText)
+{
+	if(hit >= index->numHits) {
+		outText[0] = '\0';
+		return;
+	}
+
+	const UWNavaid * navaid = &index->navaids[index->hits[hit].navaid];
+	char frequency[16] = "";
+	if(navaid->type & xplm_Nav_NDB) {
+		sprintf(frequency, "%d", navaid->frequency);
+	} else if(navaid->frequency > 0) {
+		sprintf(frequency, "%.2f", navaid->frequency / 100.0);
+	}
+	sprintf(outText, "  %-10s %-7s %7s %6.1f nm %03.0f", TypeName(navaid->type), navaid->id, frequency,
+			index->hits[hit].distance, index->hits[hit].bearing);
+}
+
+
+
+/*
+One line for the overlay with the FMS leg being flown, e.g. "FMS leg 3 of 7 to INN at 5000 ft"
+*/
+void UWNavaidDescribeLeg(char * outText)
+{
+	int count = XPLMCountFMSEntries();
+	if(count <= 0) {
+		strcpy(outText, "FMS: no flight plan");
+		return;
+	}
+
+	int destination = XPLMGetDestinationFMSEntry();
+	char id[256] = "";
+	int altitude = 0;
+	float latitude = 0.0f, longitude = 0.0f;
+	XPLMGetFMSEntryInfo(destination, NULL, id, NULL, &altitude, &latitude, &longitude);
+	id[UW_NAVAID_DESCRIPTION_LENGTH / 2] = '\0';		//keeps the line within UW_NAVAID_DESCRIPTION_LENGTH
+
+	if(id[0] != '\0') {
+		sprintf(outText, "FMS leg %d of %d to %s at %d ft", destination + 1, count, id, altitude);
+	} else {
+		sprintf(outText, "FMS leg %d of %d to %.4f %.4f at %d ft", destination + 1, count, latitude, longitude,
+				altitude);
+	}
+}
@@ -0,0 +1,108 @@
+/*
+UWNavaidIndex.h
+
+Finds the navaids near the streamed position in microseconds, for the overlay (e.g. to check the trajectory
+against the navaids and the FMS legs it was flown along in a mission debrief).
+
+Walking X-Plane's navaid database with XPLMGetNextNavAid and XPLMGetNavAidInfo takes far too long to do per query,
+so the navaids of the types wanted are copied once, after the plugin starts, into an index: cells of one degree of
+latitude by one degree of longitude, with the navaids of every cell stored next to each other, so a query only
+looks at the navaids of the few cells within range.  The XPLM may only be called from X-Plane's main thread, so
+the database is not read on a thread of its own; instead UWNavaidBuildStep reads it in slices of at most
+navaid_build_budget milliseconds, from a flight loop which runs every frame until the index is built, so the sim
+never stalls while it is built.  The database is read a navaid type at a time (XPLMFindFirstNavAidOfType to
+XPLMFindLastNavAidOfType), so the types which are not wanted are skipped without being read.
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	navaid_index			1 to build the index, 0 not to (default 1)
+	navaid_types			the types to index, separated by commas, from airport, ndb, vor, ils, localizer,
+							glideslope, marker, fix and dme (default ndb,vor,ils,localizer,dme,fix)
+	navaid_range			nautical miles from the streamed position to the navaids shown (default 25)
+	navaid_build_budget		milliseconds per frame spent building the index (default 1)
+*/
+
+#ifndef _UWNavaidIndex_h_
+#define _UWNavaidIndex_h_
+
+#include "XPLMDataAccess.h"
+#include "XPLMNavigation.h"
+
+#include "UWPluginConfig.h"
+
+#define UW_NAVAID_ID_LENGTH				8
+#define UW_NAVAID_ROWS					180			//one degree cells
+#define UW_NAVAID_COLUMNS				360
+#define UW_NAVAID_OVERLAY_HITS			5			//nearest navaids shown on the overlay
+#define UW_NAVAID_DESCRIPTION_LENGTH	80			//see UWNavaidDescribe
+
+enum UWNavaidBuildState {
+	uwNavaid_Off,									//navaid_index is 0
+	uwNavaid_Reading,								//the database is being read
+	uwNavaid_Sorting,								//every navaid has been read, the next step sorts them
+	uwNavaid_Ready
+};
+
+struct UWNavaid {
+	float			latitude;
+	float			longitude;
+	int				type;							//XPLMNavType
+	int				frequency;						//as XPLMGetNavAidInfo returns it
+	char			id[UW_NAVAID_ID_LENGTH];
+};
+
+struct UWNavaidHit {
+	int				navaid;							//index in UWNavaidIndex::navaids
+	float			distance;						//nautical miles
+	float			bearing;						//degrees true
+};
+
+struct UWNavaidIndex {
+	int				types;							//XPLMNavType flags
+	double			range;							//nautical miles
+	double			budget;							//seconds per build step
+
+	UWNavaidBuildState	state;
+	int				typeBit;						//type being read
+	XPLMNavRef		next;							//next navaid to read
+	XPLMNavRef		last;							//last navaid of the type
+	UWNavaid *		read;							//navaids read so far (grows while reading)
+	int *			readCells;						//cell of every navaid read
+	int				numRead;
+	int				readCapacity;
+	double			buildSeconds;					//spent reading and sorting
+	int				buildSteps;
+
+	UWNavaid *		navaids;						//sorted by cell, once built
+	int				numNavaids;
+	int *			cellStart;						//first navaid of every cell, and numNavaids at the end (while
+													//reading, the navaids read in the cell before)
+
+	XPLMDataRef		latitudeRef;					//the streamed position
+	XPLMDataRef		longitudeRef;
+	UWNavaidHit		hits[UW_NAVAID_OVERLAY_HITS];	//last overlay query
+	int				numHits;
+	int				numInRange;
+	double			querySeconds;
+};
+
+
+
+void		UWNavaidReadSettings(UWNavaidIndex * index, const UWPluginConfig * config);
+
+bool		UWNavaidBuildStep(UWNavaidIndex * index);
+
+void		UWNavaidStop(UWNavaidIndex * index);
+
+int			UWNavaidQuery(const UWNavaidIndex * index, double latitude, double longitude, double range,
+						  UWNavaidHit * outHits, int maxHits, int * outInRange);
+
+void		UWNavaidQueryOverlay(UWNavaidIndex * index);
+
+void		UWNavaidDescribe(const UWNavaidIndex * index, char * outText);
+
+void		UWNavaidDescribeHit(const UWNavaidIndex * index, int hit, char * outText);
+
+void		UWNavaidDescribeLeg(char * outText);
+
+#endif
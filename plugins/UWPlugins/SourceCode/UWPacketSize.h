@@ -0,0 +1,16 @@
+/*
+UWPacketSize.h
+
+The largest packet any transport carries: a UDP or Unix datagram, the payload of a TCP frame (see UWFrameDecoder.h)
+or a dataref stream packet (see UWDataRefStreamProtocol.h).  The receive buffers, the frame decoder and the
+readback buffer are all sized from it, so a packet the protocol allows is never cut short on the way in or out.
+
+This header does not depend on the X-Plane SDK and is plain C, so it can be included by the external simulation.
+*/
+
+#ifndef _UWPacketSize_h_
+#define _UWPacketSize_h_
+
+#define UW_MAX_PACKET_SIZE		8192		//bytes
+
+#endif
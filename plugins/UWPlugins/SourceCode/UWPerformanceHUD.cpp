@@ -0,0 +1,285 @@
+/*
+UWPerformanceHUD.cpp
+
+See UWPerformanceHUD.h
+*/
+
+#if IBM
+#include <windows.h>
+#endif
+#if APL
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+#include <string.h>
+#include "XPLMGraphics.h"
+
+#include "UWPerformanceHUD.h"
+
+#define UW_HUD_RESYNC_GAP		1000		//a sequence number this far behind the expected one means the sender restarted
+#define UW_HUD_TEXT_WIDTH		230			//pixels left of the graphs for the text
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWHudInit(UWPerformanceHUD * hud)
+{
+	memset(hud, 0, sizeof(UWPerformanceHUD));
+	hud->newest = UW_HUD_SAMPLES - 1;
+}
+
+
+
+/*
+A pose was received.  sequence is only looked at if sequenced: a sequence number beyond the next one expected
+counts the skipped ones as lost, and one before it counts as reordered (a pose counted as lost which arrives late
+is counted as reordered but still as lost, since the sender cannot tell the difference either).
+*/
+void UWHudReceived(UWPerformanceHUD * hud, bool sequenced, unsigned int sequence)
+{
+	hud->received++;
+	if(!sequenced) {
+		return;
+	}
+
+	hud->sequenced++;
+	int gap = (int)(sequence - hud->nextSequence);
+	if(!hud->haveSequence || gap < -UW_HUD_RESYNC_GAP) {
+		hud->haveSequence = true;
+	} else if(gap < 0) {
+		hud->reordered++;
+		return;
+	} else {
+		hud->lost += gap;
+	}
+	hud->nextSequence = sequence + 1;
+}
+
+
+
+/*
+A pose was set to the datarefs latency seconds after the sender's time stamp
+*/
+void UWHudApplied(UWPerformanceHUD * hud, double latency)
+{
+	int bucket = (latency > 0.0) ? (int)(latency / UW_HUD_LATENCY_BUCKET) : 0;
+	if(bucket >= UW_HUD_LATENCY_BUCKETS) {
+		bucket = UW_HUD_LATENCY_BUCKETS - 1;
+	}
+	hud->latencies[bucket]++;
+	hud->numLatencies++;
+}
+
+
+
+void UWHudFlightLoop(UWPerformanceHUD * hud, double seconds)
+{
+	hud->flightLoopSum += seconds;
+	if(seconds > hud->flightLoopMax) {
+		hud->flightLoopMax = seconds;
+	}
+	hud->flightLoops++;
+}
+
+
+
+/*
+The jitter buffer held depth poses, and the pose shown is extrapolation seconds older than the target display time
+*/
+void UWHudBuffer(UWPerformanceHUD * hud, int depth, double extrapolation)
+{
+	hud->bufferSum			+= depth;
+	hud->extrapolationSum	+= extrapolation;
+	hud->buffers++;
+}
+
+
+
+/*
+The latency below which fraction of the poses applied since the last sample were (the upper edge of the bucket)
+*/
+static double LatencyPercentile(const UWPerformanceHUD * hud, double fraction)
+{
+	int rank	= (int)(fraction * hud->numLatencies);
+	int count	= 0;
+	for(int i = 0; i < UW_HUD_LATENCY_BUCKETS; i++) {
+		count += hud->latencies[i];
+		if(count > rank) {
+			return (i + 1) * UW_HUD_LATENCY_BUCKET;
+		}
+	}
+	return UW_HUD_LATENCY_BUCKETS * UW_HUD_LATENCY_BUCKET;
+}
+
+
+
+static void AddSample(UWPerformanceHUD * hud, int graph, bool valid, double value)
+{
+	hud->samples[graph][hud->newest]	= valid ? (float)value : 0.0f;
+	hud->valid[graph][hud->newest]		= valid;
+
+	//the largest of the samples shown (a sample dropping out of the window may have been the largest)
+	float largest = 0.0f;
+	for(int i = 0; i < UW_HUD_SAMPLES; i++) {
+		if(hud->valid[graph][i] && hud->samples[graph][i] > largest) {
+			largest = hud->samples[graph][i];
+		}
+	}
+	hud->largest[graph] = largest;
+}
+
+
+
+/*
+Close the sample every UW_HUD_SAMPLE_INTERVAL seconds (now is UWClockMonotonicSeconds), called every flight loop
+whether or not the HUD is shown
+*/
+void UWHudStep(UWPerformanceHUD * hud, double now)
+{
+	if(hud->sampleStart == 0.0) {
+		hud->sampleStart = now;
+		return;
+	}
+
+	double interval = now - hud->sampleStart;
+	if(interval < UW_HUD_SAMPLE_INTERVAL) {
+		return;
+	}
+
+	bool haveLatency = hud->numLatencies > 0;
+	if(haveLatency) {
+		hud->latencyP50 = LatencyPercentile(hud, 0.50);
+		hud->latencyP95 = LatencyPercentile(hud, 0.95);
+		hud->latencyP99 = LatencyPercentile(hud, 0.99);
+	}
+	hud->flightLoopMean = (hud->flightLoops > 0) ? hud->flightLoopSum / hud->flightLoops : 0.0;
+
+	int sent = hud->sequenced + hud->lost - hud->reordered;
+	hud->newest = (hud->newest + 1) % UW_HUD_SAMPLES;
+	AddSample(hud, uwHud_Received,		true,						hud->received / interval);
+	AddSample(hud, uwHud_Lost,			sent > 0,					(sent > 0) ? 100.0 * hud->lost / sent : 0.0);
+	AddSample(hud, uwHud_Reordered,		hud->sequenced > 0,			(hud->sequenced > 0) ? 100.0 * hud->reordered / hud->sequenced : 0.0);
+	AddSample(hud, uwHud_Latency,		haveLatency,				1000.0 * hud->latencyP99);
+	AddSample(hud, uwHud_FlightLoop,	hud->flightLoops > 0,		1.0e6 * hud->flightLoopMax);
+	AddSample(hud, uwHud_Buffer,		hud->buffers > 0,			(hud->buffers > 0) ? hud->bufferSum / hud->buffers : 0.0);
+	AddSample(hud, uwHud_Extrapolation,	hud->buffers > 0,			(hud->buffers > 0) ? 1000.0 * hud->extrapolationSum / hud->buffers : 0.0);
+	if(hud->numSamples < UW_HUD_SAMPLES) {
+		hud->numSamples++;
+	}
+
+	//start the next sample (the expected sequence number carries over)
+	hud->sampleStart	= now;
+	hud->received		= 0;
+	hud->sequenced		= 0;
+	hud->lost			= 0;
+	hud->reordered		= 0;
+	memset(hud->latencies, 0, sizeof(hud->latencies));
+	hud->numLatencies	= 0;
+	hud->flightLoopSum	= 0.0;
+	hud->flightLoopMax	= 0.0;
+	hud->flightLoops	= 0;
+	hud->bufferSum			= 0.0;
+	hud->extrapolationSum	= 0.0;
+	hud->buffers			= 0;
+}
+
+
+
+/*
+Write the text of every graph to the overlay, on every UW_HUD_ROW_LINES lines from firstLine (called when the
+overlay is refreshed)
+*/
+void UWHudDescribe(const UWPerformanceHUD * hud, UWStatusOverlay * overlay, int firstLine)
+{
+	const int newest = hud->newest;
+	for(int graph = 0; graph < UW_HUD_GRAPHS; graph++) {
+		int		line	= firstLine + graph * UW_HUD_ROW_LINES;
+		bool	valid	= hud->numSamples > 0 && hud->valid[graph][newest];
+		double	value	= hud->samples[graph][newest];
+
+		switch(graph) {
+			case uwHud_Received:
+				UWOverlayPrintf(overlay, line, "Received %.0f poses/s", value);
+				break;
+			case uwHud_Lost:
+				UWOverlayPrintf(overlay, line, valid ? "Lost %.1f%%" : "Lost (no sequence numbers)", value);
+				break;
+			case uwHud_Reordered:
+				UWOverlayPrintf(overlay, line, valid ? "Reordered %.1f%%" : "Reordered (no sequence numbers)", value);
+				break;
+			case uwHud_Latency:
+				if(valid) {
+					UWOverlayPrintf(overlay, line, "Latency p50 %.2f p95 %.2f p99 %.2f ms", 1000.0 * hud->latencyP50,
+									1000.0 * hud->latencyP95, 1000.0 * hud->latencyP99);
+				} else {
+					UWOverlaySetText(overlay, line, "Latency (nothing applied)");
+				}
+				break;
+			case uwHud_FlightLoop:
+				UWOverlayPrintf(overlay, line, "Flight loop mean %.0f max %.0f us", 1.0e6 * hud->flightLoopMean, value);
+				break;
+			case uwHud_Buffer:
+				UWOverlayPrintf(overlay, line, valid ? "Jitter buffer %.1f poses" : "Jitter buffer (epoch mode only)",
+								value);
+				break;
+			case uwHud_Extrapolation:
+				UWOverlayPrintf(overlay, line, valid ? "Extrapolation %.1f ms" : "Extrapolation (epoch mode only)",
+								value);
+				break;
+		}
+	}
+}
+
+
+
+/*
+Draw the graphs right of the text written by UWHudDescribe (called from the window's draw callback after
+UWOverlayDraw).  Invalid samples break the line.
+*/
+void UWHudDraw(const UWPerformanceHUD * hud, XPLMWindowID window, int firstLine)
+{
+	int left, top, right, bottom;
+	XPLMGetWindowGeometry(window, &left, &top, &right, &bottom);
+
+	//untextured lines in window coordinates: no fog, textures, lighting or depth, but alpha blending
+	XPLMSetGraphicsState(0, 0, 0, 0, 1, 0, 0);
+
+	const int	graphLeft	= left + UW_HUD_TEXT_WIDTH;
+	const int	oldest		= (hud->newest + 1) % UW_HUD_SAMPLES;
+	for(int graph = 0; graph < UW_HUD_GRAPHS; graph++) {
+		int		line		= firstLine + graph * UW_HUD_ROW_LINES;
+		float	graphBottom	= (float)(top - (line + 1) * UW_OVERLAY_LINE_SPACING + 2);
+		float	scale		= (hud->largest[graph] > 0.0f) ? UW_HUD_GRAPH_HEIGHT / hud->largest[graph] : 0.0f;
+
+		//the baseline
+		glColor4f(0.5f, 0.5f, 0.5f, 0.5f);
+		glBegin(GL_LINES);
+		glVertex2f((float)graphLeft, graphBottom);
+		glVertex2f((float)(graphLeft + UW_HUD_GRAPH_WIDTH), graphBottom);
+		glEnd();
+
+		//the samples, oldest on the left
+		glColor4f(0.2f, 1.0f, 0.4f, 1.0f);
+		bool drawing = false;
+		for(int i = UW_HUD_SAMPLES - hud->numSamples; i < UW_HUD_SAMPLES; i++) {
+			int sample = (oldest + i) % UW_HUD_SAMPLES;
+			if(!hud->valid[graph][sample]) {
+				if(drawing) {
+					glEnd();
+					drawing = false;
+				}
+				continue;
+			}
+			if(!drawing) {
+				glBegin(GL_LINE_STRIP);
+				drawing = true;
+			}
+			glVertex2f((float)(graphLeft + i * UW_HUD_GRAPH_WIDTH / UW_HUD_SAMPLES),
+					   graphBottom + scale * hud->samples[graph][sample]);
+		}
+		if(drawing) {
+			glEnd();
+		}
+	}
+}
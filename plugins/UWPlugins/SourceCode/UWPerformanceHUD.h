@@ -0,0 +1,107 @@
+/*
+UWPerformanceHUD.h
+
+A live performance display for the timed processing plugins' status window: how many poses arrive, how many are
+lost or arrive out of order, how old they are when they are applied, what the flight loop costs, how deep the
+jitter buffer is and how far the display time runs ahead of the pose shown.
+
+The plugin reports what happens as it happens (UWHudReceived for every pose received, UWHudApplied for every pose
+applied, UWHudFlightLoop for every flight loop and UWHudBuffer for the jitter buffer in epoch mode, see
+UWEpochApply.h).  These only add to counters and to a latency histogram.  UWHudStep turns the counters into one
+sample of every graph each UW_HUD_SAMPLE_INTERVAL seconds and clears them, so the HUD costs next to nothing while it
+is hidden, and the graphs already hold the last minute when it is shown.
+
+	received		poses received per second
+	lost			sequence numbers skipped, as a share of the poses sent (only poses with sequence numbers: binary
+					records, or text packets whose schema has a sequence field)
+	reordered		poses older than one already received, as a share of the poses received
+	latency			percentiles of the sender clock when a pose is applied minus its time stamp (poses without a time
+					stamp are stamped when they are received, so for them this is the time from receive to apply)
+	flight loop		mean and worst time of the plugin's flight loop
+	buffer			mean depth of the jitter buffer (epoch mode only)
+	extrapolation	mean time from the time stamp of the pose shown to the target display time (epoch mode only),
+					i.e. how far the shown pose has to be carried forward
+
+UWHudDescribe writes one line of text per graph into the status overlay (see UWStatusOverlay.h), every other line,
+and UWHudDraw draws the graphs as sparklines beside them: one GL line strip per graph, scaled to the largest sample
+shown, drawn with XPLMSetGraphicsState and immediate mode OpenGL.
+*/
+
+#ifndef _UWPerformanceHUD_h_
+#define _UWPerformanceHUD_h_
+
+#include "XPLMDisplay.h"
+
+#include "UWStatusOverlay.h"
+
+#define UW_HUD_SAMPLES				120			//samples per graph (one minute)
+#define UW_HUD_SAMPLE_INTERVAL		0.5			//seconds per sample
+#define UW_HUD_LATENCY_BUCKETS		800			//latency histogram, the last bucket holds everything beyond
+#define UW_HUD_LATENCY_BUCKET		0.00025		//seconds per bucket (so 0 to 200 ms)
+#define UW_HUD_GRAPH_WIDTH			120			//pixels, one sample each
+#define UW_HUD_GRAPH_HEIGHT			16			//pixels
+#define UW_HUD_ROW_LINES			2			//status window lines per graph
+#define UW_HUD_LINES				(UW_HUD_GRAPHS * UW_HUD_ROW_LINES)
+
+enum UWHudGraphs {
+	uwHud_Received,
+	uwHud_Lost,
+	uwHud_Reordered,
+	uwHud_Latency,
+	uwHud_FlightLoop,
+	uwHud_Buffer,
+	uwHud_Extrapolation,
+	UW_HUD_GRAPHS
+};
+
+struct UWPerformanceHUD {
+	//since the last sample
+	double			sampleStart;				//UWClockMonotonicSeconds
+	int				received;
+	int				sequenced;					//received with a sequence number
+	int				lost;
+	int				reordered;
+	bool			haveSequence;				//nextSequence is known
+	unsigned int	nextSequence;
+	int				latencies[UW_HUD_LATENCY_BUCKETS];
+	int				numLatencies;
+	double			flightLoopSum;
+	double			flightLoopMax;
+	int				flightLoops;
+	double			bufferSum;
+	double			extrapolationSum;
+	int				buffers;
+
+	//the last sample
+	double			latencyP50;					//seconds
+	double			latencyP95;
+	double			latencyP99;
+	double			flightLoopMean;				//seconds
+
+	//the graphs, oldest sample first from newest + 1
+	float			samples[UW_HUD_GRAPHS][UW_HUD_SAMPLES];
+	bool			valid[UW_HUD_GRAPHS][UW_HUD_SAMPLES];	//false where there was nothing to measure
+	float			largest[UW_HUD_GRAPHS];					//largest valid sample, which the graph is scaled to
+	int				newest;
+	int				numSamples;
+};
+
+
+
+void		UWHudInit(UWPerformanceHUD * hud);
+
+void		UWHudReceived(UWPerformanceHUD * hud, bool sequenced, unsigned int sequence);
+
+void		UWHudApplied(UWPerformanceHUD * hud, double latency);
+
+void		UWHudFlightLoop(UWPerformanceHUD * hud, double seconds);
+
+void		UWHudBuffer(UWPerformanceHUD * hud, int depth, double extrapolation);
+
+void		UWHudStep(UWPerformanceHUD * hud, double now);
+
+void		UWHudDescribe(const UWPerformanceHUD * hud, UWStatusOverlay * overlay, int firstLine);
+
+void		UWHudDraw(const UWPerformanceHUD * hud, XPLMWindowID window, int firstLine);
+
+#endif
@@ -0,0 +1,90 @@
+/*
+UWPluginConfig.cpp
+
+See UWPluginConfig.h
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "XPLMUtilities.h"
+
+#include "UWPluginConfig.h"
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWConfigClear(UWPluginConfig * config)
+{
+	config->numEntries = 0;
+}
+
+
+
+/*
+Load the config from the specified file in the X-System folder.  Returns the number of entries that were loaded
+(0 if the file does not exist, in which case every lookup returns its default).
+*/
+int UWConfigLoad(UWPluginConfig * config, const char * fileName)
+{
+	UWConfigClear(config);
+
+	char	inputPath[512];
+	XPLMGetSystemPath(inputPath);
+	strncat(inputPath, fileName, sizeof(inputPath) - strlen(inputPath) - 1);
+
+	FILE * inputFile = fopen(inputPath, "r");
+	if(inputFile == NULL) {
+		return 0;
+	}
+
+	char line[512];
+	while(fgets(line, sizeof(line), inputFile) != NULL && config->numEntries < UW_CONFIG_MAX_ENTRIES) {
+		//strip comments
+		char * comment = strchr(line, '#');
+		if(comment != NULL) {
+			*comment = '\0';
+		}
+
+		UWConfigEntry * entry = &config->entries[config->numEntries];
+		if(sscanf(line, "%31s %255s", entry->key, entry->value) != 2) {
+			continue;		//blank line or badly formed line
+		}
+		config->numEntries++;
+	}
+
+	fclose(inputFile);
+
+	return config->numEntries;
+}
+
+
+
+/*
+Return the value of key (the last one wins if a key is repeated) or defaultValue if it is not in the config
+*/
+const char * UWConfigGetString(const UWPluginConfig * config, const char * key, const char * defaultValue)
+{
+	for(int i = config->numEntries - 1; i >= 0; i--) {
+		if(strcmp(config->entries[i].key, key) == 0) {
+			return config->entries[i].value;
+		}
+	}
+	return defaultValue;
+}
+
+
+
+int UWConfigGetInt(const UWPluginConfig * config, const char * key, int defaultValue)
+{
+	const char * value = UWConfigGetString(config, key, NULL);
+	return (value != NULL) ? atoi(value) : defaultValue;
+}
+
+
+
+double UWConfigGetDouble(const UWPluginConfig * config, const char * key, double defaultValue)
+{
+	const char * value = UWConfigGetString(config, key, NULL);
+	return (value != NULL) ? atof(value) : defaultValue;
+}
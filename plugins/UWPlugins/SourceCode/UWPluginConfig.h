@@ -0,0 +1,45 @@
+/*
+UWPluginConfig.h
+
+Optional per-plugin settings read once at startup from a text file in the X-System folder (e.g.
+UWTimedProcessingUDPConfig.txt).  Each line holds a key and a value separated by white space and '#' starts a
+comment.  Keys which are not in the file fall back to the default passed in by the plugin, so the plugins behave
+exactly as before when there is no file.
+
+For example
+
+	source		shm				# udp, tcp, unix or shm (see UWPoseSource.h)
+	port		49003
+	shm_name	/UWPoseRing
+*/
+
+#ifndef _UWPluginConfig_h_
+#define _UWPluginConfig_h_
+
+#define UW_CONFIG_MAX_ENTRIES		64
+#define UW_CONFIG_KEY_LENGTH		32
+#define UW_CONFIG_VALUE_LENGTH		256
+
+struct UWConfigEntry {
+	char	key[UW_CONFIG_KEY_LENGTH];
+	char	value[UW_CONFIG_VALUE_LENGTH];
+};
+
+struct UWPluginConfig {
+	int				numEntries;
+	UWConfigEntry	entries[UW_CONFIG_MAX_ENTRIES];
+};
+
+
+
+int				UWConfigLoad(UWPluginConfig * config, const char * fileName);
+
+void			UWConfigClear(UWPluginConfig * config);
+
+const char *	UWConfigGetString(const UWPluginConfig * config, const char * key, const char * defaultValue);
+
+int				UWConfigGetInt(const UWPluginConfig * config, const char * key, int defaultValue);
+
+double			UWConfigGetDouble(const UWPluginConfig * config, const char * key, double defaultValue);
+
+#endif
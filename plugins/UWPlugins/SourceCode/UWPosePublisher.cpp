@@ -0,0 +1,58 @@
+/*
+UWPosePublisher.cpp
+
+See UWPosePublisher.h
+*/
+
+#include <string.h>
+
+#include "UWSharedMemoryRing.h"
+#include "UWPosePublisher.h"
+
+struct UWPosePublisher {
+	UWSharedMemoryRing	ring;
+	UWPoseRecord		record;
+};
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+UWPosePublisher * UWPosePublisherOpen(const char * name)
+{
+	UWPosePublisher * publisher = new UWPosePublisher;
+	memset(&publisher->record, 0, sizeof(UWPoseRecord));
+
+	if(!UWRingOpen(&publisher->ring, (name != NULL) ? name : UW_RING_DEFAULT_NAME)) {
+		delete publisher;
+		return NULL;
+	}
+	return publisher;
+}
+
+
+
+int UWPosePublish(UWPosePublisher * publisher, double timestamp, const double * words, int numWords)
+{
+	if(publisher == NULL || numWords < 0 || numWords > UW_POSE_MAX_WORDS) {
+		return 0;
+	}
+
+	publisher->record.timestamp	= timestamp;
+	publisher->record.numWords	= numWords;
+	memcpy(publisher->record.words, words, numWords * sizeof(double));
+
+	UWRingWrite(&publisher->ring, &publisher->record);
+	return 1;
+}
+
+
+
+void UWPosePublisherClose(UWPosePublisher * publisher)
+{
+	if(publisher == NULL) {
+		return;
+	}
+
+	UWRingClose(&publisher->ring, false);
+	delete publisher;
+}
@@ -0,0 +1,48 @@
+/*
+UWPosePublisher.h
+
+C interface for an external simulation on the same machine as X-Plane to publish poses into the shared memory
+ring read by the UW timed processing plugins (see UWSharedMemoryRing.h).  Build it as a shared library with
+Projects/Lin/Makefile (libUWPosePublisher.so) and call it from C, C++, or a Simulink S-function.
+
+The words are laid out exactly like the words of a text UDP packet, so the plugin's schema file applies
+unchanged.  Set "source shm" in the plugin's config file to use this transport.
+
+	UWPosePublisher * publisher = UWPosePublisherOpen(NULL);
+	...
+	UWPosePublish(publisher, t, words, numWords);		//once per simulation step
+	...
+	UWPosePublisherClose(publisher);
+*/
+
+#ifndef _UWPosePublisher_h_
+#define _UWPosePublisher_h_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct UWPosePublisher UWPosePublisher;
+
+/*
+Open (or create) the ring called name, or UW_RING_DEFAULT_NAME if name is NULL.  Returns NULL on failure.
+*/
+UWPosePublisher *	UWPosePublisherOpen(const char * name);
+
+/*
+Publish one pose.  timestamp is the simulation time in seconds at which the pose is valid.  Returns 0 if the
+publisher is not open or numWords is out of range.
+*/
+int					UWPosePublish(UWPosePublisher * publisher, double timestamp, const double * words, int numWords);
+
+/*
+Close the publisher.  The ring is left in place, so a plugin which is reading it picks up the poses of the next
+publisher to open it.
+*/
+void				UWPosePublisherClose(UWPosePublisher * publisher);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+/*
+UWPoseRecord.h
+
+A pose record as carried by the binary transports (shared memory, and binary packets/frames on the sockets).
+The words have the same layout as the words of a text UDP packet, so the plugin's schema (see UWDataRefSchema.h)
+maps them onto datarefs in exactly the same way no matter which transport delivered them.
+
+On a socket a record is sent as a binary packet (the payload of a TCP frame, see UWFrameDecoder.h) laid out as
+
+	offset	size	
+	0		4		magic "UWPR"
+	4		4		sequence (unsigned int)
+	8		4		numWords (int)
+	12		4		reserved (0)
+	16		8		timestamp (double)
+	24		8*n		words (double)
+
+in the sender's byte order (little-endian on every platform we run on).
+
+This header does not depend on the X-Plane SDK and is plain C, so it can be included by the external simulation.
+*/
+
+#ifndef _UWPoseRecord_h_
+#define _UWPoseRecord_h_
+
+#include <string.h>
+
+#define UW_POSE_MAX_WORDS			64			//same as UW_SCHEMA_MAX_WORDS
+#define UW_POSE_WIRE_MAGIC			"UWPR"
+#define UW_POSE_WIRE_HEADER_SIZE	24
+#define UW_POSE_WIRE_MAX_SIZE		(UW_POSE_WIRE_HEADER_SIZE + 8 * UW_POSE_MAX_WORDS)
+
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define UW_POSE_INLINE	static __inline		//Visual C only knows inline in C++
+#else
+#define UW_POSE_INLINE	static inline
+#endif
+
+struct UWPoseRecord {
+	unsigned int	sequence;			//incremented by the sender for every record
+	int				numWords;			//number of valid entries in words
+	double			timestamp;			//sender time in seconds when the pose was valid
+	double			words[UW_POSE_MAX_WORDS];
+};
+
+
+
+/*
+Write record into buffer (at least UW_POSE_WIRE_MAX_SIZE bytes) as a binary packet.  Returns the packet length.
+*/
+UW_POSE_INLINE int UWPoseEncode(const struct UWPoseRecord * record, char * buffer)
+{
+	int reserved = 0;
+
+	memcpy(buffer,		UW_POSE_WIRE_MAGIC,		4);
+	memcpy(buffer + 4,	&record->sequence,		4);
+	memcpy(buffer + 8,	&record->numWords,		4);
+	memcpy(buffer + 12,	&reserved,				4);
+	memcpy(buffer + 16,	&record->timestamp,		8);
+	memcpy(buffer + UW_POSE_WIRE_HEADER_SIZE, record->words, 8 * record->numWords);
+
+	return UW_POSE_WIRE_HEADER_SIZE + 8 * record->numWords;
+}
+
+
+
+/*
+Read a binary packet back into outRecord.  Returns 0 if the packet is not a well formed pose record.
+*/
+UW_POSE_INLINE int UWPoseDecode(const char * packet, int length, struct UWPoseRecord * outRecord)
+{
+	if(length < UW_POSE_WIRE_HEADER_SIZE || memcmp(packet, UW_POSE_WIRE_MAGIC, 4) != 0) {
+		return 0;
+	}
+
+	memcpy(&outRecord->sequence,	packet + 4,		4);
+	memcpy(&outRecord->numWords,	packet + 8,		4);
+	memcpy(&outRecord->timestamp,	packet + 16,	8);
+
+	if(outRecord->numWords < 0 || outRecord->numWords > UW_POSE_MAX_WORDS ||
+	   length != UW_POSE_WIRE_HEADER_SIZE + 8 * outRecord->numWords) {
+		return 0;
+	}
+
+	memcpy(outRecord->words, packet + UW_POSE_WIRE_HEADER_SIZE, 8 * outRecord->numWords);
+	return 1;
+}
+
+#endif
@@ -0,0 +1,461 @@
+/*
+UWPoseSource.cpp
+
+See UWPoseSource.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "XPLMUtilities.h"
+
+#include "UWClock.h"
+#include "UWPoseSource.h"
+
+using namespace std;
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Fill in the source settings from the plugin config.  Anything which is not in the config keeps the behaviour the
+plugins had before there was a config file (UDP on defaultPort).
+*/
+void UWSourceReadSettings(UWPoseSourceSettings * settings, const UWPluginConfig * config, unsigned short defaultPort)
+{
+	const char * kind = UWConfigGetString(config, "source", "udp");
+	if(strcmp(kind, "shm") == 0) {
+		settings->kind = uwSource_SharedMemory;
+	} else if(strcmp(kind, "unix") == 0) {
+		settings->kind = uwSource_UnixDatagram;
+	} else if(strcmp(kind, "tcp") == 0) {
+		settings->kind = uwSource_TCP;
+	} else {
+		settings->kind = uwSource_UDP;
+	}
+	settings->port = (unsigned short)UWConfigGetInt(config, "port", defaultPort);
+
+	strncpy(settings->multicastGroup, UWConfigGetString(config, "multicast_group", ""), UW_SOURCE_ADDRESS_LENGTH - 1);
+	settings->multicastGroup[UW_SOURCE_ADDRESS_LENGTH - 1] = '\0';
+	strncpy(settings->multicastInterface, UWConfigGetString(config, "multicast_interface", ""), UW_SOURCE_ADDRESS_LENGTH - 1);
+	settings->multicastInterface[UW_SOURCE_ADDRESS_LENGTH - 1] = '\0';
+
+	//by default each plugin gets its own socket file, named after its port
+	char defaultPath[UW_SOURCE_PATH_LENGTH];
+	sprintf(defaultPath, "/tmp/UWPoseSocket.%d", settings->port);
+	strncpy(settings->unixPath, UWConfigGetString(config, "unix_path", defaultPath), UW_SOURCE_PATH_LENGTH - 1);
+	settings->unixPath[UW_SOURCE_PATH_LENGTH - 1] = '\0';
+
+	strncpy(settings->shmName, UWConfigGetString(config, "shm_name", UW_RING_DEFAULT_NAME), UW_RING_NAME_LENGTH - 1);
+	settings->shmName[UW_RING_NAME_LENGTH - 1] = '\0';
+
+	settings->receiveBuffer = UWConfigGetInt(config, "receive_buffer", 0);
+	settings->keepEveryRecord = false;
+}
+
+
+
+/*
+One line description of the source for the plugin overlays (e.g. "UDP port 49003").  outText must hold at least
+UW_SOURCE_DESCRIPTION_LENGTH characters.
+*/
+void UWSourceDescribe(const UWPoseSourceSettings * settings, char * outText)
+{
+	if(settings->kind == uwSource_SharedMemory) {
+		sprintf(outText, "shared memory %s", settings->shmName);
+	} else if(settings->kind == uwSource_UnixDatagram) {
+		sprintf(outText, "unix socket %s", settings->unixPath);
+	} else if(settings->kind == uwSource_TCP) {
+		sprintf(outText, "TCP port %d", settings->port);
+	} else if(settings->multicastGroup[0] != '\0') {
+		sprintf(outText, "UDP multicast %s port %d", settings->multicastGroup, settings->port);
+	} else {
+		sprintf(outText, "UDP port %d", settings->port);
+	}
+}
+
+
+
+void UWSourceInit(UWPoseSource * source)
+{
+	memset(&source->settings, 0, sizeof(source->settings));
+	memset(&source->ring, 0, sizeof(source->ring));
+	source->udpSocket = NULL;
+#ifndef WIN32
+	source->unixSocket = NULL;
+#endif
+	source->tcpServer		= NULL;
+	source->tcpConnection	= NULL;
+	source->tcpPeerPort		= 0;
+	source->tcpOutputLength	= 0;
+	source->skippedRecords	= 0;
+}
+
+
+
+/*
+Open the source described by settings.  Returns false (and leaves the source closed) if it cannot be opened.
+*/
+bool UWSourceOpen(UWPoseSource * source, const UWPoseSourceSettings * settings)
+{
+	UWSourceClose(source);
+	source->settings = *settings;
+
+	if(settings->kind == uwSource_SharedMemory) {
+		return UWRingOpen(&source->ring, settings->shmName);
+	}
+
+	if(settings->kind == uwSource_UnixDatagram) {
+#ifndef WIN32
+		try {
+			source->unixSocket = new UnixDatagramSocket(settings->unixPath);
+			source->unixSocket->setBlocking(false);
+			if(settings->receiveBuffer > 0) {
+				source->unixSocket->setReceiveBufferSize(settings->receiveBuffer);
+			}
+
+		} catch (SocketException &e) {
+			delete source->unixSocket;
+			source->unixSocket = NULL;
+		}
+		return source->unixSocket != NULL;
+#else
+		return false;
+#endif
+	}
+
+	if(settings->kind == uwSource_TCP) {
+		try {
+			source->tcpServer = new TCPServerSocket(settings->port);
+			source->tcpServer->setBlocking(false);
+
+		} catch (SocketException &e) {
+			delete source->tcpServer;
+			source->tcpServer = NULL;
+		}
+		return source->tcpServer != NULL;
+	}
+
+	try {
+		if(settings->multicastGroup[0] != '\0') {
+			//the address must be made reusable before binding so other listeners on this host can share the group
+			source->udpSocket = new UDPSocket();
+			source->udpSocket->setReuseAddress(true);
+			source->udpSocket->setLocalPort(settings->port);
+			source->udpSocket->joinGroup(settings->multicastGroup, settings->multicastInterface);
+		} else {
+			source->udpSocket = new UDPSocket(settings->port);
+		}
+		source->udpSocket->setBlocking(false);
+		if(settings->receiveBuffer > 0) {
+			source->udpSocket->setReceiveBufferSize(settings->receiveBuffer);
+		}
+
+	} catch (SocketException &e) {
+		delete source->udpSocket;
+		source->udpSocket = NULL;
+	}
+	return source->udpSocket != NULL;
+}
+
+
+
+/*
+Drop the TCP connection (the server keeps listening for the next one)
+*/
+static void CloseConnection(UWPoseSource * source)
+{
+	delete source->tcpConnection;
+	source->tcpConnection	= NULL;
+	source->tcpOutputLength	= 0;
+}
+
+
+
+/*
+Close the source.  The shared memory ring is left in place for the next producer (see UWSharedMemoryRing.h).
+*/
+void UWSourceClose(UWPoseSource * source)
+{
+	CloseConnection(source);
+	delete source->tcpServer;
+	source->tcpServer = NULL;
+
+	delete source->udpSocket;
+	source->udpSocket = NULL;
+
+#ifndef WIN32
+	delete source->unixSocket;
+	source->unixSocket = NULL;
+#endif
+
+	UWRingClose(&source->ring, false);
+}
+
+
+
+bool UWSourceIsOpen(const UWPoseSource * source)
+{
+#ifndef WIN32
+	if(source->unixSocket != NULL) {
+		return true;
+	}
+#endif
+	return source->udpSocket != NULL || source->tcpServer != NULL || UWRingIsOpen(&source->ring);
+}
+
+
+
+/*
+Accept a waiting connection if there is none.  Returns true if there is a connection.
+*/
+static bool AcceptConnection(UWPoseSource * source)
+{
+	if(source->tcpConnection != NULL) {
+		return true;
+	}
+
+	try {
+		source->tcpConnection = source->tcpServer->accept();
+		if(source->tcpConnection == NULL) {
+			return false;
+		}
+
+		source->tcpConnection->setBlocking(false);
+		source->tcpConnection->setNoDelay(true);
+		source->tcpPeerAddress	= source->tcpConnection->getForeignAddress();
+		source->tcpPeerPort		= source->tcpConnection->getForeignPort();
+		UWFrameInit(&source->decoder);
+
+	} catch (SocketException &e) {
+		CloseConnection(source);
+	}
+	return source->tcpConnection != NULL;
+}
+
+
+
+/*
+Read everything which is waiting on the connection into the decoder (until the socket is empty or the buffer is
+full).  Returns false if the connection was closed.
+*/
+static bool ReadConnection(UWPoseSource * source)
+{
+	for(;;) {
+		int space;
+		char * buffer = UWFrameWriteSpace(&source->decoder, &space);
+		if(space == 0) {
+			return true;		//buffer full (it always holds at least one complete frame then)
+		}
+
+		int bytesRcvd;
+		try {
+			bytesRcvd = source->tcpConnection->recv(buffer, space);
+		} catch (SocketException &e) {
+			bytesRcvd = 0;
+		}
+
+		if(bytesRcvd < 0) {
+			return true;		//nothing more waiting
+		}
+		if(bytesRcvd == 0) {
+			CloseConnection(source);
+			return false;
+		}
+		UWFrameCommit(&source->decoder, bytesRcvd);
+	}
+}
+
+
+
+/*
+Take the next frame off the TCP connection into message->packet.  A binary pose record is skipped if a newer one
+is already buffered behind it, since only the newest pose is used anyway (unless the settings keep every record,
+as epoch mode needs).  Other frames are never skipped.  Returns false if there is no complete frame.
+*/
+static bool ReceiveFrame(UWPoseSource * source, UWSourceMessage * message)
+{
+	if(!AcceptConnection(source)) {
+		return false;
+	}
+
+	if(!UWFrameHasNext(&source->decoder) && !ReadConnection(source)) {
+		return false;
+	}
+
+	const char * payload;
+	int length;
+	while((length = UWFrameNext(&source->decoder, &payload)) >= 0) {
+		if(!source->settings.keepEveryRecord && length >= 4 && memcmp(payload, UW_POSE_WIRE_MAGIC, 4) == 0 &&
+		   UWFrameHasLater(&source->decoder, UW_POSE_WIRE_MAGIC)) {
+			source->skippedRecords++;
+			continue;
+		}
+
+		memcpy(message->packet, payload, length);
+		message->length			= length;
+		message->sourceAddress	= source->tcpPeerAddress;
+		message->sourcePort		= source->tcpPeerPort;
+		return true;
+	}
+
+	if(length == UW_FRAME_BAD) {
+		XPLMDebugString("UWPoseSource: bad frame length, dropping the TCP connection\n");
+		CloseConnection(source);
+	}
+	return false;
+}
+
+
+
+/*
+Read the next message from the source into message and return its kind.  Returns uwMessage_None when there is
+nothing more to read this frame.
+*/
+UWSourceMessageKind UWSourceReceive(UWPoseSource * source, UWSourceMessage * message)
+{
+	message->kind = uwMessage_None;
+
+	if(source->udpSocket != NULL) {
+		try {
+			message->length = source->udpSocket->recvFrom(message->packet, UW_SOURCE_MAX_PACKET,
+														  message->sourceAddress, message->sourcePort);
+		} catch (SocketException &e) {
+			message->length = -1;
+		}
+
+		if(message->length >= 0) {
+			message->packet[message->length] = '\0';
+			message->kind = uwMessage_Packet;
+		}
+
+#ifndef WIN32
+	} else if(source->unixSocket != NULL) {
+		try {
+			message->length = source->unixSocket->recvFrom(message->packet, UW_SOURCE_MAX_PACKET, message->sourceAddress);
+		} catch (SocketException &e) {
+			message->length = -1;
+		}
+
+		if(message->length >= 0) {
+			message->packet[message->length] = '\0';
+			message->sourcePort = 0;
+			message->kind = uwMessage_Packet;
+		}
+#endif
+
+	} else if(source->tcpServer != NULL) {
+		if(ReceiveFrame(source, message)) {
+			message->packet[message->length] = '\0';
+			message->kind = uwMessage_Packet;
+		}
+
+	} else if(UWRingReadNewest(&source->ring, &message->record)) {
+		message->kind = uwMessage_Record;
+	}
+
+	if(message->kind != uwMessage_None) {
+		message->receiveTime = UWClockWallSeconds();
+	}
+
+	//binary pose records can come over any of the sockets
+	if(message->kind == uwMessage_Packet && UWPoseDecode(message->packet, message->length, &message->record)) {
+		message->kind = uwMessage_Record;
+	}
+
+	return message->kind;
+}
+
+
+
+/*
+Send as much of the pending reply frames as the connection takes now (it is non-blocking, so a frame may go out
+in pieces).  Returns false if the connection was dropped.
+*/
+static bool SendConnection(UWPoseSource * source)
+{
+	int sent = 0;
+	try {
+		while(sent < source->tcpOutputLength) {
+			int bytesSent = source->tcpConnection->send(source->tcpOutput + sent, source->tcpOutputLength - sent);
+			if(bytesSent <= 0) {
+				break;			//the socket buffer is full, the rest goes out with the next flush
+			}
+			sent += bytesSent;
+		}
+	} catch (SocketException &e) {
+		CloseConnection(source);
+		return false;
+	}
+
+	if(sent > 0) {
+		source->tcpOutputLength -= sent;
+		memmove(source->tcpOutput, source->tcpOutput + sent, source->tcpOutputLength);
+	}
+	return true;
+}
+
+
+
+/*
+Send a reply to whoever sent a packet.  On the TCP source the reply is queued as a frame behind the replies
+which the connection has not taken yet and as much as possible is sent straight away (see UWSourceFlush for the
+rest), so a frame is never cut short on the stream.  If the sender stops reading until the queue is full the
+connection is dropped.  Sources which have no way to reply (shared memory, or an unbound Unix domain sender)
+drop it.
+*/
+void UWSourceReply(UWPoseSource * source, const char * data, int length, const string & address, unsigned short port)
+{
+	try {
+		if(source->udpSocket != NULL) {
+			source->udpSocket->sendTo(data, length, address, port);
+		}
+#ifndef WIN32
+		if(source->unixSocket != NULL && !address.empty()) {
+			source->unixSocket->sendTo(data, length, address);
+		}
+#endif
+	} catch (SocketException &e) {
+
+	}
+
+	if(source->tcpConnection == NULL) {
+		return;
+	}
+	if(length > UW_FRAME_MAX_PAYLOAD) {
+		XPLMDebugString("UWPoseSource: reply longer than a TCP frame, dropped\n");
+		return;
+	}
+
+	int frameLength = UW_FRAME_HEADER_SIZE + length;
+	if(source->tcpOutputLength + frameLength > UW_SOURCE_TCP_OUTPUT_SIZE) {
+		if(!SendConnection(source)) {
+			return;
+		}
+		if(source->tcpOutputLength + frameLength > UW_SOURCE_TCP_OUTPUT_SIZE) {
+			XPLMDebugString("UWPoseSource: the TCP sender is not reading its replies, dropping the connection\n");
+			CloseConnection(source);
+			return;
+		}
+	}
+
+	//header and payload are queued together so they go out in the same segment
+	char * frame = source->tcpOutput + source->tcpOutputLength;
+	UWFrameEncodeHeader(frame, length);
+	memcpy(frame + UW_FRAME_HEADER_SIZE, data, length);
+	source->tcpOutputLength += frameLength;
+	SendConnection(source);
+}
+
+
+
+/*
+Send what is left of the TCP replies which the connection could not take when they were made.  Called at the start
+of every flight loop.
+*/
+void UWSourceFlush(UWPoseSource * source)
+{
+	if(source->tcpConnection != NULL && source->tcpOutputLength > 0) {
+		SendConnection(source);
+	}
+}
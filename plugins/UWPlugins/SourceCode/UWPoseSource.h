@@ -0,0 +1,119 @@
+/*
+UWPoseSource.h
+
+Where the timed processing plugins get their poses from.  The plugin opens the source when listening is turned
+on and drains it in the flight loop with UWSourceReceive until it returns uwMessage_None.  Nothing in here ever
+blocks.
+
+	udp		a non-blocking UDP socket; every datagram is returned as a packet (text pose packets and the dataref
+			stream packets of UWDataRefStreamProtocol.h).  If multicast_group is set the socket joins that group
+			(on multicast_interface, the address of a local interface, if set) so every render node receives the
+			one stream.  The address is reusable so several plugins or X-Plane instances on one host can share it.
+	unix	a non-blocking Unix domain datagram socket bound to unix_path (a filesystem path, or '@' and a name in
+			the Linux abstract namespace); the packets are the same as for udp, without the loopback network stack.
+			Not available on Windows.
+	tcp		a TCP server on port which accepts one persistent connection at a time (TCP_NODELAY) carrying
+			length-prefixed frames (see UWFrameDecoder.h).  Frames are decoded incrementally without allocating,
+			and when the sender is ahead only the newest of the buffered binary pose records is returned (every
+			record is returned if keepEveryRecord is set; other frames are always returned).
+
+Binary pose records (see UWPoseRecord.h) received on any socket are returned as uwMessage_Record.
+	shm		the shared memory ring of UWSharedMemoryRing.h; the newest record is returned once and the rest of the
+			call costs nothing, so a same-host simulation pays no syscalls per frame
+
+The settings come from the plugin's config file (see UWPluginConfig.h) with the keys source, port,
+multicast_group, multicast_interface, unix_path and shm_name.  receive_buffer sets the size in bytes of the udp or
+unix socket's receive buffer, for senders which send bursts of many datagrams per frame (0, the default, keeps the
+system's size; Linux caps it at net.core.rmem_max).
+*/
+
+#ifndef _UWPoseSource_h_
+#define _UWPoseSource_h_
+
+#include <string>
+
+#include "PracticalSocket.h"
+#include "UWPluginConfig.h"
+#include "UWPoseRecord.h"
+#include "UWSharedMemoryRing.h"
+#include "UWFrameDecoder.h"
+#include "UWPacketSize.h"
+
+#define UW_SOURCE_MAX_PACKET			UW_MAX_PACKET_SIZE	//longest datagram which is received (see UWPacketSize.h)
+#define UW_SOURCE_DESCRIPTION_LENGTH	160		//see UWSourceDescribe
+#define UW_SOURCE_PATH_LENGTH			108		//longest unix_path (the size of sockaddr_un::sun_path)
+#define UW_SOURCE_ADDRESS_LENGTH		64		//longest multicast_group/multicast_interface
+#define UW_SOURCE_TCP_OUTPUT_SIZE		(4 * (UW_FRAME_HEADER_SIZE + UW_FRAME_MAX_PAYLOAD))	//replies waiting to be sent
+
+enum UWPoseSourceKind {
+	uwSource_UDP			= 0,
+	uwSource_SharedMemory	= 1,
+	uwSource_UnixDatagram	= 2,
+	uwSource_TCP			= 3
+};
+
+enum UWSourceMessageKind {
+	uwMessage_None			= 0,			//nothing more to read this frame
+	uwMessage_Packet		= 1,			//a datagram (packet/length/sourceAddress/sourcePort are set)
+	uwMessage_Record		= 2				//a binary pose record (record is set)
+};
+
+struct UWPoseSourceSettings {
+	UWPoseSourceKind	kind;
+	unsigned short		port;								//UDP or TCP port to listen on
+	char				multicastGroup[UW_SOURCE_ADDRESS_LENGTH];		//empty for unicast UDP
+	char				multicastInterface[UW_SOURCE_ADDRESS_LENGTH];	//empty to let the system choose
+	char				unixPath[UW_SOURCE_PATH_LENGTH];	//path of the Unix domain socket
+	char				shmName[UW_RING_NAME_LENGTH];		//name of the shared memory ring
+	int					receiveBuffer;						//bytes, 0 for the system's size
+	bool				keepEveryRecord;					//never skip stale pose records (set by the plugin in epoch mode)
+};
+
+struct UWSourceMessage {
+	UWSourceMessageKind	kind;
+	int					length;
+	char				packet[UW_SOURCE_MAX_PACKET + 1];	//always '\0' terminated
+	UWPoseRecord		record;
+	std::string			sourceAddress;						//IP address, or path for Unix domain sockets
+	unsigned short		sourcePort;							//0 for Unix domain sockets
+	double				receiveTime;						//UWClockWallSeconds when the message was taken off the source
+};
+
+struct UWPoseSource {
+	UWPoseSourceSettings	settings;
+	UDPSocket *				udpSocket;						//NULL unless an open udp source
+#ifndef WIN32
+	UnixDatagramSocket *	unixSocket;						//NULL unless an open unix source
+#endif
+	UWSharedMemoryRing		ring;
+	TCPServerSocket *		tcpServer;						//NULL unless an open tcp source
+	TCPSocket *				tcpConnection;					//the connected sender (NULL until one connects)
+	std::string				tcpPeerAddress;
+	unsigned short			tcpPeerPort;
+	UWFrameDecoder			decoder;						//frames received on tcpConnection
+	char					tcpOutput[UW_SOURCE_TCP_OUTPUT_SIZE];	//reply frames not yet taken by the connection
+	int						tcpOutputLength;
+	unsigned int			skippedRecords;					//stale pose records skipped because a newer frame was buffered
+};
+
+
+
+void				UWSourceReadSettings(UWPoseSourceSettings * settings, const UWPluginConfig * config, unsigned short defaultPort);
+
+void				UWSourceDescribe(const UWPoseSourceSettings * settings, char * outText);
+
+void				UWSourceInit(UWPoseSource * source);
+
+bool				UWSourceOpen(UWPoseSource * source, const UWPoseSourceSettings * settings);
+
+void				UWSourceClose(UWPoseSource * source);
+
+bool				UWSourceIsOpen(const UWPoseSource * source);
+
+UWSourceMessageKind	UWSourceReceive(UWPoseSource * source, UWSourceMessage * message);
+
+void				UWSourceReply(UWPoseSource * source, const char * data, int length, const std::string & address, unsigned short port);
+
+void				UWSourceFlush(UWPoseSource * source);
+
+#endif
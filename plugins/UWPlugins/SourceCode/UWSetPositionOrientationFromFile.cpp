@@ -14,10 +14,12 @@ This plugin allows the position (lat, lon, alt) and the orientation (phi, theta,
 //#include "XPWidgets.h"
 //#include "XPStandardWidgets.h"
 //#include "XPLMCamera.h"
-//#include <string.h>
+#include <string.h>
 #include <stdio.h>
 //#include <stdlib.h>
 
+#include "UWStatusOverlay.h"
+
 #if IBM
 #include <windows.h>
 #endif
@@ -34,6 +36,7 @@ XPLMHotKeyID	gHotKey = NULL;
 XPLMDataRef		gPositionDataRef[MAX_ITEMS];
 
 int				gClicked = 0;
+UWStatusOverlay	gOverlay;						//text of the status window (see UWStatusOverlay.h)
 
 //Notes about the DataRefs
 //	sim/flightmodel/position/local_x		double	y	meters	The location of the plane in OpenGL coordinates
@@ -122,6 +125,8 @@ PLUGIN_API int XPluginStart(
 	for (int Item=0; Item<MAX_ITEMS; Item++)
 		gPositionDataRef[Item] = XPLMFindDataRef(DataRefString[Item]);
 
+	UWOverlayInit(&gOverlay, UW_OVERLAY_REFRESH_RATE);
+
 	/* Now we create a window.  We pass in a rectangle in left, top,
 	* right, bottom screen coordinates.  We pass in three callbacks. */
 	int topLeftX = 725 - 350;
@@ -152,7 +157,9 @@ PLUGIN_API void	XPluginStop(void)
 	XPLMUnregisterHotKey(gHotKey);
 
 	/* Close the file */
-	fclose(gInputFile);
+	if(gInputFile != NULL) {
+		fclose(gInputFile);
+	}
 }
 
 
@@ -227,58 +234,31 @@ void MyDrawWindowCallback(
                                    XPLMWindowID         inWindowID,    
                                    void *               inRefcon)
 {
-	int		left, top, right, bottom;
-	float	color[] = { 1.0, 1.0, 1.0 }; 	/* RGB White */
-	int		verticalLineSpacing = 10;
-	
-	/* First we get the location of the window passed in to us. */
-	XPLMGetWindowGeometry(inWindowID, &left, &top, &right, &bottom);
-	
-	/* We now use an XPLMGraphics routine to draw a translucent dark
-	 * rectangle that is our window's shape. */
-	XPLMDrawTranslucentDarkBox(left, top, right, bottom);
-
-	/* Finally we draw the text into the window, also using XPLMGraphics
-	 * routines.  The NULL indicates no word wrapping. */
-		
-	//Line 1 (display plugin info)
-	XPLMDrawString(color, left + 5, top - 1*verticalLineSpacing, 
-		(char*)(gClicked ? "You are clicking here" : "UWSetPositionOrientationFromFile (press F8)"), NULL, xplmFont_Basic);
-	
-	//Print out all the data refs
-	for(int i = 0; i < MAX_ITEMS; i++) 
-	{
-
-		char currentValue_char[20];
-		if((i==0) || (i==1) || (i==2) || (i==8) || (i==9) || (i==10)) {
-			//doubles stored at these locations
-			double valueDouble = XPLMGetDatad(gPositionDataRef[i]);
-			sprintf(currentValue_char, "%f", valueDouble);
-
-		} else {
-			//floats stored at these locations
-			float valueFloat = XPLMGetDataf(gPositionDataRef[i]);
-			sprintf(currentValue_char, "%f", valueFloat);
+	//format the text only when it is due, and draw the lines kept from the last refresh (see UWStatusOverlay.h)
+	if(UWOverlayBeginRefresh(&gOverlay)) {
+		//Line 1 (display plugin info)
+		UWOverlaySetText(&gOverlay, 1, gClicked ? "You are clicking here" : "UWSetPositionOrientationFromFile (press F8)");
+
+		//Print out all the data refs
+		for(int i = 0; i < MAX_ITEMS; i++) 
+		{
+			double value;
+			if((i==0) || (i==1) || (i==2) || (i==8) || (i==9) || (i==10)) {
+				//doubles stored at these locations
+				value = XPLMGetDatad(gPositionDataRef[i]);
+			} else {
+				//floats stored at these locations
+				value = XPLMGetDataf(gPositionDataRef[i]);
+			}
+
+			UWOverlaySetValue(&gOverlay, i+2, DataRefString[i], value);
 		}
-		
-		char totalString[300];
-		strcpy(totalString, DataRefString[i]);
-		strcat(totalString, " is ");
-		strcat(totalString, currentValue_char);
 
-		XPLMDrawString(color, left + 5, top - (i+2)*verticalLineSpacing, totalString, NULL, xplmFont_Basic);
+		//Line 15 (did the file handle get opened ok?)
+		UWOverlaySetText(&gOverlay, 15, (gInputFile == NULL) ? "gInputFile is NULL" : "gInputFile is OK");
 	}
 
-	//Line 2 (did the file handle get opened ok?)
-	if(gInputFile==NULL) {
-		XPLMDrawString(color, left + 5, top - 15*verticalLineSpacing, 
-		"gInputFile is NULL", NULL, xplmFont_Basic);
-	
-	} else {
-		XPLMDrawString(color, left + 5, top - 15*verticalLineSpacing, 
-		"gInputFile is OK", NULL, xplmFont_Basic);
-	
-	}
+	UWOverlayDraw(&gOverlay, inWindowID);
 } 
 
 
@@ -288,6 +268,9 @@ Read in info from a file and set the aircraft to some orientation and position t
 */
 void	MyHotKeyCallback(void *               inRefcon)
 {	
+	//show what the hot key changed right away
+	UWOverlayInvalidate(&gOverlay);
+
 	/*
 	float thetaDeg = 10.2320F;
 	float phiDeg	= -12.23245F;
@@ -367,8 +350,10 @@ int MyHandleMouseClickCallback(
 {
 	/* If we get a down or up, toggle our status click.  We will
 	 * never get a down without an up if we accept the down. */
-	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp))
+	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp)) {
 		gClicked = 1 - gClicked;
+		UWOverlayInvalidate(&gOverlay);
+	}
 	
 	/* Returning 1 tells X-Plane that we 'accepted' the click; otherwise
 	 * it would be passed to the next window behind us.  If we accept
@@ -14,11 +14,13 @@ This plugin allows the position (lat, lon, alt) and the orientation (phi, theta,
 //#include "XPWidgets.h"
 //#include "XPStandardWidgets.h"
 //#include "XPLMCamera.h"
-//#include <string.h>
+#include <string.h>
 #include <stdio.h>
 //#include <stdlib.h>
 
 #include "PracticalSocket.h"   // For UDPSocket and SocketException
+#include "UWDataRefSchema.h"
+#include "UWStatusOverlay.h"
 
 
 #if IBM
@@ -27,14 +29,14 @@ This plugin allows the position (lat, lon, alt) and the orientation (phi, theta,
 	
 
 //----------------------------GLOBAL VARIALBES----------------------------------------
-#define MAX_ITEMS 11
 #define UDP_PORT_RECEIVE 49003		//port to listen to to receive UDP packets
+#define SCHEMA_FILE "UWSetPositionOrientationFromUDPSchema.txt"	//optional schema file in the X-System folder (see UWDataRefSchema.h)
 
 const int MAXRCVSTRING = 4096; // Longest string to receive
 XPLMWindowID	gWindow = NULL;			//for displaying plugin status
 XPLMHotKeyID	gHotKey = NULL;
-XPLMDataRef		gPositionDataRef[MAX_ITEMS];
 int				gClicked = 0;
+UWStatusOverlay	gOverlay;						//text of the status window (see UWStatusOverlay.h)
 
 //Notes about the DataRefs
 //	sim/flightmodel/position/local_x		double	y	meters	The location of the plane in OpenGL coordinates
@@ -48,17 +50,21 @@ int				gClicked = 0;
 //	sim/flightmodel/position/latitude		double	n	degrees	The latitude of the aircraft
 //	sim/flightmodel/position/longitude		double	n	degrees	The longitude of the aircraft
 //	sim/flightmodel/position/elevation		double	n	meters	The elevation above MSL of the aircraft
-char DataRefString[MAX_ITEMS][255] = {	"sim/flightmodel/position/local_x", "sim/flightmodel/position/local_y", "sim/flightmodel/position/local_z",
-										"sim/flightmodel/position/lat_ref", "sim/flightmodel/position/lon_ref",	"sim/flightmodel/position/theta",
-										"sim/flightmodel/position/phi", "sim/flightmodel/position/psi",
-										"sim/flightmodel/position/latitude", "sim/flightmodel/position/longitude", "sim/flightmodel/position/elevation"};
+UWDataRefSchema	gSchema;						//maps the words of a packet onto datarefs (resolved once at startup)
+double			gPacketWords[UW_SCHEMA_MAX_WORDS];	//words of the most recent packet
+int				gLatitudeField;					//index of the schema fields used to compute local_x, local_y, local_z
+int				gLongitudeField;
+int				gElevationField;
+int				gLocalXField;
+int				gLocalYField;
+int				gLocalZField;
 
 
 
 
 //----------------------------FUNCTION PROTOTYPES-------------------------------------
-void ApplyThetaPhiPsiToDataRefs(float theta, float phi, float psi);
-void ApplyLatLonAltToDataRefs(double lat, double lon, double altitude);
+void LoadDataRefSchema();
+void ApplyLocalPositionToDataRefs(const double * words);
 
 void MyDrawWindowCallback(
                                    XPLMWindowID         inWindowID,    
@@ -94,9 +100,10 @@ PLUGIN_API int XPluginStart(
 	strcpy(outSig, "xpsdk.examples.UWSetPositionOrientationFromUDP");
 	strcpy(outDesc, "A plug-in that sets the position/orientation of the vehicle to a fixed value from a UDP socket.  Be sure that X-Plane Physics Engine is disabled before using (see UWDiablePhysicsEngine).");
 
-	//fill up the gPositionDataRef array with data references
-	for (int Item=0; Item<MAX_ITEMS; Item++)
-		gPositionDataRef[Item] = XPLMFindDataRef(DataRefString[Item]);
+	//build the schema and resolve all of the data references once
+	LoadDataRefSchema();
+
+	UWOverlayInit(&gOverlay, UW_OVERLAY_REFRESH_RATE);
 
 	/* Now we create a window.  We pass in a rectangle in left, top,
 	* right, bottom screen coordinates.  We pass in three callbacks. */
@@ -145,33 +152,59 @@ PLUGIN_API int XPluginEnable(void)
 
 //-------------------------FUNCTION DEFINITIONS---------------------------------------
 /*
-Apply the specified Euler angles to the datarefs
+Build the schema which maps the words of a packet onto datarefs.  If the schema file exists in the X-System folder
+it is used, otherwise the default packet layout is used
+
+	'phiDeg thetaDeg psiDeg latitudeDeg longitudeDeg altitudeMeters'
+
+Every dataref handle and type is resolved here so that the flight loop does not have to look anything up.
 */
-void ApplyThetaPhiPsiToDataRefs(float theta, float phi, float psi)
+void LoadDataRefSchema()
 {
-	//apply the angles to the datarefs
-	XPLMSetDataf(gPositionDataRef[5], theta);
-	XPLMSetDataf(gPositionDataRef[6], phi);
-	XPLMSetDataf(gPositionDataRef[7], psi);
+	if(UWSchemaLoad(&gSchema, SCHEMA_FILE) == 0) {
+		UWSchemaClear(&gSchema);
+		UWSchemaAddField(&gSchema, "local_x",	-1,	uwFieldType_Double,	1.0, "sim/flightmodel/position/local_x");
+		UWSchemaAddField(&gSchema, "local_y",	-1,	uwFieldType_Double,	1.0, "sim/flightmodel/position/local_y");
+		UWSchemaAddField(&gSchema, "local_z",	-1,	uwFieldType_Double,	1.0, "sim/flightmodel/position/local_z");
+		UWSchemaAddField(&gSchema, "lat_ref",	-1,	uwFieldType_Float,	1.0, "sim/flightmodel/position/lat_ref");
+		UWSchemaAddField(&gSchema, "lon_ref",	-1,	uwFieldType_Float,	1.0, "sim/flightmodel/position/lon_ref");
+		UWSchemaAddField(&gSchema, "theta",		1,	uwFieldType_Float,	1.0, "sim/flightmodel/position/theta");
+		UWSchemaAddField(&gSchema, "phi",		0,	uwFieldType_Float,	1.0, "sim/flightmodel/position/phi");
+		UWSchemaAddField(&gSchema, "psi",		2,	uwFieldType_Float,	1.0, "sim/flightmodel/position/psi");
+		UWSchemaAddField(&gSchema, "latitude",	3,	uwFieldType_Double,	1.0, "sim/flightmodel/position/latitude");
+		UWSchemaAddField(&gSchema, "longitude",	4,	uwFieldType_Double,	1.0, "sim/flightmodel/position/longitude");
+		UWSchemaAddField(&gSchema, "elevation",	5,	uwFieldType_Double,	1.0, "sim/flightmodel/position/elevation");
+	}
+
+	UWSchemaResolve(&gSchema);
+
+	gLatitudeField	= UWSchemaFindField(&gSchema, "latitude");
+	gLongitudeField	= UWSchemaFindField(&gSchema, "longitude");
+	gElevationField	= UWSchemaFindField(&gSchema, "elevation");
+	gLocalXField	= UWSchemaFindField(&gSchema, "local_x");
+	gLocalYField	= UWSchemaFindField(&gSchema, "local_y");
+	gLocalZField	= UWSchemaFindField(&gSchema, "local_z");
 }
 
 
 
 /*
-Apply the specified lat/lon/alt to the datarefs.  Note the units on the inputs arguments 
+Use XPLMWorldToLocal to compute the local_x, local_y, local_z from the lat/lon/alt in the packet and apply them to 
+the datarefs.  Note the units of the packet words
 
 latitude in degrees
 longitude in degrees
 altitude in meters
-
-This will then use XPLMWorldToLocal to also compute the local_x, local_y, local_z and apply them to the datarefs
 */
-void ApplyLatLonAltToDataRefs(double latitudeDeg, double longitudeDeg, double altitudeMeters)
+void ApplyLocalPositionToDataRefs(const double * words)
 {
-	//apply the positions to the data refs
-	XPLMSetDatad(gPositionDataRef[8], latitudeDeg);
-	XPLMSetDatad(gPositionDataRef[9], longitudeDeg);
-	XPLMSetDatad(gPositionDataRef[10], altitudeMeters);
+	if(gLatitudeField < 0 || gLongitudeField < 0 || gElevationField < 0) {
+		return;
+	}
+
+	double latitudeDeg		= UWSchemaGetValue(&gSchema, gLatitudeField, words);
+	double longitudeDeg		= UWSchemaGetValue(&gSchema, gLongitudeField, words);
+	double altitudeMeters	= UWSchemaGetValue(&gSchema, gElevationField, words);
 
 	//compute the local_x, local_y, and local_z values
 	double local_x;
@@ -180,9 +213,9 @@ void ApplyLatLonAltToDataRefs(double latitudeDeg, double longitudeDeg, double al
 	XPLMWorldToLocal(latitudeDeg, longitudeDeg, altitudeMeters, &local_x, &local_y, &local_z);
 
 	//apply the local_x, local_y, and local_z values to the datarefs
-	XPLMSetDatad(gPositionDataRef[0], local_x);
-	XPLMSetDatad(gPositionDataRef[1], local_y);
-	XPLMSetDatad(gPositionDataRef[2], local_z);
+	UWSchemaSetField(&gSchema, gLocalXField, local_x);
+	UWSchemaSetField(&gSchema, gLocalYField, local_y);
+	UWSchemaSetField(&gSchema, gLocalZField, local_z);
 }
 
 
@@ -200,47 +233,25 @@ void MyDrawWindowCallback(
                                    XPLMWindowID         inWindowID,    
                                    void *               inRefcon)
 {
-	int		left, top, right, bottom;
-	float	color[] = { 1.0, 1.0, 1.0 }; 	/* RGB White */
-	int		verticalLineSpacing = 10;
-	
-	/* First we get the location of the window passed in to us. */
-	XPLMGetWindowGeometry(inWindowID, &left, &top, &right, &bottom);
-	
-	/* We now use an XPLMGraphics routine to draw a translucent dark
-	 * rectangle that is our window's shape. */
-	XPLMDrawTranslucentDarkBox(left, top, right, bottom);
+	//format the text only when it is due, and draw the lines kept from the last refresh (see UWStatusOverlay.h)
+	if(UWOverlayBeginRefresh(&gOverlay)) {
+		//Line 1 (display plugin info)
+		UWOverlaySetText(&gOverlay, 1, gClicked ? "You are clicking here" : "UWSetPositionOrientationFromUDP (press F6)");
+
+		//Print out all the data refs
+		int line = 2;
+		for(int i = 0; i < gSchema.numFields; i++) 
+		{
+			if(gSchema.fields[i].dataRef == NULL) {
+				continue;
+			}
 
-	/* Finally we draw the text into the window, also using XPLMGraphics
-	 * routines.  The NULL indicates no word wrapping. */
-		
-	//Line 1 (display plugin info)
-	XPLMDrawString(color, left + 5, top - 1*verticalLineSpacing, 
-		(char*)(gClicked ? "You are clicking here" : "UWSetPositionOrientationFromUDP (press F6)"), NULL, xplmFont_Basic);
-	
-	//Print out all the data refs
-	for(int i = 0; i < MAX_ITEMS; i++) 
-	{
-
-		char currentValue_char[20];
-		if((i==0) || (i==1) || (i==2) || (i==8) || (i==9) || (i==10)) {
-			//doubles stored at these locations
-			double valueDouble = XPLMGetDatad(gPositionDataRef[i]);
-			sprintf(currentValue_char, "%f", valueDouble);
-
-		} else {
-			//floats stored at these locations
-			float valueFloat = XPLMGetDataf(gPositionDataRef[i]);
-			sprintf(currentValue_char, "%f", valueFloat);
+			UWOverlaySetValue(&gOverlay, line, gSchema.fields[i].dataRefString, UWSchemaReadField(&gSchema, i));
+			line++;
 		}
-		
-		char totalString[300];
-		strcpy(totalString, DataRefString[i]);
-		strcat(totalString, " is ");
-		strcat(totalString, currentValue_char);
-
-		XPLMDrawString(color, left + 5, top - (i+2)*verticalLineSpacing, totalString, NULL, xplmFont_Basic);
 	}
+
+	UWOverlayDraw(&gOverlay, inWindowID);
 } 
 
 
@@ -252,18 +263,9 @@ Note that this will block until it receives the UDP packet
 */
 void	MyHotKeyCallback(void *               inRefcon)
 {	
-	//Setup the containers for values we want to get from UDP
-	double phiDegDouble;
-	double thetaDegDouble;
-	double psiDegDouble;
-	double latitudeDeg;
-	double longitudeDeg;
-	double altitudeMeters;
-	
-	float thetaDeg;
-	float phiDeg;
-	float psiDeg;
-	
+	//show what the hot key changed right away
+	UWOverlayInvalidate(&gOverlay);
+
 	//receive the data from the UDP port
 	try {
 		unsigned short echoServPort = UDP_PORT_RECEIVE;
@@ -276,50 +278,15 @@ void	MyHotKeyCallback(void *               inRefcon)
 		int bytesRcvd = sock.recvFrom(recvString, MAXRCVSTRING, sourceAddress, sourcePort);
 		recvString[bytesRcvd] = '\0';  // Terminate string
 
-		//Convert the recieved string to values
-		char *pch;			
-		pch = strtok(recvString," ");
-
-		for(int wordNumber = 0; wordNumber < 6; wordNumber++)
-		{
-			double value = atof(pch);
-
-			if (wordNumber==0) {
-				phiDegDouble = value;
-
-			} else if (wordNumber==1) {
-				thetaDegDouble = value;
-
-			} else if (wordNumber==2) {
-				psiDegDouble = value;
-
-			} else if (wordNumber==3) {
-				latitudeDeg = value;
-
-			} else if (wordNumber==4) {
-				longitudeDeg = value;
-
-			} else if (wordNumber==5) {
-				altitudeMeters = value;
-
-			} else {
-			}		
-
-			pch = strtok (NULL, " ");
+		//Convert the recieved string to values and set them to the datarefs
+		if(UWSchemaParsePacket(&gSchema, recvString, gPacketWords) == gSchema.numPacketWords) {
+			UWSchemaApply(&gSchema, gPacketWords);
+			ApplyLocalPositionToDataRefs(gPacketWords);
 		}
-
-		//convert phi, theta, psi to floats
-		phiDeg		= (float)phiDegDouble;
-		thetaDeg	= (float)thetaDegDouble;
-		psiDeg		= (float)psiDegDouble;
 		
 	} catch (SocketException &e) {
 
 	}
-	
-	//Set these values to the datarefs
-	ApplyThetaPhiPsiToDataRefs(thetaDeg, phiDeg, psiDeg);
-	ApplyLatLonAltToDataRefs(latitudeDeg, longitudeDeg, altitudeMeters);
 }
 
 
@@ -360,8 +327,10 @@ int MyHandleMouseClickCallback(
 {
 	/* If we get a down or up, toggle our status click.  We will
 	 * never get a down without an up if we accept the down. */
-	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp))
+	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp)) {
 		gClicked = 1 - gClicked;
+		UWOverlayInvalidate(&gOverlay);
+	}
 	
 	/* Returning 1 tells X-Plane that we 'accepted' the click; otherwise
 	 * it would be passed to the next window behind us.  If we accept
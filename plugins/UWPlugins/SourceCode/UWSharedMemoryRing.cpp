@@ -0,0 +1,212 @@
+/*
+UWSharedMemoryRing.cpp
+
+See UWSharedMemoryRing.h
+*/
+
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+
+#if LIN || APL
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "UWSharedMemoryRing.h"
+
+using namespace std;
+
+//----------------------------GLOBAL VARIALBES----------------------------------------
+#define UW_RING_MAGIC			0x52505755		//"UWPR"
+#define UW_RING_INITIALIZING	0x49505755		//"UWPI", magic while the creator fills in the header
+#define UW_RING_VERSION			1
+#define UW_RING_READ_RETRIES	4				//attempts before giving up on a slot the writer keeps overwriting
+#define UW_RING_INIT_TIMEOUT	0.1				//seconds to wait for the creator to fill in the header
+
+struct UWRingHeader {
+	atomic<unsigned int>		magic;
+	unsigned int				version;
+	unsigned int				capacity;
+	unsigned int				slotSize;
+	char						pad0[48];		//keep the write index on its own cache line
+	atomic<unsigned long long>	writeIndex;		//number of records written so far
+	char						pad1[56];
+};
+
+struct UWRingSlot {
+	atomic<unsigned int>		sequence;		//odd while the slot is being written
+	unsigned int				pad;
+	UWPoseRecord				record;
+};
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Map the ring called name, creating and initializing it if no one else has yet.  The name must start with '/'.
+The ring is only readable and writable by the user who created it.
+
+Fails if the creator has not finished filling in the header within UW_RING_INIT_TIMEOUT (it died half way; remove
+the ring, e.g. /dev/shm/UWPoseRing on Linux, to start again).
+*/
+bool UWRingOpen(UWSharedMemoryRing * ring, const char * name)
+{
+	memset(ring, 0, sizeof(UWSharedMemoryRing));
+	strncpy(ring->name, name, UW_RING_NAME_LENGTH - 1);
+
+#if LIN || APL
+	size_t size = sizeof(UWRingHeader) + UW_RING_CAPACITY * sizeof(UWRingSlot);
+
+	int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+	if(fd < 0) {
+		return false;
+	}
+
+	//Both sides size the object the same way, so it does not matter who gets here first
+	struct stat info;
+	if(fstat(fd, &info) != 0 || ((size_t)info.st_size < size && ftruncate(fd, size) != 0)) {
+		close(fd);
+		return false;
+	}
+
+	void * base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED) {
+		return false;
+	}
+
+	//A new object is zero filled.  Whoever swaps the magic away from zero initializes the header.
+	UWRingHeader * header = (UWRingHeader *)base;
+	unsigned int expected = 0;
+	if(header->magic.compare_exchange_strong(expected, UW_RING_INITIALIZING)) {
+		header->version		= UW_RING_VERSION;
+		header->capacity	= UW_RING_CAPACITY;
+		header->slotSize	= sizeof(UWRingSlot);
+		header->writeIndex.store(0);
+		header->magic.store(UW_RING_MAGIC, memory_order_release);
+	}
+	else {
+		chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+			chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(UW_RING_INIT_TIMEOUT));
+		while(header->magic.load(memory_order_acquire) == UW_RING_INITIALIZING) {
+			if(chrono::steady_clock::now() > deadline) {
+				break;
+			}
+			this_thread::yield();
+		}
+	}
+
+	if(header->magic.load(memory_order_acquire) != UW_RING_MAGIC || header->version != UW_RING_VERSION ||
+	   header->capacity != UW_RING_CAPACITY || header->slotSize != sizeof(UWRingSlot)) {
+		munmap(base, size);
+		return false;
+	}
+
+	ring->base			= base;
+	ring->size			= size;
+	ring->header		= header;
+	ring->slots			= (UWRingSlot *)((char *)base + sizeof(UWRingHeader));
+	ring->lastReadIndex	= header->writeIndex.load(memory_order_acquire);	//only records written from now on are new
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+/*
+Unmap the ring, and remove its name if unlink is true.  The producer leaves the name in place when it closes: a
+plugin which still has the ring mapped would never see a new object under the same name, so a restarted producer
+has to attach to the same ring.
+*/
+void UWRingClose(UWSharedMemoryRing * ring, bool unlink)
+{
+#if LIN || APL
+	if(ring->base != NULL) {
+		munmap(ring->base, ring->size);
+	}
+	if(unlink && ring->name[0] != '\0') {
+		shm_unlink(ring->name);
+	}
+#endif
+
+	ring->base		= NULL;
+	ring->header	= NULL;
+	ring->slots		= NULL;
+}
+
+
+
+bool UWRingIsOpen(const UWSharedMemoryRing * ring)
+{
+	return ring->base != NULL;
+}
+
+
+
+/*
+Producer side.  Copy record into the next slot and publish it.  The sequence number of the record is assigned
+here.
+*/
+void UWRingWrite(UWSharedMemoryRing * ring, const UWPoseRecord * record)
+{
+	if(ring->base == NULL) {
+		return;
+	}
+
+	unsigned long long index = ring->header->writeIndex.load(memory_order_relaxed);
+	UWRingSlot * slot = &ring->slots[index % UW_RING_CAPACITY];
+
+	unsigned int sequence = slot->sequence.load(memory_order_relaxed);
+	slot->sequence.store(sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	slot->record			= *record;
+	slot->record.sequence	= ring->nextSequence++;
+
+	slot->sequence.store(sequence + 2, memory_order_release);
+	ring->header->writeIndex.store(index + 1, memory_order_release);
+}
+
+
+
+/*
+Consumer side.  Copy the most recently written record into outRecord.  Returns false if nothing has been written
+since the last successful read (this is the common case and costs one load).
+*/
+bool UWRingReadNewest(UWSharedMemoryRing * ring, UWPoseRecord * outRecord)
+{
+	if(ring->base == NULL) {
+		return false;
+	}
+
+	for(int attempt = 0; attempt < UW_RING_READ_RETRIES; attempt++) {
+		unsigned long long index = ring->header->writeIndex.load(memory_order_acquire);
+		if(index == ring->lastReadIndex) {
+			return false;
+		}
+
+		UWRingSlot * slot = &ring->slots[(index - 1) % UW_RING_CAPACITY];
+		unsigned int before = slot->sequence.load(memory_order_acquire);
+		if(before & 1) {
+			continue;
+		}
+
+		*outRecord = slot->record;
+
+		atomic_thread_fence(memory_order_acquire);
+		if(slot->sequence.load(memory_order_relaxed) == before) {
+			ring->lastReadIndex = index;
+			return true;
+		}
+	}
+
+	//The producer lapped us every time; try again next frame
+	return false;
+}
@@ -0,0 +1,52 @@
+/*
+UWSharedMemoryRing.h
+
+A single-producer/single-consumer ring of pose records in POSIX shared memory, for an external simulation which
+runs on the same machine as X-Plane.  The producer (see UWPosePublisher.h) writes records and the plugin reads
+the newest one in the flight loop with plain memory reads, so there are no syscalls and no copies through the
+network stack.
+
+Each slot is protected by a sequence counter (odd while it is being written), so the reader never sees a half
+written record and the writer never waits for the reader.  Either side may create the ring; the other attaches
+to it.  The producer does not remove the ring when it closes, so a restarted producer writes into the ring the
+plugin already has mapped.  The ring is only open to the user who created it.
+
+Shared memory is only available on Linux and Mac; on Windows UWRingOpen always fails.
+*/
+
+#ifndef _UWSharedMemoryRing_h_
+#define _UWSharedMemoryRing_h_
+
+#include <stddef.h>
+#include "UWPoseRecord.h"
+
+#define UW_RING_CAPACITY		64				//number of records in the ring
+#define UW_RING_NAME_LENGTH		64
+#define UW_RING_DEFAULT_NAME	"/UWPoseRing"
+
+struct UWRingHeader;
+struct UWRingSlot;
+
+struct UWSharedMemoryRing {
+	char					name[UW_RING_NAME_LENGTH];
+	void *					base;				//start of the mapping (NULL if not open)
+	size_t					size;
+	UWRingHeader *			header;
+	UWRingSlot *			slots;
+	unsigned long long		lastReadIndex;		//write index seen by the last successful read
+	unsigned int			nextSequence;		//used by the producer
+};
+
+
+
+bool	UWRingOpen(UWSharedMemoryRing * ring, const char * name);
+
+void	UWRingClose(UWSharedMemoryRing * ring, bool unlink);
+
+bool	UWRingIsOpen(const UWSharedMemoryRing * ring);
+
+void	UWRingWrite(UWSharedMemoryRing * ring, const UWPoseRecord * record);
+
+bool	UWRingReadNewest(UWSharedMemoryRing * ring, UWPoseRecord * outRecord);
+
+#endif
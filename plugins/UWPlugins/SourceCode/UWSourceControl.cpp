@@ -0,0 +1,459 @@
+/*
+UWSourceControl.cpp
+
+See UWSourceControl.h
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "UWSourceControl.h"
+
+using namespace std;
+
+static const char * sCommandNames[UW_CONTROL_COMMANDS] = {
+	"port_up", "port_down", "rate_up", "rate_down", "delay_up", "delay_down", "next_source"
+};
+
+static const char * sCommandDescriptions[UW_CONTROL_COMMANDS] = {
+	"Listen on the next port up",
+	"Listen on the next port down",
+	"Drain the pose source more often",
+	"Drain the pose source less often",
+	"Lengthen the epoch delay",
+	"Shorten the epoch delay",
+	"Read the poses from the next transport (udp, tcp, unix, shm)"
+};
+
+static const double sRates[] = UW_CONTROL_RATES;
+
+static const UWPoseSourceKind sSourceKinds[] = {
+	uwSource_UDP,
+	uwSource_TCP,
+#ifndef WIN32
+	uwSource_UnixDatagram,
+#endif
+	uwSource_SharedMemory
+};
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+The thread which opens and closes the spare source, so the flight loop never waits on a socket being set up
+*/
+static void RebindSources(UWSourceControl * control)
+{
+	unique_lock<mutex> lock(control->mutex);
+	while(control->running) {
+		if(control->retire) {
+			//the flight loop swapped to the new source, close the old one
+			control->retire = false;
+			lock.unlock();
+			UWSourceClose(control->spare);
+			lock.lock();
+
+		} else if(control->pending && !control->ready) {
+			UWPoseSourceSettings	settings	= control->wanted;
+			unsigned int			generation	= control->generation;
+			lock.unlock();
+			bool opened = UWSourceOpen(control->spare, &settings);
+			lock.lock();
+
+			//a request made while it was being opened supersedes it (and a cancelled one is closed again)
+			if(control->pending && control->generation == generation) {
+				control->failed	= !opened;
+				control->ready	= true;
+			} else if(!control->pending) {
+				control->retire = true;
+			}
+
+		} else {
+			control->wake.wait(lock);
+		}
+	}
+}
+
+
+
+static bool SameSettings(const UWPoseSourceSettings * a, const UWPoseSourceSettings * b)
+{
+	return a->kind == b->kind && a->port == b->port && a->receiveBuffer == b->receiveBuffer &&
+		   a->keepEveryRecord == b->keepEveryRecord &&
+		   strcmp(a->multicastGroup, b->multicastGroup) == 0 &&
+		   strcmp(a->multicastInterface, b->multicastInterface) == 0 &&
+		   strcmp(a->unixPath, b->unixPath) == 0 && strcmp(a->shmName, b->shmName) == 0;
+}
+
+
+
+/*
+Have the thread open the source the settings now describe (unless it is the one already being read)
+*/
+static void RequestSource(UWSourceControl * control)
+{
+	if(!control->listening) {
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock(control->mutex);
+		control->generation++;
+		if(UWSourceIsOpen(control->active) && SameSettings(&control->active->settings, control->settings)) {
+			//changed back before the new source was swapped in
+			control->pending = false;
+			if(control->ready) {
+				control->ready	= false;
+				control->retire	= true;
+			}
+		} else {
+			control->wanted		= *control->settings;
+			control->pending	= true;
+			control->ready		= false;
+		}
+	}
+	control->wake.notify_one();
+}
+
+
+
+/*
+Show the current values in the items of the plugin's menu
+*/
+static void UpdateMenu(UWSourceControl * control)
+{
+	char item[UW_SOURCE_DESCRIPTION_LENGTH + 32];
+	char source[UW_SOURCE_DESCRIPTION_LENGTH];
+
+	sprintf(item, "Port up (%d)", control->settings->port);
+	XPLMSetMenuItemName(control->menu, uwControl_PortUp, item, 1);
+
+	if(control->receiveRate > 0.0) {
+		sprintf(item, "Receive rate up (%.0f Hz)", control->receiveRate);
+	} else {
+		sprintf(item, "Receive rate up (every frame)");
+	}
+	XPLMSetMenuItemName(control->menu, uwControl_RateUp, item, 1);
+
+	sprintf(item, "Epoch delay up (%.0f ms)", 1000.0 * control->epoch->delay);
+	XPLMSetMenuItemName(control->menu, uwControl_DelayUp, item, 1);
+
+	UWSourceDescribe(control->settings, source);
+	sprintf(item, "Next source (%s)", source);
+	XPLMSetMenuItemName(control->menu, uwControl_NextSource, item, 1);
+}
+
+
+
+/*
+Move the port by step, and the unix socket with it if it has the default name (see UWSourceReadSettings)
+*/
+static void MovePort(UWPoseSourceSettings * settings, int step)
+{
+	int port = settings->port + step;
+	if(port < 1 || port > 65535) {
+		return;
+	}
+
+	char defaultPath[UW_SOURCE_PATH_LENGTH];
+	sprintf(defaultPath, "/tmp/UWPoseSocket.%d", settings->port);
+	if(strcmp(settings->unixPath, defaultPath) == 0) {
+		sprintf(settings->unixPath, "/tmp/UWPoseSocket.%d", port);
+	}
+	settings->port = (unsigned short)port;
+}
+
+
+
+/*
+Step the receive rate through UW_CONTROL_RATES (a rate from the config file which is not one of them moves to the
+nearest one in the direction asked)
+*/
+static void StepRate(UWSourceControl * control, int step)
+{
+	const int	numRates	= sizeof(sRates) / sizeof(sRates[0]);
+	double		rate		= (control->receiveRate > 0.0) ? control->receiveRate : 1.0e9;		//every frame is fastest
+
+	int i;
+	if(step > 0) {
+		for(i = 0; i < numRates - 1; i++) {
+			double candidate = (sRates[i] > 0.0) ? sRates[i] : 1.0e9;
+			if(candidate > rate) {
+				break;
+			}
+		}
+	} else {
+		for(i = numRates - 1; i > 0; i--) {
+			double candidate = (sRates[i] > 0.0) ? sRates[i] : 1.0e9;
+			if(candidate < rate) {
+				break;
+			}
+		}
+	}
+	control->receiveRate = sRates[i];
+}
+
+
+
+/*
+Lengthen or shorten the epoch delay by step seconds, in whole milliseconds so the steps do not drift
+*/
+static void StepDelay(UWEpochApply * epoch, double step)
+{
+	double delay = floor(1000.0 * (epoch->delay + step) + 0.5) / 1000.0;
+	epoch->delay = (delay < 0.0) ? 0.0 : (delay > UW_CONTROL_MAX_DELAY) ? UW_CONTROL_MAX_DELAY : delay;
+}
+
+
+
+static void NextSourceKind(UWPoseSourceSettings * settings)
+{
+	const int numKinds = sizeof(sSourceKinds) / sizeof(sSourceKinds[0]);
+	for(int i = 0; i < numKinds; i++) {
+		if(sSourceKinds[i] == settings->kind) {
+			settings->kind = sSourceKinds[(i + 1) % numKinds];
+			return;
+		}
+	}
+	settings->kind = uwSource_UDP;
+}
+
+
+
+static int HandleCommand(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void * inRefcon)
+{
+	UWSourceControl * control = (UWSourceControl *)inRefcon;
+	if(inPhase != xplm_CommandBegin) {
+		return 1;
+	}
+
+	if(inCommand == control->commands[uwControl_PortUp]) {
+		MovePort(control->settings, 1);
+		RequestSource(control);
+	} else if(inCommand == control->commands[uwControl_PortDown]) {
+		MovePort(control->settings, -1);
+		RequestSource(control);
+	} else if(inCommand == control->commands[uwControl_RateUp]) {
+		StepRate(control, 1);
+	} else if(inCommand == control->commands[uwControl_RateDown]) {
+		StepRate(control, -1);
+	} else if(inCommand == control->commands[uwControl_DelayUp]) {
+		StepDelay(control->epoch, UW_CONTROL_DELAY_STEP);
+	} else if(inCommand == control->commands[uwControl_DelayDown]) {
+		StepDelay(control->epoch, -UW_CONTROL_DELAY_STEP);
+	} else if(inCommand == control->commands[uwControl_NextSource]) {
+		NextSourceKind(control->settings);
+		RequestSource(control);
+	}
+
+	UpdateMenu(control);
+	UWOverlayInvalidate(control->overlay);
+	return 1;
+}
+
+
+
+static void HandleMenu(void * inMenuRef, void * inItemRef)
+{
+	UWSourceControl *	control	= (UWSourceControl *)inMenuRef;
+	int					command	= (int)(intptr_t)inItemRef;
+	XPLMCommandOnce(control->commands[command]);
+}
+
+
+
+/*
+Create the commands (commandPrefix/port_up etc.) and the plugin's menu.  settings, epoch and overlay are the
+plugin's, and are changed by the commands.
+*/
+void UWControlInit(UWSourceControl * control, const char * name, const char * commandPrefix,
+				   const UWPluginConfig * config, UWPoseSourceSettings * settings, UWEpochApply * epoch,
+				   UWStatusOverlay * overlay)
+{
+	strncpy(control->name, name, UW_CONTROL_NAME_LENGTH - 1);
+	control->name[UW_CONTROL_NAME_LENGTH - 1] = '\0';
+	control->settings		= settings;
+	control->epoch			= epoch;
+	control->overlay		= overlay;
+	control->receiveRate	= UWConfigGetDouble(config, "receive_rate", UW_CONTROL_DEFAULT_RATE);
+	if(control->receiveRate < 0.0) {
+		control->receiveRate = 0.0;
+	}
+
+	UWSourceInit(&control->sources[0]);
+	UWSourceInit(&control->sources[1]);
+	control->active		= &control->sources[0];
+	control->spare		= &control->sources[1];
+	control->listening	= false;
+	control->rebinds	= 0;
+
+	control->thread		= NULL;
+	control->running	= false;
+	control->pending	= false;
+	control->generation	= 0;
+	control->retire		= false;
+	control->failed		= false;
+	control->ready		= false;
+
+	char commandName[UW_CONTROL_NAME_LENGTH + 32];
+	for(int i = 0; i < UW_CONTROL_COMMANDS; i++) {
+		snprintf(commandName, sizeof(commandName), "%s/%s", commandPrefix, sCommandNames[i]);
+		control->commands[i] = XPLMCreateCommand(commandName, sCommandDescriptions[i]);
+		XPLMRegisterCommandHandler(control->commands[i], HandleCommand, 1, control);
+	}
+
+	//a submenu of Plugins, one item per command in the order of UWControlCommand
+	XPLMMenuID pluginsMenu = XPLMFindPluginsMenu();
+	int pluginsItem = XPLMAppendMenuItem(pluginsMenu, control->name, NULL, 1);
+	control->menu = XPLMCreateMenu(control->name, pluginsMenu, pluginsItem, HandleMenu, control);
+	XPLMAppendMenuItem(control->menu, "Port up", (void *)(intptr_t)uwControl_PortUp, 1);
+	XPLMAppendMenuItem(control->menu, "Port down", (void *)(intptr_t)uwControl_PortDown, 1);
+	XPLMAppendMenuItem(control->menu, "Receive rate up", (void *)(intptr_t)uwControl_RateUp, 1);
+	XPLMAppendMenuItem(control->menu, "Receive rate down", (void *)(intptr_t)uwControl_RateDown, 1);
+	XPLMAppendMenuItem(control->menu, "Epoch delay up", (void *)(intptr_t)uwControl_DelayUp, 1);
+	XPLMAppendMenuItem(control->menu, "Epoch delay down", (void *)(intptr_t)uwControl_DelayDown, 1);
+	XPLMAppendMenuItem(control->menu, "Next source", (void *)(intptr_t)uwControl_NextSource, 1);
+	UpdateMenu(control);
+}
+
+
+
+/*
+Start listening: the thread opens the source the settings describe, and UWControlTakeSource hands it to the flight
+loop once it is open
+*/
+void UWControlStart(UWSourceControl * control)
+{
+	if(control->listening) {
+		return;
+	}
+	control->listening = true;
+
+	{
+		lock_guard<mutex> lock(control->mutex);
+		control->wanted		= *control->settings;
+		control->pending	= true;
+		control->generation++;
+		control->retire		= false;
+		control->ready		= false;
+		control->running	= true;
+	}
+	control->thread = new thread(RebindSources, control);
+}
+
+
+
+/*
+Stop listening: stop the thread and close both sources
+*/
+void UWControlStop(UWSourceControl * control)
+{
+	if(!control->listening) {
+		return;
+	}
+	control->listening = false;
+
+	{
+		lock_guard<mutex> lock(control->mutex);
+		control->running = false;
+	}
+	control->wake.notify_one();
+	control->thread->join();
+	delete control->thread;
+	control->thread = NULL;
+
+	UWSourceClose(control->active);
+	UWSourceClose(control->spare);
+	control->pending	= false;
+	control->retire		= false;
+	control->ready		= false;
+}
+
+
+
+/*
+Remove the commands and the menu (called from XPluginStop, after UWControlStop)
+*/
+void UWControlDestroy(UWSourceControl * control)
+{
+	for(int i = 0; i < UW_CONTROL_COMMANDS; i++) {
+		XPLMUnregisterCommandHandler(control->commands[i], HandleCommand, 1, control);
+	}
+	XPLMDestroyMenu(control->menu);
+}
+
+
+
+/*
+The source the flight loop reads this frame.  Called at the start of every flight loop: swaps to the source the
+thread opened, if it is ready (which costs a pointer swap and, once per swap, a lock the thread never holds for
+long).
+*/
+UWPoseSource * UWControlTakeSource(UWSourceControl * control)
+{
+	if(!control->ready.load(memory_order_acquire)) {
+		return control->active;
+	}
+
+	bool failed;
+	{
+		lock_guard<mutex> lock(control->mutex);
+		failed = control->failed;
+		if(!failed) {
+			UWPoseSource * source	= control->active;
+			control->active			= control->spare;
+			control->spare			= source;
+			control->rebinds++;
+		}
+		control->retire		= true;
+		control->pending	= false;
+		control->ready		= false;
+	}
+	control->wake.notify_one();
+
+	if(failed) {
+		char source[UW_SOURCE_DESCRIPTION_LENGTH];
+		char message[UW_CONTROL_NAME_LENGTH + UW_SOURCE_DESCRIPTION_LENGTH + 64];
+		UWSourceDescribe(control->settings, source);
+		snprintf(message, sizeof(message), "%s: unable to open the pose source (%s)\n", control->name, source);
+		XPLMDebugString(message);
+
+		//keep reading the old source, and show its settings again
+		if(UWSourceIsOpen(control->active)) {
+			*control->settings = control->active->settings;
+			UpdateMenu(control);
+		}
+	}
+	UWOverlayInvalidate(control->overlay);
+	return control->active;
+}
+
+
+
+/*
+The interval for the flight loop to return when it is not needed every frame
+*/
+float UWControlInterval(const UWSourceControl * control)
+{
+	return (control->receiveRate > 0.0) ? (float)(1.0 / control->receiveRate) : -1.0f;
+}
+
+
+
+/*
+One line with the receive rate and the epoch delay for the overlay.  outText must hold at least
+UW_CONTROL_DESCRIPTION_LENGTH characters.
+*/
+void UWControlDescribe(const UWSourceControl * control, char * outText)
+{
+	char rate[16];
+	if(control->receiveRate > 0.0) {
+		sprintf(rate, "%.0f Hz", control->receiveRate);
+	} else {
+		sprintf(rate, "every frame");
+	}
+	sprintf(outText, "Receive rate %s, epoch delay %.0f ms, %lld sources opened", rate,
+			1000.0 * control->epoch->delay, control->rebinds);
+}
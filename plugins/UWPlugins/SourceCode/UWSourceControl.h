@@ -0,0 +1,110 @@
+/*
+UWSourceControl.h
+
+Runtime control of the timed processing plugins, so the port, the receive rate, the epoch delay and the transport can
+be tuned without recompiling or restarting X-Plane.  Each is changed by a command (XPLMCreateCommand, so it can be
+bound to a key or a joystick button), named after the plugin's prefix (e.g. uw/timed_processing_udp/port_up)
+
+	port_up, port_down			the UDP or TCP port (and the default unix_path, which is named after it)
+	rate_up, rate_down			how often the flight loop drains the source (UW_CONTROL_RATES)
+	delay_up, delay_down		epoch_delay, in steps of UW_CONTROL_DELAY_STEP (see UWEpochApply.h)
+	next_source					udp, tcp, unix (not on Windows) and shm in turn (see UWPoseSource.h)
+
+and the plugin's menu under Plugins runs the same commands, showing the current values in its items.
+
+The rate and the delay take effect at the next flight loop.  A new port or transport means a new socket, which may
+take long enough to open (binding, joining a multicast group, listening) to cost a frame, so it is never opened on
+X-Plane's main thread: the control owns two sources, and while the plugin is listening a thread of its own opens the
+new one beside the one being read.  UWControlTakeSource, called at the start of every flight loop, swaps to the new
+source as soon as it is open (a pointer swap) and hands the old one back to the thread to close.  If the new source
+cannot be opened the plugin keeps reading the old one and the settings go back to the old source's.  Starting to
+listen opens the source on the thread in the same way, so the first poses are read a frame or two later.
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	receive_rate		flight loop calls per second draining the source (default 20, 0 for every frame)
+*/
+
+#ifndef _UWSourceControl_h_
+#define _UWSourceControl_h_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "XPLMMenus.h"
+#include "XPLMUtilities.h"
+
+#include "UWPluginConfig.h"
+#include "UWPoseSource.h"
+#include "UWEpochApply.h"
+#include "UWStatusOverlay.h"
+
+#define UW_CONTROL_NAME_LENGTH			64
+#define UW_CONTROL_DESCRIPTION_LENGTH	80			//see UWControlDescribe
+#define UW_CONTROL_RATES				{ 5.0, 10.0, 20.0, 30.0, 60.0, 0.0 }	//rate_up steps, 0 is every frame
+#define UW_CONTROL_DEFAULT_RATE			20.0
+#define UW_CONTROL_DELAY_STEP			0.01		//seconds
+#define UW_CONTROL_MAX_DELAY			0.5
+
+enum UWControlCommand {
+	uwControl_PortUp,
+	uwControl_PortDown,
+	uwControl_RateUp,
+	uwControl_RateDown,
+	uwControl_DelayUp,
+	uwControl_DelayDown,
+	uwControl_NextSource,
+	UW_CONTROL_COMMANDS
+};
+
+struct UWSourceControl {
+	char					name[UW_CONTROL_NAME_LENGTH];	//plugin name, for the menu and the log
+	UWPoseSourceSettings *	settings;				//the plugin's settings, which the commands change
+	UWEpochApply *			epoch;
+	UWStatusOverlay *		overlay;				//refreshed when a setting changes
+	double					receiveRate;			//Hz, 0 for every frame
+
+	XPLMCommandRef			commands[UW_CONTROL_COMMANDS];
+	XPLMMenuID				menu;
+
+	//flight loop only
+	UWPoseSource			sources[2];
+	UWPoseSource *			active;					//the source the flight loop reads
+	UWPoseSource *			spare;					//the source the thread opens and closes
+	bool					listening;
+	long long				rebinds;				//sources opened and swapped in
+
+	//shared with the thread
+	std::thread *			thread;					//running while the plugin is listening
+	std::mutex				mutex;					//guards the rest
+	std::condition_variable	wake;
+	bool					running;
+	bool					pending;				//wanted is to be opened in spare
+	UWPoseSourceSettings	wanted;
+	unsigned int			generation;				//changed with every request, so stale opens are not used
+	bool					retire;					//spare holds the old source, to be closed
+	bool					failed;					//wanted could not be opened
+	std::atomic<bool>		ready;					//spare holds wanted, opened (or failed), for the flight loop
+};
+
+
+
+void			UWControlInit(UWSourceControl * control, const char * name, const char * commandPrefix,
+							  const UWPluginConfig * config, UWPoseSourceSettings * settings, UWEpochApply * epoch,
+							  UWStatusOverlay * overlay);
+
+void			UWControlStart(UWSourceControl * control);
+
+void			UWControlStop(UWSourceControl * control);
+
+void			UWControlDestroy(UWSourceControl * control);
+
+UWPoseSource *	UWControlTakeSource(UWSourceControl * control);
+
+float			UWControlInterval(const UWSourceControl * control);
+
+void			UWControlDescribe(const UWSourceControl * control, char * outText);
+
+#endif
@@ -0,0 +1,146 @@
+/*
+UWStatusOverlay.cpp
+
+See UWStatusOverlay.h
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "XPLMGraphics.h"
+#include "XPLMProcessing.h"
+
+#include "UWStatusOverlay.h"
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWOverlayInit(UWStatusOverlay * overlay, double refreshRate)
+{
+	overlay->refreshInterval	= (refreshRate > 0.0) ? 1.0 / refreshRate : 0.0;
+	overlay->nextRefresh		= 0.0;
+	overlay->invalid			= true;
+
+	for(int i = 0; i < UW_OVERLAY_MAX_LINES; i++) {
+		overlay->lines[i].text[0]	= '\0';
+		overlay->lines[i].hasValue	= false;
+	}
+	overlay->numLines			= 0;
+	overlay->overflow.hasValue	= false;
+
+	overlay->refreshes	= 0;
+	overlay->draws		= 0;
+}
+
+
+
+/*
+Refresh the text at the next draw (e.g. after a hot key changed what is shown)
+*/
+void UWOverlayInvalidate(UWStatusOverlay * overlay)
+{
+	overlay->invalid = true;
+}
+
+
+
+/*
+Returns true if the text is due to be formatted, in which case the caller sets its lines before UWOverlayDraw.
+Returns false if the lines kept from the last refresh are still current.
+*/
+bool UWOverlayBeginRefresh(UWStatusOverlay * overlay)
+{
+	double now = XPLMGetElapsedTime();
+	if(!overlay->invalid && now < overlay->nextRefresh) {
+		return false;
+	}
+
+	overlay->invalid		= false;
+	overlay->nextRefresh	= now + overlay->refreshInterval;
+	overlay->refreshes++;
+	return true;
+}
+
+
+
+static UWOverlayLine * GetLine(UWStatusOverlay * overlay, int line)
+{
+	if(line < 1 || line > UW_OVERLAY_MAX_LINES) {
+		return &overlay->overflow;
+	}
+	if(line > overlay->numLines) {
+		overlay->numLines = line;
+	}
+	return &overlay->lines[line - 1];
+}
+
+
+
+/*
+The buffer of a line (numbered from 1, as the lines of the window), UW_OVERLAY_LINE_LENGTH characters long, for a
+Describe function to write into
+*/
+char * UWOverlayText(UWStatusOverlay * overlay, int line)
+{
+	UWOverlayLine * overlayLine = GetLine(overlay, line);
+	overlayLine->hasValue = false;
+	return overlayLine->text;
+}
+
+
+
+void UWOverlaySetText(UWStatusOverlay * overlay, int line, const char * text)
+{
+	char * lineText = UWOverlayText(overlay, line);
+	strncpy(lineText, text, UW_OVERLAY_LINE_LENGTH - 1);
+	lineText[UW_OVERLAY_LINE_LENGTH - 1] = '\0';
+}
+
+
+
+void UWOverlayPrintf(UWStatusOverlay * overlay, int line, const char * format, ...)
+{
+	va_list arguments;
+	va_start(arguments, format);
+	vsnprintf(UWOverlayText(overlay, line), UW_OVERLAY_LINE_LENGTH, format, arguments);
+	va_end(arguments);
+}
+
+
+
+/*
+A line reading "label is value", formatted only if the value changed since the line was last set
+*/
+void UWOverlaySetValue(UWStatusOverlay * overlay, int line, const char * label, double value)
+{
+	UWOverlayLine * overlayLine = GetLine(overlay, line);
+	if(overlayLine->hasValue && overlayLine->value == value) {
+		return;
+	}
+
+	snprintf(overlayLine->text, UW_OVERLAY_LINE_LENGTH, "%s is %f", label, value);
+	overlayLine->value		= value;
+	overlayLine->hasValue	= true;
+}
+
+
+
+/*
+Draw the dark box of the window and the lines kept from the last refresh (called from the window's draw callback)
+*/
+void UWOverlayDraw(UWStatusOverlay * overlay, XPLMWindowID window)
+{
+	int		left, top, right, bottom;
+	float	color[] = { 1.0, 1.0, 1.0 }; 	/* RGB White */
+
+	XPLMGetWindowGeometry(window, &left, &top, &right, &bottom);
+	XPLMDrawTranslucentDarkBox(left, top, right, bottom);
+
+	for(int i = 0; i < overlay->numLines; i++) {
+		if(overlay->lines[i].text[0] != '\0') {
+			XPLMDrawString(color, left + 5, top - (i + 1)*UW_OVERLAY_LINE_SPACING, overlay->lines[i].text, NULL,
+						   xplmFont_Basic);
+		}
+	}
+	overlay->draws++;
+}
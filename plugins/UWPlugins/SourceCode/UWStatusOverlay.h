@@ -0,0 +1,69 @@
+/*
+UWStatusOverlay.h
+
+The text of a plugin's status window, formatted at a capped rate rather than on every draw.
+
+The window's draw callback asks UWOverlayBeginRefresh whether the text is due; only then does it read the datarefs
+and format its lines, which it writes into the overlay's own line buffers (UWOverlaySetText, UWOverlayPrintf,
+UWOverlaySetValue, or straight into UWOverlayText with a Describe function).  UWOverlayDraw then draws the lines
+kept from the last refresh, skipping empty ones, so a draw between refreshes costs the dark box and one
+XPLMDrawString per line and nothing else.  Dataref lines (UWOverlaySetValue) are only formatted again when their
+value changed.  All of the work is done from the draw callback, which X-Plane does not call while the window is
+hidden, so a hidden overlay costs nothing.
+
+The text is refreshed at most refreshRate times a second (the values shown change at about 20 Hz, and nobody reads
+faster than that), and right away after UWOverlayInvalidate (e.g. when a hot key or a click changes what is shown).
+The plugins with a config file take the rate from it (see UWPluginConfig.h)
+
+	overlay_rate		refreshes of the status window's text per second (default UW_OVERLAY_REFRESH_RATE, 0 to
+						refresh on every draw)
+*/
+
+#ifndef _UWStatusOverlay_h_
+#define _UWStatusOverlay_h_
+
+#include "XPLMDisplay.h"
+
+#define UW_OVERLAY_MAX_LINES		32
+#define UW_OVERLAY_LINE_LENGTH		300			//characters per line, at least every *_DESCRIPTION_LENGTH
+#define UW_OVERLAY_LINE_SPACING		10			//pixels
+#define UW_OVERLAY_REFRESH_RATE		10.0		//default refreshes per second
+
+struct UWOverlayLine {
+	char			text[UW_OVERLAY_LINE_LENGTH];
+	double			value;						//last value formatted by UWOverlaySetValue
+	bool			hasValue;
+};
+
+struct UWStatusOverlay {
+	double			refreshInterval;			//seconds, 0 to refresh on every draw
+	double			nextRefresh;				//XPLMGetElapsedTime the text is due
+	bool			invalid;					//refresh at the next draw, whenever it is
+
+	UWOverlayLine	lines[UW_OVERLAY_MAX_LINES];
+	int				numLines;					//highest line set
+	UWOverlayLine	overflow;					//lines past UW_OVERLAY_MAX_LINES go here and are never drawn
+
+	long long		refreshes;
+	long long		draws;
+};
+
+
+
+void		UWOverlayInit(UWStatusOverlay * overlay, double refreshRate);
+
+void		UWOverlayInvalidate(UWStatusOverlay * overlay);
+
+bool		UWOverlayBeginRefresh(UWStatusOverlay * overlay);
+
+char *		UWOverlayText(UWStatusOverlay * overlay, int line);
+
+void		UWOverlaySetText(UWStatusOverlay * overlay, int line, const char * text);
+
+void		UWOverlayPrintf(UWStatusOverlay * overlay, int line, const char * format, ...);
+
+void		UWOverlaySetValue(UWStatusOverlay * overlay, int line, const char * label, double value);
+
+void		UWOverlayDraw(UWStatusOverlay * overlay, XPLMWindowID window);
+
+#endif
@@ -0,0 +1,395 @@
+/*
+UWStreamedEntities.cpp
+
+This plugin draws the other entities of an external simulation (traffic, ground vehicles, people, ...) in X-Plane.
+The simulation streams their poses over a UDP socket (see UWEntityProtocol.h for the packet layout) and the
+plugin draws every entity with the object of its model, listed in UWStreamedEntitiesConfig.txt in the X-System
+folder (see UWEntityModels.h).
+
+The entities are drawn as instances: all of the entities of one model are drawn with one XPLMDrawObjects call per
+frame, from arrays which are packed every frame with the entities in view (see UWEntityTable.h), so thousands of
+entities cost a handful of draw calls.  The objects are loaded asynchronously, so the sim never stops to load them.
+The entities are kept in a spatial index (see UWEntityGrid.h), so entities out of view or beyond cull_distance cost
+nothing, and the far ones are updated less often (see UWEntityCulling.h).
+
+With traffic on, the entities nearest the camera are handed to X-Plane's multiplayer aircraft, whose AI is turned
+off (see UWEntityTraffic.h).  The aircraft are loaded one at a time by a flight loop of their own, never by the
+flight loop which moves the entities every frame.
+
+The same config file chooses the transport (source, port, ... see UWPoseSource.h; the default is UDP on port
+49005), the entity limits (see UWEntityTable.h), the culling distances (see UWEntityCulling.h), the size of the
+spatial index's cells (see UWEntityGrid.h) and the traffic settings (see UWEntityTraffic.h).
+
+*/
+
+
+#if APL
+#if defined(__MACH__)
+#include <Carbon/Carbon.h>
+#endif
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "XPLMProcessing.h"
+#include "XPLMDataAccess.h"
+#include "XPLMUtilities.h"
+#include "XPLMGraphics.h"
+#include "XPLMDisplay.h"
+
+#include "UWClock.h"
+#include "UWPluginConfig.h"
+#include "UWPoseSource.h"
+#include "UWEntityModels.h"
+#include "UWEntityTable.h"
+#include "UWEntityTraffic.h"
+#include "UWStatusOverlay.h"
+
+//----------------------------GLOBAL VARIALBES----------------------------------------
+#define UDP_PORT_RECEIVE 49005					//default port to listen to to receive entity packets
+#define UDP_RECEIVE_BUFFER (1 << 20)			//default receive buffer, for the packets of thousands of entities arriving at once
+#define CONFIG_FILE "UWStreamedEntitiesConfig.txt"	//optional config file in the X-System folder (see UWPluginConfig.h)
+
+XPLMWindowID	gWindow = NULL;					//for displaying plugin status
+XPLMHotKeyID	gHotKey = NULL;					//used to register our hotkey
+int				gClicked = 0;					//used to determine if user is clicking in the window or not
+UWStatusOverlay	gOverlay;						//text of the status window (see UWStatusOverlay.h)
+bool			gListeningForUDPPackets;		//set this to true to start listening for UDP packets
+bool			gDisplayOverlay = false;		//set this to true to display the overlay on the X-Plane window which shows plugin information (useful for debugging).
+
+UWPoseSourceSettings	gSourceSettings;		//which transport to listen on (from the config file)
+UWPoseSource	gSource;						//open while we are listening (never blocks)
+UWSourceMessage	gMessage;						//the message being processed
+UWEntityModels	gModels;						//the objects the entities are drawn with (see UWEntityModels.h)
+UWEntityTable	gEntities;						//the entities and their packed draw arrays (see UWEntityTable.h)
+UWEntityTraffic	gTraffic;						//the multiplayer aircraft standing for the nearest entities
+XPLMDataRef		gLightsOnRef = NULL;			//sim/graphics/scenery/percent_lights_on (the objects' night lighting)
+double			gDrawSeconds = 0.0;				//time taken by the last draw callback
+
+
+
+
+//----------------------------FUNCTION PROTOTYPES-------------------------------------
+int		MyDrawEntitiesCallback(
+                                   XPLMDrawingPhase     inPhase,
+                                   int                  inIsBefore,
+                                   void *               inRefcon);
+
+void MyDrawWindowCallback(
+                                   XPLMWindowID         inWindowID,
+                                   void *               inRefcon);
+
+
+void MyHandleKeyCallback(
+                                   XPLMWindowID         inWindowID,
+                                   char                 inKey,
+                                   XPLMKeyFlags         inFlags,
+                                   char                 inVirtualKey,
+                                   void *               inRefcon,
+                                   int                  losingFocus);
+
+int MyHandleMouseClickCallback(
+                                   XPLMWindowID         inWindowID,
+                                   int                  x,
+                                   int                  y,
+                                   XPLMMouseStatus      inMouse,
+                                   void *               inRefcon);
+
+
+void	MyHotKeyCallback(void *               inRefcon);
+
+float	MyFlightLoopCallback(
+                                   float                inElapsedSinceLastCall,
+                                   float                inElapsedTimeSinceLastFlightLoop,
+                                   int                  inCounter,
+                                   void *               inRefcon);
+
+float	MyLoadAircraftCallback(
+                                   float                inElapsedSinceLastCall,
+                                   float                inElapsedTimeSinceLastFlightLoop,
+                                   int                  inCounter,
+                                   void *               inRefcon);
+
+
+
+//-------------------IMPLEMENT THE X-PLANE PLUGIN INTERFACE---------------------------
+PLUGIN_API int XPluginStart(
+						char *		outName,
+						char *		outSig,
+						char *		outDesc)
+{
+	strcpy(outName, "UWStreamedEntities");
+	strcpy(outSig, "xplanesdk.examples.UWStreamedEntities");
+	strcpy(outDesc, "A plugin that listens to UDP packets and draws the entities of an external simulation.");
+
+	//Start up with listening for packets turned off
+	gListeningForUDPPackets = false;
+
+	//read the transport, model and entity settings (everything is allocated here, once)
+	UWPluginConfig config;
+	UWConfigLoad(&config, CONFIG_FILE);
+	UWSourceReadSettings(&gSourceSettings, &config, UDP_PORT_RECEIVE);
+	gSourceSettings.receiveBuffer = UWConfigGetInt(&config, "receive_buffer", UDP_RECEIVE_BUFFER);
+	UWSourceInit(&gSource);
+	UWEntityModelsReadSettings(&gModels, &config);
+	UWEntityTableInit(&gEntities, &config, gModels.numModels);
+	UWEntityTrafficInit(&gTraffic, &config, gEntities.capacity);
+
+	gLightsOnRef = XPLMFindDataRef("sim/graphics/scenery/percent_lights_on");
+
+	UWOverlayInit(&gOverlay, UWConfigGetDouble(&config, "overlay_rate", UW_OVERLAY_REFRESH_RATE));
+
+	if(gDisplayOverlay) {
+		int topLeftX = 725 - 2*350;
+		int topLeftY = 440 - 225;
+
+		int width = 300;
+		int height = 90;
+		gWindow = XPLMCreateWindow(
+			topLeftX, topLeftY, topLeftX+width, topLeftY-height,			/* Area of the window. */
+			1,							/* Start visible. */
+			MyDrawWindowCallback,		/* Callbacks */
+			MyHandleKeyCallback,
+			MyHandleMouseClickCallback,
+			NULL);						/* Refcon - not used. */
+	}
+
+	/* Register our hot key for toggling listening. */
+	gHotKey = XPLMRegisterHotKey(XPLM_VK_F3, xplm_DownFlag,
+		"Toggle listening/stop listening for entity packets",
+		MyHotKeyCallback,
+		NULL);
+
+	/* The entities are drawn with the scenery objects */
+	XPLMRegisterDrawCallback(MyDrawEntitiesCallback, xplm_Phase_Objects, 0, NULL);
+
+	/* Called every frame, so every entity moves every frame */
+	XPLMRegisterFlightLoopCallback(MyFlightLoopCallback, -1.0f, NULL);
+
+	/* Loads the traffic's aircraft, one at a time */
+	XPLMRegisterFlightLoopCallback(MyLoadAircraftCallback, (float)gTraffic.loadInterval, NULL);
+
+	return 1;
+}
+
+
+
+PLUGIN_API void	XPluginStop(void)
+{
+	XPLMUnregisterFlightLoopCallback(MyFlightLoopCallback, NULL);
+	XPLMUnregisterFlightLoopCallback(MyLoadAircraftCallback, NULL);
+	XPLMUnregisterDrawCallback(MyDrawEntitiesCallback, xplm_Phase_Objects, 0, NULL);
+
+	UWSourceClose(&gSource);
+	UWEntityModelsUnload(&gModels);
+	UWEntityTrafficStop(&gTraffic, &gEntities);
+	UWEntityTableStop(&gEntities);
+}
+
+
+
+PLUGIN_API void XPluginDisable(void)
+{
+	//X-Plane takes the aircraft back from a disabled plugin
+	UWEntityTrafficRelease(&gTraffic, &gEntities);
+}
+
+
+
+PLUGIN_API int XPluginEnable(void)
+{
+	if(gListeningForUDPPackets) {
+		UWEntityTrafficAcquire(&gTraffic);
+	}
+	return 1;
+}
+
+
+
+PLUGIN_API void XPluginReceiveMessage(
+					XPLMPluginID	inFromWho,
+					long			inMessage,
+					void *			inParam)
+{
+}
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+/*
+Apply every entity packet waiting on the source and move the entities to where they are this frame
+*/
+float	MyFlightLoopCallback(
+                                   float                inElapsedSinceLastCall,
+                                   float                inElapsedTimeSinceLastFlightLoop,
+                                   int                  inCounter,
+                                   void *               inRefcon)
+{
+	if(gListeningForUDPPackets && UWSourceIsOpen(&gSource)) {
+		double now = XPLMGetElapsedTime();
+
+		//drain everything which is waiting on the source (it is non-blocking so this never waits)
+		while(UWSourceReceive(&gSource, &gMessage) != uwMessage_None) {
+			if(gMessage.kind == uwMessage_Packet && UWEntityIsPacket(gMessage.packet, gMessage.length)) {
+				UWEntityTableApplyPacket(&gEntities, gMessage.packet, gMessage.length, now);
+			}
+		}
+
+		//only the entities which changed are converted to local coordinates
+		UWEntityTableStep(&gEntities, now);
+		UWEntityTrafficStep(&gTraffic, &gEntities, now);
+	}
+
+	return -1.0f;
+}
+
+
+
+/*
+Load the aircraft one traffic slot is waiting for (if any).  Loading an aircraft stops the sim until it is loaded,
+so it is done here, every aircraft_load_interval seconds, and not in MyFlightLoopCallback.
+*/
+float	MyLoadAircraftCallback(
+                                   float                inElapsedSinceLastCall,
+                                   float                inElapsedTimeSinceLastFlightLoop,
+                                   int                  inCounter,
+                                   void *               inRefcon)
+{
+	UWEntityTrafficLoadAircraft(&gTraffic);
+	return (float)gTraffic.loadInterval;
+}
+
+
+
+/*
+Draw every entity, one XPLMDrawObjects call per model
+*/
+int		MyDrawEntitiesCallback(
+                                   XPLMDrawingPhase     inPhase,
+                                   int                  inIsBefore,
+                                   void *               inRefcon)
+{
+	double start = UWClockMonotonicSeconds();
+
+	int lighting = (gLightsOnRef != NULL && XPLMGetDataf(gLightsOnRef) > 0.0f) ? 1 : 0;
+	UWEntityTableDraw(&gEntities, &gModels, lighting);
+
+	gDrawSeconds = UWClockMonotonicSeconds() - start;
+	return 1;
+}
+
+
+
+/*
+ * MyDrawingWindowCallback
+ *
+ * This callback does the work of drawing our window once per sim cycle each time
+ * it is needed.
+ *
+ */
+void MyDrawWindowCallback(
+                                   XPLMWindowID         inWindowID,
+                                   void *               inRefcon)
+{
+	//format the text only when it is due, and draw the lines kept from the last refresh (see UWStatusOverlay.h)
+	if(UWOverlayBeginRefresh(&gOverlay)) {
+		//Line 1 (display plugin info)
+		UWOverlaySetText(&gOverlay, 1, gClicked ? "You are clicking here" : "UWStreamedEntities");
+
+		//Line 2 (plugin instructions)
+		UWOverlaySetText(&gOverlay, 2, "Press F3 to toggle listening on/off");
+
+		//Line 3 (display status of listening or not)
+		UWOverlaySetText(&gOverlay, 3, gListeningForUDPPackets ? "Currently listening for entity packets"
+															   : "Currently not listening for entity packets");
+
+		//Line 4 (display where the entities are read from)
+		UWSourceDescribe(&gSourceSettings, UWOverlayText(&gOverlay, 4));
+
+		//Line 5 (display the models)
+		UWEntityModelsDescribe(&gModels, UWOverlayText(&gOverlay, 5));
+
+		//Line 6 (display the entities)
+		UWEntityTableDescribe(&gEntities, UWOverlayText(&gOverlay, 6));
+
+		//Line 7 (display the time taken drawing)
+		UWOverlayPrintf(&gOverlay, 7, "Drawn in %.2f ms", 1000.0*gDrawSeconds);
+
+		//Line 8 (display the traffic)
+		UWEntityTrafficDescribe(&gTraffic, UWOverlayText(&gOverlay, 8));
+	}
+
+	UWOverlayDraw(&gOverlay, inWindowID);
+}
+
+
+
+/*
+Toggle listening for entity packets.  The models start loading the first time we listen, and the multiplayer
+aircraft are taken (with traffic on).  When we stop listening the aircraft are given back and the entities are
+removed.
+*/
+void	MyHotKeyCallback(void *               inRefcon)
+{
+	//show what the hot key changed right away
+	UWOverlayInvalidate(&gOverlay);
+
+	if(gListeningForUDPPackets) {
+		gListeningForUDPPackets = false;
+
+		UWSourceClose(&gSource);
+		UWEntityTrafficRelease(&gTraffic, &gEntities);
+		UWEntityTableClear(&gEntities);
+
+	} else {
+		gListeningForUDPPackets = true;
+
+		if(!UWSourceOpen(&gSource, &gSourceSettings)) {
+			XPLMDebugString("UWStreamedEntities: unable to open the entity source\n");
+		}
+		UWEntityModelsLoad(&gModels);
+		UWEntityTrafficAcquire(&gTraffic);
+	}
+}
+
+
+
+/*
+ * MyHandleKeyCallback
+ *
+ * Our key handling callback does nothing in this plugin.
+ *
+ */
+void MyHandleKeyCallback(
+                                   XPLMWindowID         inWindowID,
+                                   char                 inKey,
+                                   XPLMKeyFlags         inFlags,
+                                   char                 inVirtualKey,
+                                   void *               inRefcon,
+                                   int                  losingFocus)
+{
+}
+
+
+
+/*
+ * MyHandleMouseClickCallback
+ *
+ * Our mouse click callback toggles the status of our mouse variable
+ * as the mouse is clicked.
+ *
+ */
+int MyHandleMouseClickCallback(
+                                   XPLMWindowID         inWindowID,
+                                   int                  x,
+                                   int                  y,
+                                   XPLMMouseStatus      inMouse,
+                                   void *               inRefcon)
+{
+	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp)) {
+		gClicked = 1 - gClicked;
+		UWOverlayInvalidate(&gOverlay);
+	}
+
+	return 1;
+}
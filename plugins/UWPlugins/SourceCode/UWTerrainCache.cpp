@@ -0,0 +1,345 @@
+/*
+UWTerrainCache.cpp
+
+See UWTerrainCache.h
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "XPLMGraphics.h"
+
+#include "UWClock.h"
+#include "UWTerrainCache.h"
+
+#define METERS_PER_DEGREE	111320.0				//along a meridian (the lattice uses the same spacing in longitude)
+#define DEGREES_TO_RADIANS	(3.14159265358979323846 / 180.0)
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+static double GetHitRate(void * inRefcon)
+{
+	return UWTerrainHitRate((const UWTerrainCache *)inRefcon);
+}
+
+
+
+static int GetProbes(void * inRefcon)
+{
+	return (int)((const UWTerrainCache *)inRefcon)->probes;
+}
+
+
+
+static double GetProbeTime(void * inRefcon)
+{
+	const UWTerrainCache * cache = (const UWTerrainCache *)inRefcon;
+	return (cache->probes > 0) ? cache->probeSeconds / cache->probes : 0.0;
+}
+
+
+
+static double GetMaxProbeTime(void * inRefcon)
+{
+	return ((const UWTerrainCache *)inRefcon)->maxProbeSeconds;
+}
+
+
+
+static XPLMDataRef RegisterDataRef(const char * prefix, const char * name, XPLMDataTypeID type,
+								   XPLMGetDatai_f readInt, XPLMGetDatad_f readDouble, void * refcon)
+{
+	char dataRefName[256];
+	sprintf(dataRefName, "%.200s/%s", prefix, name);
+
+	return XPLMRegisterDataAccessor(dataRefName, type, 0,
+									readInt, NULL, NULL, NULL, readDouble, NULL,
+									NULL, NULL, NULL, NULL, NULL, NULL,
+									refcon, NULL);
+}
+
+
+
+/*
+Read the altitude mode, create the probe and register the datarefs
+*/
+void UWTerrainReadSettings(UWTerrainCache * cache, const UWPluginConfig * config, const char * dataRefPrefix)
+{
+	const char * mode = UWConfigGetString(config, "altitude_mode", "msl");
+	if(strcmp(mode, "agl") == 0) {
+		cache->mode = uwAltitude_AGL;
+	} else if(strcmp(mode, "clamp") == 0) {
+		cache->mode = uwAltitude_Clamp;
+	} else {
+		cache->mode = uwAltitude_MSL;
+	}
+
+	double spacingMeters = UWConfigGetDouble(config, "terrain_spacing", 10.0);
+	if(spacingMeters < 0.1) {
+		spacingMeters = 0.1;
+	}
+
+	cache->offset	= UWConfigGetDouble(config, "terrain_offset", 0.0);
+	cache->spacing	= spacingMeters / METERS_PER_DEGREE;
+	cache->maxAge	= UWConfigGetDouble(config, "terrain_max_age", 30.0);
+	cache->spacingMeters = spacingMeters;
+	cache->probe	= XPLMCreateProbe(xplm_ProbeY);
+	UWTerrainFlush(cache);
+
+	cache->lookups			= 0;
+	cache->hits				= 0;
+	cache->probes			= 0;
+	cache->probeMisses		= 0;
+	cache->probeSeconds		= 0.0;
+	cache->maxProbeSeconds	= 0.0;
+
+	cache->dataRefs[0] = RegisterDataRef(dataRefPrefix, "terrain_hit_rate", xplmType_Double, NULL, GetHitRate, cache);
+	cache->dataRefs[1] = RegisterDataRef(dataRefPrefix, "terrain_probes", xplmType_Int, GetProbes, NULL, cache);
+	cache->dataRefs[2] = RegisterDataRef(dataRefPrefix, "terrain_probe_time", xplmType_Double, NULL, GetProbeTime, cache);
+	cache->dataRefs[3] = RegisterDataRef(dataRefPrefix, "terrain_probe_time_max", xplmType_Double, NULL, GetMaxProbeTime, cache);
+}
+
+
+
+void UWTerrainStop(UWTerrainCache * cache)
+{
+	for(int i = 0; i < UW_TERRAIN_NUM_DATAREFS; i++) {
+		if(cache->dataRefs[i] != NULL) {
+			XPLMUnregisterDataAccessor(cache->dataRefs[i]);
+			cache->dataRefs[i] = NULL;
+		}
+	}
+
+	if(cache->probe != NULL) {
+		XPLMDestroyProbe(cache->probe);
+		cache->probe = NULL;
+	}
+}
+
+
+
+/*
+Forget every cached elevation (call it when X-Plane loads new scenery, i.e. on XPLM_MSG_SCENERY_LOADED)
+*/
+void UWTerrainFlush(UWTerrainCache * cache)
+{
+	for(int i = 0; i < UW_TERRAIN_CACHE_SIZE; i++) {
+		cache->entries[i].used = false;
+	}
+}
+
+
+
+/*
+Probe the terrain at a lattice point.  Returns false if the probe did not hit the terrain (e.g. the scenery there
+is not loaded), in which case nothing is cached.
+*/
+static bool ProbeLatticePoint(UWTerrainCache * cache, int latitudeIndex, int longitudeIndex, double now,
+							  UWTerrainEntry * entry)
+{
+	double local_x;
+	double local_y;
+	double local_z;
+	XPLMWorldToLocal(latitudeIndex*cache->spacing, longitudeIndex*cache->spacing, 0.0, &local_x, &local_y, &local_z);
+
+	XPLMProbeInfo_t info;
+	info.structSize = sizeof(info);
+
+	double start = UWClockMonotonicSeconds();
+	XPLMProbeResult result = XPLMProbeTerrainXYZ(cache->probe, (float)local_x, (float)local_y, (float)local_z, &info);
+	double seconds = UWClockMonotonicSeconds() - start;
+
+	cache->probes++;
+	cache->probeSeconds += seconds;
+	if(seconds > cache->maxProbeSeconds) {
+		cache->maxProbeSeconds = seconds;
+	}
+
+	if(result != xplm_ProbeHitTerrain) {
+		cache->probeMisses++;
+		return false;
+	}
+
+	double latitudeDeg;
+	double longitudeDeg;
+	XPLMLocalToWorld(info.locationX, info.locationY, info.locationZ, &latitudeDeg, &longitudeDeg, &entry->elevation);
+
+	entry->latitudeIndex	= latitudeIndex;
+	entry->longitudeIndex	= longitudeIndex;
+	entry->probeTime		= now;
+	entry->used				= true;
+	return true;
+}
+
+
+
+/*
+The terrain elevation at a lattice point, from the cache if it is there and not too old, otherwise probed (unless
+allowProbe is false).  A lattice point is looked for in up to UW_TERRAIN_CACHE_PROBES slots from the one it hashes
+to; if it is not there it takes the first free slot, or the oldest of those slots.
+*/
+static UWTerrainResult LatticeElevation(UWTerrainCache * cache, int latitudeIndex, int longitudeIndex, double now,
+										bool allowProbe, double * outElevation)
+{
+	cache->lookups++;
+
+	unsigned int hash = (unsigned int)latitudeIndex*73856093u ^ (unsigned int)longitudeIndex*19349663u;
+	UWTerrainEntry * replace = NULL;
+	for(int n = 0; n < UW_TERRAIN_CACHE_PROBES; n++) {
+		UWTerrainEntry * entry = &cache->entries[(hash + n) & (UW_TERRAIN_CACHE_SIZE - 1)];
+		if(!entry->used) {
+			replace = entry;		//lattice points are never removed one at a time, so it is not further on
+			break;
+		}
+
+		if(entry->latitudeIndex == latitudeIndex && entry->longitudeIndex == longitudeIndex) {
+			if(now - entry->probeTime <= cache->maxAge) {
+				cache->hits++;
+				*outElevation = entry->elevation;
+				return uwTerrain_Found;
+			}
+			replace = entry;		//probe it again in place
+			break;
+		}
+
+		if(replace == NULL || entry->probeTime < replace->probeTime) {
+			replace = entry;
+		}
+	}
+
+	if(!allowProbe) {
+		return uwTerrain_NotCached;
+	}
+	if(!ProbeLatticePoint(cache, latitudeIndex, longitudeIndex, now, replace)) {
+		return uwTerrain_NoTerrain;
+	}
+	*outElevation = replace->elevation;
+	return uwTerrain_Found;
+}
+
+
+
+/*
+The terrain elevation (meters above mean sea level) at a position, interpolated between the four lattice points
+around it, and optionally the normal of the interpolated surface in local coordinates (x east, y up, z south, as
+XPLMProbeInfo_t).  If allowProbe is false nothing is probed and uwTerrain_NotCached is returned unless all four
+lattice points are cached; such a lookup is not counted in the hit rate, since it will be made again.
+*/
+UWTerrainResult UWTerrainLookup(UWTerrainCache * cache, double latitudeDeg, double longitudeDeg, bool allowProbe,
+								double * outElevation, float * outNormal)
+{
+	if(cache->probe == NULL) {
+		return uwTerrain_NoTerrain;
+	}
+
+	double u = latitudeDeg / cache->spacing;
+	double v = longitudeDeg / cache->spacing;
+	int i = (int)floor(u);
+	int j = (int)floor(v);
+	double fu = u - i;
+	double fv = v - j;
+
+	double now = UWClockMonotonicSeconds();
+	double elevation[4];
+	int corners[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+	long long lookups = cache->lookups;
+	long long hits = cache->hits;
+	for(int k = 0; k < 4; k++) {
+		UWTerrainResult result = LatticeElevation(cache, i + corners[k][0], j + corners[k][1], now, allowProbe, &elevation[k]);
+		if(result == uwTerrain_NotCached) {
+			cache->lookups = lookups;
+			cache->hits = hits;
+		}
+		if(result != uwTerrain_Found) {
+			return result;
+		}
+	}
+
+	*outElevation = (1.0 - fu)*((1.0 - fv)*elevation[0] + fv*elevation[1]) + fu*((1.0 - fv)*elevation[2] + fv*elevation[3]);
+
+	if(outNormal != NULL) {
+		//slope of the interpolated surface to the north and to the east (the lattice is narrower east-west)
+		double north	= ((1.0 - fv)*(elevation[2] - elevation[0]) + fv*(elevation[3] - elevation[1])) / cache->spacingMeters;
+		double east		= ((1.0 - fu)*(elevation[1] - elevation[0]) + fu*(elevation[3] - elevation[2])) /
+						  (cache->spacingMeters * cos(latitudeDeg * DEGREES_TO_RADIANS));
+		double length	= sqrt(north*north + east*east + 1.0);
+		outNormal[0]	= (float)(-east / length);
+		outNormal[1]	= (float)(1.0 / length);
+		outNormal[2]	= (float)(north / length);
+	}
+	return uwTerrain_Found;
+}
+
+
+
+/*
+The terrain elevation (meters above mean sea level) at a position, probing X-Plane where it is not cached.  Returns
+false if the terrain could not be probed.
+*/
+bool UWTerrainElevation(UWTerrainCache * cache, double latitudeDeg, double longitudeDeg, double * outElevation)
+{
+	return UWTerrainLookup(cache, latitudeDeg, longitudeDeg, true, outElevation, NULL) == uwTerrain_Found;
+}
+
+
+
+/*
+Mean seconds per XPLMProbeTerrainXYZ call so far (UW_TERRAIN_PROBE_ESTIMATE before the first one), for callers which
+have to fit their probing into a time budget
+*/
+double UWTerrainProbeTime(const UWTerrainCache * cache)
+{
+	return (cache->probes > 0) ? cache->probeSeconds / cache->probes : UW_TERRAIN_PROBE_ESTIMATE;
+}
+
+
+
+/*
+The altitude above mean sea level to set, from the packet altitude and the altitude mode.  Where the terrain can not
+be probed the packet altitude is used as it is.
+*/
+double UWTerrainResolveAltitude(UWTerrainCache * cache, double latitudeDeg, double longitudeDeg, double altitude)
+{
+	if(cache->mode == uwAltitude_MSL) {
+		return altitude;
+	}
+
+	double terrain;
+	if(!UWTerrainElevation(cache, latitudeDeg, longitudeDeg, &terrain)) {
+		return altitude;
+	}
+	terrain += cache->offset;
+
+	if(cache->mode == uwAltitude_AGL) {
+		return terrain + altitude;
+	}
+	return (altitude < terrain) ? terrain : altitude;
+}
+
+
+
+double UWTerrainHitRate(const UWTerrainCache * cache)
+{
+	return (cache->lookups > 0) ? (double)cache->hits / cache->lookups : 0.0;
+}
+
+
+
+/*
+One line for the overlay, e.g. "Terrain agl 99.2% cached, probe 14.1 us (max 52.0 us)".  outText must hold
+UW_TERRAIN_DESCRIPTION_LENGTH characters.
+*/
+void UWTerrainDescribe(const UWTerrainCache * cache, char * outText)
+{
+	if(cache->mode == uwAltitude_MSL && cache->lookups == 0) {
+		strcpy(outText, "Altitude above mean sea level");
+		return;
+	}
+
+	const char * modeNames[] = { "msl", "agl", "clamp" };
+	sprintf(outText, "Terrain %s %.1f%% cached, probe %.1f us (max %.1f us)", modeNames[cache->mode],
+			100.0*UWTerrainHitRate(cache),
+			1e6*GetProbeTime((void *)cache), 1e6*cache->maxProbeSeconds);
+}
@@ -0,0 +1,108 @@
+/*
+UWTerrainCache.h
+
+Resolves the packet altitude against X-Plane's terrain, for an external simulation whose terrain model differs
+from X-Plane's mesh (otherwise the aircraft sinks into or floats above the ground during taxi and low passes).
+
+The terrain is probed with one XPLMProbeRef kept for the life of the plugin, at the points of a lattice in latitude
+and longitude (terrain_spacing meters apart), and the terrain elevation at a position is interpolated between the
+four lattice points around it.  The probed elevations are kept in a fixed size hash table keyed by lattice point,
+so while the aircraft (or any number of entities) moves about the same area a terrain lookup is a few hash lookups
+and X-Plane is only probed when a new lattice point comes into use.  Elevations are kept above mean sea level, so
+the cache stays valid when X-Plane moves its local origin, and the cache is emptied when new scenery is loaded
+(see UWTerrainFlush).  The same cache answers the terrain queries of the external simulation (see
+UWTerrainQuery.h).
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	altitude_mode		msl (the default: the packet altitude is above mean sea level and is set as it is), agl
+						(the packet altitude is above the terrain) or clamp (above mean sea level, but never below
+						the terrain)
+	terrain_offset		meters added to the terrain elevation, e.g. the height of the reference point above the
+						wheels (default 0)
+	terrain_spacing		meters between the probed lattice points (default 10)
+	terrain_max_age		seconds after which a cached elevation is probed again, as X-Plane pages in finer mesh
+						(default 30)
+
+The cache statistics are published as read-only datarefs
+
+	<prefix>/terrain_hit_rate		double	fraction of the lattice lookups found in the cache
+	<prefix>/terrain_probes			int		XPLMProbeTerrainXYZ calls
+	<prefix>/terrain_probe_time		double	mean seconds per XPLMProbeTerrainXYZ call
+	<prefix>/terrain_probe_time_max	double	seconds
+*/
+
+#ifndef _UWTerrainCache_h_
+#define _UWTerrainCache_h_
+
+#include "XPLMDataAccess.h"
+#include "XPLMScenery.h"
+
+#include "UWPluginConfig.h"
+
+#define UW_TERRAIN_CACHE_SIZE			4096		//lattice points kept (a power of 2)
+#define UW_TERRAIN_CACHE_PROBES			8			//slots searched for a lattice point before one is replaced
+#define UW_TERRAIN_NUM_DATAREFS			4
+#define UW_TERRAIN_DESCRIPTION_LENGTH	80			//see UWTerrainDescribe
+#define UW_TERRAIN_PROBE_ESTIMATE		50e-6		//seconds per probe assumed before the first one is timed
+
+enum UWAltitudeMode {
+	uwAltitude_MSL,
+	uwAltitude_AGL,
+	uwAltitude_Clamp
+};
+
+enum UWTerrainResult {
+	uwTerrain_Found,
+	uwTerrain_NoTerrain,							//the probe did not hit the terrain (e.g. the scenery is not loaded)
+	uwTerrain_NotCached								//only when probing is not allowed
+};
+
+struct UWTerrainEntry {
+	int				latitudeIndex;					//lattice point
+	int				longitudeIndex;
+	bool			used;
+	double			elevation;						//meters above mean sea level
+	double			probeTime;						//UWClockMonotonicSeconds when probed
+};
+
+struct UWTerrainCache {
+	UWAltitudeMode	mode;
+	double			offset;
+	double			spacing;						//degrees between lattice points
+	double			spacingMeters;					//along a meridian
+	double			maxAge;
+	XPLMProbeRef	probe;
+	UWTerrainEntry	entries[UW_TERRAIN_CACHE_SIZE];
+
+	long long		lookups;						//lattice points looked up
+	long long		hits;							//found in the cache
+	long long		probes;
+	long long		probeMisses;					//probes which did not hit the terrain
+	double			probeSeconds;					//total time spent in XPLMProbeTerrainXYZ
+	double			maxProbeSeconds;
+	XPLMDataRef		dataRefs[UW_TERRAIN_NUM_DATAREFS];
+};
+
+
+
+void		UWTerrainReadSettings(UWTerrainCache * cache, const UWPluginConfig * config, const char * dataRefPrefix);
+
+void		UWTerrainStop(UWTerrainCache * cache);
+
+void		UWTerrainFlush(UWTerrainCache * cache);
+
+UWTerrainResult	UWTerrainLookup(UWTerrainCache * cache, double latitudeDeg, double longitudeDeg, bool allowProbe,
+								double * outElevation, float * outNormal);
+
+bool		UWTerrainElevation(UWTerrainCache * cache, double latitudeDeg, double longitudeDeg, double * outElevation);
+
+double		UWTerrainResolveAltitude(UWTerrainCache * cache, double latitudeDeg, double longitudeDeg, double altitude);
+
+double		UWTerrainHitRate(const UWTerrainCache * cache);
+
+double		UWTerrainProbeTime(const UWTerrainCache * cache);
+
+void		UWTerrainDescribe(const UWTerrainCache * cache, char * outText);
+
+#endif
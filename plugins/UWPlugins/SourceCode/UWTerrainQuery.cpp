@@ -0,0 +1,196 @@
+/*
+UWTerrainQuery.cpp
+
+See UWTerrainQuery.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "UWClock.h"
+#include "UWTerrainQuery.h"
+
+using namespace std;
+
+
+
+//-------------------------FUNCTION DEFINITIONS---------------------------------------
+void UWTerrainQueryInit(UWTerrainQuery * query, const UWPluginConfig * config, UWTerrainCache * cache)
+{
+	query->cache		= cache;
+	query->budget		= UWConfigGetDouble(config, "terrain_query_budget", 0.5) / 1000.0;
+	query->first		= 0;
+	query->count		= 0;
+	query->answered		= 0;
+	query->points		= 0;
+	query->rejected		= 0;
+	query->totalLatency	= 0.0;
+	query->maxLatency	= 0.0;
+}
+
+
+
+/*
+Write a reply header with no points.  Returns the length of the reply.
+*/
+static int BuildEmptyReply(char * outReply, unsigned int requestId, UWTerrainReplyStatus status)
+{
+	UWTerrainReplyHeader header;
+	memcpy(header.magic, UW_TERRAIN_REPLY_MAGIC, 4);
+	header.requestId	= requestId;
+	header.count		= 0;
+	header.status		= (unsigned char)status;
+	header.reserved		= 0;
+	memcpy(outReply, &header, sizeof(header));
+	return sizeof(header);
+}
+
+
+
+/*
+Queue a query to be answered by UWTerrainQueryService.  If the query is malformed or the queue is full nothing is
+queued and the reply to send straight away is written to outReply (which must hold sizeof(UWTerrainReplyHeader)
+bytes); its length is returned.  Otherwise 0 is returned.
+*/
+int UWTerrainQueryPush(UWTerrainQuery * query, const char * packet, int length, const string & address,
+					   unsigned short port, char * outReply)
+{
+	UWTerrainQueryHeader header;
+	memcpy(&header, packet, sizeof(header));
+
+	if(header.count > UW_TERRAIN_QUERY_MAX_POINTS ||
+	   length != (int)(sizeof(UWTerrainQueryHeader) + header.count * sizeof(UWTerrainQueryPoint))) {
+		query->rejected++;
+		return BuildEmptyReply(outReply, header.requestId, uwTerrainReply_Malformed);
+	}
+
+	if(query->count == UW_TERRAIN_QUERY_MAX_BATCHES) {
+		query->rejected++;
+		return BuildEmptyReply(outReply, header.requestId, uwTerrainReply_Busy);
+	}
+
+	UWTerrainBatch * batch = &query->batches[(query->first + query->count) % UW_TERRAIN_QUERY_MAX_BATCHES];
+	batch->address		= address;
+	batch->port			= port;
+	batch->requestId	= header.requestId;
+	batch->count		= header.count;
+	batch->next			= 0;
+	batch->receiveTime	= UWClockMonotonicSeconds();
+	memcpy(batch->points, packet + sizeof(header), header.count * sizeof(UWTerrainQueryPoint));
+	query->count++;
+	return 0;
+}
+
+
+
+/*
+Answer one point of a query into its place in the reply
+*/
+static void AnswerPoint(UWTerrainQuery * query, const UWTerrainBatch * batch, bool allowProbe, UWTerrainResult * outResult)
+{
+	const UWTerrainQueryPoint * point = &batch->points[batch->next];
+
+	double elevation = 0.0;
+	float normal[3] = { 0.0f, 1.0f, 0.0f };
+	*outResult = UWTerrainLookup(query->cache, point->latitude, point->longitude, allowProbe, &elevation, normal);
+	if(*outResult == uwTerrain_NotCached) {
+		return;
+	}
+
+	UWTerrainReplyPoint answer;
+	answer.elevation	= elevation;
+	memcpy(answer.normal, normal, sizeof(normal));
+	answer.status		= (unsigned char)((*outResult == uwTerrain_Found) ? uwTerrainPoint_Found : uwTerrainPoint_NoTerrain);
+	memset(answer.reserved, 0, sizeof(answer.reserved));
+	memcpy(query->reply + sizeof(UWTerrainReplyHeader) + batch->next * sizeof(UWTerrainReplyPoint), &answer, sizeof(answer));
+}
+
+
+
+/*
+Answer the waiting queries, oldest first, until they are all answered or the budget is spent (see
+UWTerrainQuery.h), and send the reply of every query which has been answered completely.
+*/
+void UWTerrainQueryService(UWTerrainQuery * query, UWPoseSource * source)
+{
+	double start = UWClockMonotonicSeconds();
+	bool first = true;
+
+	while(query->count > 0) {
+		UWTerrainBatch * batch = &query->batches[query->first];
+
+		while(batch->next < batch->count) {
+			//X-Plane is only probed if the probes for the point (up to four lattice points) fit in the budget; if they
+			//do not, the point is answered only if it is cached, and is looked up again next time
+			double elapsed = UWClockMonotonicSeconds() - start;
+			if(!first && elapsed >= query->budget) {
+				return;
+			}
+
+			UWTerrainResult result;
+			bool allowProbe = first || elapsed + 4.0*UWTerrainProbeTime(query->cache) <= query->budget;
+			AnswerPoint(query, batch, allowProbe, &result);
+			if(result == uwTerrain_NotCached) {
+				return;
+			}
+
+			batch->next++;
+			first = false;
+		}
+
+		UWTerrainReplyHeader header;
+		memcpy(header.magic, UW_TERRAIN_REPLY_MAGIC, 4);
+		header.requestId	= batch->requestId;
+		header.count		= (unsigned short)batch->count;
+		header.status		= uwTerrainReply_OK;
+		header.reserved		= 0;
+		memcpy(query->reply, &header, sizeof(header));
+		UWSourceReply(source, query->reply, sizeof(header) + batch->count * sizeof(UWTerrainReplyPoint), batch->address,
+					  batch->port);
+
+		double latency = UWClockMonotonicSeconds() - batch->receiveTime;
+		query->answered++;
+		query->points += batch->count;
+		query->totalLatency += latency;
+		if(latency > query->maxLatency) {
+			query->maxLatency = latency;
+		}
+
+		query->first = (query->first + 1) % UW_TERRAIN_QUERY_MAX_BATCHES;
+		query->count--;
+	}
+}
+
+
+
+/*
+Drop the waiting queries (when the plugin stops listening)
+*/
+void UWTerrainQueryClear(UWTerrainQuery * query)
+{
+	query->first = 0;
+	query->count = 0;
+}
+
+
+
+/*
+Returns true if there are queries which have not been answered yet
+*/
+bool UWTerrainQueryIsWaiting(const UWTerrainQuery * query)
+{
+	return query->count > 0;
+}
+
+
+
+/*
+One line for the overlay, e.g. "Terrain queries 120 (3840 points), 1.20 ms mean (max 3.40 ms), 0 rejected".
+outText must hold UW_TERRAIN_QUERY_DESCRIPTION_LENGTH characters.
+*/
+void UWTerrainQueryDescribe(const UWTerrainQuery * query, char * outText)
+{
+	double meanLatency = (query->answered > 0) ? query->totalLatency / query->answered : 0.0;
+	sprintf(outText, "Terrain queries %lld (%lld points), %.2f ms mean (max %.2f ms), %lld rejected", query->answered,
+			query->points, 1000.0*meanLatency, 1000.0*query->maxLatency, query->rejected);
+}
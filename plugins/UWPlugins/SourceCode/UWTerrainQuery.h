@@ -0,0 +1,71 @@
+/*
+UWTerrainQuery.h
+
+Plugin side of the terrain queries (see UWTerrainQueryProtocol.h).  Queries received on the pose source are queued
+(up to UW_TERRAIN_QUERY_MAX_BATCHES of them) and answered in the flight loop by UWTerrainQueryService, oldest
+first, from the terrain cache (see UWTerrainCache.h).  Points whose lattice points are all cached cost a few hash
+lookups; the others need X-Plane to be probed, which is only done while the time spent this flight loop plus the
+expected probe time stays within terrain_query_budget.  The rest of the queue waits for the next flight loop (the
+plugin asks to be called back every frame while queries are waiting), so answering queries never takes more than
+the budget out of a frame.  To make sure every query is answered eventually, the first point of a flight loop is
+always answered.
+
+Settings from the plugin's config file (see UWPluginConfig.h)
+
+	terrain_query_budget	milliseconds per flight loop spent answering queries (default 0.5)
+*/
+
+#ifndef _UWTerrainQuery_h_
+#define _UWTerrainQuery_h_
+
+#include <string>
+
+#include "UWPluginConfig.h"
+#include "UWPoseSource.h"
+#include "UWTerrainCache.h"
+#include "UWTerrainQueryProtocol.h"
+
+#define UW_TERRAIN_QUERY_MAX_BATCHES		8
+#define UW_TERRAIN_QUERY_DESCRIPTION_LENGTH	96		//see UWTerrainQueryDescribe
+
+struct UWTerrainBatch {
+	std::string				address;				//where the reply goes
+	unsigned short			port;
+	unsigned int			requestId;
+	int						count;
+	int						next;					//first point not answered yet
+	double					receiveTime;			//UWClockMonotonicSeconds when queued
+	UWTerrainQueryPoint		points[UW_TERRAIN_QUERY_MAX_POINTS];
+};
+
+struct UWTerrainQuery {
+	UWTerrainCache *		cache;
+	double					budget;					//seconds per flight loop
+	UWTerrainBatch			batches[UW_TERRAIN_QUERY_MAX_BATCHES];		//ring of waiting queries
+	int						first;
+	int						count;
+	char					reply[UW_TERRAIN_REPLY_MAX_PACKET];			//reply to the oldest query, filled in as it is answered
+
+	long long				answered;				//queries
+	long long				points;
+	long long				rejected;				//busy or malformed
+	double					totalLatency;			//seconds from queuing to replying, over the answered queries
+	double					maxLatency;
+};
+
+
+
+void		UWTerrainQueryInit(UWTerrainQuery * query, const UWPluginConfig * config, UWTerrainCache * cache);
+
+int			UWTerrainQueryPush(UWTerrainQuery * query, const char * packet, int length, const std::string & address,
+						   unsigned short port, char * outReply);
+
+void		UWTerrainQueryService(UWTerrainQuery * query, UWPoseSource * source);
+
+void		UWTerrainQueryClear(UWTerrainQuery * query);
+
+bool		UWTerrainQueryIsWaiting(const UWTerrainQuery * query);
+
+void		UWTerrainQueryDescribe(const UWTerrainQuery * query, char * outText);
+
+#endif
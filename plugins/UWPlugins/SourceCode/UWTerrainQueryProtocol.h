@@ -0,0 +1,143 @@
+/*
+UWTerrainQueryProtocol.h
+
+The packet layout the external simulation uses to ask the UDP plugin for X-Plane's terrain under a batch of
+points (e.g. under the wheels of every entity, to compute ground contact).  This header does not depend on the
+X-Plane SDK so it can be included by the external simulation which sends the queries.
+
+The sender sends a query to the port the plugin listens on
+
+	UWTerrainQueryHeader			magic "UWTQ", the sender's request id and the number of points
+	UWTerrainQueryPoint ...			latitude and longitude in degrees, repeated count times
+
+and the plugin answers every query with one reply, in the order the queries arrived
+
+	UWTerrainReplyHeader			magic "UWTR", the request id of the query, the number of points and a status
+	UWTerrainReplyPoint ...			one for each point of the query, in the same order
+
+The elevation is in meters above mean sea level and the normal is in X-Plane's local coordinates (x east, y up,
+z south).  The plugin answers a query within a time budget per flight loop, so a large query or one for new ground
+(which X-Plane has to be probed for) can take a few frames; a query it has no room for is answered straight away
+with status uwTerrainReply_Busy and no points.
+
+All values are little-endian.
+*/
+
+#ifndef _UWTerrainQueryProtocol_h_
+#define _UWTerrainQueryProtocol_h_
+
+#include <string.h>
+
+#define UW_TERRAIN_QUERY_MAGIC			"UWTQ"		//first 4 bytes of a query
+#define UW_TERRAIN_REPLY_MAGIC			"UWTR"		//first 4 bytes of a reply
+#define UW_TERRAIN_QUERY_MAX_POINTS		160			//most points in one query (so the reply fits in 4096 bytes)
+
+enum UWTerrainReplyStatus {
+	uwTerrainReply_OK			= 0,
+	uwTerrainReply_Busy			= 1,			//too many queries waiting, send it again later
+	uwTerrainReply_Malformed	= 2
+};
+
+enum UWTerrainPointStatus {
+	uwTerrainPoint_Found		= 0,
+	uwTerrainPoint_NoTerrain	= 1				//X-Plane has no terrain there (e.g. the scenery is not loaded)
+};
+
+#pragma pack(push, 1)
+struct UWTerrainQueryHeader {
+	char			magic[4];			//UW_TERRAIN_QUERY_MAGIC
+	unsigned int	requestId;			//chosen by the sender, copied into the reply
+	unsigned short	count;				//number of points which follow
+	unsigned short	reserved;
+};
+
+struct UWTerrainQueryPoint {
+	double			latitude;			//degrees
+	double			longitude;			//degrees
+};
+
+struct UWTerrainReplyHeader {
+	char			magic[4];			//UW_TERRAIN_REPLY_MAGIC
+	unsigned int	requestId;
+	unsigned short	count;				//number of points which follow
+	unsigned char	status;				//UWTerrainReplyStatus
+	unsigned char	reserved;
+};
+
+struct UWTerrainReplyPoint {
+	double			elevation;			//meters above mean sea level
+	float			normal[3];			//x east, y up, z south
+	unsigned char	status;				//UWTerrainPointStatus
+	unsigned char	reserved[3];
+};
+#pragma pack(pop)
+
+#define UW_TERRAIN_QUERY_MAX_PACKET		((int)(sizeof(UWTerrainQueryHeader) + UW_TERRAIN_QUERY_MAX_POINTS*sizeof(UWTerrainQueryPoint)))
+#define UW_TERRAIN_REPLY_MAX_PACKET		((int)(sizeof(UWTerrainReplyHeader) + UW_TERRAIN_QUERY_MAX_POINTS*sizeof(UWTerrainReplyPoint)))
+
+
+
+/*
+Build a query for count points into the buffer, which must hold UW_TERRAIN_QUERY_MAX_PACKET bytes.  Returns the
+length of the query or -1 if there are too many points.
+*/
+inline int UWTerrainBuildQuery(char * buffer, unsigned int requestId, const UWTerrainQueryPoint * points, int count)
+{
+	if(count < 0 || count > UW_TERRAIN_QUERY_MAX_POINTS) {
+		return -1;
+	}
+
+	UWTerrainQueryHeader header;
+	memcpy(header.magic, UW_TERRAIN_QUERY_MAGIC, 4);
+	header.requestId	= requestId;
+	header.count		= (unsigned short)count;
+	header.reserved		= 0;
+	memcpy(buffer, &header, sizeof(header));
+	memcpy(buffer + sizeof(header), points, count * sizeof(UWTerrainQueryPoint));
+	return sizeof(header) + count * sizeof(UWTerrainQueryPoint);
+}
+
+
+
+/*
+Returns true if the packet is a terrain query
+*/
+inline bool UWTerrainIsQuery(const char * packet, int length)
+{
+	return length >= (int)sizeof(UWTerrainQueryHeader) && memcmp(packet, UW_TERRAIN_QUERY_MAGIC, 4) == 0;
+}
+
+
+
+/*
+Returns true if the packet is a reply to a terrain query
+*/
+inline bool UWTerrainIsReply(const char * packet, int length)
+{
+	return length >= (int)sizeof(UWTerrainReplyHeader) && memcmp(packet, UW_TERRAIN_REPLY_MAGIC, 4) == 0;
+}
+
+
+
+/*
+Read a reply into outHeader and outPoints (which must hold UW_TERRAIN_QUERY_MAX_POINTS points).  Returns the
+number of points or -1 if the packet is not a well formed reply.
+*/
+inline int UWTerrainParseReply(const char * packet, int length, UWTerrainReplyHeader * outHeader,
+							   UWTerrainReplyPoint * outPoints)
+{
+	if(!UWTerrainIsReply(packet, length)) {
+		return -1;
+	}
+
+	memcpy(outHeader, packet, sizeof(UWTerrainReplyHeader));
+	if(outHeader->count > UW_TERRAIN_QUERY_MAX_POINTS ||
+	   length != (int)(sizeof(UWTerrainReplyHeader) + outHeader->count * sizeof(UWTerrainReplyPoint))) {
+		return -1;
+	}
+
+	memcpy(outPoints, packet + sizeof(UWTerrainReplyHeader), outHeader->count * sizeof(UWTerrainReplyPoint));
+	return outHeader->count;
+}
+
+#endif
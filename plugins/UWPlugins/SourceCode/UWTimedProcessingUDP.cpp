@@ -3,6 +3,40 @@ UWTimeProcessingUDP.cpp
 
 This plugin allows the position (lat, lon, alt) and the orientation (phi, theta, psi) of the aircraft to be set by reading continuously reading values from a UDP socket.
 
+Arbitrary datarefs (including array datarefs) can also be streamed in and read back over the same socket.  See
+UWDataRefStreamProtocol.h for the packet layout.
+
+An external simulation on the same machine can instead publish poses into shared memory (see UWPosePublisher.h)
+or send the same packets to a Unix domain socket, and a remote one can send length-prefixed frames over a TCP
+connection.  Put "source shm", "source unix" or "source tcp" in UWTimedProcessingUDPConfig.txt in the
+X-System folder to choose (see UWPoseSource.h).
+
+For multi-node rendering, "apply_mode epoch" in the same file makes every node apply the pose for a shared target
+display time instead of the newest one (see UWEpochApply.h).
+
+The sender can synchronize its clock with the plugin's by pinging it over the same socket (see UWClockSync.h and
+UWClockClient.h), so that its time stamps are mapped onto the plugin's clock.
+
+If the sender's terrain differs from X-Plane's, "altitude_mode agl" in the same file makes the packet altitude a
+height above X-Plane's terrain ("altitude_mode clamp" keeps it above mean sea level but never below the terrain),
+see UWTerrainCache.h.  The sender can also ask for X-Plane's terrain elevation and normal under a batch of points
+over the same socket (see UWTerrainQueryProtocol.h).
+
+To measure the latency, "echo_port" in the same file makes the plugin send back the sequence number and times of
+every pose it applies (see UWEchoSender.h).
+
+The overlay lists the navaids nearest the streamed position and the FMS leg being flown, for mission debriefs.  The
+navaids are indexed once, a slice per frame after the plugin starts ("navaid_types" and "navaid_range" in the same
+file choose which and how far, see UWNavaidIndex.h).
+
+Shift+F5 shows or hides the status window, with the performance HUD: receive rate, loss, reordering, latency,
+flight loop time, jitter buffer depth and extrapolation, with a graph of the last minute of each (see
+UWPerformanceHUD.h).
+
+The port, the receive rate ("receive_rate" in the same file), the epoch delay and the transport can be changed while
+X-Plane runs from the plugin's menu under Plugins, or by binding keys to its commands (see UWSourceControl.h).  A new
+socket is opened on a thread of its own and swapped in once it is open, so the flight loop never waits for it.
+
 */
 
 
@@ -19,42 +53,75 @@ This plugin allows the position (lat, lon, alt) and the orientation (phi, theta,
 #include "XPLMUtilities.h"
 #include "XPLMGraphics.h"
 #include "XPLMDisplay.h"
+#include "XPLMPlugin.h"
 
 #include "PracticalSocket.h"   // For UDPSocket and SocketException
+#include "UWDataRefSchema.h"
+#include "UWDataRefStream.h"
+#include "UWPluginConfig.h"
+#include "UWPoseSource.h"
+#include "UWClockResponder.h"
+#include "UWEpochApply.h"
+#include "UWTerrainCache.h"
+#include "UWTerrainQuery.h"
+#include "UWEchoSender.h"
+#include "UWNavaidIndex.h"
+#include "UWStatusOverlay.h"
+#include "UWPerformanceHUD.h"
+#include "UWClock.h"
+#include "UWSourceControl.h"
 
 //----------------------------GLOBAL VARIALBES----------------------------------------
-#define MAX_ITEMS 11
-#define UDP_PORT_RECEIVE 49003					//port to listen to to receive UDP packets
-#define UDP_RECEIVE_DELTA_T 0.05				//time between UDP processes
-const int MAXRCVSTRING = 4096;					// Longest string to receive
+#define UDP_PORT_RECEIVE 49003					//default port to listen to to receive UDP packets
+#define SCHEMA_FILE "UWTimedProcessingUDPSchema.txt"	//optional schema file in the X-System folder (see UWDataRefSchema.h)
+#define CONFIG_FILE "UWTimedProcessingUDPConfig.txt"	//optional config file in the X-System folder (see UWPluginConfig.h)
 
 XPLMWindowID	gWindow = NULL;					//for displaying plugin status
 XPLMHotKeyID	gHotKey = NULL;					//used to register our hotkey
-XPLMDataRef		gPositionDataRef[MAX_ITEMS];	//hold all of the datarefs
+XPLMHotKeyID	gHudHotKey = NULL;				//shows and hides the status window
 int				gClicked = 0;					//used to determine if user is clicking in the window or not
+UWStatusOverlay	gOverlay;						//text of the status window (see UWStatusOverlay.h)
 bool			gListeningForUDPPackets;		//set this to true to start listening for UDP packets (it should start as false to avoid making X-Plane hang if no packets are incoming)
-bool			gDisplayOverlay = false;		//set this to true to display the overlay on the X-Plane window which shows plugin information (useful for debugging).
 
-char DataRefString[MAX_ITEMS][255] = {
-	"sim/flightmodel/position/local_x", 
-	"sim/flightmodel/position/local_y", 
-	"sim/flightmodel/position/local_z",
-	"sim/flightmodel/position/lat_ref", 
-	"sim/flightmodel/position/lon_ref",	
-	"sim/flightmodel/position/theta", 
-	"sim/flightmodel/position/phi", 
-	"sim/flightmodel/position/psi", 
-	"sim/flightmodel/position/latitude", 
-	"sim/flightmodel/position/longitude", 
-	"sim/flightmodel/position/elevation"
-};
+UWDataRefSchema	gSchema;						//maps the words of a packet onto datarefs (resolved once at startup)
+double			gPacketWords[UW_SCHEMA_MAX_WORDS];	//words of the most recent packet
+int				gLatitudeField;					//index of the schema fields used to compute local_x, local_y, local_z
+int				gLongitudeField;
+int				gElevationField;
+int				gLocalXField;
+int				gLocalYField;
+int				gLocalZField;
+
+UWPoseSourceSettings	gSourceSettings;		//which transport to listen on (from the config file)
+UWSourceControl	gControl;						//port, rate, delay and transport changed at runtime (see UWSourceControl.h)
+UWPoseSource *	gSource;						//the source being read, one of gControl's (open while we are listening, never blocks)
+UWSourceMessage	gMessage;						//the message being processed
+UWClockResponder	gClock;						//clock synchronization with the sender (see UWClockResponder.h)
+UWEpochApply	gEpoch;							//epoch apply mode (see UWEpochApply.h)
+UWTerrainCache	gTerrain;						//altitude above the terrain (see UWTerrainCache.h)
+UWTerrainQuery	gTerrainQuery;					//terrain queries from the sender (see UWTerrainQuery.h)
+UWNavaidIndex	gNavaids;						//navaids near the streamed position, for the overlay (see UWNavaidIndex.h)
+UWPerformanceHUD	gHud;						//performance graphs on the status window (see UWPerformanceHUD.h)
+UWPoseRecord	gPose;							//a received pose on its way to gPacketWords or the jitter buffer
+int				gTimestampField;				//index of the schema field with the sender time stamp (-1 if none)
+int				gSequenceField;					//index of the schema field with the sender sequence number (-1 if none)
+UWEchoSender	gEchoSender;					//echo mode (see UWEchoSender.h)
+UWEchoRecord	gEcho;							//echo of the pose set to the datarefs this frame
+UWDataRefStream	gStream;						//datarefs subscribed by the sender (see UWDataRefStreamProtocol.h)
+UWDataRefBatch	gBatch;							//streamed writes are grouped by dataref and flushed once per flight loop
+string			gSubscriberAddress;				//where the readback packets are sent (the sender of the last subscription)
+unsigned short	gSubscriberPort = 0;
+char			gReadbackPacket[UW_STREAM_MAX_PACKET];
 
 
 
 
 //----------------------------FUNCTION PROTOTYPES-------------------------------------
-void ApplyThetaPhiPsiToDataRefs(float theta, float phi, float psi);
-void ApplyLatLonAltToDataRefs(double lat, double lon, double altitude);
+void LoadDataRefSchema();
+void ApplyLocalPositionToDataRefs(const double * words);
+bool ProcessPacket(char * packet, int length, const string & sourceAddress, unsigned short sourcePort);
+bool ProcessRecord(const UWPoseRecord * record);
+bool AcceptPose(const UWPoseRecord * pose);
 
 void MyDrawWindowCallback(
                                    XPLMWindowID         inWindowID,    
@@ -79,12 +146,20 @@ int MyHandleMouseClickCallback(
 
 void	MyHotKeyCallback(void *               inRefcon);    
 
+void	MyHudHotKeyCallback(void *               inRefcon);    
+
 float	MyFlightLoopCallback(
                                    float                inElapsedSinceLastCall,    
                                    float                inElapsedTimeSinceLastFlightLoop,    
                                    int                  inCounter,    
                                    void *               inRefcon);    
 
+float	MyBuildNavaidsCallback(
+                                   float                inElapsedSinceLastCall,    
+                                   float                inElapsedTimeSinceLastFlightLoop,    
+                                   int                  inCounter,    
+                                   void *               inRefcon);    
+
 
 
 //-------------------IMPLEMENT THE X-PLANE PLUGIN INTERFACE---------------------------
@@ -106,27 +181,46 @@ PLUGIN_API int XPluginStart(
 	//Start up with listening for packets turned off (otherwise, x-plane will hang waiting for packets which may not be coming yet)
 	gListeningForUDPPackets = false;
 
-	//fill up the gPositionDataRef array with data references
-	for (int Item=0; Item<MAX_ITEMS; Item++) {
-		gPositionDataRef[Item] = XPLMFindDataRef(DataRefString[Item]);
-	}
+	//read the transport settings
+	UWPluginConfig config;
+	UWConfigLoad(&config, CONFIG_FILE);
+	UWSourceReadSettings(&gSourceSettings, &config, UDP_PORT_RECEIVE);
+	UWClockResponderInit(&gClock, UWConfigGetDouble(&config, "clock_offset", 0.0), "uw/timed_processing_udp");
+	UWEpochReadSettings(&gEpoch, &config, &gClock);
+	gSourceSettings.keepEveryRecord = gEpoch.enabled;		//the jitter buffer needs every pose
+	UWTerrainReadSettings(&gTerrain, &config, "uw/timed_processing_udp");
+	UWNavaidReadSettings(&gNavaids, &config);
+	UWTerrainQueryInit(&gTerrainQuery, &config, &gTerrain);
+	UWEchoReadSettings(&gEchoSender, &config);
+
+	//build the schema and resolve all of the data references once
+	LoadDataRefSchema();
+	UWBatchInit(&gBatch);
+	UWStreamInit(&gStream, &gBatch);
 	
-	if(gDisplayOverlay) {
-		/* Now we create a window.  We pass in a rectangle in left, top,
-		* right, bottom screen coordinates.  We pass in three callbacks. */
-		int topLeftX = 725 - 2*350;
-		int topLeftY = 440 - 225;
-
-		int width = 250;
-		int height = 250;
-		gWindow = XPLMCreateWindow(
-			topLeftX, topLeftY, topLeftX+width, topLeftY-height,			/* Area of the window. */
-			1,							/* Start visible. */
-			MyDrawWindowCallback,		/* Callbacks */
-			MyHandleKeyCallback,
-			MyHandleMouseClickCallback,
-			NULL);						/* Refcon - not used. */
-	}
+	UWOverlayInit(&gOverlay, UWConfigGetDouble(&config, "overlay_rate", UW_OVERLAY_REFRESH_RATE));
+	UWHudInit(&gHud);
+
+	//the commands and the menu which change the settings at runtime
+	UWControlInit(&gControl, "UWTimedProcessingUDP", "uw/timed_processing_udp",
+				  &config, &gSourceSettings, &gEpoch, &gOverlay);
+	gSource = gControl.active;
+
+	/* Now we create a window.  We pass in a rectangle in left, top,
+	* right, bottom screen coordinates.  We pass in three callbacks.
+	* It starts hidden (X-Plane does not draw it) until Shift+F5 shows it. */
+	int topLeftX = 725 - 2*350;
+	int topLeftY = 440 + 225;
+
+	int width = 400;
+	int height = 330;
+	gWindow = XPLMCreateWindow(
+		topLeftX, topLeftY, topLeftX+width, topLeftY-height,			/* Area of the window. */
+		0,							/* Start hidden. */
+		MyDrawWindowCallback,		/* Callbacks */
+		MyHandleKeyCallback,
+		MyHandleMouseClickCallback,
+		NULL);						/* Refcon - not used. */
 
 	/* Register our hot key for applying a new position. */
 	gHotKey = XPLMRegisterHotKey(XPLM_VK_F5, xplm_DownFlag, 
@@ -134,14 +228,21 @@ PLUGIN_API int XPluginStart(
 		MyHotKeyCallback,
 		NULL);
 
+	gHudHotKey = XPLMRegisterHotKey(XPLM_VK_F5, xplm_DownFlag | xplm_ShiftFlag,
+		"Show/hide the status window and performance HUD",
+		MyHudHotKeyCallback,
+		NULL);
 
 	/* Register our callback for once a second.  Positive intervals
 	 * are in seconds, negative are the negative of sim frames.  Zero
 	 * registers but does not schedule a callback for time. */
 	XPLMRegisterFlightLoopCallback(		
 			MyFlightLoopCallback,	/* Callback */
-			UDP_RECEIVE_DELTA_T,					/* Interval */
+			gEpoch.enabled ? -1.0f : UWControlInterval(&gControl),	/* Interval (every frame in epoch mode) */
 			NULL);					/* refcon not used. */
+
+	//index the navaids a slice per frame (see UWNavaidIndex.h)
+	XPLMRegisterFlightLoopCallback(MyBuildNavaidsCallback, -1.0f, NULL);
 			
 	return 1;
 }
@@ -152,6 +253,15 @@ PLUGIN_API void	XPluginStop(void)
 {
 	/* Unregister the callback */
 	XPLMUnregisterFlightLoopCallback(MyFlightLoopCallback, NULL);
+	XPLMUnregisterFlightLoopCallback(MyBuildNavaidsCallback, NULL);
+
+	UWControlStop(&gControl);
+	UWControlDestroy(&gControl);
+	UWEpochStop(&gEpoch);
+	UWEchoStop(&gEchoSender);
+	UWClockResponderStop(&gClock);
+	UWTerrainStop(&gTerrain);
+	UWNavaidStop(&gNavaids);
 	
 	///* Close the file */
 	//fclose(gOutputFile);
@@ -180,39 +290,74 @@ PLUGIN_API void XPluginReceiveMessage(
 					long			inMessage,
 					void *			inParam)
 {
+	//the cached terrain elevations may be out of date once new scenery is loaded
+	if(inMessage == XPLM_MSG_SCENERY_LOADED) {
+		UWTerrainFlush(&gTerrain);
+	}
 }
 
 
 
 //-------------------------FUNCTION DEFINITIONS---------------------------------------
 /*
-Apply the specified Euler angles to the datarefs
+Build the schema which maps the words of a packet onto datarefs.  If the schema file exists in the X-System folder
+it is used, otherwise the default packet layout is used
+
+	'phiDeg thetaDeg psiDeg latitudeDeg longitudeDeg altitudeMeters'
+
+Every dataref handle and type is resolved here so that the flight loop does not have to look anything up.
 */
-void ApplyThetaPhiPsiToDataRefs(float theta, float phi, float psi)
+void LoadDataRefSchema()
 {
-	//apply the angles to the datarefs
-	XPLMSetDataf(gPositionDataRef[5], theta);
-	XPLMSetDataf(gPositionDataRef[6], phi);
-	XPLMSetDataf(gPositionDataRef[7], psi);
+	if(UWSchemaLoad(&gSchema, SCHEMA_FILE) == 0) {
+		UWSchemaClear(&gSchema);
+		UWSchemaAddField(&gSchema, "local_x",	-1,	uwFieldType_Double,	1.0, "sim/flightmodel/position/local_x");
+		UWSchemaAddField(&gSchema, "local_y",	-1,	uwFieldType_Double,	1.0, "sim/flightmodel/position/local_y");
+		UWSchemaAddField(&gSchema, "local_z",	-1,	uwFieldType_Double,	1.0, "sim/flightmodel/position/local_z");
+		UWSchemaAddField(&gSchema, "lat_ref",	-1,	uwFieldType_Float,	1.0, "sim/flightmodel/position/lat_ref");
+		UWSchemaAddField(&gSchema, "lon_ref",	-1,	uwFieldType_Float,	1.0, "sim/flightmodel/position/lon_ref");
+		UWSchemaAddField(&gSchema, "theta",		1,	uwFieldType_Float,	1.0, "sim/flightmodel/position/theta");
+		UWSchemaAddField(&gSchema, "phi",		0,	uwFieldType_Float,	1.0, "sim/flightmodel/position/phi");
+		UWSchemaAddField(&gSchema, "psi",		2,	uwFieldType_Float,	1.0, "sim/flightmodel/position/psi");
+		UWSchemaAddField(&gSchema, "latitude",	3,	uwFieldType_Double,	1.0, "sim/flightmodel/position/latitude");
+		UWSchemaAddField(&gSchema, "longitude",	4,	uwFieldType_Double,	1.0, "sim/flightmodel/position/longitude");
+		UWSchemaAddField(&gSchema, "elevation",	5,	uwFieldType_Double,	1.0, "sim/flightmodel/position/elevation");
+	}
+
+	UWSchemaResolve(&gSchema);
+
+	gLatitudeField	= UWSchemaFindField(&gSchema, "latitude");
+	gLongitudeField	= UWSchemaFindField(&gSchema, "longitude");
+	gElevationField	= UWSchemaFindField(&gSchema, "elevation");
+	gLocalXField	= UWSchemaFindField(&gSchema, "local_x");
+	gLocalYField	= UWSchemaFindField(&gSchema, "local_y");
+	gLocalZField	= UWSchemaFindField(&gSchema, "local_z");
+	gTimestampField	= UWSchemaFindField(&gSchema, "timestamp");
+	gSequenceField	= UWSchemaFindField(&gSchema, "sequence");
 }
 
 
 
 /*
-Apply the specified lat/lon/alt to the datarefs.  Note the units on the inputs arguments 
+Use XPLMWorldToLocal to compute the local_x, local_y, local_z from the lat/lon/alt in the packet and apply them to 
+the datarefs.  Note the units of the packet words
 
 latitude in degrees
 longitude in degrees
-altitude in meters
-
-This will then use XPLMWorldToLocal to also compute the local_x, local_y, local_z and apply them to the datarefs
+altitude in meters (above mean sea level, or above the terrain in the agl altitude mode)
 */
-void ApplyLatLonAltToDataRefs(double latitudeDeg, double longitudeDeg, double altitudeMeters)
+void ApplyLocalPositionToDataRefs(const double * words)
 {
-	//apply the positions to the data refs
-	XPLMSetDatad(gPositionDataRef[8], latitudeDeg);
-	XPLMSetDatad(gPositionDataRef[9], longitudeDeg);
-	XPLMSetDatad(gPositionDataRef[10], altitudeMeters);
+	if(gLatitudeField < 0 || gLongitudeField < 0 || gElevationField < 0) {
+		return;
+	}
+
+	double latitudeDeg		= UWSchemaGetValue(&gSchema, gLatitudeField, words);
+	double longitudeDeg		= UWSchemaGetValue(&gSchema, gLongitudeField, words);
+	double altitudeMeters	= UWSchemaGetValue(&gSchema, gElevationField, words);
+
+	//resolve the altitude against X-Plane's terrain (a cache lookup unless the aircraft has moved onto new ground)
+	altitudeMeters = UWTerrainResolveAltitude(&gTerrain, latitudeDeg, longitudeDeg, altitudeMeters);
 
 	//compute the local_x, local_y, and local_z values
 	double local_x;
@@ -221,103 +366,221 @@ void ApplyLatLonAltToDataRefs(double latitudeDeg, double longitudeDeg, double al
 	XPLMWorldToLocal(latitudeDeg, longitudeDeg, altitudeMeters, &local_x, &local_y, &local_z);
 
 	//apply the local_x, local_y, and local_z values to the datarefs
-	XPLMSetDatad(gPositionDataRef[0], local_x);
-	XPLMSetDatad(gPositionDataRef[1], local_y);
-	XPLMSetDatad(gPositionDataRef[2], local_z);
+	UWSchemaSetField(&gSchema, gLocalXField, local_x);
+	UWSchemaSetField(&gSchema, gLocalYField, local_y);
+	UWSchemaSetField(&gSchema, gLocalZField, local_z);
 }
 
 
 
 
 /*
-Process what to do at timed intervals
+Handle one received packet.  There are four kinds of packets
+
+	text pose packets		parsed with the schema into gPacketWords (returns true)
+	subscription messages	UWSUB/UWOUT/UWRESET, answered straight away to the sender
+	dataref data packets	the subscribed datarefs are written straight away
+	terrain queries			queued and answered after the pose is applied (see UWTerrainQuery.h)
+
+See UWDataRefStreamProtocol.h for the subscription and data packets.
 */
-float	MyFlightLoopCallback(
-                                   float                inElapsedSinceLastCall,    
-                                   float                inElapsedTimeSinceLastFlightLoop,    
-                                   int                  inCounter,    
-                                   void *               inRefcon)
+bool ProcessPacket(char * packet, int length, const string & sourceAddress, unsigned short sourcePort)
 {
-	/* The actual callback.  First we read the sim's time and the data. */
-	float	elapsed = XPLMGetElapsedTime();
+	if(UWStreamIsDataPacket(packet, length)) {
+		UWStreamApplyData(&gStream, packet, length);
+		return false;
+	}
 
-	if(gListeningForUDPPackets) {
-		//Setup the containers for values we want to get from UDP
-		double phiDegDouble;
-		double thetaDegDouble;
-		double psiDegDouble;
-		double latitudeDeg;
-		double longitudeDeg;
-		double altitudeMeters;
+	if(UWTerrainIsQuery(packet, length)) {
+		char reply[sizeof(UWTerrainReplyHeader)];
+		int replyLength = UWTerrainQueryPush(&gTerrainQuery, packet, length, sourceAddress, sourcePort, reply);
+		if(replyLength > 0) {
+			UWSourceReply(gSource, reply, replyLength, sourceAddress, sourcePort);
+		}
+		return false;
+	}
+
+	if(UWStreamIsControlPacket(packet, length)) {
+		char reply[64];
+		int replyLength = UWStreamHandleControl(&gStream, packet, length, reply, sizeof(reply));
+		if(replyLength > 0) {
+			UWSourceReply(gSource, reply, replyLength, sourceAddress, sourcePort);
+		}
+
+		gSubscriberAddress	= sourceAddress;
+		gSubscriberPort		= sourcePort;
+		return false;
+	}
+
+	//a badly formed packet must not clobber a good pose received earlier in the same frame
+	if(UWSchemaParsePacket(&gSchema, packet, gPose.words) != gSchema.numPacketWords) {
+		return false;
+	}
+
+	//text packets only carry a time stamp (and sequence number) if the schema has one, otherwise they are stamped on arrival
+	gPose.sequence	= (gSequenceField >= 0) ? (unsigned int)UWSchemaGetValue(&gSchema, gSequenceField, gPose.words) : 0;
+	gPose.numWords	= gSchema.numPacketWords;
+	gPose.timestamp	= (gTimestampField >= 0) ? UWSchemaGetValue(&gSchema, gTimestampField, gPose.words) : UWEpochSharedTime(&gEpoch);
+	UWHudReceived(&gHud, gSequenceField >= 0, gPose.sequence);
+	return AcceptPose(&gPose);
+}
+
+
+
+/*
+Handle one binary pose record (from the shared memory ring, or a UWPR packet on the UDP, TCP or Unix socket).  The
+words have the same layout as a text pose packet.  Returns true if the record holds every word the schema needs.
+*/
+bool ProcessRecord(const UWPoseRecord * record)
+{
+	if(record->numWords < gSchema.numPacketWords) {
+		return false;
+	}
 
-		float thetaDeg;
-		float phiDeg;
-		float psiDeg;
+	UWHudReceived(&gHud, true, record->sequence);
+	return AcceptPose(record);
+}
 
-		//receive the data from the UDP port
-		try {
-			unsigned short echoServPort = UDP_PORT_RECEIVE;
-			UDPSocket sock(echoServPort);                
 
-			char recvString[MAXRCVSTRING + 1]; // This will be the buffer for echo string + \0
-			string sourceAddress;              // Address of datagram source
-			unsigned short sourcePort;         // Port of datagram source
-			int bytesRcvd = sock.recvFrom(recvString, MAXRCVSTRING, sourceAddress, sourcePort);
-			recvString[bytesRcvd] = '\0';		// Terminate string
 
-			//Convert the recieved string to values
-			char *pch;			
-			pch = strtok(recvString," ");
+/*
+In the default mode the pose goes straight to gPacketWords (returns true).  In epoch mode it goes into the
+jitter buffer and is picked from there after all of the packets have been read (returns false).
 
-			for(int wordNumber = 0; wordNumber < 6; wordNumber++)
-			{
-				double value = atof(pch);
+The pose is the one in gMessage, whose sender and receive time are kept for the echo.
+*/
+bool AcceptPose(const UWPoseRecord * pose)
+{
+	if(gMessage.sourcePort != 0) {
+		UWEchoSetPoseAddress(&gEchoSender, gMessage.sourceAddress);
+	}
 
-				if (wordNumber==0) {
-					phiDegDouble = value;
+	if(gEpoch.enabled) {
+		UWEpochPush(&gEpoch, pose, gMessage.receiveTime);
+		return false;
+	}
 
-				} else if (wordNumber==1) {
-					thetaDegDouble = value;
+	memcpy(gPacketWords, pose->words, gSchema.numPacketWords * sizeof(double));
+	gEcho.sequence		= pose->sequence;
+	gEcho.timestamp		= pose->timestamp;
+	gEcho.receiveTime	= UWClockResponderToSender(&gClock, gMessage.receiveTime);
+	return true;
+}
 
-				} else if (wordNumber==2) {
-					psiDegDouble = value;
 
-				} else if (wordNumber==3) {
-					latitudeDeg = value;
 
-				} else if (wordNumber==4) {
-					longitudeDeg = value;
+/*
+Process what to do at timed intervals
+*/
+float	MyFlightLoopCallback(
+                                   float                inElapsedSinceLastCall,    
+                                   float                inElapsedTimeSinceLastFlightLoop,    
+                                   int                  inCounter,    
+                                   void *               inRefcon)
+{
+	/* The actual callback.  First we read the sim's time and the data. */
+	float	elapsed = XPLMGetElapsedTime();
+	double	start	= UWClockMonotonicSeconds();
+
+	//swap to a new source once it is open (see UWSourceControl.h)
+	gSource = UWControlTakeSource(&gControl);
+
+	//send what is left of the replies the TCP connection could not take last time
+	UWSourceFlush(gSource);
+
+	if(gListeningForUDPPackets && UWSourceIsOpen(gSource)) {
+		//drain everything which is waiting on the source (it is non-blocking so this never waits)
+		bool havePose = false;
+		UWSourceMessageKind kind;
+		while((kind = UWSourceReceive(gSource, &gMessage)) != uwMessage_None) {
+			//clock pings are answered straight away
+			if(UWClockResponderAnswer(&gClock, gSource, &gMessage)) {
+				continue;
+			}
 
-				} else if (wordNumber==5) {
-					altitudeMeters = value;
+			if(kind == uwMessage_Packet) {
+				havePose |= ProcessPacket(gMessage.packet, gMessage.length, gMessage.sourceAddress, gMessage.sourcePort);
+			} else {
+				havePose |= ProcessRecord(&gMessage.record);
+			}
+		}
 
-				} else {
-				}		
+		//in epoch mode the pose for the shared target display time is used
+		if(gEpoch.enabled) {
+			double receiveTime;
+			const UWPoseRecord * pose = UWEpochSelect(&gEpoch, &receiveTime);
+			if(pose != NULL) {
+				memcpy(gPacketWords, pose->words, gSchema.numPacketWords * sizeof(double));
+				gEcho.sequence		= pose->sequence;
+				gEcho.timestamp		= pose->timestamp;
+				gEcho.receiveTime	= UWClockResponderToSender(&gClock, receiveTime);
+				havePose = true;
+			}
+			UWEpochReport(&gEpoch);
 
-				pch = strtok (NULL, " ");
+			//how far the target display time is ahead of the pose shown
+			if(gEpoch.lastAppliedTimestamp != 0.0) {
+				UWHudBuffer(&gHud, UWJitterDepth(&gEpoch.jitter),
+							UWEpochSharedTime(&gEpoch) - gEpoch.delay - gEpoch.lastAppliedTimestamp);
 			}
+		}
+
+		//only the newest pose is set to the datarefs
+		if(havePose) {
+			UWSchemaApply(&gSchema, gPacketWords);
+			ApplyLocalPositionToDataRefs(gPacketWords);
+			UWHudApplied(&gHud, UWClockResponderSenderTime(&gClock) - gEcho.timestamp);
 
-			//convert phi, theta, psi to floats
-			phiDeg		= (float)phiDegDouble;
-			thetaDeg	= (float)thetaDegDouble;
-			psiDeg		= (float)psiDegDouble;
+			//the echo is sent by the echo thread, so this never waits on the socket
+			if(UWEchoIsEnabled(&gEchoSender)) {
+				gEcho.applyTime = UWClockResponderSenderTime(&gClock);
+				UWEchoPush(&gEchoSender, &gEcho);
+			}
+		}
 
-		} catch (SocketException &e) {
+		//one XPLMSetData* call per streamed dataref (one XPLMSetDatav* call per array dataref)
+		UWBatchFlush(&gBatch);
 
+		//send the subscribed output datarefs back to the sender
+		if(!gSubscriberAddress.empty()) {
+			int length = UWStreamBuildReadback(&gStream, gReadbackPacket, sizeof(gReadbackPacket));
+			if(length > 0) {
+				UWSourceReply(gSource, gReadbackPacket, length, gSubscriberAddress, gSubscriberPort);
+			}
 		}
 
-		//Set these values to the datarefs
-		ApplyThetaPhiPsiToDataRefs(thetaDeg, phiDeg, psiDeg);
-		ApplyLatLonAltToDataRefs(latitudeDeg, longitudeDeg, altitudeMeters);
+		//answer terrain queries within their time budget (the rest wait for the next frame)
+		UWTerrainQueryService(&gTerrainQuery, gSource);
 	}
 
-	/* Return UDP_RECEIVE_DELTA_T to indicate that we want to be called again in UDP_RECEIVE_DELTA_T second. */
+	//the performance HUD is sampled whether or not it is shown
+	double end = UWClockMonotonicSeconds();
+	UWHudFlightLoop(&gHud, end - start);
+	UWHudStep(&gHud, end);
+
+	/* Return the receive interval (receive_rate, which can be changed from the Plugins menu) to be called again. */
 	//DOES THIS NEED TO BE CHANGED TO CALLING RATE?
-	return UDP_RECEIVE_DELTA_T;
+	//(in epoch mode we are called every frame so the target display time is met on every frame, and we are also
+	//called every frame while terrain queries are waiting to be answered)
+	return (gEpoch.enabled || UWTerrainQueryIsWaiting(&gTerrainQuery)) ? -1.0f : UWControlInterval(&gControl);
 }                                   
 
 
 
+/*
+Build the navaid index for at most navaid_build_budget milliseconds a frame, until it is built
+*/
+float	MyBuildNavaidsCallback(
+                                   float                inElapsedSinceLastCall,    
+                                   float                inElapsedTimeSinceLastFlightLoop,    
+                                   int                  inCounter,    
+                                   void *               inRefcon)
+{
+	return UWNavaidBuildStep(&gNavaids) ? 0.0f : -1.0f;
+}
+
+
+
 /*
  * MyDrawingWindowCallback
  * 
@@ -331,84 +594,94 @@ void MyDrawWindowCallback(
                                    XPLMWindowID         inWindowID,    
                                    void *               inRefcon)
 {
-	int		left, top, right, bottom;
-	float	color[] = { 1.0, 1.0, 1.0 }; 	/* RGB White */
-	int		verticalLineSpacing = 10;
-	
-	/* First we get the location of the window passed in to us. */
-	XPLMGetWindowGeometry(inWindowID, &left, &top, &right, &bottom);
-	
-	/* We now use an XPLMGraphics routine to draw a translucent dark
-	 * rectangle that is our window's shape. */
-	XPLMDrawTranslucentDarkBox(left, top, right, bottom);
+	//format the text only when it is due, and draw the lines kept from the last refresh (see UWStatusOverlay.h)
+	if(UWOverlayBeginRefresh(&gOverlay)) {
+		//Line 1 (display plugin info)
+		UWOverlaySetText(&gOverlay, 1, gClicked ? "You are clicking here" : "UWTimedProcessingUDP");
 
-	/* Finally we draw the text into the window, also using XPLMGraphics
-	 * routines.  The NULL indicates no word wrapping. */
-		
-	//Line 1 (display plugin info)
-	XPLMDrawString(color, left + 5, top - 1*verticalLineSpacing, 
-		(char*)(gClicked ? "You are clicking here" : "UWTimedProcessingUDP"), NULL, xplmFont_Basic);
-	
-	//Line 2 (plugin instructions)
-	XPLMDrawString(color, left + 5, top - 2*verticalLineSpacing, "Press F5 to toggle UDP listening on/off", NULL, xplmFont_Basic);
-	
-	//Line 3 (display status of listening or not)
-	if(gListeningForUDPPackets) {
-		XPLMDrawString(color, left + 5, top - 3*verticalLineSpacing, "Currently listening for UDP packets", NULL, xplmFont_Basic);
-	} else {
-		XPLMDrawString(color, left + 5, top - 3*verticalLineSpacing, "Currently not listening for UDP packets", NULL, xplmFont_Basic);
-	}
+		//Line 2 (plugin instructions)
+		UWOverlaySetText(&gOverlay, 2, "Press F5 to toggle UDP listening on/off");
 
-	////Line 4 & 5 (display port number that UDP is listening for)
-	char UDP_port_receive_char[10];
-	itoa(UDP_PORT_RECEIVE, UDP_port_receive_char, 10);
-	
-	XPLMDrawString(color, left + 5, top - 4*verticalLineSpacing, "Port number for UDP packets displayed below", NULL, xplmFont_Basic);
-	XPLMDrawString(color, left + 5, top - 5*verticalLineSpacing, UDP_port_receive_char, NULL, xplmFont_Basic);
-	
-	//Print out all the data refs
-	for(int i = 0; i < MAX_ITEMS; i++) 
-	{
-		char currentValue_char[20];
-		if((i==0) || (i==1) || (i==2) || (i==8) || (i==9) || (i==10)) {
-			//doubles stored at these locations
-			double valueDouble = XPLMGetDatad(gPositionDataRef[i]);
-			sprintf(currentValue_char, "%f", valueDouble);
-
-		} else {
-			//floats stored at these locations
-			float valueFloat = XPLMGetDataf(gPositionDataRef[i]);
-			sprintf(currentValue_char, "%f", valueFloat);
+		//Line 3 (display status of listening or not)
+		UWOverlaySetText(&gOverlay, 3, gListeningForUDPPackets ? "Currently listening for UDP packets"
+															   : "Currently not listening for UDP packets");
+
+		//Line 4 & 5 (display where the poses are read from)
+		UWOverlaySetText(&gOverlay, 4, "Poses are read from");
+		UWSourceDescribe(&gSourceSettings, UWOverlayText(&gOverlay, 5));
+
+		//Line 6 (display the clock offset to the sender)
+		UWClockResponderDescribe(&gClock, UWOverlayText(&gOverlay, 6));
+
+		//Line 7 (display the altitude mode and the terrain cache statistics)
+		UWTerrainDescribe(&gTerrain, UWOverlayText(&gOverlay, 7));
+
+		//Line 8 (display the terrain queries answered)
+		UWTerrainQueryDescribe(&gTerrainQuery, UWOverlayText(&gOverlay, 8));
+
+		//Line 9 to 15 (display the navaids nearest the streamed position and the FMS leg being flown)
+		UWNavaidQueryOverlay(&gNavaids);
+		UWNavaidDescribe(&gNavaids, UWOverlayText(&gOverlay, 9));
+		for(int hit = 0; hit < UW_NAVAID_OVERLAY_HITS; hit++) {
+			UWNavaidDescribeHit(&gNavaids, hit, UWOverlayText(&gOverlay, 10 + hit));
 		}
-		
-		char totalString[300];
-		strcpy(totalString, DataRefString[i]);
-		strcat(totalString, " is ");
-		strcat(totalString, currentValue_char);
+		UWNavaidDescribeLeg(UWOverlayText(&gOverlay, 15));
+
+		//Line 16 to 29 (display the performance HUD)
+		UWHudDescribe(&gHud, &gOverlay, 16);
 
-		XPLMDrawString(color, left + 5, top - (i+6)*verticalLineSpacing, totalString, NULL, xplmFont_Basic);
+		//Line 30 (display the receive rate and the epoch delay set from the Plugins menu)
+		UWControlDescribe(&gControl, UWOverlayText(&gOverlay, 30));
 	}
+
+	UWOverlayDraw(&gOverlay, inWindowID);
+	UWHudDraw(&gHud, inWindowID, 16);
 } 
 
 
 
 /*
-Read in info from a UDP socket and set the aircraft orientation and position to that value.
-
-Note that this will block until it receives the UDP packet
+Toggle listening for UDP packets.  The source is opened when we start listening and is non-blocking, so the
+flight loop never waits for packets which may not be coming.
 */
 void	MyHotKeyCallback(void *               inRefcon)
 {	
+	//show what the hot key changed right away
+	UWOverlayInvalidate(&gOverlay);
+
 	//toggle the gListeningForUDPPackets
 	if(gListeningForUDPPackets) {
 		gListeningForUDPPackets = false;
+
+		UWControlStop(&gControl);
+		UWEpochStop(&gEpoch);
+		UWEchoStop(&gEchoSender);
+		UWTerrainQueryClear(&gTerrainQuery);
+
 	} else {
 		gListeningForUDPPackets = true;
+
+		//the source is opened on gControl's thread and kept open while listening
+		UWControlStart(&gControl);
+		UWEpochStart(&gEpoch);
+		UWEchoStart(&gEchoSender);
 	}
 }
 
 
 
+/*
+Show or hide the status window.  X-Plane does not call the draw callback of a hidden window, so the overlay and the
+HUD graphs cost nothing while it is hidden (the HUD is still sampled, so it shows the last minute right away).
+*/
+void	MyHudHotKeyCallback(void *               inRefcon)
+{
+	XPLMSetWindowIsVisible(gWindow, !XPLMGetWindowIsVisible(gWindow));
+	UWOverlayInvalidate(&gOverlay);
+}
+
+
+
 /*
  * MyHandleKeyCallback
  * 
@@ -445,8 +718,10 @@ int MyHandleMouseClickCallback(
 {
 	/* If we get a down or up, toggle our status click.  We will
 	 * never get a down without an up if we accept the down. */
-	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp))
+	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp)) {
 		gClicked = 1 - gClicked;
+		UWOverlayInvalidate(&gOverlay);
+	}
 	
 	/* Returning 1 tells X-Plane that we 'accepted' the click; otherwise
 	 * it would be passed to the next window behind us.  If we accept
@@ -5,6 +5,33 @@ This plugin allows the position (lat, lon, alt) of the aircraft, the orientation
 
 To use this plugin, press the F4 key to toggle between listening and not listening for UDP packets.
 
+An external simulation on the same machine can instead publish poses into shared memory (see UWPosePublisher.h)
+or send the same packets to a Unix domain socket, and a remote one can send length-prefixed frames over a TCP
+connection.  Put "source shm", "source unix" or "source tcp" in UWTimedProcessingWithCameraUDPConfig.txt in the
+X-System folder to choose (see UWPoseSource.h).
+
+For multi-node rendering, "apply_mode epoch" in the same file makes every node apply the pose for a shared target
+display time instead of the newest one (see UWEpochApply.h).
+
+The sender can synchronize its clock with the plugin's by pinging it over the same socket (see UWClockSync.h and
+UWClockClient.h), so that its time stamps are mapped onto the plugin's clock.
+
+If the sender's terrain differs from X-Plane's, "altitude_mode agl" in the same file makes the packet altitude a
+height above X-Plane's terrain ("altitude_mode clamp" keeps it above mean sea level but never below the terrain),
+see UWTerrainCache.h.
+
+The overlay lists the navaids nearest the streamed position and the FMS leg being flown, for mission debriefs.  The
+navaids are indexed once, a slice per frame after the plugin starts ("navaid_types" and "navaid_range" in the same
+file choose which and how far, see UWNavaidIndex.h).
+
+Shift+F4 shows or hides the status window, with the performance HUD: receive rate, loss, reordering, latency,
+flight loop time, jitter buffer depth and extrapolation (see UWPerformanceHUD.h).  Text poses carry no sequence
+number here, so only binary pose records count towards loss and reordering.
+
+The port, the receive rate ("receive_rate" in the same file), the epoch delay and the transport can be changed while
+X-Plane runs from the plugin's menu under Plugins, or by binding keys to its commands (see UWSourceControl.h).  A new
+socket is opened on a thread of its own and swapped in once it is open, so the flight loop never waits for it.
+
 */
 
 
@@ -21,22 +48,33 @@ To use this plugin, press the F4 key to toggle between listening and not listeni
 #include "XPLMUtilities.h"
 #include "XPLMGraphics.h"
 #include "XPLMDisplay.h"
+#include "XPLMPlugin.h"
 #include "XPLMCamera.h"
 
 #include "PracticalSocket.h"   // For UDPSocket and SocketException
+#include "UWDataRefSchema.h"
+#include "UWPluginConfig.h"
+#include "UWPoseSource.h"
+#include "UWClockResponder.h"
+#include "UWEpochApply.h"
+#include "UWTerrainCache.h"
+#include "UWNavaidIndex.h"
+#include "UWStatusOverlay.h"
+#include "UWPerformanceHUD.h"
+#include "UWClock.h"
+#include "UWSourceControl.h"
 
 //----------------------------GLOBAL VARIALBES----------------------------------------
-#define MAX_ITEMS 11
-#define UDP_PORT_RECEIVE 49004					//port to listen to to receive UDP packets
-#define UDP_RECEIVE_DELTA_T 0.05				//time between UDP processes
-const int MAXRCVSTRING = 4096;					// Longest string to receive
+#define UDP_PORT_RECEIVE 49004					//default port to listen to to receive UDP packets
+#define SCHEMA_FILE "UWTimedProcessingWithCameraUDPSchema.txt"	//optional schema file in the X-System folder (see UWDataRefSchema.h)
+#define CONFIG_FILE "UWTimedProcessingWithCameraUDPConfig.txt"	//optional config file in the X-System folder (see UWPluginConfig.h)
 
 XPLMWindowID	gWindow = NULL;					//for displaying plugin status
 XPLMHotKeyID	gHotKey = NULL;					//used to register our hotkey
-XPLMDataRef		gPositionDataRef[MAX_ITEMS];	//hold all of the datarefs
+XPLMHotKeyID	gHudHotKey = NULL;				//shows and hides the status window
 int				gClicked = 0;					//used to determine if user is clicking in the window or not
+UWStatusOverlay	gOverlay;						//text of the status window (see UWStatusOverlay.h)
 bool			gListeningForUDPPackets;		//set this to true to start listening for UDP packets (it should start as false to avoid making X-Plane hang if no packets are incoming)
-bool			gDisplayOverlay = false;		//set this to true to display the overlay on the X-Plane window which shows plugin information (useful for debugging).
 
 float			gThetaC_Deg_fromUDP;			//camera angle in deg read from the UDP stream
 float			gPhiC_Deg_fromUDP;				//camera angle in deg read from the UDP stream
@@ -46,26 +84,36 @@ double			gLonC_Deg_fromUDP;				//camera position in deg read from UDP stream
 double			gAltC_m_fromUDP;				//camera position in meters read from UDP stream
 double			gZoomC_fromUDP;					//camera zoom read from UDP stream
 
-char DataRefString[MAX_ITEMS][255] = {
-	"sim/flightmodel/position/local_x", 
-	"sim/flightmodel/position/local_y", 
-	"sim/flightmodel/position/local_z",
-	"sim/flightmodel/position/lat_ref", 
-	"sim/flightmodel/position/lon_ref",	
-	"sim/flightmodel/position/theta", 
-	"sim/flightmodel/position/phi", 
-	"sim/flightmodel/position/psi", 
-	"sim/flightmodel/position/latitude", 
-	"sim/flightmodel/position/longitude", 
-	"sim/flightmodel/position/elevation"
-};
+UWDataRefSchema	gSchema;						//maps the words of a packet onto datarefs (resolved once at startup)
+double			gPacketWords[UW_SCHEMA_MAX_WORDS];	//words of the most recent packet
+int				gLatitudeField;					//index of the schema fields used to compute local_x, local_y, local_z
+int				gLongitudeField;
+int				gElevationField;
+int				gLocalXField;
+int				gLocalYField;
+int				gLocalZField;
+int				gCameraField[7];				//index of the schema fields of the camera (phi, theta, psi, lat, lon, alt, zoom)
+
+UWPoseSourceSettings	gSourceSettings;		//which transport to listen on (from the config file)
+UWSourceControl	gControl;						//port, rate, delay and transport changed at runtime (see UWSourceControl.h)
+UWPoseSource *	gSource;						//the source being read, one of gControl's (open while we are listening, never blocks)
+UWSourceMessage	gMessage;						//the message being processed
+UWClockResponder	gClock;						//clock synchronization with the sender (see UWClockResponder.h)
+UWEpochApply	gEpoch;							//epoch apply mode (see UWEpochApply.h)
+UWTerrainCache	gTerrain;						//altitude above the terrain (see UWTerrainCache.h)
+UWNavaidIndex	gNavaids;						//navaids near the streamed position, for the overlay (see UWNavaidIndex.h)
+UWPerformanceHUD	gHud;						//performance graphs on the status window (see UWPerformanceHUD.h)
+UWPoseRecord	gPose;							//a received text pose on its way to gPacketWords or the jitter buffer
+int				gTimestampField;				//index of the schema field with the sender time stamp (-1 if none)
+double			gPoseTimestamp;					//sender time stamp of the pose in gPacketWords
 
 
 
 
 //----------------------------FUNCTION PROTOTYPES-------------------------------------
-void ApplyThetaPhiPsiToDataRefs(float theta, float phi, float psi);
-void ApplyLatLonAltToDataRefs(double lat, double lon, double altitude);
+void LoadDataRefSchema();
+void ApplyLocalPositionToDataRefs(const double * words);
+bool ReadPose(const UWSourceMessage * message);
 
 void MyDrawWindowCallback(
                                    XPLMWindowID         inWindowID,    
@@ -90,12 +138,20 @@ int MyHandleMouseClickCallback(
 
 void	MyHotKeyCallback(void *               inRefcon);    
 
+void	MyHudHotKeyCallback(void *               inRefcon);    
+
 float	MyFlightLoopCallback(
                                    float                inElapsedSinceLastCall,    
                                    float                inElapsedTimeSinceLastFlightLoop,    
                                    int                  inCounter,    
                                    void *               inRefcon);    
 
+float	MyBuildNavaidsCallback(
+                                   float                inElapsedSinceLastCall,    
+                                   float                inElapsedTimeSinceLastFlightLoop,    
+                                   int                  inCounter,    
+                                   void *               inRefcon);    
+
 
 int 	MyCameraControlFunc(
                                    XPLMCameraPosition_t * outCameraPosition,  
@@ -122,27 +178,41 @@ PLUGIN_API int XPluginStart(
 	//Start up with listening for packets turned off (otherwise, x-plane will hang waiting for packets which may not be coming yet)
 	gListeningForUDPPackets = false;
 
-	//fill up the gPositionDataRef array with data references
-	for (int Item=0; Item<MAX_ITEMS; Item++)
-	{
-		gPositionDataRef[Item] = XPLMFindDataRef(DataRefString[Item]);
-	}
-
-	if(gDisplayOverlay) {
-		/* Now we create a window.  We pass in a rectangle in left, top,
-		* right, bottom screen coordinates.  We pass in three callbacks. */
-		int topLeftX = 725 - 1*350;
-		int topLeftY = 440 - 225;
-		int width = 250;
-		int height = 250;
-		gWindow = XPLMCreateWindow(
-			topLeftX, topLeftY, topLeftX+width, topLeftY-height,			/* Area of the window. */
-			1,							/* Start visible. */
-			MyDrawWindowCallback,		/* Callbacks */
-			MyHandleKeyCallback,
-			MyHandleMouseClickCallback,
-			NULL);						/* Refcon - not used. */
-	}
+	//read the transport settings
+	UWPluginConfig config;
+	UWConfigLoad(&config, CONFIG_FILE);
+	UWSourceReadSettings(&gSourceSettings, &config, UDP_PORT_RECEIVE);
+	UWClockResponderInit(&gClock, UWConfigGetDouble(&config, "clock_offset", 0.0), "uw/timed_processing_camera_udp");
+	UWEpochReadSettings(&gEpoch, &config, &gClock);
+	gSourceSettings.keepEveryRecord = gEpoch.enabled;		//the jitter buffer needs every pose
+	UWTerrainReadSettings(&gTerrain, &config, "uw/timed_processing_camera_udp");
+	UWNavaidReadSettings(&gNavaids, &config);
+
+	//build the schema and resolve all of the data references once
+	LoadDataRefSchema();
+
+	UWOverlayInit(&gOverlay, UWConfigGetDouble(&config, "overlay_rate", UW_OVERLAY_REFRESH_RATE));
+	UWHudInit(&gHud);
+
+	//the commands and the menu which change the settings at runtime
+	UWControlInit(&gControl, "UWTimedProcessingWithCameraUDP", "uw/timed_processing_camera_udp",
+				  &config, &gSourceSettings, &gEpoch, &gOverlay);
+	gSource = gControl.active;
+
+	/* Now we create a window.  We pass in a rectangle in left, top,
+	* right, bottom screen coordinates.  We pass in three callbacks.
+	* It starts hidden (X-Plane does not draw it) until Shift+F4 shows it. */
+	int topLeftX = 725 - 1*350;
+	int topLeftY = 440 + 225;
+	int width = 400;
+	int height = 330;
+	gWindow = XPLMCreateWindow(
+		topLeftX, topLeftY, topLeftX+width, topLeftY-height,			/* Area of the window. */
+		0,							/* Start hidden. */
+		MyDrawWindowCallback,		/* Callbacks */
+		MyHandleKeyCallback,
+		MyHandleMouseClickCallback,
+		NULL);						/* Refcon - not used. */
 
 	/* Register our hot key for applying a new position. */
 	gHotKey = XPLMRegisterHotKey(XPLM_VK_F4, xplm_DownFlag, 
@@ -150,14 +220,21 @@ PLUGIN_API int XPluginStart(
 		MyHotKeyCallback,
 		NULL);
 
+	gHudHotKey = XPLMRegisterHotKey(XPLM_VK_F4, xplm_DownFlag | xplm_ShiftFlag,
+		"Show/hide the status window and performance HUD",
+		MyHudHotKeyCallback,
+		NULL);
 
 	/* Register our callback for once a second.  Positive intervals
 	 * are in seconds, negative are the negative of sim frames.  Zero
 	 * registers but does not schedule a callback for time. */
 	XPLMRegisterFlightLoopCallback(		
 			MyFlightLoopCallback,	/* Callback */
-			UDP_RECEIVE_DELTA_T,					/* Interval */
+			gEpoch.enabled ? -1.0f : UWControlInterval(&gControl),	/* Interval (every frame in epoch mode) */
 			NULL);					/* refcon not used. */
+
+	//index the navaids a slice per frame (see UWNavaidIndex.h)
+	XPLMRegisterFlightLoopCallback(MyBuildNavaidsCallback, -1.0f, NULL);
 			
 	return 1;
 }
@@ -168,6 +245,14 @@ PLUGIN_API void	XPluginStop(void)
 {
 	/* Unregister the callback */
 	XPLMUnregisterFlightLoopCallback(MyFlightLoopCallback, NULL);
+	XPLMUnregisterFlightLoopCallback(MyBuildNavaidsCallback, NULL);
+
+	UWControlStop(&gControl);
+	UWControlDestroy(&gControl);
+	UWEpochStop(&gEpoch);
+	UWClockResponderStop(&gClock);
+	UWTerrainStop(&gTerrain);
+	UWNavaidStop(&gNavaids);
 	
 	///* Close the file */
 	//fclose(gOutputFile);
@@ -196,39 +281,89 @@ PLUGIN_API void XPluginReceiveMessage(
 					long			inMessage,
 					void *			inParam)
 {
+	//the cached terrain elevations may be out of date once new scenery is loaded
+	if(inMessage == XPLM_MSG_SCENERY_LOADED) {
+		UWTerrainFlush(&gTerrain);
+	}
 }
 
 
 
 //-------------------------FUNCTION DEFINITIONS---------------------------------------
 /*
-Apply the specified Euler angles to the datarefs
+Build the schema which maps the words of a packet onto datarefs.  If the schema file exists in the X-System folder
+it is used, otherwise the default packet layout is used
+
+	'phiDeg thetaDeg psiDeg latitudeDeg longitudeDeg altitudeMeters phiC_Deg thetaC_Deg psiC_Deg latitudeC_Deg longitudeC_Deg altitudeC_Meters zoomC'
+
+The camera words are not written to datarefs; they are picked up by MyCameraControlFunc.  Every dataref handle and
+type is resolved here so that the flight loop does not have to look anything up.
 */
-void ApplyThetaPhiPsiToDataRefs(float theta, float phi, float psi)
+void LoadDataRefSchema()
 {
-	//apply the angles to the datarefs
-	XPLMSetDataf(gPositionDataRef[5], theta);
-	XPLMSetDataf(gPositionDataRef[6], phi);
-	XPLMSetDataf(gPositionDataRef[7], psi);
+	if(UWSchemaLoad(&gSchema, SCHEMA_FILE) == 0) {
+		UWSchemaClear(&gSchema);
+		UWSchemaAddField(&gSchema, "local_x",	-1,	uwFieldType_Double,	1.0, "sim/flightmodel/position/local_x");
+		UWSchemaAddField(&gSchema, "local_y",	-1,	uwFieldType_Double,	1.0, "sim/flightmodel/position/local_y");
+		UWSchemaAddField(&gSchema, "local_z",	-1,	uwFieldType_Double,	1.0, "sim/flightmodel/position/local_z");
+		UWSchemaAddField(&gSchema, "lat_ref",	-1,	uwFieldType_Float,	1.0, "sim/flightmodel/position/lat_ref");
+		UWSchemaAddField(&gSchema, "lon_ref",	-1,	uwFieldType_Float,	1.0, "sim/flightmodel/position/lon_ref");
+		UWSchemaAddField(&gSchema, "theta",		1,	uwFieldType_Float,	1.0, "sim/flightmodel/position/theta");
+		UWSchemaAddField(&gSchema, "phi",		0,	uwFieldType_Float,	1.0, "sim/flightmodel/position/phi");
+		UWSchemaAddField(&gSchema, "psi",		2,	uwFieldType_Float,	1.0, "sim/flightmodel/position/psi");
+		UWSchemaAddField(&gSchema, "latitude",	3,	uwFieldType_Double,	1.0, "sim/flightmodel/position/latitude");
+		UWSchemaAddField(&gSchema, "longitude",	4,	uwFieldType_Double,	1.0, "sim/flightmodel/position/longitude");
+		UWSchemaAddField(&gSchema, "elevation",	5,	uwFieldType_Double,	1.0, "sim/flightmodel/position/elevation");
+		UWSchemaAddField(&gSchema, "phiC",		6,	uwFieldType_Float,	1.0, "-");
+		UWSchemaAddField(&gSchema, "thetaC",	7,	uwFieldType_Float,	1.0, "-");
+		UWSchemaAddField(&gSchema, "psiC",		8,	uwFieldType_Float,	1.0, "-");
+		UWSchemaAddField(&gSchema, "latitudeC",	9,	uwFieldType_Double,	1.0, "-");
+		UWSchemaAddField(&gSchema, "longitudeC",10,	uwFieldType_Double,	1.0, "-");
+		UWSchemaAddField(&gSchema, "elevationC",11,	uwFieldType_Double,	1.0, "-");
+		UWSchemaAddField(&gSchema, "zoomC",		12,	uwFieldType_Float,	1.0, "-");
+	}
+
+	UWSchemaResolve(&gSchema);
+
+	gLatitudeField	= UWSchemaFindField(&gSchema, "latitude");
+	gLongitudeField	= UWSchemaFindField(&gSchema, "longitude");
+	gElevationField	= UWSchemaFindField(&gSchema, "elevation");
+	gLocalXField	= UWSchemaFindField(&gSchema, "local_x");
+	gLocalYField	= UWSchemaFindField(&gSchema, "local_y");
+	gLocalZField	= UWSchemaFindField(&gSchema, "local_z");
+	gTimestampField	= UWSchemaFindField(&gSchema, "timestamp");
+
+	gCameraField[0]	= UWSchemaFindField(&gSchema, "phiC");
+	gCameraField[1]	= UWSchemaFindField(&gSchema, "thetaC");
+	gCameraField[2]	= UWSchemaFindField(&gSchema, "psiC");
+	gCameraField[3]	= UWSchemaFindField(&gSchema, "latitudeC");
+	gCameraField[4]	= UWSchemaFindField(&gSchema, "longitudeC");
+	gCameraField[5]	= UWSchemaFindField(&gSchema, "elevationC");
+	gCameraField[6]	= UWSchemaFindField(&gSchema, "zoomC");
 }
 
 
 
 /*
-Apply the specified lat/lon/alt to the datarefs.  Note the units on the inputs arguments 
+Use XPLMWorldToLocal to compute the local_x, local_y, local_z from the lat/lon/alt in the packet and apply them to 
+the datarefs.  Note the units of the packet words
 
 latitude in degrees
 longitude in degrees
-altitude in meters
-
-This will then use XPLMWorldToLocal to also compute the local_x, local_y, local_z and apply them to the datarefs
+altitude in meters (above mean sea level, or above the terrain in the agl altitude mode)
 */
-void ApplyLatLonAltToDataRefs(double latitudeDeg, double longitudeDeg, double altitudeMeters)
+void ApplyLocalPositionToDataRefs(const double * words)
 {
-	//apply the positions to the data refs
-	XPLMSetDatad(gPositionDataRef[8], latitudeDeg);
-	XPLMSetDatad(gPositionDataRef[9], longitudeDeg);
-	XPLMSetDatad(gPositionDataRef[10], altitudeMeters);
+	if(gLatitudeField < 0 || gLongitudeField < 0 || gElevationField < 0) {
+		return;
+	}
+
+	double latitudeDeg		= UWSchemaGetValue(&gSchema, gLatitudeField, words);
+	double longitudeDeg		= UWSchemaGetValue(&gSchema, gLongitudeField, words);
+	double altitudeMeters	= UWSchemaGetValue(&gSchema, gElevationField, words);
+
+	//resolve the altitude against X-Plane's terrain (a cache lookup unless the aircraft has moved onto new ground)
+	altitudeMeters = UWTerrainResolveAltitude(&gTerrain, latitudeDeg, longitudeDeg, altitudeMeters);
 
 	//compute the local_x, local_y, and local_z values
 	double local_x;
@@ -237,151 +372,146 @@ void ApplyLatLonAltToDataRefs(double latitudeDeg, double longitudeDeg, double al
 	XPLMWorldToLocal(latitudeDeg, longitudeDeg, altitudeMeters, &local_x, &local_y, &local_z);
 
 	//apply the local_x, local_y, and local_z values to the datarefs
-	XPLMSetDatad(gPositionDataRef[0], local_x);
-	XPLMSetDatad(gPositionDataRef[1], local_y);
-	XPLMSetDatad(gPositionDataRef[2], local_z);
+	UWSchemaSetField(&gSchema, gLocalXField, local_x);
+	UWSchemaSetField(&gSchema, gLocalYField, local_y);
+	UWSchemaSetField(&gSchema, gLocalZField, local_z);
 }
 
 
 
 /*
-Process what to do at timed intervals
+Take the pose out of a text pose packet or a binary pose record.  Returns false if the message does not hold
+every word the schema needs.
+
+In the default mode the pose is copied to gPacketWords (returns true).  In epoch mode it goes into the jitter
+buffer and is picked from there after all of the packets have been read (returns false).
 */
-float	MyFlightLoopCallback(
-                                   float                inElapsedSinceLastCall,    
-                                   float                inElapsedTimeSinceLastFlightLoop,    
-                                   int                  inCounter,    
-                                   void *               inRefcon)
+bool ReadPose(const UWSourceMessage * message)
 {
-	/* The actual callback.  First we read the sim's time and the data. */
-	float	elapsed = XPLMGetElapsedTime();
-
-	if(gListeningForUDPPackets) {
-		//Setup the containers for values we want to get from UDP
-		double phiDegDouble;
-		double thetaDegDouble;
-		double psiDegDouble;
-		double latitudeDeg;
-		double longitudeDeg;
-		double altitudeMeters;
-		
-		double phiC_DegDouble;
-		double thetaC_DegDouble;
-		double psiC_DegDouble;
-		double latitudeC_DegDouble;
-		double longitudeC_DegDouble;
-		double altitudeC_MetersDouble;
-		double zoomC_Double;
-		
-		//Some of these will need to be converted to floats
-		float phiDeg;
-		float thetaDeg;
-		float psiDeg;
-
-		float phiC_Deg;
-		float thetaC_Deg;
-		float psiC_Deg;
-		
-		//receive the data from the UDP port
-		try {
-			unsigned short echoServPort = UDP_PORT_RECEIVE;
-			UDPSocket sock(echoServPort);                
-
-			char recvString[MAXRCVSTRING + 1]; // This will be the buffer for echo string + \0
-			string sourceAddress;              // Address of datagram source
-			unsigned short sourcePort;         // Port of datagram source
-			int bytesRcvd = sock.recvFrom(recvString, MAXRCVSTRING, sourceAddress, sourcePort);
-			recvString[bytesRcvd] = '\0';		// Terminate string
-
-			//Convert the recieved string to values
-			char *pch;			
-			pch = strtok(recvString," ");
+	const UWPoseRecord * pose = &message->record;
 
-			for(int wordNumber = 0; wordNumber < 13; wordNumber++)
-			{
-				double value = atof(pch);
-
-				if (wordNumber==0) {
-					phiDegDouble = value;
-
-				} else if (wordNumber==1) {
-					thetaDegDouble = value;
-
-				} else if (wordNumber==2) {
-					psiDegDouble = value;
-
-				} else if (wordNumber==3) {
-					latitudeDeg = value;
-
-				} else if (wordNumber==4) {
-					longitudeDeg = value;
+	if(message->kind != uwMessage_Record) {
+		//a badly formed packet must not clobber a good pose received earlier in the same frame
+		if(UWSchemaParsePacket(&gSchema, message->packet, gPose.words) != gSchema.numPacketWords) {
+			return false;
+		}
 
-				} else if (wordNumber==5) {
-					altitudeMeters = value;
+		//text packets only carry a time stamp if the schema has one, otherwise they are stamped on arrival
+		gPose.sequence	= 0;
+		gPose.numWords	= gSchema.numPacketWords;
+		gPose.timestamp	= (gTimestampField >= 0) ? UWSchemaGetValue(&gSchema, gTimestampField, gPose.words) : UWEpochSharedTime(&gEpoch);
+		pose = &gPose;
+	}
 
-				} else if (wordNumber==6) {
-					phiC_DegDouble = value;
+	if(pose->numWords < gSchema.numPacketWords) {
+		return false;
+	}
 
-				} else if (wordNumber==7) {
-					thetaC_DegDouble = value;
+	UWHudReceived(&gHud, message->kind == uwMessage_Record, pose->sequence);
+	if(gEpoch.enabled) {
+		UWEpochPush(&gEpoch, pose, message->receiveTime);
+		return false;
+	}
 
-				} else if (wordNumber==8) {
-					psiC_DegDouble = value;
+	memcpy(gPacketWords, pose->words, gSchema.numPacketWords * sizeof(double));
+	gPoseTimestamp = pose->timestamp;
+	return true;
+}
 
-				} else if (wordNumber==9) {
-					latitudeC_DegDouble = value;
 
-				} else if (wordNumber==10) {
-					longitudeC_DegDouble = value;
 
-				} else if (wordNumber==11) {
-					altitudeC_MetersDouble = value;
+/*
+Process what to do at timed intervals
+*/
+float	MyFlightLoopCallback(
+                                   float                inElapsedSinceLastCall,    
+                                   float                inElapsedTimeSinceLastFlightLoop,    
+                                   int                  inCounter,    
+                                   void *               inRefcon)
+{
+	/* The actual callback.  First we read the sim's time and the data. */
+	float	elapsed = XPLMGetElapsedTime();
+	double	start	= UWClockMonotonicSeconds();
 
-				} else if (wordNumber==12) {
-					zoomC_Double = value;
+	//swap to a new source once it is open (see UWSourceControl.h)
+	gSource = UWControlTakeSource(&gControl);
 
-				} else {
-				}		
+	//send what is left of the replies the TCP connection could not take last time
+	UWSourceFlush(gSource);
 
-				pch = strtok (NULL, " ");
+	if(gListeningForUDPPackets && UWSourceIsOpen(gSource)) {
+		//drain everything which is waiting on the source (it is non-blocking so this never waits)
+		bool havePose = false;
+		while(UWSourceReceive(gSource, &gMessage) != uwMessage_None) {
+			//clock pings are answered straight away, everything else is a pose
+			if(!UWClockResponderAnswer(&gClock, gSource, &gMessage)) {
+				havePose |= ReadPose(&gMessage);
 			}
+		}
 
-			//convert phi, theta, psi to floats
-			phiDeg				= (float)phiDegDouble;
-			thetaDeg			= (float)thetaDegDouble;
-			psiDeg				= (float)psiDegDouble;
+		//in epoch mode the pose for the shared target display time is used
+		if(gEpoch.enabled) {
+			const UWPoseRecord * pose = UWEpochSelect(&gEpoch, NULL);
+			if(pose != NULL) {
+				memcpy(gPacketWords, pose->words, gSchema.numPacketWords * sizeof(double));
+				gPoseTimestamp = pose->timestamp;
+				havePose = true;
+			}
+			UWEpochReport(&gEpoch);
 
-			//convert phiC, thetaC, psiC to floats
-			phiC_Deg			= (float)phiC_DegDouble;
-			thetaC_Deg			= (float)thetaC_DegDouble;
-			psiC_Deg			= (float)psiC_DegDouble;
+			//how far the target display time is ahead of the pose shown
+			if(gEpoch.lastAppliedTimestamp != 0.0) {
+				UWHudBuffer(&gHud, UWJitterDepth(&gEpoch.jitter),
+							UWEpochSharedTime(&gEpoch) - gEpoch.delay - gEpoch.lastAppliedTimestamp);
+			}
+		}
 
+		//only the newest pose is used
+		if(havePose) {
 			//for camera variables, write these to the appropriate global variables
-			gPhiC_Deg_fromUDP	= phiC_Deg;
-			gThetaC_Deg_fromUDP = thetaC_Deg;
-			gPsiC_Deg_fromUDP	= psiC_Deg;
-			
-			gLatC_Deg_fromUDP	= latitudeC_DegDouble;
-			gLonC_Deg_fromUDP	= longitudeC_DegDouble;
-			gAltC_m_fromUDP		= altitudeC_MetersDouble;
-			gZoomC_fromUDP		= zoomC_Double;
+			gPhiC_Deg_fromUDP	= (float)UWSchemaGetValue(&gSchema, gCameraField[0], gPacketWords);
+			gThetaC_Deg_fromUDP = (float)UWSchemaGetValue(&gSchema, gCameraField[1], gPacketWords);
+			gPsiC_Deg_fromUDP	= (float)UWSchemaGetValue(&gSchema, gCameraField[2], gPacketWords);
 			
-		} catch (SocketException &e) {
-
+			gLatC_Deg_fromUDP	= UWSchemaGetValue(&gSchema, gCameraField[3], gPacketWords);
+			gLonC_Deg_fromUDP	= UWSchemaGetValue(&gSchema, gCameraField[4], gPacketWords);
+			gAltC_m_fromUDP		= UWSchemaGetValue(&gSchema, gCameraField[5], gPacketWords);
+			gZoomC_fromUDP		= UWSchemaGetValue(&gSchema, gCameraField[6], gPacketWords);
+
+			//Set the remaining values to the datarefs
+			UWSchemaApply(&gSchema, gPacketWords);
+			ApplyLocalPositionToDataRefs(gPacketWords);
+			UWHudApplied(&gHud, UWClockResponderSenderTime(&gClock) - gPoseTimestamp);
 		}
-
-		//Set these values to the datarefs
-		ApplyThetaPhiPsiToDataRefs(thetaDeg, phiDeg, psiDeg);
-		ApplyLatLonAltToDataRefs(latitudeDeg, longitudeDeg, altitudeMeters);
 	}
 
-	/* Return UDP_RECEIVE_DELTA_T to indicate that we want to be called again in UDP_RECEIVE_DELTA_T second. */
+	//the performance HUD is sampled whether or not it is shown
+	double end = UWClockMonotonicSeconds();
+	UWHudFlightLoop(&gHud, end - start);
+	UWHudStep(&gHud, end);
+
+	/* Return the receive interval (receive_rate, which can be changed from the Plugins menu) to be called again. */
 	//DOES THIS NEED TO BE CHANGED TO CALLING RATE?
-	return UDP_RECEIVE_DELTA_T;
+	//(in epoch mode we are called every frame so the target display time is met on every frame)
+	return gEpoch.enabled ? -1.0f : UWControlInterval(&gControl);
 }                                   
 
 
 
+/*
+Build the navaid index for at most navaid_build_budget milliseconds a frame, until it is built
+*/
+float	MyBuildNavaidsCallback(
+                                   float                inElapsedSinceLastCall,    
+                                   float                inElapsedTimeSinceLastFlightLoop,    
+                                   int                  inCounter,    
+                                   void *               inRefcon)
+{
+	return UWNavaidBuildStep(&gNavaids) ? 0.0f : -1.0f;
+}
+
+
+
 /*
  * MyDrawingWindowCallback
  * 
@@ -395,83 +525,74 @@ void MyDrawWindowCallback(
                                    XPLMWindowID         inWindowID,    
                                    void *               inRefcon)
 {
-	int		left, top, right, bottom;
-	float	color[] = { 1.0, 1.0, 1.0 }; 	/* RGB White */
-	int		verticalLineSpacing = 10;
-	
-	/* First we get the location of the window passed in to us. */
-	XPLMGetWindowGeometry(inWindowID, &left, &top, &right, &bottom);
-	
-	/* We now use an XPLMGraphics routine to draw a translucent dark
-	 * rectangle that is our window's shape. */
-	XPLMDrawTranslucentDarkBox(left, top, right, bottom);
-
-	/* Finally we draw the text into the window, also using XPLMGraphics
-	 * routines.  The NULL indicates no word wrapping. */
-		
+	//format the text only when it is due, and draw the lines kept from the last refresh (see UWStatusOverlay.h)
+	if(UWOverlayBeginRefresh(&gOverlay)) {
 		//Line 1 (display plugin info)
-	XPLMDrawString(color, left + 5, top - 1*verticalLineSpacing, 
-		(char*)(gClicked ? "You are clicking here" : "UWTimedProcessingWithCameraUDP"), NULL, xplmFont_Basic);
-	
-	//Line 2 (plugin instructions)
-	XPLMDrawString(color, left + 5, top - 2*verticalLineSpacing, "Press F4 to toggle UDP listening on/off", NULL, xplmFont_Basic);
-	
-	//Line 3 (display status of listening or not)
-	if(gListeningForUDPPackets) {
-		XPLMDrawString(color, left + 5, top - 3*verticalLineSpacing, "Currently listening for UDP packets", NULL, xplmFont_Basic);
-	} else {
-		XPLMDrawString(color, left + 5, top - 3*verticalLineSpacing, "Currently not listening for UDP packets", NULL, xplmFont_Basic);
-	}
+		UWOverlaySetText(&gOverlay, 1, gClicked ? "You are clicking here" : "UWTimedProcessingWithCameraUDP");
 
-	////Line 4 & 5 (display port number that UDP is listening for)
-	char UDP_port_receive_char[10];
-	itoa(UDP_PORT_RECEIVE, UDP_port_receive_char, 10);
-	
-	XPLMDrawString(color, left + 5, top - 4*verticalLineSpacing, "Port number for UDP packets displayed below", NULL, xplmFont_Basic);
-	XPLMDrawString(color, left + 5, top - 5*verticalLineSpacing, UDP_port_receive_char, NULL, xplmFont_Basic);
-	
-	//Print out all the data refs
-	for(int i = 0; i < MAX_ITEMS; i++) 
-	{
-		char currentValue_char[20];
-		if((i==0) || (i==1) || (i==2) || (i==8) || (i==9) || (i==10)) {
-			//doubles stored at these locations
-			double valueDouble = XPLMGetDatad(gPositionDataRef[i]);
-			sprintf(currentValue_char, "%f", valueDouble);
-
-		} else {
-			//floats stored at these locations
-			float valueFloat = XPLMGetDataf(gPositionDataRef[i]);
-			sprintf(currentValue_char, "%f", valueFloat);
+		//Line 2 (plugin instructions)
+		UWOverlaySetText(&gOverlay, 2, "Press F4 to toggle UDP listening on/off");
+
+		//Line 3 (display status of listening or not)
+		UWOverlaySetText(&gOverlay, 3, gListeningForUDPPackets ? "Currently listening for UDP packets"
+															   : "Currently not listening for UDP packets");
+
+		//Line 4 & 5 (display where the poses are read from)
+		UWOverlaySetText(&gOverlay, 4, "Poses are read from");
+		UWSourceDescribe(&gSourceSettings, UWOverlayText(&gOverlay, 5));
+
+		//Line 6 (display the clock offset to the sender)
+		UWClockResponderDescribe(&gClock, UWOverlayText(&gOverlay, 6));
+
+		//Line 7 (display the altitude mode and the terrain cache statistics)
+		UWTerrainDescribe(&gTerrain, UWOverlayText(&gOverlay, 7));
+
+		//Line 8 to 14 (display the navaids nearest the streamed position and the FMS leg being flown)
+		UWNavaidQueryOverlay(&gNavaids);
+		UWNavaidDescribe(&gNavaids, UWOverlayText(&gOverlay, 8));
+		for(int hit = 0; hit < UW_NAVAID_OVERLAY_HITS; hit++) {
+			UWNavaidDescribeHit(&gNavaids, hit, UWOverlayText(&gOverlay, 9 + hit));
 		}
-		
-		char totalString[300];
-		strcpy(totalString, DataRefString[i]);
-		strcat(totalString, " is ");
-		strcat(totalString, currentValue_char);
+		UWNavaidDescribeLeg(UWOverlayText(&gOverlay, 14));
 
-		XPLMDrawString(color, left + 5, top - (i+6)*verticalLineSpacing, totalString, NULL, xplmFont_Basic);
+		//Line 15 to 28 (display the performance HUD)
+		UWHudDescribe(&gHud, &gOverlay, 15);
+
+		//Line 29 (display the receive rate and the epoch delay set from the Plugins menu)
+		UWControlDescribe(&gControl, UWOverlayText(&gOverlay, 29));
 	}
+
+	UWOverlayDraw(&gOverlay, inWindowID);
+	UWHudDraw(&gHud, inWindowID, 15);
 } 
 
 
 
 /*
-Read in info from a UDP socket and set the aircraft orientation and position to that value.
-
-Note that this will block until it receives the UDP packet
+Toggle listening for UDP packets.  The source is opened when we start listening and is non-blocking, so the
+flight loop never waits for packets which may not be coming.
 */
 void	MyHotKeyCallback(void *               inRefcon)
 {	
+	//show what the hot key changed right away
+	UWOverlayInvalidate(&gOverlay);
+
 	//toggle the gListeningForUDPPackets
 	if(gListeningForUDPPackets) {
 		//stop listening for packets
 		gListeningForUDPPackets = false;
 
+		UWControlStop(&gControl);
+		UWEpochStop(&gEpoch);
+
 	} else {
 		//start listening for packets
 		gListeningForUDPPackets = true;
 
+		//the source is opened on gControl's thread and kept open while listening
+		UWControlStart(&gControl);
+		UWEpochStart(&gEpoch);
+
 		/* This is the hotkey callback.  First we simulate a joystick press and
 		* release to put us in 'free view 1'.  This guarantees that no panels
 		* are showing and we are an external view. */
@@ -485,6 +606,18 @@ void	MyHotKeyCallback(void *               inRefcon)
 
 
 
+/*
+Show or hide the status window.  X-Plane does not call the draw callback of a hidden window, so the overlay and the
+HUD graphs cost nothing while it is hidden (the HUD is still sampled, so it shows the last minute right away).
+*/
+void	MyHudHotKeyCallback(void *               inRefcon)
+{
+	XPLMSetWindowIsVisible(gWindow, !XPLMGetWindowIsVisible(gWindow));
+	UWOverlayInvalidate(&gOverlay);
+}
+
+
+
 /*
  * MyHandleKeyCallback
  * 
@@ -521,8 +654,10 @@ int MyHandleMouseClickCallback(
 {
 	/* If we get a down or up, toggle our status click.  We will
 	 * never get a down without an up if we accept the down. */
-	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp))
+	if ((inMouse == xplm_MouseDown) || (inMouse == xplm_MouseUp)) {
 		gClicked = 1 - gClicked;
+		UWOverlayInvalidate(&gOverlay);
+	}
 	
 	/* Returning 1 tells X-Plane that we 'accepted' the click; otherwise
 	 * it would be passed to the next window behind us.  If we accept
@@ -30,9 +30,20 @@
   #include <arpa/inet.h>       // For inet_addr()
   #include <unistd.h>          // For close()
   #include <netinet/in.h>      // For sockaddr_in
+  #include <netinet/tcp.h>     // For TCP_NODELAY
+  #include <fcntl.h>           // For fcntl()
+  #include <sys/un.h>          // For sockaddr_un
+  #include <sys/stat.h>        // For lstat()
+  #include <stddef.h>          // For offsetof()
+  #include <sys/uio.h>         // For iovec
   typedef void raw_type;       // Type used for raw data on this platform
 #endif
 
+#if defined(__linux__) && defined(_GNU_SOURCE)
+  #define HAVE_SENDMMSG        // sendmmsg() is declared by sys/socket.h
+  const int SENDMMSG_BATCH = 64;
+#endif
+
 #include <errno.h>             // For errno
 
 using namespace std;
@@ -75,6 +86,62 @@ static void fillAddr(const string &address, unsigned short port,
   addr.sin_port = htons(port);     // Assign port in network byte order
 }
 
+// Function to tell if a failed call only failed because a non-blocking
+// socket had nothing to do
+static bool wouldBlock() {
+  #ifdef WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+  #else
+    return errno == EWOULDBLOCK || errno == EAGAIN;
+  #endif
+}
+
+#ifndef WIN32
+// Function to fill in a Unix domain address structure given a path.  A
+// leading '@' selects the abstract namespace.
+static socklen_t fillUnixAddr(const string &path, sockaddr_un &addr) {
+  memset(&addr, 0, sizeof(addr));  // Zero out address structure
+  addr.sun_family = AF_UNIX;
+
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    throw SocketException("Unix socket path is empty or too long");
+  }
+
+  // The abstract name is the bytes after a leading '\0'
+  memcpy(addr.sun_path, path.data(), path.size());
+  if (path[0] == '@') {
+    addr.sun_path[0] = '\0';
+    return offsetof(sockaddr_un, sun_path) + path.size();
+  }
+  return sizeof(addr);
+}
+
+// Function to remove the socket file at path.  Anything else at the path (a
+// mistyped path naming a regular file, say) is left alone, as are abstract
+// names, which have no file.
+static void unlinkSocketFile(const string &path) {
+  struct stat info;
+  if (path.empty() || path[0] == '@' || lstat(path.c_str(), &info) != 0 ||
+      !S_ISSOCK(info.st_mode)) {
+    return;
+  }
+  ::unlink(path.c_str());
+}
+
+// Function to turn an address filled in by recvfrom() back into a path
+static string unixAddrToPath(const sockaddr_un &addr, socklen_t addrLen) {
+  if (addrLen <= offsetof(sockaddr_un, sun_path)) {
+    return "";                     // Unbound sender
+  }
+
+  size_t length = addrLen - offsetof(sockaddr_un, sun_path);
+  if (addr.sun_path[0] == '\0') {
+    return "@" + string(addr.sun_path + 1, length - 1);
+  }
+  return string(addr.sun_path, strnlen(addr.sun_path, length));
+}
+#endif
+
 // Socket Code
 
 Socket::Socket(int type, int protocol) throw(SocketException) {
@@ -97,6 +164,26 @@ Socket::Socket(int type, int protocol) throw(SocketException) {
   }
 }
 
+Socket::Socket(int domain, int type, int protocol) throw(SocketException) {
+  #ifdef WIN32
+    if (!initialized) {
+      WORD wVersionRequested;
+      WSADATA wsaData;
+
+      wVersionRequested = MAKEWORD(2, 0);              // Request WinSock v2.0
+      if (WSAStartup(wVersionRequested, &wsaData) != 0) {  // Load WinSock DLL
+        throw SocketException("Unable to load WinSock DLL");
+      }
+      initialized = true;
+    }
+  #endif
+
+  // Make a new socket in the given domain
+  if ((sockDesc = socket(domain, type, protocol)) < 0) {
+    throw SocketException("Socket creation failed (socket())", true);
+  }
+}
+
 Socket::Socket(int sockDesc) {
   this->sockDesc = sockDesc;
 }
@@ -154,6 +241,36 @@ void Socket::setLocalAddressAndPort(const string &localAddress,
   }
 }
 
+void Socket::setBlocking(bool blocking) throw(SocketException) {
+  #ifdef WIN32
+    u_long nonBlocking = blocking ? 0 : 1;
+    if (ioctlsocket(sockDesc, FIONBIO, &nonBlocking) != 0) {
+      throw SocketException("Set of blocking mode failed (ioctlsocket())", true);
+    }
+  #else
+    int flags = fcntl(sockDesc, F_GETFL, 0);
+    if (flags < 0 || fcntl(sockDesc, F_SETFL, 
+        blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK)) < 0) {
+      throw SocketException("Set of blocking mode failed (fcntl())", true);
+    }
+  #endif
+}
+
+void Socket::setReuseAddress(bool reuse) throw(SocketException) {
+  int flag = reuse ? 1 : 0;
+  if (setsockopt(sockDesc, SOL_SOCKET, SO_REUSEADDR, 
+                 (raw_type *) &flag, sizeof(flag)) < 0) {
+    throw SocketException("Set of SO_REUSEADDR failed (setsockopt())", true);
+  }
+}
+
+void Socket::setReceiveBufferSize(int bytes) throw(SocketException) {
+  if (setsockopt(sockDesc, SOL_SOCKET, SO_RCVBUF, 
+                 (raw_type *) &bytes, sizeof(bytes)) < 0) {
+    throw SocketException("Set of SO_RCVBUF failed (setsockopt())", true);
+  }
+}
+
 void Socket::cleanUp() throw(SocketException) {
   #ifdef WIN32
     if (WSACleanup() != 0) {
@@ -178,6 +295,10 @@ CommunicatingSocket::CommunicatingSocket(int type, int protocol)
     throw(SocketException) : Socket(type, protocol) {
 }
 
+CommunicatingSocket::CommunicatingSocket(int domain, int type, int protocol)
+    throw(SocketException) : Socket(domain, type, protocol) {
+}
+
 CommunicatingSocket::CommunicatingSocket(int newConnSD) : Socket(newConnSD) {
 }
 
@@ -193,17 +314,32 @@ void CommunicatingSocket::connect(const string &foreignAddress,
   }
 }
 
-void CommunicatingSocket::send(const void *buffer, int bufferLen) 
+int CommunicatingSocket::send(const void *buffer, int bufferLen) 
     throw(SocketException) {
-  if (::send(sockDesc, (raw_type *) buffer, bufferLen, 0) < 0) {
+  // Don't let a peer which has gone away kill the whole process with SIGPIPE
+  #ifdef MSG_NOSIGNAL
+    int flags = MSG_NOSIGNAL;
+  #else
+    int flags = 0;
+  #endif
+  int rtn;
+  if ((rtn = ::send(sockDesc, (raw_type *) buffer, bufferLen, flags)) < 0) {
+    if (wouldBlock()) {
+      return -1;
+    }
     throw SocketException("Send failed (send())", true);
   }
+
+  return rtn;
 }
 
 int CommunicatingSocket::recv(void *buffer, int bufferLen) 
     throw(SocketException) {
   int rtn;
   if ((rtn = ::recv(sockDesc, (raw_type *) buffer, bufferLen, 0)) < 0) {
+    if (wouldBlock()) {
+      return -1;
+    }
     throw SocketException("Received failed (recv())", true);
   }
 
@@ -244,12 +380,26 @@ TCPSocket::TCPSocket(const string &foreignAddress, unsigned short foreignPort)
 }
 
 TCPSocket::TCPSocket(int newConnSD) : CommunicatingSocket(newConnSD) {
+  // Where send() has no MSG_NOSIGNAL (Mac), ask for no SIGPIPE on the socket
+  #if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+    int flag = 1;
+    setsockopt(sockDesc, SOL_SOCKET, SO_NOSIGPIPE, (raw_type *) &flag, sizeof(flag));
+  #endif
+}
+
+void TCPSocket::setNoDelay(bool noDelay) throw(SocketException) {
+  int flag = noDelay ? 1 : 0;
+  if (setsockopt(sockDesc, IPPROTO_TCP, TCP_NODELAY, 
+                 (raw_type *) &flag, sizeof(flag)) < 0) {
+    throw SocketException("Set of TCP_NODELAY failed (setsockopt())", true);
+  }
 }
 
 // TCPServerSocket Code
 
 TCPServerSocket::TCPServerSocket(unsigned short localPort, int queueLen) 
     throw(SocketException) : Socket(SOCK_STREAM, IPPROTO_TCP) {
+  setReuseAddress(true);
   setLocalPort(localPort);
   setListen(queueLen);
 }
@@ -257,6 +407,7 @@ TCPServerSocket::TCPServerSocket(unsigned short localPort, int queueLen)
 TCPServerSocket::TCPServerSocket(const string &localAddress, 
     unsigned short localPort, int queueLen) 
     throw(SocketException) : Socket(SOCK_STREAM, IPPROTO_TCP) {
+  setReuseAddress(true);
   setLocalAddressAndPort(localAddress, localPort);
   setListen(queueLen);
 }
@@ -264,6 +415,9 @@ TCPServerSocket::TCPServerSocket(const string &localAddress,
 TCPSocket *TCPServerSocket::accept() throw(SocketException) {
   int newConnSD;
   if ((newConnSD = ::accept(sockDesc, NULL, 0)) < 0) {
+    if (wouldBlock()) {
+      return NULL;
+    }
     throw SocketException("Accept failed (accept())", true);
   }
 
@@ -333,6 +487,55 @@ void UDPSocket::sendTo(const void *buffer, int bufferLen,
   }
 }
 
+int UDPSocket::sendBatch(const void * const *buffers, const int *bufferLens,
+    int count, const string &foreignAddress, unsigned short foreignPort)
+    throw(SocketException) {
+  sockaddr_in destAddr;
+  fillAddr(foreignAddress, foreignPort, destAddr);
+
+  int sent = 0;
+#ifdef HAVE_SENDMMSG
+  mmsghdr messages[SENDMMSG_BATCH];
+  iovec iovecs[SENDMMSG_BATCH];
+
+  while (sent < count) {
+    int batch = (count - sent < SENDMMSG_BATCH) ? count - sent : SENDMMSG_BATCH;
+    for (int i = 0; i < batch; i++) {
+      iovecs[i].iov_base = (void *) buffers[sent + i];
+      iovecs[i].iov_len = bufferLens[sent + i];
+      memset(&messages[i], 0, sizeof(mmsghdr));
+      messages[i].msg_hdr.msg_name = &destAddr;
+      messages[i].msg_hdr.msg_namelen = sizeof(destAddr);
+      messages[i].msg_hdr.msg_iov = &iovecs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int rtn = sendmmsg(sockDesc, messages, batch, 0);
+    if (rtn < 0) {
+      if (wouldBlock()) {
+        return sent;
+      }
+      throw SocketException("Send failed (sendmmsg())", true);
+    }
+    sent += rtn;
+    if (rtn < batch) {
+      return sent;               // The send buffer is full
+    }
+  }
+#else
+  for (; sent < count; sent++) {
+    if (sendto(sockDesc, (raw_type *) buffers[sent], bufferLens[sent], 0,
+               (sockaddr *) &destAddr, sizeof(destAddr)) != bufferLens[sent]) {
+      if (wouldBlock()) {
+        return sent;
+      }
+      throw SocketException("Send failed (sendto())", true);
+    }
+  }
+#endif
+  return sent;
+}
+
 int UDPSocket::recvFrom(void *buffer, int bufferLen, string &sourceAddress,
     unsigned short &sourcePort) throw(SocketException) {
   sockaddr_in clntAddr;
@@ -340,6 +543,9 @@ int UDPSocket::recvFrom(void *buffer, int bufferLen, string &sourceAddress,
   int rtn;
   if ((rtn = recvfrom(sockDesc, (raw_type *) buffer, bufferLen, 0, 
                       (sockaddr *) &clntAddr, (socklen_t *) &addrLen)) < 0) {
+    if (wouldBlock()) {
+      return -1;
+    }
     throw SocketException("Receive failed (recvfrom())", true);
   }
   sourceAddress = inet_ntoa(clntAddr.sin_addr);
@@ -356,10 +562,19 @@ void UDPSocket::setMulticastTTL(unsigned char multicastTTL) throw(SocketExceptio
 }
 
 void UDPSocket::joinGroup(const string &multicastGroup) throw(SocketException) {
+  joinGroup(multicastGroup, "");
+}
+
+void UDPSocket::joinGroup(const string &multicastGroup, 
+    const string &localInterface) throw(SocketException) {
   struct ip_mreq multicastRequest;
 
   multicastRequest.imr_multiaddr.s_addr = inet_addr(multicastGroup.c_str());
-  multicastRequest.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (localInterface.empty()) {
+    multicastRequest.imr_interface.s_addr = htonl(INADDR_ANY);
+  } else {
+    multicastRequest.imr_interface.s_addr = inet_addr(localInterface.c_str());
+  }
   if (setsockopt(sockDesc, IPPROTO_IP, IP_ADD_MEMBERSHIP, 
                  (raw_type *) &multicastRequest, 
                  sizeof(multicastRequest)) < 0) {
@@ -378,3 +593,58 @@ void UDPSocket::leaveGroup(const string &multicastGroup) throw(SocketException)
     throw SocketException("Multicast group leave failed (setsockopt())", true);
   }
 }
+
+#ifndef WIN32
+// UnixDatagramSocket Code
+
+UnixDatagramSocket::UnixDatagramSocket() throw(SocketException) :
+    CommunicatingSocket(AF_UNIX, SOCK_DGRAM, 0) {
+}
+
+UnixDatagramSocket::UnixDatagramSocket(const string &localPath)
+    throw(SocketException) : CommunicatingSocket(AF_UNIX, SOCK_DGRAM, 0) {
+  sockaddr_un localAddr;
+  socklen_t addrLen = fillUnixAddr(localPath, localAddr);
+
+  // A socket file left behind by a previous run would make bind() fail
+  unlinkSocketFile(localPath);
+
+  if (bind(sockDesc, (sockaddr *) &localAddr, addrLen) < 0) {
+    throw SocketException("Set of local path failed (bind())", true);
+  }
+  this->localPath = localPath;
+}
+
+UnixDatagramSocket::~UnixDatagramSocket() {
+  unlinkSocketFile(localPath);
+}
+
+void UnixDatagramSocket::sendTo(const void *buffer, int bufferLen,
+    const string &foreignPath) throw(SocketException) {
+  sockaddr_un destAddr;
+  socklen_t addrLen = fillUnixAddr(foreignPath, destAddr);
+
+  // Write out the whole buffer as a single message.
+  if (sendto(sockDesc, (raw_type *) buffer, bufferLen, 0,
+             (sockaddr *) &destAddr, addrLen) != bufferLen) {
+    throw SocketException("Send failed (sendto())", true);
+  }
+}
+
+int UnixDatagramSocket::recvFrom(void *buffer, int bufferLen,
+    string &sourcePath) throw(SocketException) {
+  sockaddr_un clntAddr;
+  socklen_t addrLen = sizeof(clntAddr);
+  int rtn;
+  if ((rtn = recvfrom(sockDesc, (raw_type *) buffer, bufferLen, 0,
+                      (sockaddr *) &clntAddr, &addrLen)) < 0) {
+    if (wouldBlock()) {
+      return -1;
+    }
+    throw SocketException("Receive failed (recvfrom())", true);
+  }
+  sourcePath = unixAddrToPath(clntAddr, addrLen);
+
+  return rtn;
+}
+#endif
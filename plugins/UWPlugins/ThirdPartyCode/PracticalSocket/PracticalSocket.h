@@ -96,6 +96,32 @@ public:
   void setLocalAddressAndPort(const string &localAddress, 
     unsigned short localPort = 0) throw(SocketException);
 
+  /**
+   *   Put the socket into blocking or non-blocking mode.  In non-blocking
+   *   mode recv() and recvFrom() return -1 instead of waiting when no data
+   *   is available
+   *   @param blocking true for blocking (the default), false for non-blocking
+   *   @exception SocketException thrown if the mode cannot be changed
+   */
+  void setBlocking(bool blocking) throw(SocketException);
+
+  /**
+   *   Allow the local address and port to be bound again straight away
+   *   (SO_REUSEADDR).  Must be called before the socket is bound
+   *   @param reuse true to allow the address to be reused
+   *   @exception SocketException thrown if the option cannot be set
+   */
+  void setReuseAddress(bool reuse) throw(SocketException);
+
+  /**
+   *   Set the size of the receive buffer (SO_RCVBUF), so that bursts of
+   *   datagrams are not dropped before they are read.  The system may cap
+   *   the size (net.core.rmem_max on Linux)
+   *   @param bytes requested size of the buffer
+   *   @exception SocketException thrown if the option cannot be set
+   */
+  void setReceiveBufferSize(int bytes) throw(SocketException);
+
   /**
    *   If WinSock, unload the WinSock DLLs; otherwise do nothing.  We ignore
    *   this in our sample client code but include it in the library for
@@ -128,6 +154,7 @@ private:
 protected:
   int sockDesc;              // Socket descriptor
   Socket(int type, int protocol) throw(SocketException);
+  Socket(int domain, int type, int protocol) throw(SocketException);
   Socket(int sockDesc);
 };
 
@@ -151,16 +178,20 @@ public:
    *   calling send()
    *   @param buffer buffer to be written
    *   @param bufferLen number of bytes from buffer to be written
+   *   @return number of bytes written, which may be less than bufferLen on
+   *   a non-blocking socket, and -1 if the socket is non-blocking and no
+   *   data can be written
    *   @exception SocketException thrown if unable to send data
    */
-  void send(const void *buffer, int bufferLen) throw(SocketException);
+  int send(const void *buffer, int bufferLen) throw(SocketException);
 
   /**
    *   Read into the given buffer up to bufferLen bytes data from this
    *   socket.  Call connect() before calling recv()
    *   @param buffer buffer to receive the data
    *   @param bufferLen maximum number of bytes to read into buffer
-   *   @return number of bytes read, 0 for EOF, and -1 for error
+   *   @return number of bytes read, 0 for EOF, and -1 if the socket is
+   *   non-blocking and no data is available
    *   @exception SocketException thrown if unable to receive data
    */
   int recv(void *buffer, int bufferLen) throw(SocketException);
@@ -181,6 +212,8 @@ public:
 
 protected:
   CommunicatingSocket(int type, int protocol) throw(SocketException);
+  CommunicatingSocket(int domain, int type, int protocol) 
+      throw(SocketException);
   CommunicatingSocket(int newConnSD);
 };
 
@@ -205,6 +238,14 @@ public:
   TCPSocket(const string &foreignAddress, unsigned short foreignPort) 
       throw(SocketException);
 
+  /**
+   *   Turn Nagle's algorithm off (TCP_NODELAY) so small messages are sent
+   *   straight away instead of being held back to be coalesced
+   *   @param noDelay true to send small messages immediately
+   *   @exception SocketException thrown if the option cannot be set
+   */
+  void setNoDelay(bool noDelay) throw(SocketException);
+
 private:
   // Access for TCPServerSocket::accept() connection creation
   friend class TCPServerSocket;
@@ -218,7 +259,8 @@ class TCPServerSocket : public Socket {
 public:
   /**
    *   Construct a TCP socket for use with a server, accepting connections
-   *   on the specified port on any interface
+   *   on the specified port on any interface.  The address is reusable so a
+   *   server can be closed and opened again on the same port straight away
    *   @param localPort local port of server socket, a value of zero will
    *                   give a system-assigned unused port
    *   @param queueLen maximum queue length for outstanding 
@@ -241,8 +283,10 @@ public:
       int queueLen = 5) throw(SocketException);
 
   /**
-   *   Blocks until a new connection is established on this socket or error
-   *   @return new connection socket
+   *   Blocks until a new connection is established on this socket or error.
+   *   If the socket is non-blocking (see setBlocking()) returns NULL straight
+   *   away when no connection is waiting
+   *   @return new connection socket, or NULL if non-blocking and none is waiting
    *   @exception SocketException thrown if attempt to accept a new connection fails
    */
   TCPSocket *accept() throw(SocketException);
@@ -298,6 +342,23 @@ public:
   void sendTo(const void *buffer, int bufferLen, const string &foreignAddress,
             unsigned short foreignPort) throw(SocketException);
 
+  /**
+   *   Send count buffers as separate UDP datagrams to the specified
+   *   address/port.  On Linux they go out with one sendmmsg() call per
+   *   64 datagrams, elsewhere with one sendto() each
+   *   @param buffers datagrams to be written
+   *   @param bufferLens number of bytes in each datagram
+   *   @param count number of datagrams
+   *   @param foreignAddress address (IP address or name) to send to
+   *   @param foreignPort port number to send to
+   *   @return number of datagrams sent (fewer than count if the socket is
+   *   non-blocking and its send buffer is full)
+   *   @exception SocketException thrown if unable to send datagrams
+   */
+  int sendBatch(const void * const *buffers, const int *bufferLens, int count,
+                const string &foreignAddress, unsigned short foreignPort)
+      throw(SocketException);
+
   /**
    *   Read read up to bufferLen bytes data from this socket.  The given buffer
    *   is where the data will be placed
@@ -305,7 +366,8 @@ public:
    *   @param bufferLen maximum number of bytes to receive
    *   @param sourceAddress address of datagram source
    *   @param sourcePort port of data source
-   *   @return number of bytes received and -1 for error
+   *   @return number of bytes received, or -1 if the socket is non-blocking
+   *   and no datagram is waiting
    *   @exception SocketException thrown if unable to receive datagram
    */
   int recvFrom(void *buffer, int bufferLen, string &sourceAddress, 
@@ -325,6 +387,16 @@ public:
    */
   void joinGroup(const string &multicastGroup) throw(SocketException);
 
+  /**
+   *   Join the specified multicast group on the specified local interface
+   *   @param multicastGroup multicast group address to join
+   *   @param localInterface address of the local interface to receive the
+   *   group on (empty to let the system choose)
+   *   @exception SocketException thrown if unable to join group
+   */
+  void joinGroup(const string &multicastGroup, const string &localInterface)
+      throw(SocketException);
+
   /**
    *   Leave the specified multicast group
    *   @param multicastGroup multicast group address to leave
@@ -336,4 +408,61 @@ private:
   void setBroadcast();
 };
 
+#ifndef WIN32
+/**
+  *   Unix domain datagram socket class (AF_UNIX, SOCK_DGRAM) for talking to
+  *   processes on the same machine without going through the network stack.
+  *   A path which starts with '@' names a socket in the Linux abstract
+  *   namespace (nothing is created in the filesystem); any other path is a
+  *   filesystem path.  Not available on Windows.
+  */
+class UnixDatagramSocket : public CommunicatingSocket {
+public:
+  /**
+   *   Construct an unbound Unix domain datagram socket (for sending only)
+   *   @exception SocketException thrown if unable to create the socket
+   */
+  UnixDatagramSocket() throw(SocketException);
+
+  /**
+   *   Construct a Unix domain datagram socket bound to the given path.  A
+   *   stale socket file left at a filesystem path is removed first
+   *   @param localPath filesystem path, or '@' followed by an abstract name
+   *   @exception SocketException thrown if unable to create or bind the socket
+   */
+  UnixDatagramSocket(const string &localPath) throw(SocketException);
+
+  /**
+   *   Close the socket and remove its filesystem path (if it has one)
+   */
+  ~UnixDatagramSocket();
+
+  /**
+   *   Send the given buffer as a datagram to the socket bound to foreignPath
+   *   @param buffer buffer to be written
+   *   @param bufferLen number of bytes to write
+   *   @param foreignPath path of the socket to send to
+   *   @exception SocketException thrown if unable to send datagram
+   */
+  void sendTo(const void *buffer, int bufferLen, const string &foreignPath)
+      throw(SocketException);
+
+  /**
+   *   Read up to bufferLen bytes data from this socket
+   *   @param buffer buffer to receive data
+   *   @param bufferLen maximum number of bytes to receive
+   *   @param sourcePath path of the sending socket (empty if the sender is
+   *   not bound, in which case it cannot be replied to)
+   *   @return number of bytes received, or -1 if the socket is non-blocking
+   *   and no datagram is waiting
+   *   @exception SocketException thrown if unable to receive datagram
+   */
+  int recvFrom(void *buffer, int bufferLen, string &sourcePath)
+      throw(SocketException);
+
+private:
+  string localPath;          // Bound path (empty if not bound)
+};
+#endif
+
 #endif